@@ -0,0 +1,221 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotNavRouteTable.h"
+
+#include "BotNavMeshZone.h"
+#include "gameType.h"
+#include "ServerGame.h"
+
+#include "LevelFilesForTesting.h"
+#include "TestUtils.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+static const S32 ZoneSize = 100;
+
+
+// Square zones in a grid, each joined to the ones beside it, both ways, like an open level
+static BotNavRouteTable *newGridTable(S32 width, S32 height, U32 maxBytes = BotNavRouteTable::MaxTableBytes)
+{
+   Vector<Point> centers;
+
+   for(S32 y = 0; y < height; y++)
+      for(S32 x = 0; x < width; x++)
+         centers.push_back(Point(x * ZoneSize, y * ZoneSize));
+
+   // One more off on its own, that nothing joins up with
+   centers.push_back(Point(-10 * ZoneSize, -10 * ZoneSize));
+
+   BotNavRouteTable *table = new BotNavRouteTable(centers, maxBytes);
+
+   for(S32 y = 0; y < height; y++)
+      for(S32 x = 0; x < width; x++)
+      {
+         S32 zone = y * width + x;
+
+         if(x < width - 1)
+         {
+            Point gateway = (centers[zone] + centers[zone + 1]) * 0.5f;
+            table->addLink(zone, zone + 1, gateway, ZoneSize / 2);
+            table->addLink(zone + 1, zone, gateway, ZoneSize / 2);
+         }
+
+         if(y < height - 1)
+         {
+            Point gateway = (centers[zone] + centers[zone + width]) * 0.5f;
+            table->addLink(zone, zone + width, gateway, ZoneSize / 2);
+            table->addLink(zone + width, zone, gateway, ZoneSize / 2);
+         }
+      }
+
+   return table;
+}
+
+
+TEST(BotNavRouteTableTest, FollowsShortestRoute)
+{
+   BotNavRouteTable *table = newGridTable(10, 10);
+   table->finishGraph();
+
+   EXPECT_FALSE(table->isEvicting());
+
+   table->startBuilding();
+   table->waitUntilBuilt();
+   EXPECT_TRUE(table->isFullyBuilt());
+
+   // Corner to corner is 18 steps, no matter which way we go
+   EXPECT_FLOAT_EQ(18 * ZoneSize / 2, table->getRouteCost(0, 99));
+   EXPECT_FLOAT_EQ(0, table->getRouteCost(42, 42));
+
+   Point target(950, 950);
+   Vector<Point> path = table->findPath(0, 99, target);
+
+   // Target, then a zone center and a gateway for each step, then where we started
+   ASSERT_EQ(1 + 18 * 2 + 1, path.size());
+   EXPECT_EQ(target, path.first());
+   EXPECT_EQ(Point(900, 900), path[1]);
+   EXPECT_EQ(Point(0, 0), path.last());
+
+   // Every step is to the zone next door, through the middle of the border between them
+   for(S32 i = 1; i < path.size() - 1; i++)
+      EXPECT_FLOAT_EQ(ZoneSize / 2, path[i].distanceTo(path[i + 1]));
+
+   delete table;
+}
+
+
+// Like a teleporter, a link can go one way only, and costs nothing to use
+TEST(BotNavRouteTableTest, OneWayLinks)
+{
+   BotNavRouteTable *table = newGridTable(10, 10);
+   table->addLink(0, 99, Point(0, 0), 0);
+   table->finishGraph();
+
+   EXPECT_EQ(99, table->getNextZone(0, 99));
+   EXPECT_EQ(0,  table->getNextZone(1, 99));     // Quicker to go back to the teleporter
+   EXPECT_FLOAT_EQ(ZoneSize / 2, table->getRouteCost(1, 99));
+
+   EXPECT_FLOAT_EQ(18 * ZoneSize / 2, table->getRouteCost(99, 0));
+
+   Vector<Point> path = table->findPath(0, 99, Point(950, 950));
+   ASSERT_EQ(4, path.size());
+   EXPECT_EQ(Point(0, 0), path[2]);      // Teleporter is in the middle of zone 0
+
+   delete table;
+}
+
+
+TEST(BotNavRouteTableTest, NoRoute)
+{
+   BotNavRouteTable *table = newGridTable(5, 5);
+   table->finishGraph();
+
+   S32 island = table->getZoneCount() - 1;
+
+   EXPECT_EQ(BotNavRouteTable::NoRoute, table->getNextZone(0, island));
+   EXPECT_EQ(BotNavRouteTable::NoRoute, table->getNextZone(island, 0));
+   EXPECT_FLOAT_EQ(-1, table->getRouteCost(island, 0));
+   EXPECT_EQ(0, table->findPath(0, island, Point(0, 0)).size());
+
+   delete table;
+}
+
+
+// When the table won't fit, rows come and go as needed, but the answers are the same
+TEST(BotNavRouteTableTest, StaysWithinMemoryLimit)
+{
+   BotNavRouteTable *fullTable = newGridTable(30, 30);
+   fullTable->finishGraph();
+
+   S32 rowBytes = fullTable->getZoneCount() * sizeof(U16);
+   BotNavRouteTable *smallTable = newGridTable(30, 30, rowBytes * 10);
+   smallTable->finishGraph();
+
+   EXPECT_FALSE(fullTable->isEvicting());
+   EXPECT_TRUE(smallTable->isEvicting());
+
+   smallTable->startBuilding();      // Does nothing; there isn't room
+   EXPECT_FALSE(smallTable->isFullyBuilt());
+
+   U32 seed = 12345;
+
+   for(S32 i = 0; i < 2000; i++)
+   {
+      seed = seed * 1103515245 + 12345;
+      U16 from = U16((seed >> 8) % 900);
+      U16 to = U16((seed >> 20) % (i < 1000 ? 15 : 900));     // A few popular targets, then all over the place
+
+      EXPECT_EQ(fullTable->getNextZone(from, to), smallTable->getNextZone(from, to));
+      EXPECT_FLOAT_EQ(fullTable->getRouteCost(from, to), smallTable->getRouteCost(from, to));
+   }
+
+   delete smallTable;
+   delete fullTable;
+}
+
+
+// On the levels we test with, the table must find the same routes AStar does, as bots used to the first time they went
+// from one zone to another
+TEST(BotNavRouteTableTest, MatchesAStarOnTestLevels)
+{
+   Vector<string> levelCodes = getLevels().first;
+
+   for(S32 i = 0; i < levelCodes.size(); i++)
+   {
+      ServerGame *game = newServerGame(levelCodes[i]);
+      game->addObjectsToGame();    // Creates the barriers we need for building zones
+
+      game->buildBotMeshZones(false);
+
+      const Vector<BotNavMeshZone *> &zones = game->getBotZoneList();
+      BotNavRouteTable *table = game->getBotRouteTable();
+
+      if(game->getGameType()->mBotZoneCreationFailed || zones.size() < 2)
+      {
+         delete game;
+         continue;
+      }
+
+      ASSERT_TRUE(table != NULL);
+
+      table->waitUntilBuilt();
+      EXPECT_TRUE(table->isFullyBuilt());
+
+      // Every pair on small levels, a sample on bigger ones
+      S32 step = zones.size() > 200 ? zones.size() / 200 : 1;
+
+      for(S32 from = 0; from < zones.size(); from += step)
+         for(S32 to = 0; to < zones.size(); to += step)
+         {
+            if(from == to)
+               continue;
+
+            Point target = zones[to]->getCenter();
+
+            Vector<Point> aStarPath = AStar::findPath(&zones, from, to, target);
+            Vector<Point> tablePath = table->findPath(from, to, target);
+
+            // Both agree on whether we can get there, and where the trip starts and ends
+            ASSERT_EQ(aStarPath.size() == 0, tablePath.size() == 0) << "level " << i << ", zone " << from << " to " << to;
+
+            if(tablePath.size() > 0)
+            {
+               EXPECT_EQ(aStarPath.first(), tablePath.first());
+               EXPECT_EQ(aStarPath.last(),  tablePath.last());
+            }
+         }
+
+      delete game;
+   }
+}
+
+
+};
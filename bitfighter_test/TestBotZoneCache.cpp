@@ -0,0 +1,180 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotZoneCache.h"
+
+#include "BotNavMeshZone.h"
+#include "gameType.h"
+#include "Level.h"
+#include "ServerGame.h"
+
+#include "LevelFilesForTesting.h"
+#include "TestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+static const char *TestFileName = "bot_zone_cache_test.bfzones";
+
+
+static void expectSameZones(const Vector<BotNavMeshZone *> &expected, const Vector<BotNavMeshZone *> &actual)
+{
+   ASSERT_EQ(expected.size(), actual.size());
+
+   for(S32 i = 0; i < expected.size(); i++)
+   {
+      EXPECT_EQ(i, actual[i]->getZoneId());
+      EXPECT_EQ(expected[i]->getCenter(), actual[i]->getCenter());
+
+      const Vector<Point> &expectedOutline = *expected[i]->getOutline();
+      const Vector<Point> &actualOutline   = *actual[i]->getOutline();
+
+      ASSERT_EQ(expectedOutline.size(), actualOutline.size());
+      for(S32 j = 0; j < expectedOutline.size(); j++)
+         EXPECT_EQ(expectedOutline[j], actualOutline[j]);
+
+      // Neighbors come back exactly as they were, teleporter links included
+      const Vector<NeighboringZone> &expectedNeighbors = expected[i]->getNeighbors();
+      const Vector<NeighboringZone> &actualNeighbors   = actual[i]->getNeighbors();
+
+      ASSERT_EQ(expectedNeighbors.size(), actualNeighbors.size());
+      for(S32 j = 0; j < expectedNeighbors.size(); j++)
+      {
+         EXPECT_EQ(expectedNeighbors[j].zoneID,       actualNeighbors[j].zoneID);
+         EXPECT_EQ(expectedNeighbors[j].borderStart,  actualNeighbors[j].borderStart);
+         EXPECT_EQ(expectedNeighbors[j].borderEnd,    actualNeighbors[j].borderEnd);
+         EXPECT_EQ(expectedNeighbors[j].borderCenter, actualNeighbors[j].borderCenter);
+         EXPECT_EQ(expectedNeighbors[j].center,       actualNeighbors[j].center);
+         EXPECT_EQ(expectedNeighbors[j].distTo,       actualNeighbors[j].distTo);
+      }
+   }
+}
+
+
+// Loads whatever is in TestFileName; returns how many zones it got
+static S32 loadTestFile(const string &hash)
+{
+   GridDatabase database;
+   Vector<BotNavMeshZone *> zones;
+
+   bool loaded = BotZoneCache::load(TestFileName, hash, database, zones, false);
+
+   S32 count = zones.size();
+   zones.deleteAndClear();
+
+   return loaded ? count : -1;
+}
+
+
+// Zones loaded from the cache must match the ones we built, on every level we test with
+TEST(BotZoneCacheTest, RoundTrip)
+{
+   Vector<string> levelCodes = getLevels().first;
+
+   for(S32 i = 0; i < levelCodes.size(); i++)
+   {
+      ServerGame *game = newServerGame(levelCodes[i]);
+      game->addObjectsToGame();
+
+      game->buildBotMeshZones(false);
+
+      const Vector<BotNavMeshZone *> &zones = game->getBotZoneList();
+      string hash = game->getLevel()->getHash();
+
+      if(game->getGameType()->mBotZoneCreationFailed || zones.size() == 0)
+      {
+         delete game;
+         continue;
+      }
+
+      ASSERT_TRUE(BotZoneCache::save(TestFileName, hash, zones));
+
+      GridDatabase database;
+      Vector<BotNavMeshZone *> loadedZones;
+
+      ASSERT_TRUE(BotZoneCache::load(TestFileName, hash, database, loadedZones, false));
+
+      expectSameZones(zones, loadedZones);
+      EXPECT_EQ(zones.size(), database.getObjectCount());
+
+      loadedZones.deleteAndClear();
+      delete game;
+   }
+
+   remove(TestFileName);
+}
+
+
+// Anything that doesn't add up means the zones get built from scratch
+TEST(BotZoneCacheTest, RejectsBadFiles)
+{
+   ServerGame *game = newServerGame(getLevelCode1());
+   game->addObjectsToGame();
+   game->buildBotMeshZones(false);
+
+   const Vector<BotNavMeshZone *> &zones = game->getBotZoneList();
+   string hash = game->getLevel()->getHash();
+
+   ASSERT_TRUE(zones.size() > 0);
+   ASSERT_TRUE(BotZoneCache::save(TestFileName, hash, zones));
+   EXPECT_EQ(zones.size(), loadTestFile(hash));
+
+   // Some other level
+   string otherHash(hash);
+   otherHash[0] = otherHash[0] == '0' ? '1' : '0';
+   EXPECT_EQ(-1, loadTestFile(otherHash));
+
+   // Read the file, so we can mess with it
+   FILE *file = fopen(TestFileName, "rb");
+   ASSERT_TRUE(file != NULL);
+
+   Vector<U8> data;
+   U8 buffer[4096];
+   size_t count;
+
+   while((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+      for(size_t j = 0; j < count; j++)
+         data.push_back(buffer[j]);
+
+   fclose(file);
+
+   struct Damage { S32 offset; U8 value; };
+   Damage damages[] = {
+      {  4, U8(BotZoneCache::Version + 1) },   // Newer version
+      {  8, 0x01 },                            // Other byte order
+      { 67, 0xFF },                            // First zone's first vertex way out of range
+   };
+
+   for(S32 i = 0; i < ARRAYSIZE(damages); i++)
+   {
+      Vector<U8> damaged(data);
+      damaged[damages[i].offset] = damages[i].value;
+
+      file = fopen(TestFileName, "wb");
+      fwrite(damaged.address(), 1, damaged.size(), file);
+      fclose(file);
+
+      EXPECT_EQ(-1, loadTestFile(hash)) << "damage " << i;
+   }
+
+   // Cut short
+   file = fopen(TestFileName, "wb");
+   fwrite(data.address(), 1, data.size() - 1, file);
+   fclose(file);
+
+   EXPECT_EQ(-1, loadTestFile(hash));
+
+   remove(TestFileName);
+   delete game;
+}
+
+
+};
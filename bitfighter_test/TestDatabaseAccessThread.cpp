@@ -0,0 +1,339 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "../master/DatabaseAccessThread.h"
+#include "../master/database.h"
+
+#include "gameStats.h"
+#include "stringUtils.h"
+
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace Master
+{
+
+using namespace std;
+using namespace TNL;
+
+
+// Writes down the order things run in, and counts what gets finished
+struct OrderedEntry : public ThreadEntry
+{
+   static Vector<S32> ran;
+   static S32 finished;
+
+   S32 mIndex;
+   bool mFail;
+   U32 mSleep;
+
+   OrderedEntry(S32 index, bool fail = false, U32 sleep = 0)
+   {
+      mIndex = index;
+      mFail = fail;
+      mSleep = sleep;
+   }
+
+   void run()
+   {
+      if(mSleep > 0)
+         Platform::sleep(mSleep);
+
+      ran.push_back(mIndex);     // Only looked at when there's a single thread
+
+      if(mFail)
+         setFailed();
+   }
+
+   void finish()
+   {
+      finished++;
+   }
+};
+
+Vector<S32> OrderedEntry::ran;
+S32 OrderedEntry::finished = 0;
+
+
+// Idle until everything has been finished, or we give up
+static void waitForEntries(DatabaseAccessThread &thread, S32 count)
+{
+   U32 start = Platform::getRealMilliseconds();
+
+   while(OrderedEntry::finished < count && Platform::getRealMilliseconds() - start < 10000)
+   {
+      thread.idle();
+      Platform::sleep(1);
+   }
+}
+
+
+TEST(DatabaseAccessThreadTest, SingleThreadKeepsOrder)
+{
+   OrderedEntry::ran.clear();
+   OrderedEntry::finished = 0;
+
+   DatabaseAccessThread thread;
+
+   // Well past the 128 entries the old ring buffer could hold
+   const S32 Entries = 500;
+   for(S32 i = 0; i < Entries; i++)
+   {
+      RefPtr<OrderedEntry> entry = new OrderedEntry(i);
+      thread.addEntry(entry);
+   }
+
+   waitForEntries(thread, Entries);
+
+   ASSERT_EQ(Entries, OrderedEntry::finished);
+   ASSERT_EQ(Entries, OrderedEntry::ran.size());
+
+   for(S32 i = 0; i < Entries; i++)
+      EXPECT_EQ(i, OrderedEntry::ran[i]);
+
+   DatabaseAccessStats stats = thread.getStats();
+   EXPECT_EQ(U32(1), stats.threads);
+   EXPECT_EQ(U32(Entries), stats.completed);
+   EXPECT_EQ(U32(0), stats.failed);
+   EXPECT_EQ(U32(0), stats.queued);
+   EXPECT_GT(stats.peakQueued, U32(0));
+}
+
+
+TEST(DatabaseAccessThreadTest, Pool)
+{
+   OrderedEntry::finished = 0;
+
+   DatabaseAccessThread thread(4);
+
+   const S32 Entries = 40;
+   for(S32 i = 0; i < Entries; i++)
+   {
+      RefPtr<OrderedEntry> entry = new OrderedEntry(i, i % 10 == 0, 5);
+      thread.addEntry(entry);
+   }
+
+   waitForEntries(thread, Entries);
+
+   EXPECT_EQ(Entries, OrderedEntry::finished);
+
+   DatabaseAccessStats stats = thread.getStats(true);
+   EXPECT_EQ(U32(4), stats.threads);
+   EXPECT_EQ(U32(Entries), stats.completed);
+   EXPECT_EQ(U32(4), stats.failed);
+   EXPECT_GE(stats.maxLatency, U32(5));
+
+   // Peaks start over after a reset
+   stats = thread.getStats();
+   EXPECT_EQ(U32(0), stats.peakQueued);
+   EXPECT_EQ(U32(0), stats.maxLatency);
+}
+
+};
+
+
+namespace DbWriter
+{
+
+TEST(DatabaseWriterTest, PreparedStatementsAndPooling)
+{
+   const char *dbName = "test_stats.db";
+   remove(dbName);
+
+   DbQuery::enablePooling(true);
+
+   {
+      DatabaseWriter writer(dbName);     // Creates the database
+
+      EXPECT_TRUE(writer.insertAchievement(2, "O'Brien", "Server 'One'", "1.2.3.4:5"));
+      EXPECT_FALSE(writer.insertAchievement(2, "O'Brien", "Server 'One'", "1.2.3.4:5"));    // Already has it
+      EXPECT_TRUE(writer.insertAchievement(3, "O'Brien", "Server 'One'", "1.2.3.4:5"));
+
+      EXPECT_EQ(BIT(2) | BIT(3), (S32)writer.getAchievements("O'Brien"));
+
+      GameStats gameStats;
+      gameStats.serverName = "Server 'One'";
+      gameStats.serverIP = "1.2.3.4:5";
+      gameStats.gameType = "CTF";
+      gameStats.levelName = "Don't Panic";
+      gameStats.isTeamGame = true;
+      gameStats.playerCount = 2;
+
+      TeamStats teamStats;
+      teamStats.name = "Blue";
+      teamStats.hexColor = "0000ff";
+      teamStats.gameResult = 'W';
+
+      PlayerStats playerStats;
+      playerStats.name = "O'Brien";
+      playerStats.gameResult = 'W';
+
+      LoadoutStats loadoutStats;
+      loadoutStats.loadoutHash = 12345;
+      playerStats.loadoutStats.push_back(loadoutStats);
+
+      teamStats.playerStats.push_back(playerStats);
+      playerStats.name = "Bot";
+      teamStats.playerStats.push_back(playerStats);
+      gameStats.teamStats.push_back(teamStats);
+
+      EXPECT_TRUE(writer.insertStats(gameStats));
+      EXPECT_TRUE(writer.insertStats(gameStats));
+
+      EXPECT_EQ(2, writer.getGamesPlayed("O'Brien"));
+      EXPECT_EQ(2, writer.getGamesPlayed("Bot"));
+      EXPECT_EQ(0, writer.getGamesPlayed("Nobody"));
+
+      // Everything above ran on the same connection
+      EXPECT_EQ(1, DbQuery::getPooledConnectionCount());
+
+      DbQuery query(dbName);
+      Vector<string> params;
+      Vector<Vector<string> > results;
+      EXPECT_TRUE(query.runSelectQuery("SELECT count(*) FROM server;", params, 1, results));
+      ASSERT_EQ(1, results.size());
+      EXPECT_EQ("1", results[0][0]);
+   }
+
+   DbQuery::enablePooling(false);
+   EXPECT_EQ(0, DbQuery::getPooledConnectionCount());
+
+   remove(dbName);
+}
+
+
+static S32 countRows(const char *dbName, const char *table)
+{
+   DbQuery query(dbName);
+   Vector<string> params;
+   Vector<Vector<string> > results;
+
+   string sql = string("SELECT count(*) FROM ") + table + ";";
+   if(!query.runSelectQuery(sql.c_str(), params, 1, results) || results.size() != 1)
+      return -1;
+
+   return atoi(results[0][0].c_str());
+}
+
+
+static GameStats makeGameStats(const string &serverName, const string &playerName)
+{
+   GameStats gameStats;
+   gameStats.serverName = serverName;
+   gameStats.serverIP = "1.2.3.4:5";
+   gameStats.gameType = "Bitmatch";
+   gameStats.levelName = "Batch";
+   gameStats.isTeamGame = false;
+   gameStats.playerCount = 1;
+
+   TeamStats teamStats;
+   teamStats.name = playerName;
+   teamStats.hexColor = "ff0000";
+   teamStats.gameResult = 'W';
+
+   PlayerStats playerStats;
+   playerStats.name = playerName;
+   playerStats.gameResult = 'W';
+
+   LoadoutStats loadoutStats;
+   loadoutStats.loadoutHash = 1;
+   playerStats.loadoutStats.push_back(loadoutStats);
+   loadoutStats.loadoutHash = 2;
+   playerStats.loadoutStats.push_back(loadoutStats);
+
+   WeaponStats weaponStats;
+   weaponStats.weaponType = WeaponPhaser;
+   weaponStats.shots = 10;
+   weaponStats.hits = 4;
+   weaponStats.hitBy = 0;
+   playerStats.weaponStats.push_back(weaponStats);
+
+   teamStats.playerStats.push_back(playerStats);
+   gameStats.teamStats.push_back(teamStats);
+
+   return gameStats;
+}
+
+
+TEST(DatabaseWriterTest, StatsBatch)
+{
+   const char *dbName = "test_stats_batch.db";
+   remove(dbName);
+
+   DatabaseWriter writer(dbName);
+
+   // More leaf rows than fit in a single multi-row insert
+   StatsBatch batch;
+   batch.batchId = "0123456789abcdef0123456789abcdef";
+   for(S32 i = 0; i < 30; i++)
+      batch.games.push_back(makeGameStats(i % 2 ? "Odd" : "Even", "Player " + itos(i % 3)));
+
+   AchievementRecord achievement;
+   achievement.achievementId = 1;
+   achievement.playerName = "Player 0";
+   achievement.serverName = "Even";
+   achievement.serverIP = "1.2.3.4:5";
+   batch.achievements.push_back(achievement);
+   batch.achievements.push_back(achievement);      // Duplicate is skipped, not an error
+
+   EXPECT_EQ(32, batch.size());
+   EXPECT_TRUE(writer.insertStatsBatch(batch));
+
+   EXPECT_EQ(30, countRows(dbName, "stats_game"));
+   EXPECT_EQ(30, countRows(dbName, "stats_player"));
+   EXPECT_EQ(60, countRows(dbName, "stats_player_loadout"));
+   EXPECT_EQ(30, countRows(dbName, "stats_player_shots"));
+   EXPECT_EQ(1,  countRows(dbName, "player_achievements"));
+   EXPECT_EQ(2,  countRows(dbName, "server"));
+   EXPECT_EQ(10, writer.getGamesPlayed("Player 1"));
+   EXPECT_EQ(1,  countRows(dbName, "stats_batch"));
+
+   // Sending it again, as we would if we never heard that it went in, doesn't write it twice
+   EXPECT_TRUE(writer.insertStatsBatch(batch));
+   EXPECT_EQ(30, countRows(dbName, "stats_game"));
+   EXPECT_EQ(30, countRows(dbName, "stats_player"));
+   EXPECT_EQ(1,  countRows(dbName, "player_achievements"));
+   EXPECT_EQ(1,  countRows(dbName, "stats_batch"));
+
+   // A different batch with the same games is a different batch; the achievement is already on record
+   batch.batchId = "fedcba9876543210fedcba9876543210";
+   EXPECT_TRUE(writer.insertStatsBatch(batch));
+   EXPECT_EQ(60, countRows(dbName, "stats_game"));
+   EXPECT_EQ(1,  countRows(dbName, "player_achievements"));
+   EXPECT_EQ(2,  countRows(dbName, "stats_batch"));
+
+   // A database from before batches had ids gets somewhere to put them
+   {
+      DbQuery query(dbName);
+      query.runInsertQuery("DROP TABLE stats_batch;");
+   }
+
+   batch.batchId = "00000000000000000000000000000002";
+   batch.games.resize(1);
+   EXPECT_TRUE(writer.insertStatsBatch(batch));
+   EXPECT_EQ(61, countRows(dbName, "stats_game"));
+   EXPECT_EQ(1,  countRows(dbName, "stats_batch"));
+
+   // If any part fails, none of the batch is written, including its id, so it can be tried again
+   {
+      DbQuery query(dbName);
+      query.runInsertQuery("DROP TABLE stats_player_shots;");
+   }
+
+   batch.batchId = "00000000000000000000000000000003";
+   EXPECT_FALSE(writer.insertStatsBatch(batch));
+   EXPECT_EQ(61, countRows(dbName, "stats_game"));
+   EXPECT_EQ(61, countRows(dbName, "stats_player"));
+   EXPECT_EQ(122, countRows(dbName, "stats_player_loadout"));
+   EXPECT_EQ(1,  countRows(dbName, "stats_batch"));
+
+   remove(dbName);
+}
+
+};
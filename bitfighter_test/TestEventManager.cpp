@@ -0,0 +1,185 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "EventManager.h"
+
+#include "loadoutZone.h"
+#include "Level.h"
+#include "luaLevelGenerator.h"
+#include "moveObject.h"
+#include "ServerGame.h"
+
+#include "TestUtils.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace std;
+using namespace TNL;
+
+
+// A levelgen that writes down what it hears, in order: E for entered, L for left, N for nexus opened
+static void setUpListener(LuaLevelGenerator &levelgen)
+{
+   levelgen.runScript(false);
+
+   ASSERT_TRUE(levelgen.runString("heard = '' "
+                                  "onObjectEnteredZone = function(obj, zone) heard = heard .. 'E' end "
+                                  "onObjectLeftZone    = function(obj, zone) heard = heard .. 'L' end "
+                                  "onNexusOpened       = function() heard = heard .. 'N' end "
+                                  "subscribe(Event.ObjectEnteredZone) "
+                                  "subscribe(Event.ObjectLeftZone) "
+                                  "subscribe(Event.NexusOpened)"));
+
+   EventManager::get()->update();      // Make those subscriptions take
+}
+
+
+static void expectHeard(LuaLevelGenerator &levelgen, const string &expected)
+{
+   EXPECT_TRUE(levelgen.runString("assert(heard == '" + expected + "', heard)")) << "expected " << expected;
+}
+
+
+TEST(EventManagerTest, ImmediateByDefault)
+{
+   GamePair gamePair;
+   ServerGame *game = gamePair.server;
+
+   LuaLevelGenerator levelgen(game);
+   setUpListener(levelgen);
+
+   LoadoutZone *zone = new LoadoutZone();
+   zone->addToGame(game, game->getLevel());
+
+   EventManager *eventManager = EventManager::get();
+   EXPECT_FALSE(eventManager->isDeferred());
+   eventManager->resetEventCounts();
+
+   // Handlers run right away
+   ResourceItem *item = new ResourceItem();
+   item->addToGame(game, game->getLevel());
+
+   eventManager->fireEvent(EventManager::ObjectEnteredZoneEvent, item, zone);
+   expectHeard(levelgen, "E");
+
+   eventManager->fireEvent(EventManager::ObjectLeftZoneEvent, item, zone);
+   expectHeard(levelgen, "EL");
+
+   EXPECT_EQ(U32(1), eventManager->getFiredCount(EventManager::ObjectEnteredZoneEvent));
+   EXPECT_EQ(U32(1), eventManager->getDeliveredCount(EventManager::ObjectEnteredZoneEvent));
+   EXPECT_EQ(U32(0), eventManager->getCoalescedCount(EventManager::ObjectEnteredZoneEvent));
+}
+
+
+TEST(EventManagerTest, Deferred)
+{
+   GamePair gamePair;
+   ServerGame *game = gamePair.server;
+
+   LuaLevelGenerator levelgen(game);
+   setUpListener(levelgen);
+
+   ResourceItem *item = new ResourceItem();
+   ResourceItem *other = new ResourceItem();
+   LoadoutZone *zone = new LoadoutZone();
+   item->addToGame(game, game->getLevel());
+   other->addToGame(game, game->getLevel());
+   zone->addToGame(game, game->getLevel());
+
+   EventManager *eventManager = EventManager::get();
+   eventManager->setDeferred(true);
+   eventManager->resetEventCounts();
+
+   // Nothing until we flush, and the second entry is old news
+   eventManager->fireEvent(EventManager::ObjectEnteredZoneEvent, item, zone);
+   eventManager->fireEvent(EventManager::ObjectEnteredZoneEvent, item, zone);
+   eventManager->fireEvent(EventManager::ObjectEnteredZoneEvent, other, zone);
+   expectHeard(levelgen, "");
+
+   eventManager->flushDeferredEvents();
+   expectHeard(levelgen, "EE");
+
+   EXPECT_EQ(U32(3), eventManager->getFiredCount(EventManager::ObjectEnteredZoneEvent));
+   EXPECT_EQ(U32(2), eventManager->getDeliveredCount(EventManager::ObjectEnteredZoneEvent));
+   EXPECT_EQ(U32(1), eventManager->getCoalescedCount(EventManager::ObjectEnteredZoneEvent));
+
+   // Leaving and coming back in the same tick is no news at all
+   eventManager->fireEvent(EventManager::ObjectLeftZoneEvent, item, zone);
+   eventManager->fireEvent(EventManager::ObjectEnteredZoneEvent, item, zone);
+   eventManager->flushDeferredEvents();
+   expectHeard(levelgen, "EE");
+
+   EXPECT_EQ(U32(1), eventManager->getCoalescedCount(EventManager::ObjectLeftZoneEvent));
+   EXPECT_EQ(U32(2), eventManager->getCoalescedCount(EventManager::ObjectEnteredZoneEvent));
+
+   // Events we don't hold back see the ones we did delivered first
+   eventManager->fireEvent(EventManager::ObjectLeftZoneEvent, other, zone);
+   eventManager->fireEvent(EventManager::NexusOpenedEvent);
+   expectHeard(levelgen, "EELN");
+
+   // Events about things that are gone by the time we flush are dropped
+   ResourceItem *doomed = new ResourceItem();
+   eventManager->fireEvent(EventManager::ObjectEnteredZoneEvent, doomed, zone);
+   delete doomed;
+   eventManager->flushDeferredEvents();
+   expectHeard(levelgen, "EELN");
+
+   // Turning deferral off delivers what's waiting
+   eventManager->fireEvent(EventManager::ObjectEnteredZoneEvent, other, zone);
+   eventManager->setDeferred(false);
+   expectHeard(levelgen, "EELNE");
+
+   Vector<string> report;
+   eventManager->getEventReport(report);
+   EXPECT_EQ(3, report.size());     // ObjectEnteredZone, ObjectLeftZone, NexusOpened
+}
+
+
+// Two arenas sharing the process: what one game holds back goes to its own scripts when the other one takes over
+TEST(EventManagerTest, DeferredEventsStayInTheirGame)
+{
+   GamePair gamePair;
+   ServerGame *game = gamePair.server;
+   ServerGame *otherGame = newServerGame();
+
+   EventManager *eventManager = EventManager::get();
+   const Game *activeGame = eventManager->getActiveGame();
+
+   {
+      LuaLevelGenerator levelgen(game);
+      LuaLevelGenerator otherLevelgen(otherGame);
+      setUpListener(levelgen);
+      setUpListener(otherLevelgen);
+
+      ResourceItem *item = new ResourceItem();
+      LoadoutZone *zone = new LoadoutZone();
+      item->addToGame(game, game->getLevel());
+      zone->addToGame(game, game->getLevel());
+
+      eventManager->setActiveGame(game);
+      eventManager->setDeferred(true);
+      eventManager->fireEvent(EventManager::ObjectEnteredZoneEvent, item, zone);
+      expectHeard(levelgen, "");
+
+      // Switching games delivers what we held, to the game it came from, and ends deferred mode
+      eventManager->setActiveGame(otherGame);
+      EXPECT_FALSE(eventManager->isDeferred());
+      expectHeard(levelgen, "E");
+      expectHeard(otherLevelgen, "");
+
+      eventManager->fireEvent(EventManager::ObjectLeftZoneEvent, item, zone);
+      expectHeard(levelgen, "E");
+      expectHeard(otherLevelgen, "L");
+   }
+
+   eventManager->setActiveGame(activeGame);
+   delete otherGame;
+}
+
+
+};
@@ -0,0 +1,180 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "GameRecorder.h"
+#include "GameRecorderPlayback.h"
+
+#include "ClientGame.h"
+#include "Level.h"
+#include "moveObject.h"
+#include "ServerGame.h"
+#include "stringUtils.h"
+
+#include "TestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace std;
+using namespace TNL;
+
+
+static const string RecordingLevelCode =
+   "GameType 10 8\n"
+   "LevelName \"Recording Test\"\n"
+   "Team Bluey 0 0 1\n"
+   "Asteroid 3 3\n"
+   "Asteroid -3 2\n"
+   "Asteroid 2 -4\n"
+   "TestItem 1 -2\n";
+
+
+// Records about 25 seconds of play, long enough for a couple of keyframes, with objects coming and going in the
+// middle; returns the path of the recording
+static string recordGame()
+{
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   settings->setSetting(IniKey::GameRecording, Yes);
+   settings->setSetting<U32>(IniKey::RecordingCompression, 0);    // So we can cut the index off the end
+
+   GamePair gamePair(settings, RecordingLevelCode);
+   gamePair.addClient("Recorder");      // Nothing gets recorded while the game is suspended
+
+   GameRecorderServer *recorder = gamePair.server->getGameRecorder();
+   if(!recorder)
+      return "";
+
+   string filename = joindir(gamePair.server->getSettings()->getFolderManager()->getRecordDir(), recorder->mFileName);
+
+   GamePair::idle(20, 750);
+
+   // Make sure the keyframes have something to catch up on besides what the level started with
+   Vector<DatabaseObject *> asteroids;
+   gamePair.server->getLevel()->findObjects(AsteroidTypeNumber, asteroids);
+   if(asteroids.size() > 0)
+      static_cast<Asteroid *>(asteroids[0])->deleteObject();
+
+   TestItem *item = new TestItem();
+   item->setPos(Point(400, 400));
+   item->addToGame(gamePair.server, gamePair.server->getLevel());
+
+   GamePair::idle(20, 500);
+
+   return filename;     // Recorder writes its index when gamePair goes away
+}
+
+
+// Everything the client can see, in an order that doesn't depend on the order things arrived in
+static void getWorld(ClientGame *game, Vector<string> &world)
+{
+   world.clear();
+
+   const Vector<DatabaseObject *> *objects = game->getLevel()->findObjects_fast();
+
+   for(S32 i = 0; i < objects->size(); i++)
+   {
+      BfObject *obj = static_cast<BfObject *>(objects->get(i));
+
+      if(!obj->isDeleted())
+         world.push_back(itos(obj->getObjectTypeNumber()) + " " + obj->getPos().toString());
+   }
+
+   sort(world.getStlVector().begin(), world.getStlVector().end());
+}
+
+
+// Seeks to time, then plays from the start to the same time, and makes sure we end up looking at the same thing
+static void checkSeek(ClientGame *game, GameRecorderPlayback *playback, U32 time)
+{
+   SCOPED_TRACE("time = " + itos(time));
+
+   Vector<string> seekWorld, linearWorld;
+
+   playback->seek(time);
+   getWorld(game, seekWorld);
+   U32 seekTime = playback->mCurrentTime;
+
+   playback->restart();
+   playback->processMoreData(time);
+   getWorld(game, linearWorld);
+
+   EXPECT_EQ(playback->mCurrentTime, seekTime);
+   EXPECT_GT(seekWorld.size(), 3);
+   EXPECT_EQ(linearWorld.getStlVector(), seekWorld.getStlVector());
+}
+
+
+TEST(GameRecorderTest, SeekMatchesLinearPlayback)
+{
+   string filename = recordGame();
+   ASSERT_NE("", filename) << "Game was not recorded!";
+
+   GamePair gamePair;                           // Gets everything playback needs going
+
+   Vector<U32> keyframeTimes, keyframeOffsets;
+   U32 totalTime;
+
+   // With an index
+   {
+      ClientGame *game = newClientGame();
+      GameRecorderPlayback *playback = new GameRecorderPlayback(game, filename.c_str());
+      ASSERT_TRUE(playback->isValid());
+      game->setConnectionToServer(playback);
+
+      keyframeTimes = playback->mKeyframeTimes;
+      keyframeOffsets = playback->mKeyframeOffsets;
+      totalTime = playback->mTotalTime;
+
+      ASSERT_GE(keyframeTimes.size(), 2);
+      EXPECT_GE(totalTime, 24000);
+
+      // Between the keyframes, after the last one, then backwards
+      checkSeek(game, playback, 17345);
+      checkSeek(game, playback, totalTime - 500);
+      checkSeek(game, playback, 12000);
+
+      delete game;      // Takes playback with it
+   }
+
+   // Without one, like a recording from a server that went down, where we have to go looking for the keyframes
+   string contents;
+   ASSERT_TRUE(readFile(filename, contents));
+   ASSERT_GT(contents.size(), 8);
+
+   const U8 *end = (const U8 *)contents.c_str() + contents.size() - 8;
+   U32 indexPos = U32(end[0]) | (U32(end[1]) << 8) | (U32(end[2]) << 16) | (U32(end[3]) << 24);
+   ASSERT_LT(indexPos, contents.size());
+
+   FILE *f = fopen(filename.c_str(), "wb");
+   ASSERT_TRUE(f != NULL);
+   fwrite(contents.c_str(), 1, indexPos, f);
+   fclose(f);
+
+   {
+      ClientGame *game = newClientGame();
+      GameRecorderPlayback *playback = new GameRecorderPlayback(game, filename.c_str());
+      ASSERT_TRUE(playback->isValid());
+      game->setConnectionToServer(playback);
+
+      EXPECT_EQ(keyframeTimes.getStlVector(), playback->mKeyframeTimes.getStlVector());
+      EXPECT_EQ(keyframeOffsets.getStlVector(), playback->mKeyframeOffsets.getStlVector());
+      EXPECT_EQ(totalTime, playback->mTotalTime);
+
+      checkSeek(game, playback, 17345);
+      checkSeek(game, playback, 12000);
+
+      delete game;
+   }
+
+   remove(filename.c_str());
+}
+
+
+};
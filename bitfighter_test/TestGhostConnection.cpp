@@ -0,0 +1,63 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "ClientGame.h"
+#include "ClientInfo.h"
+#include "gameConnection.h"
+#include "Level.h"
+#include "moveObject.h"
+#include "ServerGame.h"
+#include "ship.h"
+
+#include "TestUtils.h"
+
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// Drop a pile of items around the ship all at once, then keep sending packets until they've all been ghosted.
+// Far more ghosts need updates than fit in a packet, so this exercises picking the highest priority ones
+// over many packets.
+TEST(GhostConnectionTest, GhostManyObjects)
+{
+   static const S32 ItemsPerSide = 24;
+   static const S32 ItemCount = ItemsPerSide * ItemsPerSide;
+   static const S32 MaxPackets = 1000;
+
+   GamePair gamePair;
+   ServerGame *serverGame = gamePair.server;
+   ClientGame *clientGame = gamePair.getClient(0);
+
+   GameConnection *conn = serverGame->getClientInfo(0)->getConnection();
+   Point center = serverGame->getClientInfo(0)->getShip()->getActualPos();
+
+   for(S32 x = 0; x < ItemsPerSide; x++)
+      for(S32 y = 0; y < ItemsPerSide; y++)
+      {
+         ResourceItem *item = new ResourceItem();
+         item->setActualPos(center + Point((x - ItemsPerSide / 2) * 25, (y - ItemsPerSide / 2) * 25));
+         item->addToGame(serverGame, serverGame->getLevel());
+      }
+
+   S32 packets = 0;
+
+   while(packets < MaxPackets && clientGame->getLevel()->getObjectCount(ResourceItemTypeNumber) < ItemCount)
+   {
+      conn->checkPacketSend(true, Platform::getRealMilliseconds());
+
+      packets++;
+      gamePair.idle(10);    // Deliver the packet, and get it acked
+   }
+
+   EXPECT_EQ(ItemCount, clientGame->getLevel()->getObjectCount(ResourceItemTypeNumber));
+}
+
+};
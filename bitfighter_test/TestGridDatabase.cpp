@@ -0,0 +1,197 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "gridDB.h"
+#include "Level.h"
+#include "BfObject.h"
+
+#include "LevelFilesForTesting.h"
+#include "TestUtils.h"
+
+#include "stringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+namespace Zap
+{
+
+using namespace std;
+using namespace TNL;
+
+
+// Builds a level that is much bigger than the default grid, with a wall every few cells and
+// items scattered everywhere else
+static string getLargeLevelCode(S32 cellsPerSide)
+{
+   string code = getGenericHeader();
+
+   for(S32 x = 0; x < cellsPerSide; x++)
+      for(S32 y = 0; y < cellsPerSide; y++)
+      {
+         if(x % 8 == 0 && y % 8 == 0)
+            code += "BarrierMaker 40 " + itos(x) + " " + itos(y) + " " + itos(x + 2) + " " + itos(y) + "\n";
+         else
+            code += "ResourceItem " + itos(x) + " " + itos(y) + "\n";
+      }
+
+   return code;
+}
+
+
+struct QueryStats
+{
+   S32 queries;
+   S32 found;
+   S32 bucketEntriesWalked;
+
+   QueryStats() { queries = 0; found = 0; bucketEntriesWalked = 0; }
+};
+
+
+// Sweep a query window across the whole level, collecting everything we find in results
+static QueryStats runQueries(const GridDatabase &db, const Rect &levelExtents, F32 windowSize,
+                             Vector<Vector<DatabaseObject *> > &results)
+{
+   QueryStats stats;
+   Vector<DatabaseObject *> found;
+
+   results.clear();
+
+   for(F32 x = levelExtents.min.x; x < levelExtents.max.x; x += windowSize / 2)
+      for(F32 y = levelExtents.min.y; y < levelExtents.max.y; y += windowSize / 2)
+      {
+         Rect queryRect(Point(x, y), Point(x + windowSize, y + windowSize));
+
+         found.clear();
+         db.findObjects((TestFunc)isAnyObjectType, found, queryRect);
+
+         stats.queries++;
+         stats.found += found.size();
+         stats.bucketEntriesWalked += db.countBucketEntries(queryRect);
+         results.push_back(found);
+      }
+
+   return stats;
+}
+
+
+// Runs the same queries with the default grid and with a grid sized to the level; results must match, and the sized
+// grid must not make us look at more bucket entries to find them
+static void compareGridLayouts(const string &levelCode, const string &label)
+{
+   bool adaptive = GridDatabase::getAdaptiveBucketSizing();
+   GridDatabase::setAdaptiveBucketSizing(false);
+   Level level(levelCode);
+   GridDatabase::setAdaptiveBucketSizing(adaptive);
+
+   ASSERT_EQ(GridDatabase::DefaultBucketRowCount, level.getBucketRowCount());
+
+   Rect extents = level.getExtents();
+   Vector<Vector<DatabaseObject *> > fixedResults, adaptiveResults;
+
+   QueryStats fixedStats = runQueries(level, extents, 600, fixedResults);
+
+   level.sizeBucketsToExtents(extents);
+   QueryStats adaptiveStats = runQueries(level, extents, 600, adaptiveResults);
+
+   ASSERT_EQ(fixedResults.size(), adaptiveResults.size());
+   for(S32 i = 0; i < fixedResults.size(); i++)
+   {
+      // Order depends on bucket layout; contents should not
+      sort(fixedResults[i].getStlVector().begin(), fixedResults[i].getStlVector().end());
+      sort(adaptiveResults[i].getStlVector().begin(), adaptiveResults[i].getStlVector().end());
+      ASSERT_EQ(fixedResults[i].getStlVector(), adaptiveResults[i].getStlVector()) << label << ", query " << i;
+   }
+
+   EXPECT_LE(adaptiveStats.bucketEntriesWalked, fixedStats.bucketEntriesWalked) << label;
+}
+
+
+TEST(GridDatabaseTest, SizeBucketsToExtents)
+{
+   GridDatabase db;
+
+   // Small levels keep the default layout
+   db.sizeBucketsToExtents(Rect(Point(0, 0), Point(1000, 1000)));
+   EXPECT_EQ(GridDatabase::DefaultBucketRowCount, db.getBucketRowCount());
+   EXPECT_EQ(GridDatabase::DefaultBucketWidthBitShift, db.getBucketWidthBitShift());
+
+   // 10,000 pixels needs 40 default-width buckets; next power of 2 is 64
+   db.sizeBucketsToExtents(Rect(Point(-5000, -5000), Point(5000, 5000)));
+   EXPECT_EQ(64, db.getBucketRowCount());
+   EXPECT_EQ(GridDatabase::DefaultBucketWidthBitShift, db.getBucketWidthBitShift());
+
+   // Really huge levels max out the row count, then widen the buckets
+   db.sizeBucketsToExtents(Rect(Point(0, 0), Point(200000, 1000)));
+   EXPECT_EQ(GridDatabase::MaxBucketRowCount, db.getBucketRowCount());
+   EXPECT_GT(db.getBucketWidthBitShift(), GridDatabase::DefaultBucketWidthBitShift);
+   EXPECT_LE(200000 >> db.getBucketWidthBitShift(), GridDatabase::MaxBucketRowCount);
+}
+
+
+// Searches should be able to nest, and objects spanning many buckets should only be reported once
+TEST(GridDatabaseTest, NestedSearches)
+{
+   Level level(getLargeLevelCode(16));
+   Rect extents = level.getExtents();
+
+   FillVector outer;
+   level.findObjects((TestFunc)isAnyObjectType, outer, extents);
+   ASSERT_EQ(level.getObjectCount(), outer.size());
+
+   Vector<DatabaseObject *> sorted = outer;
+   sort(sorted.getStlVector().begin(), sorted.getStlVector().end());
+   EXPECT_TRUE(adjacent_find(sorted.getStlVector().begin(), sorted.getStlVector().end()) == sorted.getStlVector().end());
+
+   for(S32 i = 0; i < outer.size(); i++)
+   {
+      FillVector inner;
+      level.findObjects((TestFunc)isAnyObjectType, inner, outer[i]->getExtent());
+
+      // Each object should at least find itself, and the outer list should be left alone
+      EXPECT_TRUE(inner.contains(outer[i]));
+      ASSERT_EQ(level.getObjectCount(), outer.size());
+   }
+}
+
+
+// Anything that could change search results should change the change count
+TEST(GridDatabaseTest, ChangeCount)
+{
+   Level level(getLargeLevelCode(4));
+   BfObject *obj = static_cast<BfObject *>(level.getObjectByIndex(level.getObjectCount() - 1));
+
+   U32 count = level.getChangeCount();
+   Vector<DatabaseObject *> found;
+   level.findObjects((TestFunc)isAnyObjectType, found, level.getExtents());
+   EXPECT_EQ(count, level.getChangeCount());                // Searching changes nothing
+
+   Rect extent = obj->getExtent();
+   extent.offset(Point(1, 1));
+   obj->setExtent(extent);
+   EXPECT_NE(count, level.getChangeCount());                // Moving something does
+
+   count = level.getChangeCount();
+   level.removeFromDatabase(obj, true);
+   EXPECT_NE(count, level.getChangeCount());                // As does removing it
+}
+
+
+// Compares the default grid with one sized to the level
+TEST(GridDatabaseTest, CompareLayouts)
+{
+   pair<Vector<string>, Vector<LevelInfo> > levels = getLevels();
+
+   for(S32 i = 0; i < levels.first.size(); i++)
+      compareGridLayouts(levels.first[i], "Test level " + itos(i));
+
+   compareGridLayouts(getLevelCode1(), "Level code 1");
+   compareGridLayouts(getLargeLevelCode(48), "Large level");
+}
+
+
+};
@@ -6,6 +6,8 @@
 #include "gtest/gtest.h"
 
 #include "../zap/config.h"
+#include "../zap/GameSettings.h"
+#include "../zap/IniFile.h"
 
 namespace Zap
 {
@@ -53,4 +55,29 @@ TEST(INISettingsTest, PackUnpack)
    ASSERT_EQ(IniSettings::bitArrayToIniString(items, count), vals);
 }   
 
+
+TEST(INISettingsTest, ArenaSettings)
+{
+   GameSettings settings;
+   settings.getIniSettings()->mSettings.setVal(IniKey::Arenas, string(" ctf, soccer ,ctf,,"));
+
+   // Blanks and duplicates are dropped
+   Vector<string> arenaNames = settings.getArenaNames();
+   ASSERT_EQ(2, arenaNames.size());
+   EXPECT_EQ("ctf",    arenaNames[0]);
+   EXPECT_EQ("soccer", arenaNames[1]);
+
+   // An arena's section overrides [Host], and everything else comes from the main settings
+   CIniFile ini;
+   ini.setValue("Host", "ServerName", "Main server");
+   ini.setValue("Host", "MaxPlayers", "16");
+   ini.setValue(GameSettings::getArenaSection("ctf"), "ServerName", "CTF arena");
+
+   GameSettings arenaSettings;
+   loadArenaSettingsFromINI(&ini, &arenaSettings, GameSettings::getArenaSection("ctf"));
+
+   EXPECT_EQ("CTF arena", arenaSettings.getSetting<string>(IniKey::ServerName));
+   EXPECT_EQ(16U,         arenaSettings.getSetting<U32>(IniKey::MaxPlayers));
+}
+
 };
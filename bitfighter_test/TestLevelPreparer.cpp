@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelPreparer.h"
+
+#include "BotNavMeshZone.h"
+#include "gameType.h"
+#include "Level.h"
+#include "ServerGame.h"
+
+#include "LevelFilesForTesting.h"
+#include "TestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+static const char *TestFileName = "level_preparer_test.level";
+
+
+static void writeTestFile(const string &levelCode)
+{
+   FILE *file = fopen(TestFileName, "wb");
+   ASSERT_TRUE(file != NULL);
+
+   fwrite(levelCode.c_str(), 1, levelCode.length(), file);
+   fclose(file);
+}
+
+
+// A prepared level should be just like one loaded the usual way, zones and all
+TEST(LevelPreparerTest, SameAsUsualLoad)
+{
+   Vector<string> levelCodes = getLevels().first;
+
+   for(S32 i = 0; i < levelCodes.size(); i++)
+   {
+      writeTestFile(levelCodes[i]);
+
+      LevelPreparer preparer(i, TestFileName, 0, false, false, false, false);
+      preparer.start();
+
+      Level *level = preparer.takeLevel();
+      ASSERT_TRUE(level != NULL) << "level " << i;
+      EXPECT_EQ(LevelPreparer::Ready, preparer.getStage());
+
+      Level usualLevel(levelCodes[i]);
+      EXPECT_EQ(usualLevel.getHash(), level->getHash()) << "level " << i;
+      EXPECT_EQ(usualLevel.findObjects_fast()->size(), level->findObjects_fast()->size()) << "level " << i;
+
+      ServerGame *game = newServerGame(levelCodes[i]);
+      game->addObjectsToGame();
+      game->buildBotMeshZones(false);
+
+      EXPECT_TRUE(preparer.hasBotZones());
+      EXPECT_EQ(game->getGameType()->mBotZoneCreationFailed, preparer.getZoneCreationFailed()) << "level " << i;
+      EXPECT_EQ(game->getBotZoneList().size(), level->getBotZoneList().size()) << "level " << i;
+      EXPECT_FALSE(preparer.getZonesFromCache());
+
+      delete game;
+      delete level;
+   }
+
+   remove(TestFileName);
+}
+
+
+TEST(LevelPreparerTest, MissingFile)
+{
+   remove(TestFileName);
+
+   LevelPreparer preparer(0, TestFileName, 0, false, false, false, false);
+   preparer.start();
+
+   EXPECT_TRUE(preparer.takeLevel() == NULL);
+   EXPECT_EQ(LevelPreparer::Failed, preparer.getStage());
+}
+
+
+// With global levelgens running, zones wait until the level is in play
+TEST(LevelPreparerTest, NoZonesWithLevelgens)
+{
+   writeTestFile(getLevelCode1());
+
+   LevelPreparer preparer(0, TestFileName, 0, true, false, false, false);
+   preparer.start();
+
+   Level *level = preparer.takeLevel();
+   ASSERT_TRUE(level != NULL);
+   EXPECT_FALSE(preparer.hasBotZones());
+   EXPECT_EQ(0, level->getBotZoneList().size());
+
+   delete level;
+   remove(TestFileName);
+}
+
+
+};
@@ -9,6 +9,7 @@
 #include "gameType.h"
 #include "Level.h"
 #include "luaLevelGenerator.h"
+#include "LuaProfiler.h"
 #include "SystemFunctions.h"
 
 #include "gtest/gtest.h"
@@ -131,6 +132,24 @@ TEST_F(LuaEnvironmentTest, immutability)
 }
 
 
+// A script that won't return gets stopped, even if it tries to catch the error that stops it
+TEST_F(LuaEnvironmentTest, callTimeLimit)
+{
+   settings->setSetting<U32>(IniKey::ScriptCallTimeLimit, 50);
+
+   // The call back into C++ keeps LuaJIT from compiling the loop, which would take it out of the watchdog's reach
+   EXPECT_TRUE(levelgen->runString("function spin() while true do bf:getPlayerCount() end end"));
+   EXPECT_TRUE(levelgen->runString("function spinSafely() while true do pcall(spin) end end"));
+
+   EXPECT_TRUE(levelgen->runFunction("spin", 0));           // runFunction() returns true on error
+   EXPECT_TRUE(levelgen->runFunction("spinSafely", 0));
+
+   // The next call gets its own time
+   EXPECT_TRUE(levelgen->runString("function quick() return 1 end"));
+   EXPECT_FALSE(levelgen->runFunction("quick", 0));
+}
+
+
 TEST_F(LuaEnvironmentTest, findAllObjects)
 {
    EXPECT_TRUE(levelgen->runString("t = bf:findAllObjects()"));
@@ -159,4 +178,88 @@ TEST_F(LuaEnvironmentTest, findAllObjects)
 }
 
 
+TEST_F(LuaEnvironmentTest, findAllObjectsFillTable)
+{
+   EXPECT_TRUE(levelgen->runString("bf:addItem(ResourceItem.new(point.new(0,0)))"));
+   EXPECT_TRUE(levelgen->runString("bf:addItem(ResourceItem.new(point.new(300,300)))"));
+   EXPECT_TRUE(levelgen->runString("bf:addItem(TestItem.new(point.new(200,200)))"));
+
+   // Results go into the table we pass in, replacing whatever was there
+   EXPECT_TRUE(levelgen->runString("t = { 1, 2, 3, 4, 5 }"));
+   EXPECT_TRUE(levelgen->runString("u = bf:findAllObjects(t)"));
+   EXPECT_TRUE(levelgen->runString("assert(u == t)"));
+   EXPECT_TRUE(levelgen->runString("assert(#t == 3 and t[4] == nil and t[5] == nil)"));
+   EXPECT_TRUE(levelgen->runString("bf:findAllObjects(t, ObjType.ResourceItem)"));
+   EXPECT_TRUE(levelgen->runString("assert(#t == 2 and t[3] == nil)"));
+
+   EXPECT_TRUE(levelgen->runString("bf:findAllObjectsInArea(t, point.new(-10,-10), point.new(10,10), ObjType.ResourceItem)"));
+   EXPECT_TRUE(levelgen->runString("assert(#t == 1)"));
+
+   // Without a table of our own, we get a new one, with just the objects in the area
+   EXPECT_TRUE(levelgen->runString("t = bf:findAllObjectsInArea(point.new(-10,-10), point.new(400,400), ObjType.ResourceItem)"));
+   EXPECT_TRUE(levelgen->runString("assert(#t == 2)"));
+
+   // An object pushed twice is the same userdata both times
+   EXPECT_TRUE(levelgen->runString("a = bf:findAllObjects(ObjType.TestItem)"));
+   EXPECT_TRUE(levelgen->runString("b = bf:findAllObjects(ObjType.TestItem)"));
+   EXPECT_TRUE(levelgen->runString("assert(a ~= b and a[1] == b[1] and rawequal(a[1], b[1]))"));
+}
+
+
+// Bytes the Lua state allocates, per search, searching with the given function.  The collector is stopped, so nothing
+// gets freed along the way, and running the function with no searches tells us what the call itself costs.
+static F64 bytesPerSearch(LuaLevelGenerator *levelgen, lua_State *L, const string &function, S32 searches)
+{
+   string emptyRun = function + "(0)";
+   string fullRun  = function + "(" + itos(searches) + ")";
+
+   // Once through first, so any strings and such it needs are already made
+   EXPECT_TRUE(levelgen->runString(fullRun));
+
+   lua_gc(L, LUA_GCCOLLECT, 0);
+   lua_gc(L, LUA_GCSTOP, 0);
+
+   S32 start = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+   EXPECT_TRUE(levelgen->runString(emptyRun));
+   S32 overhead = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0) - start;
+
+   start = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+   EXPECT_TRUE(levelgen->runString(fullRun));
+   S32 total = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0) - start;
+
+   lua_gc(L, LUA_GCRESTART, 0);
+
+   return F64(total - overhead) / searches;
+}
+
+
+// How much garbage a script searching every tick makes
+TEST_F(LuaEnvironmentTest, findAllObjectsAllocations)
+{
+   const S32 ObjectCount = 50;
+   const S32 Searches = 2000;
+
+   EXPECT_TRUE(levelgen->runString("for i = 1, " + itos(ObjectCount) + " do "
+                                   "bf:addItem(ResourceItem.new(point.new(i * 10, 0))) end"));
+
+   EXPECT_TRUE(levelgen->runString("function newTables(n) "
+                                   "for i = 1, n do local t = bf:findAllObjects(ObjType.ResourceItem) end end"));
+   EXPECT_TRUE(levelgen->runString("results = { } function sameTable(n) "
+                                   "for i = 1, n do bf:findAllObjects(results, ObjType.ResourceItem) end end"));
+
+   // Compiled traces allocate too; keep to the interpreter so we only count what the searches make
+   LuaProfiler::setJitEnabled(L, false);
+
+   F64 newTableBytes  = bytesPerSearch(levelgen, L, "newTables", Searches);
+   F64 sameTableBytes = bytesPerSearch(levelgen, L, "sameTable", Searches);
+
+   LuaProfiler::setJitEnabled(L, true);
+
+   // A new table needs room for every object; pushing the objects themselves shouldn't cost anything once they've been
+   // pushed before
+   EXPECT_GE(newTableBytes, ObjectCount * sizeof(void *));
+   EXPECT_LT(sameTableBytes, 1.0);
+}
+
+
 };
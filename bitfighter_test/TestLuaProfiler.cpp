@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LuaProfiler.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+static LuaProfiler *profiler;
+
+
+// Stands in for the instruction hook LuaScriptRunner sets
+static void sampleHook(lua_State *L, lua_Debug *ar)
+{
+   profiler->sample(L);
+}
+
+
+// Stands in for a C++ method called from a script; burns a bit of time
+static int slowBinding(lua_State *L)
+{
+   LuaProfiler::BindingCall profile(L, "Robot");
+
+   volatile U32 x = 0;
+   for(S32 i = 0; i < 200000; i++)
+      x += i;
+
+   return 0;
+}
+
+
+static bool profileHas(const Vector<string> &lines, const string &name)
+{
+   for(S32 i = 0; i < lines.size(); i++)
+      if(lines[i].find(name) != string::npos)
+         return true;
+
+   return false;
+}
+
+
+TEST(LuaProfilerTest, ChargesLuaAndCpp)
+{
+   lua_State *L = lua_open();
+   luaL_openlibs(L);
+
+   lua_register(L, "getWaypoint", slowBinding);
+
+   // Like a script loaded from s_bot.bot
+   const char *script = 
+         "function busy()                      \n"
+         "   local x = 0                       \n"
+         "   for i = 1, 20000 do               \n"
+         "      x = x + math.sin(i)            \n"
+         "   end                               \n"
+         "end                                  \n"
+         "function onTick()                    \n"
+         "   for i = 1, 20 do                  \n"
+         "      busy()                         \n"
+         "      getWaypoint()                  \n"
+         "   end                               \n"
+         "end                                  \n";
+
+   ASSERT_EQ(0, luaL_loadbuffer(L, script, strlen(script), "@scripts/s_bot.bot") || lua_pcall(L, 0, 0, 0));
+
+   profiler = new LuaProfiler();
+   LuaProfiler::setCurrent(profiler);
+   LuaProfiler::setJitEnabled(L, false);
+
+   lua_sethook(L, sampleHook, LUA_MASKCOUNT, 100);
+   profiler->beginCall("onTick");
+
+   lua_getglobal(L, "onTick");
+   ASSERT_EQ(0, lua_pcall(L, 0, 0, 0));
+
+   profiler->endCall();
+   lua_sethook(L, NULL, 0, 0);
+   LuaProfiler::setCurrent(NULL);
+
+   EXPECT_GT(profiler->getTotalTime(), 0);
+
+   Vector<string> lines;
+   profiler->getFlatProfile(lines);
+
+   EXPECT_TRUE(profileHas(lines, "onTick@s_bot.bot:7"));
+   EXPECT_TRUE(profileHas(lines, "busy@s_bot.bot:1"));
+   EXPECT_TRUE(profileHas(lines, "Robot:getWaypoint"));
+
+   // Folded stacks, one per line, outermost function first
+   const char *filename = "lua_profiler_test.folded";
+   ASSERT_TRUE(profiler->writeFoldedStacks(filename));
+
+   FILE *f = fopen(filename, "r");
+   ASSERT_TRUE(f != NULL);
+
+   bool foundBinding = false;
+   char line[1024];
+
+   while(fgets(line, sizeof(line), f))
+   {
+      string stack = line;
+      EXPECT_EQ(0, stack.find("onTick@s_bot.bot:7")) << stack;
+
+      if(stack.find(";Robot:getWaypoint ") != string::npos)
+         foundBinding = true;
+   }
+
+   fclose(f);
+   remove(filename);
+
+   EXPECT_TRUE(foundBinding);
+
+   delete profiler;
+   lua_close(L);
+}
+
+
+};
@@ -8,6 +8,10 @@
 #include "TestUtils.h"
 
 #include "../master/master.h"
+#include "../master/ServerRegistry.h"
+#include "../master/LobbyChat.h"
+#include "../master/MasterServerConnection.h"
+#include "../zap/version.h"
 #include "ClientGame.h"
 
 namespace Zap
@@ -33,5 +37,302 @@ TEST(MasterTest, Sanity)
 //   Master::MasterServerConnection *masterConnection = dynamic_cast<Master::MasterServerConnection *>(clientConnection->getRemoteConnectionObject());
 //   EXPECT_TRUE(masterConnection != NULL);
 }
-	
+
+
+static S32 countServers(const ServerRegistry::QueryResponse &response)
+{
+   S32 count = 0;
+
+   for(S32 i = 0; i < response.addresses.size(); i++)
+   {
+      EXPECT_LE(response.addresses[i].size(), IP_MESSAGE_ADDRESS_COUNT);
+      EXPECT_EQ(response.addresses[i].size(), response.serverIds[i].size());
+      count += response.serverIds[i].size();
+   }
+
+   return count;
+}
+
+
+static bool responseHasServer(const ServerRegistry::QueryResponse &response, S32 clientId)
+{
+   for(S32 i = 0; i < response.serverIds.size(); i++)
+      if(response.serverIds[i].contains(clientId))
+         return true;
+
+   return false;
+}
+
+
+TEST(MasterTest, ServerRegistry)
+{
+   MasterSettings masterSettings("");
+   masterSettings.mSettings.setVal(Master::IniKey::JsonOutfile, string(""));
+   MasterServer master(&masterSettings);     // Connections expect one to be around when they go away
+
+   ServerRegistry registry;
+   Vector<RefPtr<Master::MasterServerConnection> > servers;
+
+   // 54 regular and 6 host mode servers on protocol 40, 9 and 1 on protocol 39
+   for(S32 i = 0; i < 70; i++)
+   {
+      Master::MasterServerConnection *server = new Master::MasterServerConnection();
+      server->mCSProtocolVersion = i < 60 ? 40 : 39;
+      server->mInfoFlags = i % 10 == 0 ? HostModeFlag : 0;
+
+      servers.push_back(server);
+      registry.add(server);
+   }
+
+   EXPECT_EQ(70, registry.getServers()->size());
+   EXPECT_EQ(70, registry.getListedServers()->size());
+
+   EXPECT_EQ(2, registry.getQueryResponse(40, false).addresses.size());
+   EXPECT_EQ(54, countServers(registry.getQueryResponse(40, false)));
+   EXPECT_EQ(6,  countServers(registry.getQueryResponse(40, true)));
+   EXPECT_EQ(9,  countServers(registry.getQueryResponse(39, false)));
+   EXPECT_EQ(1,  countServers(registry.getQueryResponse(39, true)));
+   EXPECT_EQ(0,  countServers(registry.getQueryResponse(41, false)));
+
+   // Asking again doesn't cost anything
+   U32 built = registry.getResponsesBuilt();
+   EXPECT_EQ(4, built);
+   EXPECT_EQ(54, countServers(registry.getQueryResponse(40, false)));
+   EXPECT_EQ(built, registry.getResponsesBuilt());
+
+   // Updating a server that hasn't changed how it's listed doesn't either
+   servers[1]->mPlayerCount = 5;
+   registry.update(servers[1]);
+   EXPECT_EQ(54, countServers(registry.getQueryResponse(40, false)));
+   EXPECT_EQ(built, registry.getResponsesBuilt());
+
+   // Hidden servers drop out of their group, and only that group gets rebuilt
+   servers[1]->mIsIgnoredFromList = true;
+   registry.update(servers[1]);
+   EXPECT_EQ(53, countServers(registry.getQueryResponse(40, false)));
+   EXPECT_EQ(6,  countServers(registry.getQueryResponse(40, true)));
+   EXPECT_EQ(built + 1, registry.getResponsesBuilt());
+   EXPECT_FALSE(responseHasServer(registry.getQueryResponse(40, false), servers[1]->getClientId()));
+   EXPECT_EQ(69, registry.getListedServers()->size());
+   EXPECT_EQ(70, registry.getServers()->size());
+
+   // Switching to host mode moves a server between groups
+   servers[2]->mInfoFlags = HostModeFlag;
+   registry.update(servers[2]);
+   EXPECT_EQ(52, countServers(registry.getQueryResponse(40, false)));
+   EXPECT_EQ(7,  countServers(registry.getQueryResponse(40, true)));
+   EXPECT_TRUE(responseHasServer(registry.getQueryResponse(40, true), servers[2]->getClientId()));
+
+   // Leaving
+   registry.remove(servers[60]);
+   registry.remove(servers[1]);
+   EXPECT_EQ(0, countServers(registry.getQueryResponse(39, true)));
+   EXPECT_EQ(68, registry.getServers()->size());
+   EXPECT_EQ(68, registry.getListedServers()->size());
+
+   // Coming back from hiding
+   servers[1]->mIsIgnoredFromList = false;
+   registry.update(servers[1]);     // Not registered any more, so nothing happens
+   EXPECT_EQ(52, countServers(registry.getQueryResponse(40, false)));
+
+   for(S32 i = 0; i < servers.size(); i++)
+      registry.remove(servers[i]);
+
+   EXPECT_EQ(0, registry.getServers()->size());
+   EXPECT_EQ(0, countServers(registry.getQueryResponse(40, false)));
+}
+
+
+// Just enough of a client to take part in lobby chat; keeps track of who it thinks is there and what it's heard
+class LobbyTestClient : public MasterServerInterface
+{
+   typedef MasterServerInterface Parent;
+
+public:
+   string name;
+   std::set<string> lobby;
+   S32 clientId;
+
+   S32 rpcsReceived;          // Each batch or member list counts as one
+   S32 eventsReceived;
+   S32 chatsReceived;
+
+   LobbyTestClient(const string &name = "") : name(name)
+   {
+      clientId = 0;
+      rpcsReceived = 0;
+      eventsReceived = 0;
+      chatsReceived = 0;
+   }
+
+   void writeConnectRequest(BitStream *bstream)
+   {
+      Parent::writeConnectRequest(bstream);
+
+      bstream->write(U32(MASTER_PROTOCOL_VERSION));
+      bstream->write(U32(CS_PROTOCOL_VERSION));
+      bstream->write(U32(BUILD_VERSION));
+      bstream->writeEnum(MasterConnectionTypeClient, MasterConnectionTypeCount);
+
+      bstream->writeString("");              // Controller
+      bstream->writeString(name.c_str());
+      bstream->writeString("");              // Password
+      bstream->writeInt(0, 8);               // Flags
+
+      Nonce id;
+      id.getRandom();
+      id.write(bstream);
+   }
+
+   bool readConnectAccept(BitStream *stream, NetConnection::TerminationReason &reason)
+   {
+      if(!Parent::readConnectAccept(stream, reason))
+         return false;
+
+      stream->read(&clientId);
+      return true;
+   }
+
+   TNL_DECLARE_RPC_OVERRIDE(m2cPlayersInGlobalChat, (Vector<StringTableEntry> playerNicks));
+   TNL_DECLARE_RPC_OVERRIDE(m2cLobbyChatEvents, (Vector<U8> eventTypes, Vector<StringTableEntry> playerNicks, Vector<string> messages));
+   TNL_DECLARE_NETCONNECTION(LobbyTestClient);
+};
+
+
+TNL_IMPLEMENT_RPC_OVERRIDE(LobbyTestClient, m2cPlayersInGlobalChat, (Vector<StringTableEntry> playerNicks))
+{
+   rpcsReceived++;
+
+   lobby.clear();
+   for(S32 i = 0; i < playerNicks.size(); i++)
+      lobby.insert(playerNicks[i].getString());
+}
+
+
+TNL_IMPLEMENT_RPC_OVERRIDE(LobbyTestClient, m2cLobbyChatEvents, 
+                          (Vector<U8> eventTypes, Vector<StringTableEntry> playerNicks, Vector<string> messages))
+{
+   rpcsReceived++;
+   eventsReceived += eventTypes.size();
+
+   S32 messageCount = 0;
+
+   for(S32 i = 0; i < eventTypes.size(); i++)
+   {
+      if(eventTypes[i] == LobbyChatPlayerJoined)
+         lobby.insert(playerNicks[i].getString());
+      else if(eventTypes[i] == LobbyChatPlayerLeft || eventTypes[i] == LobbyChatClientDisconnected)
+         lobby.erase(playerNicks[i].getString());
+      else if(eventTypes[i] == LobbyChatMessage)
+         messageCount++;
+   }
+
+   EXPECT_EQ(eventTypes.size(), playerNicks.size());
+   EXPECT_EQ(messageCount, messages.size());
+   chatsReceived += messageCount;
+}
+
+
+TNL_IMPLEMENT_NETCONNECTION(LobbyTestClient, NetClassGroupMaster, false);
+
+
+// Runs the master, and the clients' end of their connections, for one tick
+static void pump(MasterServer &master, NetInterface &clientInterface)
+{
+   clientInterface.processConnections();
+   master.idle(5);
+   Platform::sleep(1);
+}
+
+
+// Do the first count clients each see lobbySize others in lobby chat?
+static bool lobbiesAreSize(const Vector<RefPtr<LobbyTestClient> > &clients, S32 count, U32 lobbySize)
+{
+   for(S32 i = 0; i < count; i++)
+      if(clients[i]->lobby.size() != lobbySize)
+         return false;
+
+   return true;
+}
+
+
+// Has everyone heard what the first talkers clients said?  Nobody hears themselves.
+static bool chatsAllReceived(const Vector<RefPtr<LobbyTestClient> > &clients, S32 talkers)
+{
+   for(S32 i = 0; i < clients.size(); i++)
+      if(clients[i]->chatsReceived != (i < talkers ? talkers - 1 : talkers))
+         return false;
+
+   return true;
+}
+
+
+// A crowd of clients in lobby chat, all connected in process; each should get a single message a tick, no matter
+// how much is going on.  master_loadtest does this with thousands.
+TEST(MasterTest, LobbyChatLoad)
+{
+   const S32 ClientCount = 200;
+   const S32 Talkers = 20;
+   const U32 Timeout = 10000;
+
+   MasterSettings masterSettings("");
+   masterSettings.mSettings.setVal(Master::IniKey::JsonOutfile, string(""));     // Don't leave a server.json behind
+   MasterServer master(&masterSettings);
+   NetInterface clientInterface(Address(IPProtocol, Address::Any, 0));
+
+   Vector<RefPtr<LobbyTestClient> > clients;
+
+   for(S32 i = 0; i < ClientCount; i++)
+   {
+      LobbyTestClient *client = new LobbyTestClient("LobbyLoad" + itos(i));
+      clients.push_back(client);
+
+      ASSERT_TRUE(client->connectLocal(&clientInterface, master.getNetInterface(), new Master::MasterServerConnection()));
+   }
+
+   EXPECT_EQ(ClientCount, master.getClientList()->size());
+
+   // Everyone joins lobby chat, and should end up seeing everyone else there
+   for(S32 i = 0; i < ClientCount; i++)
+      clients[i]->c2mJoinGlobalChat();
+
+   U32 start = Platform::getRealMilliseconds();
+   while(!lobbiesAreSize(clients, ClientCount, ClientCount - 1) && Platform::getRealMilliseconds() - start < Timeout)
+      pump(master, clientInterface);
+
+   EXPECT_TRUE(lobbiesAreSize(clients, ClientCount, ClientCount - 1));
+   EXPECT_EQ(ClientCount, master.getLobbyChat()->getMembers()->size());
+
+   // Some of them talk
+   for(S32 i = 0; i < Talkers; i++)
+      clients[i]->c2mSendChat("Hello lobby!");
+
+   start = Platform::getRealMilliseconds();
+   while(!chatsAllReceived(clients, Talkers) && Platform::getRealMilliseconds() - start < Timeout)
+      pump(master, clientInterface);
+
+   EXPECT_TRUE(chatsAllReceived(clients, Talkers));
+
+   // Then half of them leave, which takes a second to go through
+   for(S32 i = ClientCount / 2; i < ClientCount; i++)
+      clients[i]->c2mLeaveGlobalChat();
+
+   start = Platform::getRealMilliseconds();
+   while(!lobbiesAreSize(clients, ClientCount / 2, ClientCount / 2 - 1) && Platform::getRealMilliseconds() - start < Timeout)
+      pump(master, clientInterface);
+
+   EXPECT_TRUE(lobbiesAreSize(clients, ClientCount / 2, ClientCount / 2 - 1));
+   EXPECT_EQ(ClientCount / 2, master.getLobbyChat()->getMembers()->size());
+
+   for(S32 i = 0; i < ClientCount / 2; i++)
+   {
+      EXPECT_EQ(0, clients[i]->lobby.count(clients[i]->name));                    // Never see ourselves
+      EXPECT_EQ(0, clients[i]->lobby.count(clients[ClientCount - 1 - i]->name));  // Nor anyone who left
+   }
+
+   // Each client heard about thousands of things, but in only a handful of messages
+   for(S32 i = 0; i < ClientCount; i++)
+      EXPECT_LT(clients[i]->rpcsReceived * 20, clients[i]->eventsReceived);
+}
+
 };
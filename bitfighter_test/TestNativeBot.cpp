@@ -0,0 +1,145 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotController.h"
+
+#include "ClientGame.h"
+#include "ClientInfo.h"
+#include "robot.h"
+#include "ServerGame.h"
+
+#include "TestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+namespace Zap
+{
+
+using namespace std;
+using namespace TNL;
+
+
+// Counts what it hears
+class CountingController : public BotController
+{
+public:
+   static S32 ticks;
+   static S32 playersJoined;
+
+   static BotController *create(const Vector<string> &args)
+   {
+      return new CountingController();
+   }
+
+   string getName()
+   {
+      return "Counter";
+   }
+
+   void onTick(const WorldView &view, Move &move)
+   {
+      ticks++;
+   }
+
+   void onPlayerJoined(LuaPlayerInfo *player)
+   {
+      playersJoined++;
+   }
+};
+
+S32 CountingController::ticks = 0;
+S32 CountingController::playersJoined = 0;
+
+
+static Vector<string> getBotArgs(const string &scriptName)
+{
+   Vector<string> args;
+   args.push_back("0");
+   args.push_back(scriptName);
+
+   return args;
+}
+
+
+TEST(NativeBotTest, AddNativeBot)
+{
+   GamePair gamePair;
+
+   EXPECT_EQ("", gamePair.server->addBot(getBotArgs("native:s_bot"), ClientInfo::ClassRobotAddedByAddbots));
+   gamePair.idle(10, 10);
+
+   ASSERT_EQ(1, gamePair.server->getBotCount());
+   EXPECT_EQ(1, gamePair.getClient(0)->getRobotCount());
+
+   Robot *bot = gamePair.server->getBot(0);
+   EXPECT_TRUE(bot->getController() != NULL);
+   EXPECT_FALSE(bot->hasOwnLuaState());
+
+   string name = bot->getClientInfo()->getName().getString();
+   EXPECT_NE(string::npos, name.find("[s_bot]")) << name;
+
+   // Let it play for a bit; it should not fall over
+   gamePair.idle(20, 50);
+   EXPECT_EQ(1, gamePair.server->getBotCount());
+}
+
+
+TEST(NativeBotTest, UnknownNativeBot)
+{
+   GamePair gamePair;
+
+   string error = gamePair.server->addBot(getBotArgs("native:nope"), ClientInfo::ClassRobotAddedByAddbots);
+   EXPECT_EQ(0, error.find("!!!")) << error;
+
+   gamePair.idle(10, 5);
+   EXPECT_EQ(0, gamePair.server->getBotCount());
+}
+
+
+TEST(NativeBotTest, TicksAndEvents)
+{
+   BotController::registerFactory("counter", CountingController::create);
+   CountingController::ticks = 0;
+   CountingController::playersJoined = 0;
+
+   GamePair gamePair;
+
+   EXPECT_EQ("", gamePair.server->addBot(getBotArgs("native:counter"), ClientInfo::ClassRobotAddedByAddbots));
+   gamePair.idle(10, 20);
+
+   ASSERT_EQ(1, gamePair.server->getBotCount());
+   EXPECT_EQ("Counter", string(gamePair.server->getBot(0)->getClientInfo()->getName().getString()));
+   EXPECT_GT(CountingController::ticks, 0);
+
+   gamePair.addClient("Newcomer");
+   gamePair.idle(10, 5);
+
+   EXPECT_EQ(1, CountingController::playersJoined);
+}
+
+
+// A server full of bots, native or scripted, should keep all of them playing
+TEST(NativeBotTest, ManyBots)
+{
+   struct Sample { const char *script; S32 botCount; };
+   Sample samples[] = { { "native:s_bot", 64 }, { "s_bot", 8 } };    // Scripted bots are slow enough that a few will do
+
+   for(S32 i = 0; i < ARRAYSIZE(samples); i++)
+   {
+      GamePair gamePair;
+
+      for(S32 j = 0; j < samples[i].botCount; j++)
+         EXPECT_EQ("", gamePair.server->addBot(getBotArgs(samples[i].script), ClientInfo::ClassRobotAddedByAddbots));
+
+      gamePair.idle(10, 50);
+
+      EXPECT_EQ(samples[i].botCount, gamePair.server->getBotCount()) << samples[i].script;
+   }
+}
+
+
+};
@@ -0,0 +1,239 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "RecordingFile.h"
+
+#include "tnlBitStream.h"
+
+#include "gtest/gtest.h"
+
+#include <math.h>
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+static const char *TestFileName = "recording_file_test.tmp";
+
+
+// Something shaped like a real recording: a stream of packets, ~30 per second, each updating the objects in
+// motion, with the odd chat message or game event.  Ships drift smoothly, with a bit of noise thrown in, like
+// positions do in the real thing.
+static void buildSampleRecording(Vector<U8> &recording, S32 objectCount, S32 seconds)
+{
+   static const char *messages[] = { "gg", "nice shot!", "Red team captured the flag", "incoming, watch the left side",
+                                     "Player joined the game", "Blue team scored a goal" };
+   U32 seed = 12345;
+   U32 time = 0;
+   U32 sequence = 0;
+
+   recording.clear();
+   for(S32 i = 0; i < 4; i++)
+      recording.push_back(U8(i + 1));
+
+   while(time < U32(seconds) * 1000)
+   {
+      U8 data[16383];
+      BitStream bstream(data, sizeof(data));
+
+      seed = seed * 1103515245 + 12345;
+      bstream.writeInt(sequence++ & 0x7FF, 11);
+
+      if(bstream.writeFlag((seed >> 16) % 64 == 0))
+         bstream.writeString(messages[(seed >> 8) % ARRAYSIZE(messages)]);
+
+      for(S32 i = 0; i < objectCount; i++)
+      {
+         seed = seed * 1103515245 + 12345;
+
+         // Most objects move on most packets, but not all
+         if(!bstream.writeFlag((seed >> 16) % 4 != 0))
+            continue;
+
+         F32 t = F32(time) / 1000.0f + i;
+         bstream.writeRangedU32(i, 0, 1023);
+         bstream.writeInt(U32(S32(4000 + 3000 * sin(t * 0.3f)) + ((seed >> 8) & 1)), 16);
+         bstream.writeInt(U32(S32(4000 + 3000 * cos(t * 0.2f))), 16);
+         bstream.writeSignedInt(S32(400 * cos(t * 0.3f)), 12);
+         bstream.writeSignedInt(S32(400 * sin(t * 0.2f)), 12);
+         bstream.writeFlag((seed >> 20) % 16 == 0);      // Firing
+         bstream.writeInt(U32(t * 10) & 0x7F, 7);         // Energy and such
+      }
+
+      bstream.writeFlag(false);
+      bstream.zeroToByteBoundary();
+
+      U32 size = bstream.getBytePosition();
+      U32 ms = 30 + (seed >> 28) % 8;
+
+      recording.push_back(U8(size));
+      recording.push_back(U8((size >> 8) & 63) | U8((ms >> 8) << 6));
+      recording.push_back(U8(ms));
+
+      for(U32 i = 0; i < size; i++)
+         recording.push_back(data[i]);
+
+      time += ms;
+   }
+}
+
+
+// Writes recording in odd-sized pieces, like the recorder's writer thread does; returns the file size
+static U32 writeRecording(const Vector<U8> &recording, S32 compressionLevel)
+{
+   FILE *f = fopen(TestFileName, "wb");
+   if(!f)
+      return 0;
+
+   RecordingFileWriter writer(f, compressionLevel);
+
+   U32 pos = 0;
+   while(pos < U32(recording.size()))
+   {
+      U32 size = std::min(pos % 397 + 1, U32(recording.size()) - pos);
+      writer.write(&recording[pos], size);
+      pos += size;
+   }
+
+   writer.close();
+   return writer.getBytesWritten();
+}
+
+
+static bool matches(RecordingFileReader &reader, const Vector<U8> &recording, U32 position, U32 size)
+{
+   Vector<U8> data;
+   data.resize(size);
+
+   return reader.seek(position, SEEK_SET) && reader.tell() == position && reader.read(data.address(), size) == size &&
+          memcmp(data.address(), &recording[position], size) == 0 && reader.tell() == position + size;
+}
+
+
+TEST(RecordingFileTest, RoundTrip)
+{
+   Vector<U8> recording;
+   buildSampleRecording(recording, 24, 60);
+   ASSERT_GT(recording.size(), 3 * RecordingFileWriter::FrameSize);
+
+   S32 levels[] = { 0, 6 };
+
+   for(S32 i = 0; i < ARRAYSIZE(levels); i++)
+   {
+      SCOPED_TRACE(levels[i] == 0 ? "Uncompressed" : "Compressed");
+
+      U32 fileSize = writeRecording(recording, levels[i]);
+
+      RecordingFileReader reader;
+      ASSERT_TRUE(reader.open(TestFileName));
+      EXPECT_EQ(levels[i] != 0 && RecordingFileWriter::isCompressionAvailable(), reader.isCompressed());
+
+      if(reader.isCompressed())
+         EXPECT_LT(fileSize, U32(recording.size()));
+      else
+         EXPECT_EQ(U32(recording.size()), fileSize);
+
+      // All of it, in one go
+      EXPECT_TRUE(matches(reader, recording, 0, recording.size()));
+
+      // Bits and pieces, including some that cross from one frame to the next, and backwards seeks
+      EXPECT_TRUE(matches(reader, recording, RecordingFileWriter::FrameSize - 10, 20));
+      EXPECT_TRUE(matches(reader, recording, 5, 100));
+      EXPECT_TRUE(matches(reader, recording, 2 * RecordingFileWriter::FrameSize, RecordingFileWriter::FrameSize + 1));
+      EXPECT_TRUE(matches(reader, recording, recording.size() - 8, 8));
+
+      // Relative seeks, the way playback reads its index
+      U8 data[8];
+      ASSERT_TRUE(reader.seek(-8, SEEK_END));
+      EXPECT_EQ(U32(recording.size() - 8), reader.tell());
+      ASSERT_TRUE(reader.seek(-100, SEEK_CUR));
+      EXPECT_EQ(8, reader.read(data, 8));
+      EXPECT_EQ(0, memcmp(data, &recording[recording.size() - 108], 8));
+
+      // Reading off the end stops at the end
+      ASSERT_TRUE(reader.seek(-4, SEEK_END));
+      EXPECT_EQ(4, reader.read(data, 8));
+   }
+
+   remove(TestFileName);
+}
+
+
+// A server that goes down mid-game leaves a half-written frame behind; we should still play everything before it
+TEST(RecordingFileTest, TruncatedFile)
+{
+   if(!RecordingFileWriter::isCompressionAvailable())
+      return;
+
+   Vector<U8> recording;
+   buildSampleRecording(recording, 16, 10);
+
+   U32 fileSize = writeRecording(recording, 6);
+
+   // Chop off the end of the last frame
+   Vector<U8> file;
+   file.resize(fileSize);
+
+   FILE *f = fopen(TestFileName, "rb");
+   ASSERT_TRUE(f != NULL);
+   ASSERT_EQ(fileSize, U32(fread(file.address(), 1, fileSize, f)));
+   fclose(f);
+
+   f = fopen(TestFileName, "wb");
+   ASSERT_TRUE(f != NULL);
+   fwrite(file.address(), 1, fileSize - 10, f);
+   fclose(f);
+
+   RecordingFileReader reader;
+   ASSERT_TRUE(reader.open(TestFileName));
+
+   U32 whole = recording.size() / RecordingFileWriter::FrameSize * RecordingFileWriter::FrameSize;
+   ASSERT_TRUE(reader.seek(0, SEEK_END));
+   EXPECT_EQ(whole, reader.tell());
+   EXPECT_TRUE(matches(reader, recording, 0, whole));
+
+   reader.close();
+   remove(TestFileName);
+}
+
+
+// Every compression level must give back exactly what went in, and take up less room doing it
+TEST(RecordingFileTest, CompressionLevels)
+{
+   if(!RecordingFileWriter::isCompressionAvailable())
+      return;
+
+   struct Sample { const char *name; S32 objectCount; };
+   Sample samples[] = { { "quiet", 6 }, { "busy", 48 } };
+   S32 levels[] = { 1, 6, 9 };
+
+   for(S32 i = 0; i < ARRAYSIZE(samples); i++)
+   {
+      Vector<U8> recording;
+      buildSampleRecording(recording, samples[i].objectCount, 60);
+
+      for(S32 j = 0; j < ARRAYSIZE(levels); j++)
+      {
+         U32 fileSize = writeRecording(recording, levels[j]);
+         EXPECT_LT(fileSize, U32(recording.size())) << samples[i].name << ", level " << levels[j];
+
+         RecordingFileReader reader;
+         ASSERT_TRUE(reader.open(TestFileName));
+
+         Vector<U8> data;
+         data.resize(recording.size());
+
+         ASSERT_EQ(U32(recording.size()), reader.read(data.address(), recording.size()));
+         EXPECT_EQ(0, memcmp(data.address(), recording.address(), recording.size())) << samples[i].name << ", level " << levels[j];
+      }
+   }
+
+   remove(TestFileName);
+}
+
+
+};
@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "RingBuffer.h"
+
+#include "tnlThread.h"
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+TEST(RingBufferTest, WriteAndRead)
+{
+   RingBuffer ring(100);
+   EXPECT_EQ(128, ring.getCapacity());       // Rounded up to a power of 2
+   EXPECT_EQ(128, ring.getFreeSpace());
+
+   U8 data[100];
+   for(S32 i = 0; i < 100; i++)
+      data[i] = U8(i);
+
+   EXPECT_TRUE(ring.write(data, 100));
+   EXPECT_FALSE(ring.write(data, 29));       // All or nothing
+   EXPECT_EQ(100, ring.getUsedSpace());
+
+   const U8 *read;
+   ASSERT_EQ(100, ring.peek(&read));
+   EXPECT_EQ(0, memcmp(read, data, 100));
+   ring.consume(60);
+
+   // This one wraps around the end, so only the first part can be read in one go
+   EXPECT_TRUE(ring.write(data, 80));
+   EXPECT_EQ(120, ring.getUsedSpace());
+
+   ASSERT_EQ(68, ring.peek(&read));
+   EXPECT_EQ(0, memcmp(read, &data[60], 40));
+   EXPECT_EQ(0, memcmp(read + 40, data, 28));
+   ring.consume(68);
+
+   ASSERT_EQ(52, ring.peek(&read));
+   EXPECT_EQ(0, memcmp(read, &data[28], 52));
+   ring.consume(52);
+
+   EXPECT_EQ(0, ring.getUsedSpace());
+   EXPECT_EQ(0, ring.peek(&read));
+}
+
+
+// Writes a counting sequence into the ring, in odd-sized pieces, as fast as the ring will take it
+class RingBufferWriter : public Thread
+{
+private:
+   RingBuffer *mRing;
+   U32 mTotal;
+
+public:
+   std::atomic<bool> mDone;
+
+   RingBufferWriter(RingBuffer *ring, U32 total)
+   {
+      mRing = ring;
+      mTotal = total;
+      mDone = false;
+   }
+
+   U32 run()
+   {
+      U8 piece[251];
+      U32 written = 0;
+
+      while(written < mTotal)
+      {
+         U32 size = written % 251 + 1 < mTotal - written ? written % 251 + 1 : mTotal - written;
+
+         for(U32 i = 0; i < size; i++)
+            piece[i] = U8(written + i);
+
+         if(mRing->write(piece, size))
+            written += size;
+         else
+            Platform::sleep(0);     // Give the reader a chance
+      }
+
+      mDone = true;
+      return 0;
+   }
+};
+
+
+// One thread writing and another reading, neither waiting for the other -- everything should come out in order
+TEST(RingBufferTest, TwoThreads)
+{
+   static const U32 Total = 1024 * 1024;
+
+   RingBuffer ring(4096);
+   RingBufferWriter *writer = new RingBufferWriter(&ring, Total);
+   ASSERT_TRUE(writer->start());
+
+   U32 read = 0;
+   U32 mismatches = 0;
+
+   // Keep reading no matter what, so the writer can finish before the ring goes away
+   while(read < Total)
+   {
+      const U8 *data;
+      U32 size = ring.peek(&data);
+
+      for(U32 i = 0; i < size; i++)
+         if(data[i] != U8(read + i))
+            mismatches++;
+
+      ring.consume(size);
+      read += size;
+
+      if(size == 0)
+         Platform::sleep(0);
+   }
+
+   EXPECT_EQ(0, mismatches);
+
+   while(!writer->mDone)
+      Platform::sleep(1);
+
+   delete writer;
+}
+
+
+};
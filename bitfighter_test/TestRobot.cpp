@@ -8,10 +8,14 @@
 #include "../zap/ClientGame.h"
 #include "../zap/ServerGame.h"
 #include "../zap/gameType.h"
+#include "../zap/Level.h"
 #include "../zap/luaLevelGenerator.h"
+#include "../zap/stringUtils.h"
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+
 namespace Zap
 {
 
@@ -77,6 +81,104 @@ TEST(RobotTest, luaRobotNew)
 }
 
 
+static const string ThinkingLevelCode =
+   "GameType 10 8\n"
+   "LevelName \"Thinking Test\"\n"
+   "Team Bluey 0 0 1\n"
+   "Spawn 0 0 0\n"
+   "TestItem 3 3\n";
+
+// Does a bit of everything that has to wait while bots think in parallel -- makes things, moves them, removes them, and
+// chats -- and lets what it hears from the others steer it.  Nothing random, so every run should go the same.
+static const string ThinkingBotCode =
+   "function getName() return 'Thinker' end\n"
+   "function main()\n"
+   "   subscribe(Event.MsgReceived)\n"
+   "   ticks = 0\n"
+   "   heard = 0\n"
+   "   items = { }\n"
+   "end\n"
+   "function onMsgReceived(message, player, global)\n"
+   "   heard = heard + 1\n"
+   "end\n"
+   "function onTick()\n"
+   "   ticks = ticks + 1\n"
+   "   bot:setThrust(0.5 + (heard % 3) / 4, math.pi * (ticks % 20) / 10)\n"
+   "   if ticks % 5 == 0 then\n"
+   "      local item = TestItem.new()\n"
+   "      item:setPos(bot:getPos())\n"
+   "      bf:addItem(item)\n"
+   "      table.insert(items, item)\n"
+   "   end\n"
+   "   if #items > 3 then\n"
+   "      table.remove(items, 1):removeFromGame()\n"
+   "   end\n"
+   "   if ticks % 7 == 0 then\n"
+   "      bot:globalMsg('tick ' .. ticks)\n"
+   "   end\n"
+   "end\n";
+
+
+// Plays the level with a few of the bots above, thinking on the given number of threads, and returns what the server's
+// world looks like at the end, in order of creation
+static Vector<string> runThinkingBots(U32 threads)
+{
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   settings->setSetting<U32>(IniKey::BotThinkThreads, threads);
+
+   GamePair gamePair(settings, ThinkingLevelCode);
+   gamePair.addClient("Watcher");      // Nothing happens while the game is suspended
+
+   string botFile = joindir(gamePair.server->getSettings()->getFolderManager()->getRobotDir(), "thinking_test.bot");
+   writeFile(botFile, ThinkingBotCode);
+
+   Vector<string> args;
+   args.push_back("0");
+   args.push_back("thinking_test");
+
+   for(S32 i = 0; i < 6; i++)
+      EXPECT_EQ("", gamePair.server->addBot(args, ClientInfo::ClassRobotAddedByAddbots));
+
+   gamePair.idle(10, 300);
+
+   remove(botFile.c_str());
+
+   EXPECT_EQ(6, gamePair.server->getBotCount());
+
+   // Ids count down as things are made
+   Vector<pair<S32, string> > objects;
+   const Vector<DatabaseObject *> *found = gamePair.server->getLevel()->findObjects_fast();
+
+   for(S32 i = 0; i < found->size(); i++)
+   {
+      BfObject *obj = static_cast<BfObject *>(found->get(i));
+
+      if(!obj->isDeleted())
+         objects.push_back(pair<S32, string>(-obj->getUserAssignedId(), 
+                                             itos(obj->getObjectTypeNumber()) + " " + obj->getPos().toString()));
+   }
+
+   sort(objects.getStlVector().begin(), objects.getStlVector().end());
+
+   Vector<string> world;
+   for(S32 i = 0; i < objects.size(); i++)
+      world.push_back(objects[i].second);
+
+   return world;
+}
+
+
+// Bots thinking in parallel should leave the world just as they would taking turns on one thread
+TEST(RobotTest, ThreadedThinkingMatchesSingleThreaded)
+{
+   Vector<string> single = runThinkingBots(1);
+   Vector<string> threaded = runThinkingBots(4);
+
+   EXPECT_GT(single.size(), 6 + 6 * 3);      // Bots, and the items they've left lying around
+   EXPECT_EQ(single.getStlVector(), threaded.getStlVector());
+}
+
+
 /** onShipSpawned doesn't fire?
 
 TEST(RobotTest, RemoveFromGameDuringInitialOnShipSpawn)
@@ -0,0 +1,118 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "tnlUDP.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// Bounces packets through a pair of loopback sockets, a tick's worth at a time.  Every packet must make it through, in
+// order and intact.
+static void runLoopback(bool batched, S32 rounds)
+{
+   static const S32 PacketsPerRound = 40;   // More than a batch holds, so sendto() has to flush some itself
+   static const S32 PacketSize = 200;
+   static const U32 SocketBufferSize = 262144;
+
+   Socket sender(Address(IPProtocol, Address::Any, 0), SocketBufferSize, SocketBufferSize);
+   Socket receiver(Address(IPProtocol, Address::Any, 0), SocketBufferSize, SocketBufferSize);
+
+   EXPECT_TRUE(sender.isValid() && receiver.isValid());
+
+   sender.setBatchedIO(batched);
+   receiver.setBatchedIO(batched);
+
+   Address dest("IP:127.0.0.1");
+   dest.port = receiver.getBoundAddress().port;
+
+   Vector<Socket *> receivers;
+   receivers.push_back(&receiver);
+
+   U8 packet[PacketSize];
+   U8 received[MaxPacketDataSize];
+   S32 receivedCount = 0;
+
+   for(S32 round = 0; round < rounds; round++)
+   {
+      sender.beginSendBatch();
+
+      for(S32 i = 0; i < PacketsPerRound; i++)
+      {
+         memset(packet, (round * PacketsPerRound + i) & 0xFF, PacketSize);
+         EXPECT_EQ(NoError, sender.sendto(dest, packet, PacketSize));
+      }
+
+      EXPECT_EQ(NoError, sender.flushSendBatch());
+
+      // Loopback delivery is all but immediate; this just makes sure
+      Socket::waitForIncoming(receivers, 100);
+
+      Address from;
+      S32 size;
+
+      while(receiver.recvfrom(&from, received, sizeof(received), &size) == NoError)
+      {
+         EXPECT_EQ(PacketSize, size);
+         EXPECT_EQ(U8(receivedCount & 0xFF), received[0]);
+         EXPECT_EQ(received[0], received[PacketSize - 1]);
+         receivedCount++;
+      }
+
+      ASSERT_EQ((round + 1) * PacketsPerRound, receivedCount) << "Lost packets in round " << round;
+   }
+}
+
+
+// A datagram the OS refuses must be reported, whether it was sent right away or held for a batch
+TEST(SocketTest, BatchedSendReportsErrors)
+{
+   Socket sender(Address(IPProtocol, Address::Any, 0));
+   ASSERT_TRUE(sender.isValid());
+
+   Address dest("IP:127.0.0.1");
+   dest.port = 0;    // Nothing can be sent to port 0
+
+   U8 packet[16] = { 0 };
+
+   sender.setBatchedIO(false);
+   NetError expected = sender.sendto(dest, packet, sizeof(packet));
+   ASSERT_NE(NoError, expected);
+
+   if(!Socket::isBatchedIOAvailable())
+      return;
+
+   sender.setBatchedIO(true);
+
+   // Queued datagrams are sent, and fail, when the batch is flushed
+   sender.beginSendBatch();
+   EXPECT_EQ(NoError, sender.sendto(dest, packet, sizeof(packet)));
+   EXPECT_EQ(expected, sender.flushSendBatch());
+
+   // Or when the batch fills up, in which case the sendto() that flushed it reports the failure
+   sender.beginSendBatch();
+
+   for(S32 i = 0; i < Socket::BatchSize; i++)
+      EXPECT_EQ(NoError, sender.sendto(dest, packet, sizeof(packet)));
+
+   EXPECT_EQ(expected, sender.sendto(dest, packet, sizeof(packet)));
+   EXPECT_EQ(expected, sender.flushSendBatch());
+}
+
+
+// Batched I/O, where available, must deliver exactly what one system call per packet does
+TEST(SocketTest, BatchedLoopback)
+{
+   static const S32 Rounds = 50;
+
+   runLoopback(false, Rounds);
+   runLoopback(true, Rounds);    // Same as above where batching isn't available
+}
+
+};
@@ -0,0 +1,46 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "TickStats.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+TEST(TickStatsTest, RecordTicks)
+{
+   TickStats stats;
+
+   EXPECT_EQ(0, stats.getTicks());
+   EXPECT_EQ(0, stats.getMinInterval());
+   EXPECT_EQ(0, stats.getAverageInterval());
+
+   stats.recordTick(10, 2.0, 10);
+   stats.recordTick(12, 4.0, 10);
+   stats.recordTick(8,  0.0, 10);
+   stats.recordTick(25, 3.0, 10);     // Missed a tick entirely
+   stats.recordWakeup();
+
+   EXPECT_EQ(4, stats.getTicks());
+   EXPECT_EQ(1, stats.getLateTicks());
+   EXPECT_EQ(1, stats.getWakeups());
+
+   EXPECT_FLOAT_EQ(13.75f, stats.getAverageInterval());
+   EXPECT_EQ(8,  stats.getMinInterval());
+   EXPECT_EQ(25, stats.getMaxInterval());
+
+   EXPECT_DOUBLE_EQ(2.25, stats.getAverageWorkTime());
+   EXPECT_DOUBLE_EQ(4.0,  stats.getMaxWorkTime());
+
+   stats.reset();
+
+   EXPECT_EQ(0, stats.getTicks());
+   EXPECT_EQ(0, stats.getLateTicks());
+   EXPECT_EQ(0, stats.getMaxInterval());
+   EXPECT_EQ(0, stats.getMaxWorkTime());
+}
+
+};
@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "VisibilityQuery.h"
+
+#include "BfObject.h"
+#include "GeomUtils.h"
+#include "Level.h"
+#include "ServerGame.h"
+
+#include "LevelFilesForTesting.h"
+#include "TestUtils.h"
+
+#include "tnlRandom.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+static const F32 ShipRadius = 24;
+
+
+// The one point at a time version, as done by Robot::canSeePoint()
+static bool canSeePoint(const GridDatabase *database, TestFunc testFunc, const Point &origin, const Point &point)
+{
+   Point difference = point - origin;
+
+   Point crossVector(difference.y, -difference.x);
+   crossVector.normalize(ShipRadius);
+
+   Vector<Point> thisPoints;
+   thisPoints.push_back(origin + crossVector);
+   thisPoints.push_back(origin - crossVector);
+   thisPoints.push_back(point - crossVector);
+   thisPoints.push_back(point + crossVector);
+
+   FillVector fillVector;
+   database->findObjects(testFunc, fillVector, Rect(thisPoints));
+
+   for(S32 i = 0; i < fillVector.size(); i++)
+   {
+      const Vector<Point> *otherPoints = fillVector[i]->getCollisionPoly();
+      if(otherPoints && polygonsIntersect(thisPoints, *otherPoints))
+         return false;
+   }
+
+   return true;
+}
+
+
+static Point randomPoint(const Rect &extents)
+{
+   return Point(extents.min.x + Random::readF() * (extents.max.x - extents.min.x),
+                extents.min.y + Random::readF() * (extents.max.y - extents.min.y));
+}
+
+
+// Batches should get exactly the answers we'd get one point at a time
+TEST(VisibilityQueryTest, SameAsOneAtATime)
+{
+   Vector<string> levelCodes = getLevels().first;
+   VisibilityQuery query;
+
+   TestFunc testFuncs[] = { (TestFunc)isWallType, (TestFunc)isCollideableType };
+
+   for(S32 i = 0; i < levelCodes.size(); i++)
+   {
+      ServerGame *game = newServerGame(levelCodes[i]);
+      game->addObjectsToGame();
+
+      const GridDatabase *database = game->getLevel();
+      Rect extents = *game->getWorldExtents();
+      extents.expand(Point(200, 200));      // So some points are off the map
+
+      S32 visibleCount = 0;
+      S32 testCount = 0;
+
+      for(S32 j = 0; j < 50; j++)
+      {
+         Point origin = randomPoint(extents);
+         S32 count = 1 + j % VisibilityQuery::MaxTargets;
+
+         Point targets[VisibilityQuery::MaxTargets];
+         for(S32 k = 0; k < count; k++)
+            targets[k] = randomPoint(extents);
+
+         if(j % 10 == 0)
+            targets[0] = origin;            // Zero length
+
+         for(S32 f = 0; f < ARRAYSIZE(testFuncs); f++)
+         {
+            U64 visible = query.canSeePoints(database, testFuncs[f], origin, ShipRadius, targets, count);
+
+            for(S32 k = 0; k < count; k++)
+            {
+               bool expected = canSeePoint(database, testFuncs[f], origin, targets[k]);
+               EXPECT_EQ(expected, ((visible >> k) & 1) != 0) << "level " << i << " batch " << j << " target " << k;
+
+               visibleCount += expected ? 1 : 0;
+               testCount++;
+            }
+
+            EXPECT_EQ(U64(0), visible >> count);
+         }
+      }
+
+      // Make sure we've tested both answers
+      if(database->getObjectCount() > 0)
+         EXPECT_TRUE(visibleCount > 0 && visibleCount < testCount) << "level " << i;
+
+      delete game;
+   }
+}
+
+
+TEST(VisibilityQueryTest, NoTargets)
+{
+   ServerGame *game = newServerGame(getLevelCode1());
+   VisibilityQuery query;
+
+   EXPECT_EQ(U64(0), query.canSeePoints(game->getLevel(), (TestFunc)isWallType, Point(0, 0), ShipRadius, NULL, 0));
+
+   delete game;
+}
+
+
+};
@@ -0,0 +1,67 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "WorkerPool.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// Counts how many times each item gets done
+class CountingJob : public WorkerPool::Job
+{
+public:
+   std::atomic<S32> counts[100];
+
+   CountingJob()
+   {
+      for(S32 i = 0; i < ARRAYSIZE(counts); i++)
+         counts[i] = 0;
+   }
+
+   void run(S32 index)
+   {
+      // Make the work take long enough that the threads get in each other's way
+      volatile U32 x = 0;
+      for(S32 i = 0; i < 1000; i++)
+         x += i;
+
+      counts[index]++;
+   }
+};
+
+
+TEST(WorkerPoolTest, EveryItemOnce)
+{
+   S32 threadCounts[] = { 0, 1, 3 };
+
+   for(S32 i = 0; i < ARRAYSIZE(threadCounts); i++)
+   {
+      WorkerPool pool(threadCounts[i]);
+      EXPECT_EQ(threadCounts[i], pool.getThreadCount());
+
+      // Same pool, different sized batches, over and over, like the game does with its bots
+      for(S32 run = 0; run < 50; run++)
+      {
+         CountingJob job;
+         S32 items = run % 20 * 5;
+
+         pool.run(&job, items);
+
+         // Everything is done by the time run() comes back
+         for(S32 j = 0; j < ARRAYSIZE(job.counts); j++)
+            EXPECT_EQ(j < items ? 1 : 0, job.counts[j]) << "threads: " << threadCounts[i] << ", items: " << items;
+      }
+   }
+}
+
+
+};
@@ -21,7 +21,10 @@ SHARED_SOURCES := \
 $(ZAP_PATH)/BanList.cpp \
 $(ZAP_PATH)/barrier.cpp \
 $(ZAP_PATH)/BfObject.cpp \
+$(ZAP_PATH)/BotController.cpp \
 $(ZAP_PATH)/BotNavMeshZone.cpp \
+$(ZAP_PATH)/BotNavRouteTable.cpp \
+$(ZAP_PATH)/BotZoneCache.cpp \
 $(ZAP_PATH)/ChatCheck.cpp \
 $(ZAP_PATH)/ClientInfo.cpp \
 $(ZAP_PATH)/Color.cpp \
@@ -53,12 +56,14 @@ $(ZAP_PATH)/HttpRequest.cpp \
 $(ZAP_PATH)/IniFile.cpp \
 $(ZAP_PATH)/InputCode.cpp \
 $(ZAP_PATH)/item.cpp \
+$(ZAP_PATH)/LevelPreparer.cpp \
 $(ZAP_PATH)/LineItem.cpp \
 $(ZAP_PATH)/LoadoutTracker.cpp \
 $(ZAP_PATH)/loadoutZone.cpp \
 $(ZAP_PATH)/LuaBase.cpp \
 $(ZAP_PATH)/luaGameInfo.cpp \
 $(ZAP_PATH)/luaLevelGenerator.cpp \
+$(ZAP_PATH)/LuaProfiler.cpp \
 $(ZAP_PATH)/LuaScriptRunner.cpp \
 $(ZAP_PATH)/masterConnection.cpp \
 $(ZAP_PATH)/MathUtils.cpp \
@@ -73,9 +78,12 @@ $(ZAP_PATH)/PointObject.cpp \
 $(ZAP_PATH)/polygon.cpp \
 $(ZAP_PATH)/projectile.cpp \
 $(ZAP_PATH)/rabbitGame.cpp \
+$(ZAP_PATH)/RecordingFile.cpp \
 $(ZAP_PATH)/Rect.cpp \
+$(ZAP_PATH)/RingBuffer.cpp \
 $(ZAP_PATH)/retrieveGame.cpp \
 $(ZAP_PATH)/robot.cpp \
+$(ZAP_PATH)/SBotController.cpp \
 $(ZAP_PATH)/ScreenInfo.cpp \
 $(ZAP_PATH)/ServerGame.cpp \
 $(ZAP_PATH)/ship.cpp \
@@ -93,13 +101,17 @@ $(ZAP_PATH)/SystemFunctions.cpp \
 $(ZAP_PATH)/teamInfo.cpp \
 $(ZAP_PATH)/teleporter.cpp \
 $(ZAP_PATH)/textItem.cpp \
+$(ZAP_PATH)/TickStats.cpp \
 $(ZAP_PATH)/Timer.cpp \
+$(ZAP_PATH)/VisibilityQuery.cpp \
 $(ZAP_PATH)/WallSegmentManager.cpp \
 $(ZAP_PATH)/WeaponInfo.cpp \
+$(ZAP_PATH)/WorkerPool.cpp \
 $(ZAP_PATH)/Zone.cpp \
 $(ZAP_PATH)/zoneControlGame.cpp \
 $(ZAP_PATH)/../clipper/clipper.cpp \
 $(ZAP_PATH)/../master/database.cpp \
+$(ZAP_PATH)/../master/DatabaseAccessThread.cpp \
 $(ZAP_PATH)/../master/masterInterface.cpp \
 $(ZAP_PATH)/../recast/RecastAlloc.cpp \
 $(ZAP_PATH)/../recast/RecastMesh.cpp \
@@ -186,6 +198,6 @@ $(ZAP_PATH)/main.cpp \
 
 LOCAL_SHARED_LIBRARIES := tnl luavec tomcrypt SDL2
 
-LOCAL_LDLIBS := -llog -lGLESv1_CM
+LOCAL_LDLIBS := -llog -lGLESv1_CM -lz
 
 include $(BUILD_SHARED_LIBRARY)
@@ -0,0 +1,284 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "DatabaseAccessThread.h"
+
+#include "tnlPlatform.h"
+
+namespace Master
+{
+
+// The old fixed-size ring held this many entries; when the queue gets this deep, it's time to say something
+static const U32 FirstQueueWarning = 128;
+
+
+DatabaseAccessThread::Worker::Worker(DatabaseAccessThread *pool)
+{
+   mPool = pool;
+}
+
+
+U32 DatabaseAccessThread::Worker::run()
+{
+   return mPool->work();
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+DatabaseAccessThread::DatabaseAccessThread(U32 maxThreads) : mWakeUp(0, 1024)
+{
+   mMaxThreads = maxThreads > 0 ? maxThreads : 1;
+   mActiveThreads = 0;
+   mSleepingThreads = 0;
+   mRunningEntries = 0;
+   mRunning = true;
+
+   mWarnQueueDepth = FirstQueueWarning;
+
+   mPeakQueued = 0;
+   mCompleted = 0;
+   mFailed = 0;
+   mTotalLatency = 0;
+   mMaxLatency = 0;
+}
+
+
+// Destructor
+DatabaseAccessThread::~DatabaseAccessThread()
+{
+   terminate();
+   mWorkers.deleteAndClear();
+}
+
+
+// Main thread only.  We take a reference to the entry here and drop it in idle(), so the refcount, which isn't
+// thread safe, is only ever touched from the main thread.
+void DatabaseAccessThread::addEntry(ThreadEntry *entry)
+{
+   entry->incRef();
+   entry->mQueuedTime = Platform::getRealMilliseconds();
+
+   Worker *newWorker = NULL;
+
+   mLock.lock();
+
+   if(!mRunning)
+   {
+      mLock.unlock();
+      entry->decRef();
+      return;
+   }
+
+   mQueue.push_back(entry);
+
+   U32 queued = (U32)mQueue.size();
+
+   if(queued > mPeakQueued)
+      mPeakQueued = queued;
+
+   // Wake a sleeping worker, or add one if everyone is busy and we have room.  We only ever post the semaphore for
+   // a worker we know is asleep, so its count never gets ahead of them.
+   if(mSleepingThreads > 0)
+   {
+      mSleepingThreads--;
+      mWakeUp.increment();
+   }
+   else if((U32)mWorkers.size() < mMaxThreads)
+   {
+      newWorker = new Worker(this);
+      mWorkers.push_back(newWorker);
+      mActiveThreads++;
+   }
+
+   mLock.unlock();
+
+   if(newWorker)
+   {
+      if(!newWorker->start())
+      {
+         logprintf(LogConsumer::LogError, "Could not start database thread");
+
+         // Give its place back, so the next entry can try again; the entry we just queued waits for it, or for a
+         // worker that's already running
+         mLock.lock();
+         mWorkers.erase(mWorkers.getIndex(newWorker));
+         mActiveThreads--;
+         mLock.unlock();
+
+         delete newWorker;
+      }
+   }
+
+   if(queued >= mWarnQueueDepth)
+   {
+      logprintf(LogConsumer::LogWarning, "Database queue is %d entries deep - database access too slow?", queued);
+      mWarnQueueDepth *= 2;
+   }
+}
+
+
+U32 DatabaseAccessThread::work()
+{
+   mLock.lock();
+
+   while(mRunning)
+   {
+      if(mQueue.empty())
+      {
+         mSleepingThreads++;
+         mLock.unlock();
+
+         mWakeUp.wait();      // Whoever posts this has already taken us off the sleeping count
+
+         mLock.lock();
+         continue;
+      }
+
+      ThreadEntry *entry = mQueue.front();
+      mQueue.pop_front();
+      mRunningEntries++;
+
+      mLock.unlock();
+
+      entry->run();
+      U32 latency = Platform::getRealMilliseconds() - entry->mQueuedTime;
+
+      mLock.lock();
+
+      mRunningEntries--;
+      mDone.push_back(entry);
+
+      mCompleted++;
+      if(entry->mFailed)
+         mFailed++;
+
+      mTotalLatency += latency;
+      if(latency > mMaxLatency)
+         mMaxLatency = latency;
+   }
+
+   mActiveThreads--;
+   mLock.unlock();
+
+   return 0;
+}
+
+
+void DatabaseAccessThread::idle()
+{
+   mLock.lock();
+
+   if(mDone.size() == 0)
+   {
+      mLock.unlock();
+      return;
+   }
+
+   Vector<ThreadEntry *> done;
+   done.getStlVector().swap(mDone.getStlVector());
+
+   if(mQueue.empty())
+      mWarnQueueDepth = FirstQueueWarning;      // Caught up; complain again next time we fall behind
+
+   mLock.unlock();
+
+   for(S32 i = 0; i < done.size(); i++)
+   {
+      done[i]->finish();
+      done[i]->decRef();      // Deletes it, unless someone else still cares
+   }
+}
+
+
+void DatabaseAccessThread::terminate()
+{
+   mLock.lock();
+
+   if(!mRunning)
+   {
+      mLock.unlock();
+      return;
+   }
+
+   mRunning = false;
+
+   U32 sleeping = mSleepingThreads;
+   mSleepingThreads = 0;
+
+   mLock.unlock();
+
+   mWakeUp.increment(sleeping);
+
+   // Busy workers will notice when they finish what they're doing
+   while(true)
+   {
+      mLock.lock();
+      U32 active = mActiveThreads;
+      mLock.unlock();
+
+      if(active == 0)
+         break;
+
+      Platform::sleep(10);
+   }
+
+   if(mQueue.size() > 0)
+      logprintf(LogConsumer::LogWarning, "Database thread shutting down; dropping %d queued entries", mQueue.size());
+
+   for(U32 i = 0; i < mQueue.size(); i++)
+      mQueue[i]->decRef();
+   mQueue.clear();
+
+   for(S32 i = 0; i < mDone.size(); i++)
+      mDone[i]->decRef();
+   mDone.clear();
+}
+
+
+void DatabaseAccessThread::setMaxThreads(U32 maxThreads)
+{
+   mLock.lock();
+   mMaxThreads = maxThreads > 0 ? maxThreads : 1;
+   mLock.unlock();
+}
+
+
+U32 DatabaseAccessThread::getMaxThreads() const
+{
+   return mMaxThreads;
+}
+
+
+DatabaseAccessStats DatabaseAccessThread::getStats(bool resetPeaks)
+{
+   DatabaseAccessStats stats;
+
+   mLock.lock();
+
+   stats.threads        = mWorkers.size();
+   stats.queued         = mQueue.size();
+   stats.running        = mRunningEntries;
+   stats.peakQueued     = mPeakQueued;
+   stats.completed      = mCompleted;
+   stats.failed         = mFailed;
+   stats.averageLatency = mCompleted > 0 ? U32(mTotalLatency / mCompleted) : 0;
+   stats.maxLatency     = mMaxLatency;
+
+   if(resetPeaks)
+   {
+      mPeakQueued = mQueue.size();
+      mMaxLatency = 0;
+   }
+
+   mLock.unlock();
+
+   return stats;
+}
+
+
+}
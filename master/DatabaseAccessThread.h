@@ -8,119 +8,105 @@
 
 
 #include "tnlThread.h"
+#include "tnlVector.h"
 #include "tnlLog.h"
 
+#include <deque>
+
 namespace Master
 {
 
 class ThreadEntry : public RefPtrData
 {
+   friend class DatabaseAccessThread;
+
+   U32 mQueuedTime;           // When addEntry() got us, for the latency stats
+   bool mFailed;
+
+protected:
+   void setFailed() { mFailed = true; }    // Call from run() when the work didn't get done; it shows up in the stats
+
 public:
+   ThreadEntry() { mQueuedTime = 0; mFailed = false; }
    virtual ~ThreadEntry() {};
 
    virtual void run() = 0;    // runs on seperate thread
    virtual void finish() {};  // finishes the entry on primary thread after "run()" is done to avoid 2 threads crashing in to the same network TNL and others.
-};
 
-class DatabaseAccessThread : public TNL::Thread
-{
-private:
-   U32 mEntryStart;
-   U32 mEntryThread;
-   U32 mEntryEnd;
+   bool hasFailed() const { return mFailed; }
+};
 
-   bool mRunning;
-   bool mThreadActive;
 
-   static const U32 mEntrySize = 128;
+struct DatabaseAccessStats
+{
+   U32 threads;               // Worker threads started so far
+   U32 queued;                // Entries waiting for a worker
+   U32 running;               // Entries a worker is busy with
+   U32 peakQueued;            // Deepest the queue has been since the last reset
+   U32 completed;             // Entries whose run() has returned, failed or not
+   U32 failed;
+   U32 averageLatency;        // Milliseconds from addEntry() until run() returned
+   U32 maxLatency;            // Worst of those since the last reset
+};
 
-   RefPtr<ThreadEntry> mEntry[mEntrySize];
 
-public:
-   DatabaseAccessThread() // Constructor
+// Runs ThreadEntries on a pool of worker threads, and hands them back to the main thread, via idle(), to finish.
+// With one thread (the default), entries run one at a time in the order they were added.  With more, they run
+// concurrently and may complete in any order, so only use more than one for entries that don't depend on each other.
+// Threads are started as work arrives, up to the limit.  The queue is unbounded; we log a warning when it gets deep.
+class DatabaseAccessThread
+{
+private:
+   class Worker : public TNL::Thread
    {
-      mEntryStart = 0;
-      mEntryThread = 0;
-      mEntryEnd = 0;
+      DatabaseAccessThread *mPool;
 
-      mRunning = true;
-      mThreadActive = false;
-   }
+   public:
+      explicit Worker(DatabaseAccessThread *pool);
+      U32 run();
+   };
 
+   Mutex mLock;               // Guards everything below that the workers touch
+   Semaphore mWakeUp;         // Idle workers wait on this
 
-   void addEntry(ThreadEntry *entry)
-   {
-      U32 entryEnd = mEntryEnd + 1;
+   std::deque<ThreadEntry *> mQueue;      // Waiting to run; we hold a reference to each, see addEntry()
+   Vector<ThreadEntry *> mDone;           // Waiting for idle() to finish them
 
-      if(entryEnd >= mEntrySize)
-         entryEnd = 0;
+   Vector<Worker *> mWorkers;
+   U32 mMaxThreads;
+   U32 mActiveThreads;        // Workers that haven't yet exited their run()
+   U32 mSleepingThreads;      // Workers waiting on mWakeUp that nobody has woken yet
+   U32 mRunningEntries;
+   bool mRunning;
 
-      if(entryEnd == mEntryStart)      // Too many entries
-      {
-         logprintf(LogConsumer::LogError, "Database thread overloaded - database access too slow?");
-         return;
-      }
+   U32 mWarnQueueDepth;       // Queue depth at which we next complain about falling behind
 
-      mEntry[mEntryEnd] = entry;
-      mEntryEnd = entryEnd;
-      if(!mThreadActive)
-      {
-         mThreadActive = true;
-         start();
-      }
-   }
+   // Stats
+   U32 mPeakQueued;
+   U32 mCompleted;
+   U32 mFailed;
+   U64 mTotalLatency;
+   U32 mMaxLatency;
 
+   U32 work();                // The guts of each worker thread
 
-   U32 run()
-   {
-      mThreadActive = true;
-      while(mRunning)
-      {
-         if(mEntryThread != mEntryEnd)
-         {
-            mEntry[mEntryThread]->run();
-            mEntryThread++;
-            if(mEntryThread >= mEntrySize)
-               mEntryThread = 0;
-         }
-         else
-            Platform::sleep(50);
-      }
-
-      mThreadActive = false;
-
-      return 0;
-   }
-
-
-   void idle()
-   {
-      while(mEntryStart != mEntryThread)
-      {
-         mEntry[mEntryStart]->finish();
-         mEntry[mEntryStart].set(NULL);  // RefPtr, we can just set to NULL and it will delete itself
-         mEntryStart++;
-
-         if(mEntryStart >= mEntrySize)
-            mEntryStart = 0;
-      }
-   }
-
-   void terminate()
-   {
-      mRunning = false;
-      while(mThreadActive)
-         Platform::sleep(50);
-   }
+public:
+   explicit DatabaseAccessThread(U32 maxThreads = 1);     // Constructor
+   ~DatabaseAccessThread();                               // Destructor
 
-   ~DatabaseAccessThread()
-   {
-      terminate();
-   }
+   void addEntry(ThreadEntry *entry);
+   void idle();               // Call from the main thread to finish() completed entries
+   void terminate();          // Stops the workers; anything still queued is dropped
+
+   // Raising the limit takes effect as soon as there is work for the new threads; lowering it won't stop
+   // threads that are already running
+   void setMaxThreads(U32 maxThreads);
+   U32 getMaxThreads() const;
 
+   DatabaseAccessStats getStats(bool resetPeaks = false);
 };
 
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,339 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LobbyChat.h"
+
+#include "MasterServerConnection.h"
+
+#include "tnlAssert.h"
+
+namespace Master
+{
+
+// Client ids are never 0, so this means "no one in particular"
+static const S32 NoClientId = 0;
+
+// First master protocol version that knows about m2cLobbyChatEvents
+static const U32 BatchedLobbyChatProtocol = 9;
+
+
+void LobbyChat::Payload::add(LobbyChatEventType type, const StringTableEntry &nick, const string &message)
+{
+   eventTypes.push_back(U8(type));
+   nicks.push_back(nick);
+
+   if(type == LobbyChatMessage)
+      messages.push_back(message);
+}
+
+
+void LobbyChat::Payload::clear()
+{
+   eventTypes.clear();
+   nicks.clear();
+   messages.clear();
+}
+
+
+S32 LobbyChat::Payload::size() const
+{
+   return eventTypes.size();
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+LobbyChat::LobbyChat()
+{
+   mHaveEventsForEveryone = false;
+
+   mEventsRelayed = 0;
+   mMessagesSent = 0;
+}
+
+
+// Destructor
+LobbyChat::~LobbyChat()
+{
+   // Do nothing
+}
+
+
+void LobbyChat::addEvent(LobbyChatEventType type, const MasterServerConnection *source, const StringTableEntry &nick,
+                         const string &message)
+{
+   Event event;
+   event.type = type;
+   event.nick = nick;
+   event.message = message;
+   event.sourceId = source->getClientId();
+   event.lobbyOnly = (type == LobbyChatPlayerJoined || type == LobbyChatPlayerLeft);
+
+   mEvents.push_back(event);
+   mSources.insert(event.sourceId);
+
+   if(!event.lobbyOnly)
+      mHaveEventsForEveryone = true;
+
+   mEventsRelayed++;
+}
+
+
+void LobbyChat::addMember(MasterServerConnection *client)
+{
+   client->mLobbyChatIndex = mMembers.size();
+   client->isInLobbyChat = true;
+
+   mMembers.push_back(client);
+}
+
+
+void LobbyChat::removeMember(MasterServerConnection *client)
+{
+   S32 index = client->mLobbyChatIndex;
+   TNLAssert(index >= 0 && index < mMembers.size() && mMembers[index] == client, "Lobby chat member index is wrong!");
+
+   mMembers.erase_fast(index);
+
+   if(index < mMembers.size())
+      mMembers[index]->mLobbyChatIndex = index;      // The one that was moved into the gap
+
+   client->mLobbyChatIndex = -1;
+   client->isInLobbyChat = false;
+}
+
+
+void LobbyChat::clientConnected(MasterServerConnection *client)
+{
+   addEvent(LobbyChatClientConnected, client, client->mPlayerOrServerName);
+}
+
+
+// Clients treat a disconnect as leaving lobby chat, so there's no need to tell them about both
+void LobbyChat::clientDisconnected(MasterServerConnection *client)
+{
+   if(client->isInLobbyChat)
+      removeMember(client);
+
+   addEvent(LobbyChatClientDisconnected, client, client->mPlayerOrServerName);
+}
+
+
+void LobbyChat::join(MasterServerConnection *client)
+{
+   if(client->isInLobbyChat)
+      return;
+
+   addMember(client);
+   addEvent(LobbyChatPlayerJoined, client, client->mPlayerOrServerName);
+}
+
+
+void LobbyChat::leave(MasterServerConnection *client)
+{
+   if(!client->isInLobbyChat)
+      return;
+
+   removeMember(client);
+   addEvent(LobbyChatPlayerLeft, client, client->mPlayerOrServerName);
+}
+
+
+// Call before the name changes; members see the old name leave and the new one join
+void LobbyChat::rename(MasterServerConnection *client, const StringTableEntry &newName)
+{
+   if(!client->isInLobbyChat)
+      return;
+
+   addEvent(LobbyChatPlayerLeft,   client, client->mPlayerOrServerName);
+   addEvent(LobbyChatPlayerJoined, client, newName);
+}
+
+
+void LobbyChat::chat(MasterServerConnection *client, const char *message)
+{
+   addEvent(LobbyChatMessage, client, client->mPlayerOrServerName, message);
+}
+
+
+// The list goes out with the next flush, which lets us leave out that tick's joins and leaves
+void LobbyChat::requestMemberList(MasterServerConnection *client)
+{
+   if(mNewMembers.insert(client->getClientId()).second)
+      mNeedMemberList.push_back(client);
+}
+
+
+// Everyone already in lobby chat, except the client themselves.  The first few names go in an m2cPlayersInGlobalChat,
+// which replaces whatever list the client had; the rest follow as joins, so no single message gets too big.
+void LobbyChat::sendMemberList(MasterServerConnection *client, Payload &payload)
+{
+   Vector<StringTableEntry> names;
+   names.reserve(MemberListChunkSize);
+
+   for(S32 i = 0; i < mMembers.size(); i++)
+   {
+      if(mMembers[i] == client)
+         continue;
+
+      if(names.size() < MemberListChunkSize)
+         names.push_back(mMembers[i]->mPlayerOrServerName);
+      else
+         payload.add(LobbyChatPlayerJoined, mMembers[i]->mPlayerOrServerName, "");
+   }
+
+   if(names.size() > 0)
+   {
+      client->m2cPlayersInGlobalChat(names);
+      mMessagesSent++;
+   }
+}
+
+
+// Everything that happened this tick that recipientId should hear about
+void LobbyChat::buildPayload(Payload &payload, S32 recipientId, bool includeLobbyEvents) const
+{
+   for(S32 i = 0; i < mEvents.size(); i++)
+   {
+      const Event &event = mEvents[i];
+
+      if(event.sourceId == recipientId || (event.lobbyOnly && !includeLobbyEvents))
+         continue;
+
+      payload.add(event.type, event.nick, event.message);
+   }
+}
+
+
+void LobbyChat::send(MasterServerConnection *client, const Payload &payload)
+{
+   if(payload.size() == 0)
+      return;
+
+   if(client->mCMProtocolVersion >= BatchedLobbyChatProtocol)
+   {
+      client->m2cLobbyChatEvents(payload.eventTypes, payload.nicks, payload.messages);
+      mMessagesSent++;
+      return;
+   }
+
+   // Older clients get them one at a time
+   S32 messageIndex = 0;
+
+   for(S32 i = 0; i < payload.size(); i++)
+   {
+      switch(payload.eventTypes[i])
+      {
+         case LobbyChatClientConnected:
+            client->m2cClientConnected(payload.nicks[i]);
+            break;
+
+         case LobbyChatClientDisconnected:
+            client->m2cClientDisconnected(payload.nicks[i]);
+            break;
+
+         case LobbyChatPlayerJoined:
+            client->m2cPlayerJoinedGlobalChat(payload.nicks[i]);
+            break;
+
+         case LobbyChatPlayerLeft:
+            client->m2cPlayerLeftGlobalChat(payload.nicks[i]);
+            break;
+
+         case LobbyChatMessage:
+            client->m2cSendChat(payload.nicks[i], false, payload.messages[messageIndex++].c_str());
+            break;
+
+         default:
+            TNLAssert(false, "Unknown lobby chat event!");
+            break;
+      }
+   }
+
+   mMessagesSent += payload.size();
+}
+
+
+void LobbyChat::flush(const Vector<MasterServerConnection *> *clients)
+{
+   Payload payload;
+
+   // Whoever asked for the member list gets that, plus this tick's news, less the joins and leaves the list
+   // already reflects
+   for(S32 i = 0; i < mNeedMemberList.size(); i++)
+   {
+      MasterServerConnection *client = mNeedMemberList[i];
+
+      if(!client)
+         continue;
+
+      payload.clear();
+      sendMemberList(client, payload);
+      buildPayload(payload, client->getClientId(), false);
+      send(client, payload);
+   }
+
+   if(mEvents.size() > 0)
+   {
+      // Everyone not involved in anything this tick gets the same thing, so we only build it once
+      Payload forMembers, forEveryone;
+      buildPayload(forMembers, NoClientId, true);
+
+      if(mHaveEventsForEveryone)
+         buildPayload(forEveryone, NoClientId, false);
+
+      // If it was all joins and leaves, only members need to hear about it
+      const Vector<MasterServerConnection *> *recipients = mHaveEventsForEveryone ? clients : &mMembers;
+
+      for(S32 i = 0; i < recipients->size(); i++)
+      {
+         MasterServerConnection *client = recipients->get(i);
+         S32 clientId = client->getClientId();
+
+         if(mNewMembers.find(clientId) != mNewMembers.end())      // Already taken care of
+            continue;
+
+         if(mSources.find(clientId) != mSources.end())
+         {
+            payload.clear();
+            buildPayload(payload, clientId, client->isInLobbyChat);
+            send(client, payload);
+         }
+         else
+            send(client, client->isInLobbyChat ? forMembers : forEveryone);
+      }
+   }
+
+   mEvents.clear();
+   mNeedMemberList.clear();
+   mSources.clear();
+   mNewMembers.clear();
+   mHaveEventsForEveryone = false;
+}
+
+
+const Vector<MasterServerConnection *> *LobbyChat::getMembers() const
+{
+   return &mMembers;
+}
+
+
+// Joins, leaves, chat messages and the like
+U32 LobbyChat::getEventsRelayed() const
+{
+   return mEventsRelayed;
+}
+
+
+// RPCs sent, counting each member list and batch as one
+U32 LobbyChat::getMessagesSent() const
+{
+   return mMessagesSent;
+}
+
+
+}
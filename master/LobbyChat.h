@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _LOBBY_CHAT_H_
+#define _LOBBY_CHAT_H_
+
+#include "masterInterface.h"
+
+#include "tnlNetBase.h"
+#include "tnlNetStringTable.h"
+#include "tnlVector.h"
+
+#include <set>
+#include <string>
+
+using namespace TNL;
+using namespace std;
+
+namespace Master
+{
+
+class MasterServerConnection;
+
+
+// Keeps track of who is in lobby chat, and relays the comings, goings and chatter of clients to everyone who needs to
+// hear about them.  Rather than telling every client about every event as it happens, we save up a tick's worth and
+// send each client a single message with everything it needs to know, once per tick, from flush().  Clients too old
+// to understand that message get the individual messages they always have.
+class LobbyChat
+{
+private:
+   struct Event
+   {
+      LobbyChatEventType type;
+      StringTableEntry nick;
+      string message;            // Chat messages only
+      S32 sourceId;              // Client id of whoever this is about; they don't get told about it
+      bool lobbyOnly;            // Joins and leaves only go to people in lobby chat
+   };
+
+   // What we send a client
+   struct Payload
+   {
+      Vector<U8> eventTypes;
+      Vector<StringTableEntry> nicks;
+      Vector<string> messages;
+
+      void add(LobbyChatEventType type, const StringTableEntry &nick, const string &message);
+      void clear();
+      S32 size() const;
+   };
+
+   Vector<MasterServerConnection *> mMembers;               // Each knows its index here, see mLobbyChatIndex
+   Vector<Event> mEvents;                                  // This tick's, in order
+   Vector<SafePtr<MasterServerConnection> > mNeedMemberList;
+
+   std::set<S32> mSources;                                 // Client ids of everyone something happened to this tick
+   std::set<S32> mNewMembers;                              // Client ids of those who will get a fresh member list
+   bool mHaveEventsForEveryone;
+
+   // Stats
+   U32 mEventsRelayed;
+   U32 mMessagesSent;
+
+   void addEvent(LobbyChatEventType type, const MasterServerConnection *source, const StringTableEntry &nick,
+                 const string &message = "");
+
+   void addMember(MasterServerConnection *client);
+   void removeMember(MasterServerConnection *client);
+
+   void buildPayload(Payload &payload, S32 recipientId, bool includeLobbyEvents) const;
+   void sendMemberList(MasterServerConnection *client, Payload &payload);
+   void send(MasterServerConnection *client, const Payload &payload);
+
+public:
+   static const S32 MemberListChunkSize = 50;     // Names per m2cPlayersInGlobalChat; more follow as joins
+
+   LobbyChat();            // Constructor
+   virtual ~LobbyChat();   // Destructor
+
+   void clientConnected(MasterServerConnection *client);
+   void clientDisconnected(MasterServerConnection *client);
+
+   void join(MasterServerConnection *client);
+   void leave(MasterServerConnection *client);
+   void rename(MasterServerConnection *client, const StringTableEntry &newName);
+   void chat(MasterServerConnection *client, const char *message);
+
+   void requestMemberList(MasterServerConnection *client);
+
+   // Sends everything that has happened since the last flush; clients is everyone connected
+   void flush(const Vector<MasterServerConnection *> *clients);
+
+   const Vector<MasterServerConnection *> *getMembers() const;
+
+   U32 getEventsRelayed() const;
+   U32 getMessagesSent() const;
+};
+
+
+}
+
+#endif
@@ -8,6 +8,8 @@
 #include "master.h"
 #include "database.h"
 #include "DatabaseAccessThread.h"
+#include "StatsBatcher.h"
+#include "LobbyChat.h"
 #include "authenticator.h"
 #include "GameJoltConnector.h"
 #include "EasterEgg.h"
@@ -39,6 +41,7 @@ public:
 // Define some statics
 HighScores MasterServerConnection::highScores;
 MasterServer *MasterServerConnection::mMaster = NULL;
+MasterServerConnection::CredentialVerifier MasterServerConnection::mCredentialVerifier = NULL;
 
 
 static S32 getNextId()
@@ -63,6 +66,7 @@ MasterServerConnection::MasterServerConnection()
    setIsConnectionToClient();
    setIsAdaptive();
    isInLobbyChat = false;
+   mLobbyChatIndex = -1;
    mAuthenticated = false;
    mIsDebugClient = false;
    mIsIgnoredFromList = false;
@@ -77,12 +81,8 @@ MasterServerConnection::MasterServerConnection()
 /// Destructor removes the connection from the doubly linked list of server connections
 MasterServerConnection::~MasterServerConnection()
 {
-   const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
-
-   // Notify all clients we're quitting -- m2cClientDisconnected will exit player from LobbyChat as well
-   for(S32 i = 0; i < clientList->size(); i++)
-         if(clientList->get(i)->isConnectionToClient() && clientList->get(i) != this)    // All clients except self
-            clientList->get(i)->m2cClientDisconnected(mPlayerOrServerName);
+   // Notify all clients we're quitting -- this takes us out of LobbyChat as well
+   mMaster->getLobbyChat()->clientDisconnected(this);
 
 
    // Remove this from the client/server lists
@@ -94,11 +94,7 @@ MasterServerConnection::~MasterServerConnection()
 
    }
    else if(mConnectionType == MasterConnectionTypeServer)
-   {
-      S32 index = mMaster->getServerList()->getIndex(this);
-      if(index > -1)
-         mMaster->removeServer (index);
-   }
+      mMaster->removeServer(this);
 
    if(mLoggingStatus != "")
    {
@@ -130,6 +126,22 @@ bool MasterServerConnection::isAuthenticated() { return mAuthenticated; }
 
 // Check username & password against database
 MasterServerConnection::PHPBB3AuthenticationStatus MasterServerConnection::verifyCredentials(string &username, string password)
+{
+   if(mCredentialVerifier)
+      return mCredentialVerifier(username, password);
+
+   return verifyPhpbbCredentials(username, password);
+}
+
+
+void MasterServerConnection::setCredentialVerifier(CredentialVerifier verifier)
+{
+   mCredentialVerifier = verifier;
+}
+
+
+MasterServerConnection::PHPBB3AuthenticationStatus MasterServerConnection::verifyPhpbbCredentials(string &username, 
+                                                                                                  const string &password)
 
 #ifdef VERIFY_PHPBB3    // Defined in Linux Makefile, not in VC++ project
 {
@@ -164,7 +176,7 @@ MasterServerConnection::PHPBB3AuthenticationStatus MasterServerConnection::verif
       }
    }
 }
-#else // verifyCredentials
+#else // verifyPhpbbCredentials
 {
    return Unsupported;
 }
@@ -264,21 +276,8 @@ void MasterServerConnection::processAutentication(StringTableEntry newName, PHPB
 
       if(mPlayerOrServerName != newName)
       {
-         if(isInLobbyChat)         // Need to tell clients new name, in case of delayed authentication
-         {
-            const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
-
-            for(S32 i = 0; i < clientList->size(); i++)
-            {
-               MasterServerConnection *client = clientList->get(i);
-
-               if(client != this && client->isInLobbyChat)
-               {
-                  client->m2cPlayerLeftGlobalChat(mPlayerOrServerName);
-                  client->m2cPlayerJoinedGlobalChat(newName);
-               }
-            }
-         }
+         // Need to tell clients new name, in case of delayed authentication
+         mMaster->getLobbyChat()->rename(this, newName);
          mPlayerOrServerName = newName;
       }
 
@@ -333,53 +332,19 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mQueryHostServers, (U32 que
 }
 
 
+// The registry keeps the answer to this query ready to go, so all we do here is send it
 void MasterServerConnection::c2mQueryServersOption(U32 queryId, bool hostonly)
 {
-   Vector<IPAddress> addresses(IP_MESSAGE_ADDRESS_COUNT);
-   Vector<S32> serverIdList(IP_MESSAGE_ADDRESS_COUNT);
-   
-
-   const Vector<MasterServerConnection *> *serverList = mMaster->getServerList();
-
-   for(S32 i = 0; i < serverList->size(); i++)
-   {
-      // Hide hidden servers
-      if(serverList->get(i)->mIsIgnoredFromList)  
-         continue;
+   const ServerRegistry::QueryResponse &response = mMaster->getServerQueryResponse(mCSProtocolVersion, hostonly);
 
-      // Skip servers with incompatible versions
-      if(serverList->get(i)->mCSProtocolVersion != mCSProtocolVersion)  
-         continue;
+   for(S32 i = 0; i < response.addresses.size(); i++)
+      sendM2cQueryServersResponse(queryId, response.addresses[i], response.serverIds[i]);
 
-      // Skip servers with host mode
-      if(((serverList->get(i)->mInfoFlags & HostModeFlag) != 0) != hostonly)
-         continue;
+   // An empty list tells the client we're done
+   Vector<IPAddress> addresses;
+   Vector<S32> serverIdList;
 
-      // Add us to the results list
-      addresses.push_back(serverList->get(i)->getNetAddress().toIPAddress());
-      serverIdList.push_back(serverList->get(i)->getClientId());
-
-      // If we get a packet's worth, send it to the client and empty our buffer...
-      if(addresses.size() == IP_MESSAGE_ADDRESS_COUNT)
-      {
-         sendM2cQueryServersResponse(queryId, addresses, serverIdList);
-         
-         addresses.clear();
-         serverIdList.clear();
-      }
-   }
-
-   // Send the final packet
    sendM2cQueryServersResponse(queryId, addresses, serverIdList);
-
-   // If we sent any with the previous message, send another list with no servers
-   if(addresses.size())
-   {
-      addresses.clear();
-      serverIdList.clear();
-
-      sendM2cQueryServersResponse(queryId, addresses, serverIdList);
-   }
 }
 
 
@@ -523,15 +488,12 @@ void MasterServerConnection::writeClientServerList_JSON()
       // First the servers
       fprintf(f, "{\n\t\"servers\": [");
 
-      const Vector<MasterServerConnection *> *serverList = mMaster->getServerList();
+      const Vector<MasterServerConnection *> *serverList = mMaster->getListedServerList();
 
       for(S32 i = 0; i < serverList->size(); i++)
       {
          MasterServerConnection *server = serverList->get(i);
 
-         if(server->mIsIgnoredFromList)
-            continue;
-
          fprintf(f, "%s\n\t\t{\n\t\t\t\"serverName\": \"%s\",\n\t\t\t\"protocolVersion\": %d,\n\t\t\t\"currentLevelName\": \"%s\",\n\t\t\t\"currentLevelType\": \"%s\",\n\t\t\t\"playerCount\": %d\n\t\t}",
                      first ? "" : ", ", sanitizeForJson(server->mPlayerOrServerName.getString()).c_str(),
                      server->mCSProtocolVersion, server->mLevelName.getString(), server->mLevelType.getString(), server->mPlayerCount);
@@ -750,6 +712,8 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, s2mUpdateServerStatus, (Strin
       mMaxPlayers  = maxPlayers;
       mInfoFlags   = infoFlags;
 
+      mMaster->updateServer(this);     // In case host mode changed
+
       // Check to ensure we're not getting flooded with these requests
       checkActivityTime(FOUR_SECONDS);
 
@@ -793,20 +757,6 @@ void MasterServerConnection::processIsAuthenticated(GameStats *gameStats)
 
 
 
-struct AddGameReport : public MasterThreadEntry
-{
-   GameStats mStats;
-
-   AddGameReport(const MasterSettings *settings) : MasterThreadEntry(settings) { }    // Quickie constructor
-
-   void run()
-   {
-      DatabaseWriter databaseWriter = getDatabaseWriter(mSettings);
-      // Will fail if compiled without database support and gWriteStatsToDatabase is true
-      databaseWriter.insertStats(mStats);
-   }
-};
-
 void MasterServerConnection::writeStatisticsToDb(VersionedGameStats &stats)
 {
    if(!checkActivityTime(SIX_SECONDS))
@@ -827,30 +777,10 @@ void MasterServerConnection::writeStatisticsToDb(VersionedGameStats &stats)
    processIsAuthenticated(gameStats);
    processStatsResults(gameStats);
 
-   RefPtr<AddGameReport> gameReport = new AddGameReport(mMaster->getSettings());
-   gameReport->mStats = *gameStats;  // copy so we keep data during a thread
-   mMaster->getDatabaseAccessThread()->addEntry(gameReport);
+   mMaster->getStatsBatcher()->addGameStats(*gameStats);
 }
 
    
-struct AchievementWriter : public MasterThreadEntry
-{
-   U8 achievementId;
-   StringTableEntry playerNick;
-   StringTableEntry mPlayerOrServerName;
-   string addressString;
-
-   AchievementWriter(const MasterSettings *settings) : MasterThreadEntry(settings) { }    // Quickie constructor
-
-   void run()
-   {
-      DatabaseWriter databaseWriter = getDatabaseWriter(mSettings);
-      // Will fail if compiled without database support and gWriteStatsToDatabase is true
-      databaseWriter.insertAchievement(achievementId, playerNick.getString(), mPlayerOrServerName.getString(), addressString);
-   }
-};
-
-
 void MasterServerConnection::writeAchievementToDb(U8 achievementId, const StringTableEntry &playerNick)
 {
    if(!checkActivityTime(6 * 1000))  // 6 seconds
@@ -860,12 +790,8 @@ void MasterServerConnection::writeAchievementToDb(U8 achievementId, const String
    if(playerNick == "")
       return;
 
-   RefPtr<AchievementWriter> a_writer = new AchievementWriter(mMaster->getSettings());
-   a_writer->achievementId = achievementId;
-   a_writer->playerNick = playerNick;
-   a_writer->mPlayerOrServerName = mPlayerOrServerName;
-   a_writer->addressString = getNetAddressString();
-   mMaster->getDatabaseAccessThread()->addEntry(a_writer);
+   mMaster->getStatsBatcher()->addAchievement(achievementId, playerNick.getString(), mPlayerOrServerName.getString(),
+                                              getNetAddressString());
 }
 
 
@@ -886,7 +812,8 @@ struct LevelInfoWriter : public MasterThreadEntry
    {
       DatabaseWriter databaseWriter = getDatabaseWriter(mSettings);
       // Will fail if compiled without database support and gWriteStatsToDatabase is true
-      databaseWriter.insertLevelInfo(hash, levelName, creator, gameType.getString(), hasLevelGen, teamCount, winningScore, gameDurationInSeconds);
+      if(!databaseWriter.insertLevelInfo(hash, levelName, creator, gameType.getString(), hasLevelGen, teamCount, winningScore, gameDurationInSeconds))
+         setFailed();
    }
 };
 
@@ -989,10 +916,12 @@ struct TotalLevelRatingsReader : public MasterThreadEntry
 {
    U32 dbId;
    S16 rating;
+   shared_ptr<TotalLevelRating> totalRating;    // Grabbed up front, so run() doesn't touch the cache from another thread
 
    TotalLevelRatingsReader(const MasterSettings *settings, U32 databaseId) : MasterThreadEntry(settings)    // Constructor
    {
       dbId = databaseId;
+      totalRating = totalLevelRatingsCache[dbId];
    }
 
    // If, while we are running, we get some updated data from the client, receivedUpdateByClientWhileBusy 
@@ -1000,8 +929,6 @@ struct TotalLevelRatingsReader : public MasterThreadEntry
    // the latest data.
    void run()
    {
-      TotalLevelRating *totalRating = totalLevelRatingsCache[dbId].get();
-      
       do 
       {
          totalRating->receivedUpdateByClientWhileBusy = false;
@@ -1013,8 +940,6 @@ struct TotalLevelRatingsReader : public MasterThreadEntry
 
    void finish()
    {
-      TotalLevelRating *totalRating = totalLevelRatingsCache[dbId].get();
-
       totalRating->setRatingMagicValue(rating);  // Because, as noted above, rating could be a magic number
       totalRating->isBusy = false;
 
@@ -1718,40 +1643,22 @@ void MasterServerConnection::onConnectionEstablished()
       m2cHostOnServerAvailable(true);
 
       // Notify all connected clients that someone has joined the master
-      const  Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
-
-      for(S32 i = 0; i < clientList->size(); i++)
-         if(clientList->get(i)->isConnectionToClient() && clientList->get(i) != this)    // All clients except self
-            clientList->get(i)->m2cClientConnected(mPlayerOrServerName);
+      mMaster->getLobbyChat()->clientConnected(this);
    }
 }
 
 
 TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mJoinGlobalChat, ())
 {
-   Vector<StringTableEntry> names;
+   LobbyChat *lobbyChat = mMaster->getLobbyChat();
 
-   const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
-
-   for(S32 i = 0; i < clientList->size(); i++)
-      if(clientList->get(i) != this && clientList->get(i)->isInLobbyChat)
-         names.push_back(clientList->get(i)->mPlayerOrServerName);
-
-   if(names.size() > 0)
-      m2cPlayersInGlobalChat(names);   // Send to this client, to avoid blank name list of quickly leave/join
+   lobbyChat->requestMemberList(this); // Send to this client, to avoid blank name list of quickly leave/join
 
    if(mIsIgnoredFromList)              // don't list name in lobby, too.
       return;
 
    mLeaveLobbyChatTimer = 0;           // don't continue with delayed chat leave.
-   if(isInLobbyChat)                   // Already in Lobby Chat
-      return;
-
-   isInLobbyChat = true;
-      
-   for(S32 i = 0; i < clientList->size(); i++)
-      if(clientList->get(i) != this && clientList->get(i)->isInLobbyChat)
-         clientList->get(i)->m2cPlayerJoinedGlobalChat(mPlayerOrServerName);
+   lobbyChat->join(this);              // Does nothing if we're already in Lobby Chat
 }
 
 
@@ -1802,6 +1709,7 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mSendChat, (StringPtr messa
                if(server->getNetAddress().isEqualAddress(addr) && (addr.port == 0 || addr.port == server->getNetAddress().port))
                {
                   server->mIsIgnoredFromList = true;
+                  mMaster->updateServer(server);
                   m2cSendChat(server->mPlayerOrServerName, true, "dropped");
                   droppedServer = true;
                }
@@ -1821,6 +1729,7 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mSendChat, (StringPtr messa
                {
                   broughtBackServer = true;
                   serverList->get(i)->mIsIgnoredFromList = false;
+                  mMaster->updateServer(serverList->get(i));
                   m2cSendChat(serverList->get(i)->mPlayerOrServerName, true, "servers restored");
                }
             if(!broughtBackServer)
@@ -1931,15 +1840,9 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mSendChat, (StringPtr messa
    mChatTooFast = false;
 
 
-   // Now relay the chat to all connected clients
+   // Now relay the chat to all connected clients, except self, at the end of this tick
    if(!badCommand && !isPrivate)
-   {
-      const  Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
-
-      for(S32 i = 0; i < clientList->size(); i++)
-         if(clientList->get(i) != this)    // ...except self!
-            clientList->get(i)->m2cSendChat(mPlayerOrServerName, isPrivate, message);
-   }
+      mMaster->getLobbyChat()->chat(this, message.getString());
 
 
    // Log F5 chat messages
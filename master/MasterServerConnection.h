@@ -158,6 +158,7 @@ public:
 
    StringTableEntry mServerDescr;               // Server description
    bool isInLobbyChat;
+   S32 mLobbyChatIndex;                         // Where we are in LobbyChat's member list, -1 if not in lobby chat
 
    bool mIsMasterAdmin;
 
@@ -192,6 +193,16 @@ public:
    // Check username & password against database
    static PHPBB3AuthenticationStatus verifyCredentials(string &username, string password);
 
+   // Lets something other than phpBB check credentials, e.g. the load tester's stand-in; NULL goes back to phpBB
+   typedef PHPBB3AuthenticationStatus (*CredentialVerifier)(string &username, const string &password);
+   static void setCredentialVerifier(CredentialVerifier verifier);
+
+private:
+   static CredentialVerifier mCredentialVerifier;
+   static PHPBB3AuthenticationStatus verifyPhpbbCredentials(string &username, const string &password);
+
+public:
+
    PHPBB3AuthenticationStatus checkAuthentication(const char *password, bool doNotDelay = false);
    void processAutentication(StringTableEntry newName, PHPBB3AuthenticationStatus status, TNL::Int<32> badges,
                              U16 gamesPlayed);
@@ -0,0 +1,205 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "ServerRegistry.h"
+
+#include "MasterServerConnection.h"
+
+#include "tnlAssert.h"
+
+namespace Master
+{
+
+// Hidden servers aren't in any group
+static const U64 NotListed = U64_MAX;
+
+
+ServerRegistry::Group::Group()
+{
+   responseIsCurrent = false;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+ServerRegistry::ServerRegistry()
+{
+   mResponsesBuilt = 0;
+}
+
+
+// Destructor
+ServerRegistry::~ServerRegistry()
+{
+   // Do nothing
+}
+
+
+U64 ServerRegistry::getGroupKey(U32 protocolVersion, bool hostMode)
+{
+   return (U64(protocolVersion) << 1) | (hostMode ? 1 : 0);
+}
+
+
+U64 ServerRegistry::getGroupKey(const MasterServerConnection *server)
+{
+   if(server->mIsIgnoredFromList)
+      return NotListed;
+
+   return getGroupKey(server->mCSProtocolVersion, (server->mInfoFlags & HostModeFlag) != 0);
+}
+
+
+void ServerRegistry::add(MasterServerConnection *server)
+{
+   TNLAssert(mFiledUnder.find(server) == mFiledUnder.end(), "Server is already registered!");
+
+   U64 key = getGroupKey(server);
+
+   mServers.push_back(server);
+   mFiledUnder[server] = key;
+
+   file(server, key);
+}
+
+
+void ServerRegistry::remove(MasterServerConnection *server)
+{
+   std::map<const MasterServerConnection *, U64>::iterator it = mFiledUnder.find(server);
+
+   if(it == mFiledUnder.end())
+      return;
+
+   unfile(server, it->second);
+   mFiledUnder.erase(it);
+
+   S32 index = mServers.getIndex(server);
+   TNLAssert(index >= 0, "Registered server missing from list!");
+   mServers.erase_fast(index);
+}
+
+
+void ServerRegistry::update(MasterServerConnection *server)
+{
+   std::map<const MasterServerConnection *, U64>::iterator it = mFiledUnder.find(server);
+
+   if(it == mFiledUnder.end())
+      return;
+
+   U64 key = getGroupKey(server);
+
+   if(key == it->second)
+      return;
+
+   unfile(server, it->second);
+   file(server, key);
+
+   it->second = key;
+}
+
+
+void ServerRegistry::file(MasterServerConnection *server, U64 key)
+{
+   if(key == NotListed)
+      return;
+
+   Group &group = mGroups[key];
+
+   group.servers.push_back(server);
+   group.responseIsCurrent = false;
+
+   mListedServers.push_back(server);
+}
+
+
+void ServerRegistry::unfile(MasterServerConnection *server, U64 key)
+{
+   if(key == NotListed)
+      return;
+
+   GroupMap::iterator it = mGroups.find(key);
+   TNLAssert(it != mGroups.end(), "Server filed in a group that doesn't exist!");
+
+   Group &group = it->second;
+
+   S32 index = group.servers.getIndex(server);
+   TNLAssert(index >= 0, "Server missing from its group!");
+   group.servers.erase_fast(index);
+   group.responseIsCurrent = false;
+
+   if(group.servers.size() == 0)
+      mGroups.erase(it);
+
+   index = mListedServers.getIndex(server);
+   TNLAssert(index >= 0, "Listed server missing from list!");
+   mListedServers.erase_fast(index);
+}
+
+
+void ServerRegistry::buildResponse(Group &group)
+{
+   group.response.addresses.clear();
+   group.response.serverIds.clear();
+
+   for(S32 i = 0; i < group.servers.size(); i++)
+   {
+      // Start a new message every IP_MESSAGE_ADDRESS_COUNT servers
+      if(i % IP_MESSAGE_ADDRESS_COUNT == 0)
+      {
+         group.response.addresses.push_back(Vector<IPAddress>());
+         group.response.serverIds.push_back(Vector<S32>());
+
+         group.response.addresses.last().reserve(IP_MESSAGE_ADDRESS_COUNT);
+         group.response.serverIds.last().reserve(IP_MESSAGE_ADDRESS_COUNT);
+      }
+
+      group.response.addresses.last().push_back(group.servers[i]->getNetAddress().toIPAddress());
+      group.response.serverIds.last().push_back(group.servers[i]->getClientId());
+   }
+
+   group.responseIsCurrent = true;
+}
+
+
+const ServerRegistry::QueryResponse &ServerRegistry::getQueryResponse(U32 protocolVersion, bool hostMode)
+{
+   GroupMap::iterator it = mGroups.find(getGroupKey(protocolVersion, hostMode));
+
+   if(it == mGroups.end())
+      return mEmptyResponse;
+
+   Group &group = it->second;
+
+   if(!group.responseIsCurrent)
+   {
+      buildResponse(group);
+      mResponsesBuilt++;
+   }
+
+   return group.response;
+}
+
+
+const Vector<MasterServerConnection *> *ServerRegistry::getServers() const
+{
+   return &mServers;
+}
+
+
+const Vector<MasterServerConnection *> *ServerRegistry::getListedServers() const
+{
+   return &mListedServers;
+}
+
+
+U32 ServerRegistry::getResponsesBuilt() const
+{
+   return mResponsesBuilt;
+}
+
+
+}
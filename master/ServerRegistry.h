@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _SERVER_REGISTRY_H_
+#define _SERVER_REGISTRY_H_
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+#include "tnlUDP.h"
+
+#include <map>
+
+using namespace TNL;
+
+namespace Master
+{
+
+class MasterServerConnection;
+
+
+// Keeps track of the game servers connected to the master.  Servers clients can see are filed by the C-S protocol
+// they speak and whether they're in host mode, which is exactly what a client's server query asks for, so answering
+// one doesn't mean looking at every server.  Each group also holds its query response, already split into RPC-sized
+// pieces; that gets rebuilt only after a server in the group arrives, leaves, or changes how it should be listed.
+class ServerRegistry
+{
+public:
+   // What we send back to a client's server query: one m2cQueryServersResponse per entry, each with at most
+   // IP_MESSAGE_ADDRESS_COUNT servers.  The empty response that ends every list is not included.
+   struct QueryResponse
+   {
+      Vector<Vector<IPAddress> > addresses;
+      Vector<Vector<S32> > serverIds;
+   };
+
+private:
+   struct Group
+   {
+      Vector<MasterServerConnection *> servers;
+      QueryResponse response;
+      bool responseIsCurrent;
+
+      Group();
+   };
+
+   typedef std::map<U64, Group> GroupMap;
+
+   Vector<MasterServerConnection *> mServers;            // All of them, whether clients can see them or not
+   Vector<MasterServerConnection *> mListedServers;      // Just the ones clients can see
+
+   std::map<const MasterServerConnection *, U64> mFiledUnder;     // Which group each server is in
+   GroupMap mGroups;
+
+   QueryResponse mEmptyResponse;
+   U32 mResponsesBuilt;
+
+   static U64 getGroupKey(const MasterServerConnection *server);
+   static U64 getGroupKey(U32 protocolVersion, bool hostMode);
+
+   void file(MasterServerConnection *server, U64 key);
+   void unfile(MasterServerConnection *server, U64 key);
+
+   static void buildResponse(Group &group);
+
+public:
+   ServerRegistry();       // Constructor
+   virtual ~ServerRegistry();
+
+   void add(MasterServerConnection *server);
+   void remove(MasterServerConnection *server);
+
+   // Call after a server's protocol version, host mode flag, or hidden status may have changed; cheap if none did
+   void update(MasterServerConnection *server);
+
+   const QueryResponse &getQueryResponse(U32 protocolVersion, bool hostMode);
+
+   const Vector<MasterServerConnection *> *getServers() const;
+   const Vector<MasterServerConnection *> *getListedServers() const;
+
+   U32 getResponsesBuilt() const;      // How many times we've had to rebuild a group's response, for testing
+};
+
+
+}
+
+#endif
@@ -0,0 +1,251 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "StatsBatcher.h"
+
+#include "DatabaseAccessThread.h"
+#include "master.h"
+
+#include "../zap/stringUtils.h"     // For getTimeStamp()
+
+#include "tnlLog.h"
+#include "tnlRandom.h"
+
+using namespace DbWriter;
+
+namespace Master
+{
+
+// Writes one batch on a database thread, and reports back to the batcher on the main thread
+struct StatsBatchWriter : public ThreadEntry
+{
+   StatsBatcher *mBatcher;
+   const MasterSettings *mSettings;
+   StatsBatch mBatch;
+   S32 mAttempts;      // Including this one
+
+   StatsBatchWriter(StatsBatcher *batcher, const MasterSettings *settings, const StatsBatch &batch, S32 attempts) :
+         mBatch(batch)
+   {
+      mBatcher = batcher;
+      mSettings = settings;
+      mAttempts = attempts;
+   }
+
+   void run()
+   {
+      DatabaseWriter databaseWriter = getDatabaseWriter(mSettings);
+
+      if(!databaseWriter.insertStatsBatch(mBatch))
+         setFailed();
+   }
+
+   void finish()
+   {
+      mBatcher->batchFinished(mBatch, mAttempts, !hasFailed());
+   }
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+StatsBatcher::StatsBatcher(const MasterSettings *settings, DatabaseAccessThread *databaseAccessThread)
+{
+   mSettings = settings;
+   mDatabaseAccessThread = databaseAccessThread;
+
+   mBatchesInFlight = 0;
+
+   mBatchesWritten = 0;
+   mRecordsWritten = 0;
+   mRetries = 0;
+   mRecordsDropped = 0;
+}
+
+
+// Destructor
+StatsBatcher::~StatsBatcher()
+{
+   S32 unwritten = mPending.size();
+
+   for(S32 i = 0; i < mFailed.size(); i++)
+      unwritten += mFailed[i]->batch.size();
+
+   if(unwritten > 0)
+      logprintf(LogConsumer::LogWarning, "Shutting down with %d stats records not yet written", unwritten);
+
+   mFailed.deleteAndClear();
+}
+
+
+S32 StatsBatcher::getBatchSize() const
+{
+   return max(mSettings->getVal<U32>(IniKey::StatsBatchSize), 1u);
+}
+
+
+U32 StatsBatcher::getFlushInterval() const
+{
+   return mSettings->getVal<U32>(IniKey::StatsBatchSeconds) * 1000;
+}
+
+
+void StatsBatcher::addGameStats(const GameStats &gameStats)
+{
+   if(mPending.size() == 0)
+      mFlushTimer.reset(getFlushInterval());
+
+   mPending.games.push_back(gameStats);
+
+   if(mPending.size() >= getBatchSize())
+      flush();
+}
+
+
+void StatsBatcher::addAchievement(U8 achievementId, const string &playerName, const string &serverName, const string &serverIP)
+{
+   if(mPending.size() == 0)
+      mFlushTimer.reset(getFlushInterval());
+
+   AchievementRecord achievement;
+   achievement.achievementId = achievementId;
+   achievement.playerName = playerName;
+   achievement.serverName = serverName;
+   achievement.serverIP = serverIP;
+
+   mPending.achievements.push_back(achievement);
+
+   if(mPending.size() >= getBatchSize())
+      flush();
+}
+
+
+void StatsBatcher::idle(U32 timeDelta)
+{
+   if(mPending.size() > 0 && mFlushTimer.update(timeDelta))
+      flush();
+
+   for(S32 i = mFailed.size() - 1; i >= 0; i--)
+      if(mFailed[i]->retryTimer.update(timeDelta))
+      {
+         FailedBatch *failed = mFailed[i];
+         mFailed.erase(i);
+
+         submit(failed->batch, failed->attempts);
+         delete failed;
+      }
+}
+
+
+void StatsBatcher::flush()
+{
+   if(mPending.size() == 0)
+      return;
+
+   // Random, so ids from before a restart can't come back
+   U8 bytes[16];
+   Random::read(bytes, sizeof(bytes));
+
+   char hex[3];
+   for(U32 i = 0; i < sizeof(bytes); i++)
+   {
+      dSprintf(hex, sizeof(hex), "%02x", bytes[i]);
+      mPending.batchId += hex;
+   }
+
+   submit(mPending, 0);
+   mPending.clear();
+}
+
+
+void StatsBatcher::submit(const StatsBatch &batch, S32 attempts)
+{
+   RefPtr<StatsBatchWriter> writer = new StatsBatchWriter(this, mSettings, batch, attempts + 1);
+
+   mBatchesInFlight++;
+   mDatabaseAccessThread->addEntry(writer);
+}
+
+
+// Called from StatsBatchWriter::finish(), on the main thread.  A batch we were told failed may have been written anyway;
+// it carries its id when it's sent again, and the database skips it if it has already seen that id.
+void StatsBatcher::batchFinished(const StatsBatch &batch, S32 attempts, bool succeeded)
+{
+   mBatchesInFlight--;
+
+   if(succeeded)
+   {
+      mBatchesWritten++;
+      mRecordsWritten += batch.size();
+      return;
+   }
+
+   if(attempts >= MaxAttempts)
+   {
+      logprintf(LogConsumer::LogError, "[%s] Giving up on writing %d games and %d achievements to the database after %d attempts",
+                getTimeStamp().c_str(), batch.games.size(), batch.achievements.size(), attempts);
+
+      mRecordsDropped += batch.size();
+      return;
+   }
+
+   FailedBatch *failed = new FailedBatch;
+   failed->batch = batch;
+   failed->attempts = attempts;
+   failed->retryTimer.reset(FirstRetryDelay << (attempts - 1));
+
+   mFailed.push_back(failed);
+   mRetries++;
+
+   logprintf(LogConsumer::LogWarning, "[%s] Could not write %d stats records to the database; will try again in %d seconds",
+             getTimeStamp().c_str(), batch.size(), failed->retryTimer.getCurrent() / 1000);
+}
+
+
+S32 StatsBatcher::getPendingCount() const
+{
+   return mPending.size();
+}
+
+
+S32 StatsBatcher::getFailedBatchCount() const
+{
+   return mFailed.size();
+}
+
+
+S32 StatsBatcher::getBatchesInFlight() const
+{
+   return mBatchesInFlight;
+}
+
+
+U32 StatsBatcher::getBatchesWritten() const
+{
+   return mBatchesWritten;
+}
+
+
+U32 StatsBatcher::getRecordsWritten() const
+{
+   return mRecordsWritten;
+}
+
+
+U32 StatsBatcher::getRetryCount() const
+{
+   return mRetries;
+}
+
+
+U32 StatsBatcher::getRecordsDropped() const
+{
+   return mRecordsDropped;
+}
+
+
+}
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _STATS_BATCHER_H_
+#define _STATS_BATCHER_H_
+
+#include "database.h"
+
+#include "../zap/Timer.h"
+
+#include "tnlVector.h"
+
+using namespace TNL;
+using namespace Zap;
+
+namespace Master
+{
+
+class DatabaseAccessThread;
+class MasterSettings;
+struct StatsBatchWriter;
+
+
+// Collects game reports and achievements as servers send them in, and writes them to the database in batches, each
+// in a single transaction.  A batch goes out when it's full or when it's been waiting long enough.  A batch that fails
+// is rolled back in its entirety, and tried again a bit later; one that keeps failing is eventually given up on.
+class StatsBatcher
+{
+   friend struct StatsBatchWriter;
+
+private:
+   struct FailedBatch
+   {
+      DbWriter::StatsBatch batch;
+      S32 attempts;
+      Timer retryTimer;
+   };
+
+   const MasterSettings *mSettings;
+   DatabaseAccessThread *mDatabaseAccessThread;
+
+   DbWriter::StatsBatch mPending;
+   Timer mFlushTimer;                  // Runs while mPending has something in it
+
+   Vector<FailedBatch *> mFailed;      // Waiting for their retry timers
+   S32 mBatchesInFlight;
+
+   // Stats
+   U32 mBatchesWritten;
+   U32 mRecordsWritten;
+   U32 mRetries;
+   U32 mRecordsDropped;
+
+   void submit(const DbWriter::StatsBatch &batch, S32 attempts);
+   void batchFinished(const DbWriter::StatsBatch &batch, S32 attempts, bool succeeded);
+
+   S32 getBatchSize() const;
+   U32 getFlushInterval() const;
+
+public:
+   static const S32 MaxAttempts = 5;
+   static const U32 FirstRetryDelay = 1000;     // ms; doubles with each attempt
+
+   StatsBatcher(const MasterSettings *settings, DatabaseAccessThread *databaseAccessThread);    // Constructor
+   virtual ~StatsBatcher();                                                                      // Destructor
+
+   void addGameStats(const GameStats &gameStats);
+   void addAchievement(U8 achievementId, const string &playerName, const string &serverName, const string &serverIP);
+
+   void idle(U32 timeDelta);
+   void flush();                       // Send whatever's pending now, without waiting for the batch to fill
+
+   S32 getPendingCount() const;        // Records not yet sent to the database thread
+   S32 getFailedBatchCount() const;    // Batches waiting to be retried
+   S32 getBatchesInFlight() const;
+
+   U32 getBatchesWritten() const;
+   U32 getRecordsWritten() const;
+   U32 getRetryCount() const;
+   U32 getRecordsDropped() const;
+};
+
+
+}
+
+#endif
@@ -9,6 +9,7 @@
 
 #include "tnlTypes.h"
 #include "tnlLog.h"
+#include "tnlThread.h"
 
 #include "../zap/LevelInfoDatabaseMapping.h"
 #include "../zap/stringUtils.h"            // For replaceString() and itos()
@@ -19,6 +20,8 @@
    using namespace mysqlpp;
 #endif
 
+#include <map>
+
 using namespace std;
 using namespace TNL;
 using namespace Master;
@@ -43,6 +46,20 @@ DatabaseWriter getDatabaseWriter(const MasterSettings *settings)
 }
 
 
+S32 StatsBatch::size() const
+{
+   return games.size() + achievements.size();
+}
+
+
+void StatsBatch::clear()
+{
+   batchId.clear();
+   games.clear();
+   achievements.clear();
+}
+
+
 // Default constructor -- don't use this one!
 DatabaseWriter::DatabaseWriter()
 {
@@ -64,13 +81,26 @@ DatabaseWriter::DatabaseWriter(const char *db, const char *user, const char *pas
 }
 
 
+// Database threads may all want to create the stats database at once
+static Mutex createStatsDatabaseLock;
+
+
 // Sqlite Constructor
 DatabaseWriter::DatabaseWriter(const char *db)
 {
+   mServer[0] = 0;
+   mUser[0] = 0;
+   mPassword[0] = 0;
+
    strncpy(mDb, db, sizeof(mDb) - 1);
+   mDb[sizeof(mDb) - 1] = 0;
+
+   createStatsDatabaseLock.lock();
 
    if(!fileExists(mDb))
       createStatsDatabase();
+
+   createStatsDatabaseLock.unlock();
 }
 
 
@@ -96,101 +126,159 @@ void DatabaseWriter::initialize(const char *server, const char *db, const char *
 #endif
 
 
-static void insertStatsLoadout(const DbQuery &query, U64 playerId, const Vector<LoadoutStats> loadoutStats)
+// Rows for the tables nothing else refers to; we save these up and write them many rows to a statement
+struct LeafRows
 {
-   for(S32 i = 0; i < loadoutStats.size(); i++)
+   Vector<string> shots;      // 4 values per row
+   Vector<string> loadouts;   // 2 values per row
+};
+
+
+static const S32 MaxRowsPerInsert = 50;      // Keeps us well under sqlite's limit on the number of ?s in a statement
+
+
+// Writes rows of cols values each, with as few statements as we can
+static void insertRows(const DbQuery &query, const string &insertInto, S32 cols, const Vector<string> &values)
+{
+   S32 rows = values.size() / cols;
+
+   string row = "(";
+   for(S32 i = 0; i < cols; i++)
+      row += (i == 0) ? "?" : ", ?";
+   row += ")";
+
+   for(S32 first = 0; first < rows; first += MaxRowsPerInsert)
    {
-         string sql = "INSERT INTO stats_player_loadout(stats_player_id, loadout) "
-                       "VALUES(" + itos(playerId) + ", " + itos(loadoutStats[i].loadoutHash) + ");";
+      S32 count = min(MaxRowsPerInsert, rows - first);
+
+      string sql = insertInto + " VALUES " + row;
+      for(S32 i = 1; i < count; i++)
+         sql += ", " + row;
+
+      Vector<string> params(count * cols);
+      for(S32 i = first * cols; i < (first + count) * cols; i++)
+         params.push_back(values[i]);
 
-         query.runInsertQuery(sql);
+      query.runInsertQuery(sql.c_str(), params);
    }
 }
 
 
-static void insertStatsShots(const DbQuery &query, U64 playerId, const Vector<WeaponStats> weaponStats)
+static void addStatsLoadoutRows(U64 playerId, const Vector<LoadoutStats> &loadoutStats, LeafRows &rows)
+{
+   for(S32 i = 0; i < loadoutStats.size(); i++)
+   {
+      rows.loadouts.push_back(itos(playerId));
+      rows.loadouts.push_back(itos(loadoutStats[i].loadoutHash));
+   }
+}
+
+
+static void addStatsShotsRows(U64 playerId, const Vector<WeaponStats> &weaponStats, LeafRows &rows)
 {
    for(S32 i = 0; i < weaponStats.size(); i++)
    {
       if(weaponStats[i].shots > 0)
       {
-         string sql = "INSERT INTO stats_player_shots(stats_player_id, weapon, shots, shots_struck) "
-                       "VALUES(" + itos(playerId) + ", '" + WeaponInfo::getWeaponName(weaponStats[i].weaponType) + "', " + 
-                                  itos(weaponStats[i].shots) + ", " + itos(weaponStats[i].hits) + ");";
-         
-         query.runInsertQuery(sql);
+         rows.shots.push_back(itos(playerId));
+         rows.shots.push_back(WeaponInfo::getWeaponName(weaponStats[i].weaponType));
+         rows.shots.push_back(itos(weaponStats[i].shots));
+         rows.shots.push_back(itos(weaponStats[i].hits));
       }
    }
 }
 
 
+static void insertLeafRows(const DbQuery &query, const LeafRows &rows)
+{
+   insertRows(query, "INSERT INTO stats_player_shots(stats_player_id, weapon, shots, shots_struck)", 4, rows.shots);
+   insertRows(query, "INSERT INTO stats_player_loadout(stats_player_id, loadout)", 2, rows.loadouts);
+}
+
+
 // Inserts player and all associated weapon stats
-static U64 insertStatsPlayer(const DbQuery &query, const PlayerStats *playerStats, U64 gameId, const string &teamId)
-{
-   string sql = "INSERT INTO stats_player(stats_game_id, stats_team_id, player_name, "
-                                               "is_authenticated,               is_robot, "
-                                               "result,                         points, "
-                                               "kill_count,                     death_count, "
-                                               "suicide_count,                  switched_team_count, "
-                                               "asteroid_crashes,               flag_drops, "
-                                               "flag_pickups,                   flag_returns, "
-                                               "flag_scores,                    teleport_uses, "
-                                               "turret_kills,                   ff_kills, "
-                                               "asteroid_kills,                 turrets_engineered, "
-                                               "ffs_engineered,                 teleports_engineered, "
-                                               "distance_traveled )"                      
-                         "VALUES(" + itos(gameId) + ", " + teamId + ", '"     + sanitizeForSql(playerStats->name)           + "', " +
-                                 btos(playerStats->isAuthenticated)     + ", " + btos(playerStats->isRobot)           + ", " +
-                                 "'" + playerStats->gameResult + "'"    + ", " + itos(playerStats->points)            + ", " + 
-                                 itos(playerStats->kills)               + ", " + itos(playerStats->deaths)            + ", " +
-                                 itos(playerStats->suicides)            + ", " + itos(playerStats->switchedTeamCount) + ", " +
-                                 itos(playerStats->crashedIntoAsteroid) + ", " + itos(playerStats->flagDrop)          + ", " + 
-                                 itos(playerStats->flagPickup)          + ", " + itos(playerStats->flagReturn)        + ", " + 
-                                 itos(playerStats->flagScore)           + ", " + itos(playerStats->teleport)          + ", " + 
-                                 itos(playerStats->turretKills)         + ", " + itos(playerStats->ffKills)           + ", " + 
-                                 itos(playerStats->astKills)            + ", " + itos(playerStats->turretsEngr)       + ", " + 
-                                 itos(playerStats->ffEngr)              + ", " + itos(playerStats->telEngr)           + ", " + 
-                                 itos(playerStats->distTraveled)        + 
-                         ")";
-
-   U64 playerId = query.runInsertQuery(sql);
-
-   insertStatsShots(query, playerId, playerStats->weaponStats);
-   insertStatsLoadout(query, playerId, playerStats->loadoutStats);
+static U64 insertStatsPlayer(const DbQuery &query, const PlayerStats *playerStats, U64 gameId, const string &teamId, LeafRows &rows)
+{
+   static const char *sql = "INSERT INTO stats_player(stats_game_id, stats_team_id, player_name, "
+                                                     "is_authenticated,               is_robot, "
+                                                     "result,                         points, "
+                                                     "kill_count,                     death_count, "
+                                                     "suicide_count,                  switched_team_count, "
+                                                     "asteroid_crashes,               flag_drops, "
+                                                     "flag_pickups,                   flag_returns, "
+                                                     "flag_scores,                    teleport_uses, "
+                                                     "turret_kills,                   ff_kills, "
+                                                     "asteroid_kills,                 turrets_engineered, "
+                                                     "ffs_engineered,                 teleports_engineered, "
+                                                     "distance_traveled ) "
+                            "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+   Vector<string> params(24);
+   params.push_back(itos(gameId));                           params.push_back(teamId);
+   params.push_back(playerStats->name);
+   params.push_back(btos(playerStats->isAuthenticated));     params.push_back(btos(playerStats->isRobot));
+   params.push_back(ctos(playerStats->gameResult));          params.push_back(itos(playerStats->points));
+   params.push_back(itos(playerStats->kills));               params.push_back(itos(playerStats->deaths));
+   params.push_back(itos(playerStats->suicides));            params.push_back(itos(playerStats->switchedTeamCount));
+   params.push_back(itos(playerStats->crashedIntoAsteroid)); params.push_back(itos(playerStats->flagDrop));
+   params.push_back(itos(playerStats->flagPickup));          params.push_back(itos(playerStats->flagReturn));
+   params.push_back(itos(playerStats->flagScore));           params.push_back(itos(playerStats->teleport));
+   params.push_back(itos(playerStats->turretKills));         params.push_back(itos(playerStats->ffKills));
+   params.push_back(itos(playerStats->astKills));            params.push_back(itos(playerStats->turretsEngr));
+   params.push_back(itos(playerStats->ffEngr));              params.push_back(itos(playerStats->telEngr));
+   params.push_back(itos(playerStats->distTraveled));
+
+   U64 playerId = query.runInsertQuery(sql, params);
+
+   addStatsShotsRows(playerId, playerStats->weaponStats, rows);
+   addStatsLoadoutRows(playerId, playerStats->loadoutStats, rows);
 
    return playerId;
 }
 
 
 // Inserts stats of team and all players
-static U64 insertStatsTeam(const DbQuery &query, const TeamStats *teamStats, U64 &gameId)
+static U64 insertStatsTeam(const DbQuery &query, const TeamStats *teamStats, U64 &gameId, LeafRows &rows)
 {
-   string sql = "INSERT INTO stats_team(stats_game_id, team_name, team_score, result, color_hex) "
-                "VALUES(" + itos(gameId) + ", '" + sanitizeForSql(teamStats->name) + "', " + itos(teamStats->score) + " ,'" + 
-                ctos(teamStats->gameResult) + "' ,'" + teamStats->hexColor + "');";
+   static const char *sql = "INSERT INTO stats_team(stats_game_id, team_name, team_score, result, color_hex) VALUES(?, ?, ?, ?, ?);";
+
+   Vector<string> params(5);
+   params.push_back(itos(gameId));
+   params.push_back(teamStats->name);
+   params.push_back(itos(teamStats->score));
+   params.push_back(ctos(teamStats->gameResult));
+   params.push_back(teamStats->hexColor);
 
-   U64 teamId = query.runInsertQuery(sql);
+   U64 teamId = query.runInsertQuery(sql, params);
 
    for(S32 i = 0; i < teamStats->playerStats.size(); i++)
-      insertStatsPlayer(query, &teamStats->playerStats[i], gameId, itos(teamId));
+      insertStatsPlayer(query, &teamStats->playerStats[i], gameId, itos(teamId), rows);
 
    return teamId;
 }
 
 
-static U64 insertStatsGame(const DbQuery &query, const GameStats *gameStats, U64 serverId)
+// Games, teams and players go in a row at a time, since we need each one's id for the rows that refer to it
+static U64 insertStatsGame(const DbQuery &query, const GameStats *gameStats, U64 serverId, LeafRows &rows)
 {
-   string sql = "INSERT INTO stats_game(server_id, game_type, is_official, player_count, "
-                                       "duration_seconds, level_name, is_team_game, team_count) "
-                "VALUES( " + itos(serverId) + ", '" + gameStats->gameType + "', " + btos(gameStats->isOfficial) + ", " + 
-                             itos(gameStats->playerCount) + ", " + itos(gameStats->duration) + ", '" + 
-                             sanitizeForSql(gameStats->levelName) + "', " + btos(gameStats->isTeamGame) + ", " + 
-                             itos(gameStats->teamStats.size())  + ");";
-
-   U64 gameId = query.runInsertQuery(sql);
+   static const char *sql = "INSERT INTO stats_game(server_id, game_type, is_official, player_count, "
+                                                   "duration_seconds, level_name, is_team_game, team_count) "
+                            "VALUES(?, ?, ?, ?, ?, ?, ?, ?);";
+
+   Vector<string> params(8);
+   params.push_back(itos(serverId));
+   params.push_back(gameStats->gameType);
+   params.push_back(btos(gameStats->isOfficial));
+   params.push_back(itos(gameStats->playerCount));
+   params.push_back(itos(gameStats->duration));
+   params.push_back(gameStats->levelName);
+   params.push_back(btos(gameStats->isTeamGame));
+   params.push_back(itos(gameStats->teamStats.size()));
+
+   U64 gameId = query.runInsertQuery(sql, params);
 
    for(S32 i = 0; i < gameStats->teamStats.size(); i++)
-      insertStatsTeam(query, &gameStats->teamStats[i], gameId);
+      insertStatsTeam(query, &gameStats->teamStats[i], gameId, rows);
 
    return gameId;
 }
@@ -198,19 +286,13 @@ static U64 insertStatsGame(const DbQuery &query, const GameStats *gameStats, U64
 
 static U64 insertStatsServer(const DbQuery &query, const string &serverName, const string &serverIP)
 {
-   string sql = "INSERT INTO server(server_name, ip_address) "
-                "VALUES('" + sanitizeForSql(serverName) + "', '" + serverIP + "');";
+   static const char *sql = "INSERT INTO server(server_name, ip_address) VALUES(?, ?);";
 
-   if(query.mQuery)
-     return query.runInsertQuery(sql);
-
-   if(query.mSqliteDb)
-   {
-      query.runInsertQuery(sql);
-      return sqlite3_last_insert_rowid(query.mSqliteDb);
-   }
+   Vector<string> params(2);
+   params.push_back(serverName);
+   params.push_back(serverIP);
 
-   return U64_MAX;
+   return query.runInsertQuery(sql, params);
 }
 
 
@@ -259,12 +341,14 @@ bool DatabaseWriter::createDatabase(const string &databaseName, const string &sq
 S32 DatabaseWriter::getServerIdFromDatabase(const DbQuery &query, const string &serverName, const string &serverIP)
 {
    // Find server in database
-   string sql = "SELECT server_id FROM server AS server "
-                "WHERE server_name = '" + sanitizeForSql(serverName) + "' AND ip_address = '" + serverIP + "' LIMIT 1;";
-                //"WHERE server_name = 'Bitfighter sam686' AND ip_address = '96.2.123.136';";
+   static const char *sql = "SELECT server_id FROM server AS server WHERE server_name = ? AND ip_address = ? LIMIT 1;";
+
+   Vector<string> params(2);
+   params.push_back(serverName);
+   params.push_back(serverIP);
 
    Vector<Vector<string> > results;
-   selectHandler(sql, 1, results);
+   query.runSelectQuery(sql, params, 1, results);
 
    if(results.size() == 1 && results[0].size() == 1)
       return atoi(results[0][0].c_str());
@@ -273,15 +357,24 @@ S32 DatabaseWriter::getServerIdFromDatabase(const DbQuery &query, const string &
 }
 
 
+// Shared by every DatabaseWriter, since we make a new one for each job, and those jobs run on several threads
+static Vector<ServerInfo> cachedServers;
+static Mutex cachedServersLock;
+
+
 void DatabaseWriter::addToServerCache(U64 id, const string &serverName, const string &serverIP)
 {
    // Limit cache growth
    static const S32 SERVER_CACHE_SIZE = 20;
 
+   cachedServersLock.lock();
+
    if(cachedServers.size() >= SERVER_CACHE_SIZE) 
       cachedServers.erase(0);
 
-   cachedServers.push_back(ServerInfo(id, serverName, serverIP));
+   cachedServers.push_back(ServerInfo(id, serverName, serverIP, mDb));
+
+   cachedServersLock.unlock();
 }
 
 
@@ -296,10 +389,17 @@ U64 DatabaseWriter::getServerID(const DbQuery &query, const string &serverName,
       serverId = getServerIdFromDatabase(query, serverName, serverIP);
 
       if(serverId == U64_MAX)   // Not found in database, add to database
+      {
          serverId = insertStatsServer(query, serverName, serverIP);
 
+         // Another thread may have beaten us to it, in which case the unique index will have rejected our insert
+         if(serverId == U64_MAX)
+            serverId = getServerIdFromDatabase(query, serverName, serverIP);
+      }
+
       // Save server info to cache for future use
-      addToServerCache(serverId, serverName, serverIP);     
+      if(serverId != U64_MAX)
+         addToServerCache(serverId, serverName, serverIP);     
    }
 
    return serverId;
@@ -310,58 +410,161 @@ U64 DatabaseWriter::getServerID(const DbQuery &query, const string &serverName,
 // the database each time we need to find one.  Server IDs should be unique for a given pair of server name and IP address.
 U64 DatabaseWriter::getServerIDFromCache(const string &serverName, const string &serverIP)
 {
+   U64 id = U64_MAX;
+
+   cachedServersLock.lock();
+
    for(S32 i = cachedServers.size() - 1; i >= 0; i--)    // Counting backwards to visit newest servers first
-      if(cachedServers[i].ip == serverIP && cachedServers[i].name == serverName)
-         return cachedServers[i].id;
+      if(cachedServers[i].ip == serverIP && cachedServers[i].name == serverName && cachedServers[i].db == mDb)
+      {
+         id = cachedServers[i].id;
+         break;
+      }
 
-   return U64_MAX;
+   cachedServersLock.unlock();
+
+   return id;
+}
+
+
+bool DatabaseWriter::insertStats(const GameStats &gameStats) 
+{
+   StatsBatch batch;
+   batch.games.push_back(gameStats);
+
+   return insertStatsBatch(batch);
+}
+
+
+static void insertAchievementRows(const DbQuery &query, const Vector<AchievementRecord> &achievements, const Vector<U64> &serverIds)
+{
+   Vector<string> values(achievements.size() * 3);
+
+   for(S32 i = 0; i < achievements.size(); i++)
+   {
+      values.push_back(achievements[i].playerName);
+      values.push_back(itos(achievements[i].achievementId));
+      values.push_back(itos(serverIds[i]));
+   }
+
+   // A retried batch, or a player earning the same thing twice, shouldn't sink the whole transaction
+   const char *insert = query.mQuery ? "INSERT IGNORE INTO" : "INSERT OR IGNORE INTO";
+
+   insertRows(query, string(insert) + " player_achievements(player_name, achievement_id, server_id)", 3, values);
 }
 
 
-void DatabaseWriter::insertStats(const GameStats &gameStats) 
+bool DatabaseWriter::insertStatsBatch(const StatsBatch &batch)
 {
    DbQuery query(mDb, mServer, mUser, mPassword);
 
    try
    {
-      if(query.mIsValid)
+      if(!query.mIsValid)
+         return false;
+
+      // Look up server ids before we start; any we add stay added, which is fine, even if the rest fails
+      Vector<U64> gameServerIds(batch.games.size());
+      Vector<U64> achievementServerIds(batch.achievements.size());
+
+      for(S32 i = 0; i < batch.games.size(); i++)
+         gameServerIds.push_back(getServerID(query, batch.games[i].serverName, batch.games[i].serverIP));
+
+      for(S32 i = 0; i < batch.achievements.size(); i++)
+         achievementServerIds.push_back(getServerID(query, batch.achievements[i].serverName, batch.achievements[i].serverIP));
+
+      if(gameServerIds.contains(U64_MAX) || achievementServerIds.contains(U64_MAX))
+         return false;
+
+      // Has to come before the transaction, which MySQL would otherwise commit on the spot
+      if(batch.batchId != "" && !query.createStatsBatchTable())
+         return false;
+
+      U32 errors = query.getErrorCount();    // Losing a race to insert a server counts as an error; ignore those
+
+      if(!query.beginTransaction())
+         return false;
+
+      // A batch can make it into the database even though we were told it failed, say if the connection dropped
+      // during the commit.  Its id goes in with it, so when it's sent again we can tell.
+      if(batch.batchId != "")
+      {
+         Vector<string> params(1);
+         params.push_back(batch.batchId);
+
+         Vector<Vector<string> > results;
+         query.runSelectQuery("SELECT batch_id FROM stats_batch WHERE batch_id = ? LIMIT 1;", params, 1, results);
+
+         if(query.getErrorCount() != errors)
+         {
+            query.rollbackTransaction();
+            return false;
+         }
+
+         if(results.size() > 0)
+         {
+            query.commitTransaction();
+            return true;      // Already written
+         }
+
+         query.runInsertQuery("INSERT INTO stats_batch(batch_id) VALUES(?);", params);
+      }
+
+      LeafRows rows;
+
+      for(S32 i = 0; i < batch.games.size(); i++)
+         insertStatsGame(query, &batch.games[i], gameServerIds[i], rows);
+
+      insertLeafRows(query, rows);
+      insertAchievementRows(query, batch.achievements, achievementServerIds);
+
+      if(query.getErrorCount() != errors || !query.commitTransaction())
       {
-         U64 serverId = getServerID(query, gameStats.serverName, gameStats.serverIP);
-         insertStatsGame(query, &gameStats, serverId);
+         query.rollbackTransaction();
+         return false;
       }
+
+      return true;
    }
    catch(const Exception &ex) 
    {
       logprintf("[%s] Failure writing stats to database: %s", getTimeStamp().c_str(), ex.what());
+      return false;      // Query's destructor will roll back
    }
 }
 
 
-void DatabaseWriter::insertAchievement(U8 achievementId, const StringTableEntry &playerNick, const string &serverName, const string &serverIP) 
+bool DatabaseWriter::insertAchievement(U8 achievementId, const StringTableEntry &playerNick, const string &serverName, const string &serverIP) 
 {
    DbQuery query(mDb, mServer, mUser, mPassword);
 
    try
    {
-      if(query.mIsValid)
-      {
-         U64 serverId = getServerID(query, serverName, serverIP);
+      if(!query.mIsValid)
+         return false;
 
-         string sql = "INSERT INTO player_achievements(player_name, achievement_id, server_id) "
-                      "VALUES( '" + sanitizeForSql(playerNick.getString()) + "', "
-                              "'" + itos(achievementId) + "', " + itos(serverId) + ");";
+      U64 serverId = getServerID(query, serverName, serverIP);
+      if(serverId == U64_MAX)
+         return false;
 
-         query.runInsertQuery(sql);
-      }
+      static const char *sql = "INSERT INTO player_achievements(player_name, achievement_id, server_id) VALUES(?, ?, ?);";
+
+      Vector<string> params(3);
+      params.push_back(playerNick.getString());
+      params.push_back(itos(achievementId));
+      params.push_back(itos(serverId));
+
+      return query.runInsertQuery(sql, params) != U64_MAX;
    }
    catch(const Exception &ex) 
    {
       logprintf("[%s] Failure writing achievement to database: %s", getTimeStamp().c_str(), ex.what());
+      return false;
    }
 }
 
 
-void DatabaseWriter::insertLevelInfo(const string &hash, const string &levelName, const string &creator, 
+bool DatabaseWriter::insertLevelInfo(const string &hash, const string &levelName, const string &creator, 
                                      const string &gameType, bool hasLevelGen, U8 teamCount, S32 winningScore, S32 gameDurationInSeconds)
 {
    DbQuery query(mDb, mServer, mUser, mPassword);
@@ -369,35 +572,47 @@ void DatabaseWriter::insertLevelInfo(const string &hash, const string &levelName
    try
    {
       if(!query.mIsValid)
-         return;
+         return false;
 
       // Sanity check
       if(hash.length() != 32)
-         return;
-
-      string sql;
+         return false;
 
       // We only want to insert a record of this server if the hash does not yet exist
-      sql = "SELECT hash FROM stats_level WHERE hash = '" + sanitizeForSql(hash) + "' LIMIT 1;";
+      static const char *selectSql = "SELECT hash FROM stats_level WHERE hash = ? LIMIT 1;";
+
+      Vector<string> params(1);
+      params.push_back(hash);
 
       Vector<Vector<string> > results;
-      selectHandler(sql, 1, results);
+      query.runSelectQuery(selectSql, params, 1, results);
 
       bool found = (results.size() == 1 && results[0].size() == 1);
 
       if(!found) 
       {
-         sql = "INSERT INTO stats_level(hash, level_name, creator, game_type, has_levelgen, team_count, winning_score, game_duration) "
-               "VALUES('" + sanitizeForSql(hash)      + "', '" + sanitizeForSql(levelName)   + "', " + 
-                      "'" + sanitizeForSql(creator)   + "', '" + sanitizeForSql(gameType)    + "', " +
-                      "'" + btos(hasLevelGen)         + "', '" + itos(teamCount)             + "', " + 
-                      "'" + itos(winningScore)        + "', '" + itos(gameDurationInSeconds) + "');";
-         query.runInsertQuery(sql);
+         static const char *insertSql = "INSERT INTO stats_level(hash, level_name, creator, game_type, has_levelgen, "
+                                                                "team_count, winning_score, game_duration) "
+                                        "VALUES(?, ?, ?, ?, ?, ?, ?, ?);";
+         params.clear();
+         params.push_back(hash);
+         params.push_back(levelName);
+         params.push_back(creator);
+         params.push_back(gameType);
+         params.push_back(btos(hasLevelGen));
+         params.push_back(itos(teamCount));
+         params.push_back(itos(winningScore));
+         params.push_back(itos(gameDurationInSeconds));
+
+         query.runInsertQuery(insertSql, params);
       }
+
+      return query.getErrorCount() == 0;
    }
    catch(const Exception &ex) 
    {
       logprintf("[%s] Failure writing level info to database: %s", getTimeStamp().c_str(), ex.what());
+      return false;
    }
 }
 
@@ -524,11 +739,15 @@ S32 DatabaseWriter::getLevelRating(U32 databaseId, const StringTableEntry &name)
 
 Int<BADGE_COUNT> DatabaseWriter::getAchievements(const char *name)
 {
-   string sql = "SELECT achievement_id FROM player_achievements WHERE player_name = '" + string(name) + "';";
+   static const char *sql = "SELECT achievement_id FROM player_achievements WHERE player_name = ?;";
+
+   Vector<string> params(1);
+   params.push_back(name);
 
    Vector<Vector<string> > results;
 
-   selectHandler(sql, 1, results);
+   DbQuery query(mDb, mServer, mUser, mPassword);
+   query.runSelectQuery(sql, params, 1, results);
 
    S32 badges = 0;
 
@@ -541,11 +760,15 @@ Int<BADGE_COUNT> DatabaseWriter::getAchievements(const char *name)
 
 U16 DatabaseWriter::getGamesPlayed(const char *name)
 {
-   string sql = "SELECT count(*) FROM stats_player WHERE player_name = '" + string(name) + "';";
+   static const char *sql = "SELECT count(*) FROM stats_player WHERE player_name = ?;";
+
+   Vector<string> params(1);
+   params.push_back(name);
 
    Vector<Vector<string> > results;
 
-   selectHandler(sql, 1, results);
+   DbQuery query(mDb, mServer, mUser, mPassword);
+   query.runSelectQuery(sql, params, 1, results);
 
    if(results.size() == 0)
       return 0;
@@ -562,10 +785,10 @@ void DatabaseWriter::selectHandler(const string &sql, S32 cols, Vector<Vector<st
    {
 
 #ifdef BF_WRITE_TO_MYSQL
-      if(mQuery.query)
+      if(query.mQuery)
       {
          //S32 serverId_int = -1;
-         StoreQueryResult results = mQuery.query->store(sql.c_str(), sql.length());
+         StoreQueryResult results = query.mQuery->store(sql.c_str(), sql.length());
 
          S32 rows = results.num_rows();
 
@@ -574,7 +797,7 @@ void DatabaseWriter::selectHandler(const string &sql, S32 cols, Vector<Vector<st
             values.push_back(Vector<string>());     // Add another row
 
             for(S32 j = 0; j < cols; j++)
-               values[i].push_back(string(results[i][j]));
+               values.last().push_back(string(results[i][j]));
          }
       }
       else
@@ -593,7 +816,7 @@ void DatabaseWriter::selectHandler(const string &sql, S32 cols, Vector<Vector<st
             values.push_back(Vector<string>());     // Add another row
 
             for(S32 j = 0; j < cols; j++)
-               values[i].push_back(results[cols + i + j]);
+               values.last().push_back(results[cols + i + j]);
          }
 
          sqlite3_free_table(results);
@@ -624,17 +847,54 @@ void DatabaseWriter::setDumpSql(bool dump)
 ////////////////////////////////////////
 ////////////////////////////////////////
 
-bool DbQuery::dumpSql = false;
+// One of these for each open database; a DbQuery borrows one from the pool, or opens its own
+struct DbConnection
+{
+   string key;                               // Which database this is, see getConnectionKey()
+   sqlite3 *sqliteDb;
+   Query *query;                             // Only when we're talking to MySQL
+#ifdef BF_WRITE_TO_MYSQL
+   Connection mysqlConnection;
+#endif
+   map<string, sqlite3_stmt *> statements;   // Prepared statements, by their sql
+   bool hasStatsBatchTable;                  // See DbQuery::createStatsBatchTable()
 
+   explicit DbConnection(const string &key)
+   {
+      this->key = key;
+      sqliteDb = NULL;
+      query = NULL;
+      hasStatsBatchTable = false;
+   }
 
-// Constructor
-DbQuery::DbQuery(const char *db, const char *server, const char *user, const char *password)
+   ~DbConnection()
+   {
+      for(map<string, sqlite3_stmt *>::iterator it = statements.begin(); it != statements.end(); it++)
+         sqlite3_finalize(it->second);
+
+      delete query;
+      sqlite3_close_v2(sqliteDb);     // Ok if sqliteDb is NULL
+   }
+};
+
+
+// Idle connections, waiting for the next DbQuery that wants them
+static Vector<DbConnection *> pooledConnections;
+static Mutex poolLock;
+
+static const S32 MaxPooledConnections = 16;     // Should comfortably cover the master's database threads
+static const S32 SqliteBusyTimeout = 5000;      // ms to wait for another connection's write to finish
+
+
+static string getConnectionKey(const char *db, const char *server, const char *user)
 {
-   mQuery = NULL;
-   mSqliteDb = NULL;
-   mIsValid = true;
+   return string(db) + "|" + (server ? server : "") + "|" + (user ? user : "");
+}
 
-   TNLAssert(db && db[0] != 0, "Must have a database!");
+
+static DbConnection *openConnection(const string &key, const char *db, const char *server, const char *user, const char *password)
+{
+   DbConnection *connection = new DbConnection(key);
 
 #ifdef BF_WRITE_TO_MYSQL
 
@@ -645,32 +905,186 @@ DbQuery::DbQuery(const char *db, const char *server, const char *user, const cha
       TNLAssert(password, "const char * password is NULL");
       try
       {
-         conn.connect(db, server, user, password);    // Will throw error if it fails
-         mQuery = new Query(&conn);
+         connection->mysqlConnection.connect(db, server, user, password);    // Will throw error if it fails
+         connection->query = new Query(&connection->mysqlConnection);
       }
       catch(const Exception &ex) 
       {
          logprintf("Failure opening mysql database: %s", ex.what());
-         mIsValid = false;
+         delete connection;
+         return NULL;
       }
+
+      return connection;
    }
-   else
 #endif
+
+   connection->sqliteDb = DatabaseWriter::openSqliteDatabase(db, SQLITE_OPEN_READWRITE);
+   if(connection->sqliteDb == NULL)
    {
-      mSqliteDb = DatabaseWriter::openSqliteDatabase(db, SQLITE_OPEN_READWRITE);
-      if(mSqliteDb == NULL)
-         mIsValid = false;
-   } 
+      delete connection;
+      return NULL;
+   }
+
+   // With several threads writing, we'll sometimes find the database locked; wait our turn rather than failing
+   sqlite3_busy_timeout(connection->sqliteDb, SqliteBusyTimeout);
+
+   return connection;
+}
+
+
+static DbConnection *checkOutConnection(const string &key)
+{
+   DbConnection *connection = NULL;
+
+   poolLock.lock();
+
+   for(S32 i = pooledConnections.size() - 1; i >= 0; i--)
+      if(pooledConnections[i]->key == key)
+      {
+         connection = pooledConnections[i];
+         pooledConnections.erase_fast(i);
+         break;
+      }
+
+   poolLock.unlock();
+
+#ifdef BF_WRITE_TO_MYSQL
+   // MySQL drops connections that sit idle too long; if this one has gone stale, we'll open a new one instead
+   if(connection && connection->query && !connection->mysqlConnection.ping())
+   {
+      delete connection;
+      connection = NULL;
+   }
+#endif
+
+   return connection;
+}
+
+
+static void returnConnection(DbConnection *connection)
+{
+   poolLock.lock();
+
+   if(pooledConnections.size() < MaxPooledConnections)
+   {
+      pooledConnections.push_back(connection);
+      connection = NULL;
+   }
+
+   poolLock.unlock();
+
+   delete connection;      // Pool was full; ok if NULL
+}
+
+
+// Returns a prepared statement for sql, ready for binding, preparing it if this connection hasn't seen it before
+static sqlite3_stmt *getStatement(DbConnection *connection, const char *sql)
+{
+   map<string, sqlite3_stmt *>::iterator it = connection->statements.find(sql);
+
+   if(it != connection->statements.end())
+      return it->second;
+
+   sqlite3_stmt *statement = NULL;
+
+   if(sqlite3_prepare_v2(connection->sqliteDb, sql, -1, &statement, NULL) != SQLITE_OK)
+   {
+      logprintf(LogConsumer::DatabaseFilter, "Database error preparing statement: %s", sqlite3_errmsg(connection->sqliteDb));
+      logprintf(sql);
+      sqlite3_finalize(statement);     // Ok if statement is NULL
+      return NULL;
+   }
+
+   connection->statements[sql] = statement;
+
+   return statement;
+}
+
+
+static bool bindParams(sqlite3_stmt *statement, const Vector<string> &params)
+{
+   for(S32 i = 0; i < params.size(); i++)
+      if(sqlite3_bind_text(statement, i + 1, params[i].c_str(), (S32)params[i].length(), SQLITE_TRANSIENT) != SQLITE_OK)
+         return false;
+
+   return true;
+}
+
+
+#ifdef BF_WRITE_TO_MYSQL
+// MySQL++ has no real prepared statements, so we fill in the ?s ourselves, quoted and sanitized
+static string fillPlaceholders(const char *sql, const Vector<string> &params)
+{
+   string filled;
+   S32 param = 0;
+
+   for(const char *c = sql; *c; c++)
+   {
+      if(*c == '?' && param < params.size())
+         filled += "'" + sanitizeForSql(params[param++]) + "'";
+      else
+         filled += *c;
+   }
+
+   return filled;
+}
+#endif
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+bool DbQuery::dumpSql = false;
+bool DbQuery::mPoolingEnabled = false;
+
+
+// Constructor
+DbQuery::DbQuery(const char *db, const char *server, const char *user, const char *password)
+{
+   mConnection = NULL;
+   mPooled = mPoolingEnabled;
+   mInTransaction = false;
+   mErrorCount = 0;
+
+   mQuery = NULL;
+   mSqliteDb = NULL;
+   mIsValid = true;
+
+   TNLAssert(db && db[0] != 0, "Must have a database!");
+
+   string key = getConnectionKey(db, server, user);
+
+   if(mPooled)
+      mConnection = checkOutConnection(key);
+
+   if(!mConnection)
+      mConnection = openConnection(key, db, server, user, password);
+
+   if(!mConnection)
+   {
+      mIsValid = false;
+      return;
+   }
+
+   mQuery = mConnection->query;
+   mSqliteDb = mConnection->sqliteDb;
 }
 
 
 // Destructor
 DbQuery::~DbQuery()
 {
-   if(mQuery)
-      delete mQuery;
+   if(!mConnection)
+      return;
+
+   if(mInTransaction)
+      rollbackTransaction();
 
-   sqlite3_close_v2(mSqliteDb);     // Ok if mSqliteDb is NULL
+   if(mPooled)
+      returnConnection(mConnection);
+   else
+      delete mConnection;
 }
 
 
@@ -701,6 +1115,7 @@ U64 DbQuery::runSelectQuery(const string &sql, int(*callback)(void*, int, char**
          logprintf("Database error accessing sqlite database: %s", err);
          logprintf(sql.c_str());
          sqlite3_free(err);
+         mErrorCount++;
          return -1;
       }
 
@@ -740,6 +1155,7 @@ U64 DbQuery::runInsertQuery(const string &sql) const
          logprintf(LogConsumer::DatabaseFilter, "Database error accessing sqlite database: %s", err);
          logprintf(sql.c_str());
          sqlite3_free(err);
+         mErrorCount++;
          return U64_MAX;
       }
 
@@ -750,6 +1166,254 @@ U64 DbQuery::runInsertQuery(const string &sql) const
 }
 
 
+// Returns id of inserted record, or U64_MAX if something went wrong -- does not throw
+U64 DbQuery::runInsertQuery(const char *sql, const Vector<string> &params) const
+{
+   if(!mIsValid)
+      return U64_MAX;
+
+   if(dumpSql)
+      logprintf("SQL: %s", sql);
+
+#ifdef BF_WRITE_TO_MYSQL
+   if(mQuery)
+   {
+      try
+      {
+         return mQuery->execute(fillPlaceholders(sql, params)).insert_id();
+      }
+      catch(const Exception &ex)
+      {
+         logprintf(LogConsumer::DatabaseFilter, "Database error accessing mysql database: %s", ex.what());
+         logprintf(sql);
+         mErrorCount++;
+         return U64_MAX;
+      }
+   }
+#endif
+
+   if(!mSqliteDb)
+      return U64_MAX;
+
+   sqlite3_stmt *statement = getStatement(mConnection, sql);
+   if(!statement)
+   {
+      mErrorCount++;
+      return U64_MAX;
+   }
+
+   U64 id = U64_MAX;
+
+   if(bindParams(statement, params) && sqlite3_step(statement) == SQLITE_DONE)
+      id = sqlite3_last_insert_rowid(mSqliteDb);
+   else
+   {
+      logprintf(LogConsumer::DatabaseFilter, "Database error accessing sqlite database: %s", sqlite3_errmsg(mSqliteDb));
+      logprintf(sql);
+      mErrorCount++;
+   }
+
+   sqlite3_reset(statement);
+   sqlite3_clear_bindings(statement);
+
+   return id;
+}
+
+
+// Appends a row to results for each record found, with cols columns each; returns false if something went wrong -- does not throw
+bool DbQuery::runSelectQuery(const char *sql, const Vector<string> &params, S32 cols, Vector<Vector<string> > &results) const
+{
+   if(!mIsValid)
+      return false;
+
+   if(dumpSql)
+      logprintf("SQL: %s", sql);
+
+#ifdef BF_WRITE_TO_MYSQL
+   if(mQuery)
+   {
+      try
+      {
+         string filled = fillPlaceholders(sql, params);
+         StoreQueryResult rows = mQuery->store(filled.c_str(), filled.length());
+
+         for(S32 i = 0; i < (S32)rows.num_rows(); i++)
+         {
+            results.push_back(Vector<string>(cols));     // Add another row
+
+            for(S32 j = 0; j < cols; j++)
+               results.last().push_back(string(rows[i][j]));
+         }
+
+         return true;
+      }
+      catch(const Exception &ex)
+      {
+         logprintf(LogConsumer::DatabaseFilter, "Database error accessing mysql database: %s", ex.what());
+         logprintf(sql);
+         mErrorCount++;
+         return false;
+      }
+   }
+#endif
+
+   if(!mSqliteDb)
+      return false;
+
+   sqlite3_stmt *statement = getStatement(mConnection, sql);
+   if(!statement)
+   {
+      mErrorCount++;
+      return false;
+   }
+
+   S32 rc = SQLITE_ERROR;
+
+   if(bindParams(statement, params))
+      while((rc = sqlite3_step(statement)) == SQLITE_ROW)
+      {
+         results.push_back(Vector<string>(cols));     // Add another row
+
+         for(S32 j = 0; j < cols; j++)
+         {
+            const unsigned char *text = sqlite3_column_text(statement, j);
+            results.last().push_back(text ? (const char *)text : "");
+         }
+      }
+
+   if(rc != SQLITE_DONE)
+   {
+      logprintf(LogConsumer::DatabaseFilter, "Database error accessing sqlite database: %s", sqlite3_errmsg(mSqliteDb));
+      logprintf(sql);
+      mErrorCount++;
+   }
+
+   sqlite3_reset(statement);
+   sqlite3_clear_bindings(statement);
+
+   return rc == SQLITE_DONE;
+}
+
+
+U32 DbQuery::getErrorCount() const
+{
+   return mErrorCount;
+}
+
+
+// Works for MySQL and sqlite alike
+bool DbQuery::createStatsBatchTable()
+{
+   if(!mIsValid)
+      return false;
+
+   if(mConnection->hasStatsBatchTable)
+      return true;
+
+   static const char *sql = "CREATE TABLE IF NOT EXISTS stats_batch ("
+                            "batch_id CHAR(32) NOT NULL PRIMARY KEY, "
+                            "insertion_date TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP);";
+
+   try
+   {
+      mConnection->hasStatsBatchTable = runInsertQuery(sql) != U64_MAX;
+   }
+   catch(const Exception &ex)
+   {
+      logprintf(LogConsumer::DatabaseFilter, "Database error creating stats_batch table: %s", ex.what());
+      mErrorCount++;
+   }
+
+   return mConnection->hasStatsBatchTable;
+}
+
+
+bool DbQuery::beginTransaction()
+{
+   TNLAssert(!mInTransaction, "Transactions don't nest!");
+
+   try
+   {
+      // IMMEDIATE takes sqlite's write lock now, so two threads can't both start reading and then deadlock trying to write
+      mInTransaction = runInsertQuery(mQuery ? "START TRANSACTION;" : "BEGIN IMMEDIATE;") != U64_MAX;
+   }
+   catch(const Exception &ex)
+   {
+      logprintf(LogConsumer::DatabaseFilter, "Database error starting transaction: %s", ex.what());
+      mErrorCount++;
+   }
+
+   return mInTransaction;
+}
+
+
+bool DbQuery::commitTransaction()
+{
+   if(!mInTransaction)
+      return false;
+
+   try
+   {
+      if(runInsertQuery("COMMIT;") == U64_MAX)
+         return false;     // Still in the transaction; caller can roll it back
+   }
+   catch(const Exception &ex)
+   {
+      logprintf(LogConsumer::DatabaseFilter, "Database error committing transaction: %s", ex.what());
+      mErrorCount++;
+      return false;
+   }
+
+   mInTransaction = false;
+   return true;
+}
+
+
+void DbQuery::rollbackTransaction()
+{
+   if(!mInTransaction)
+      return;
+
+   mInTransaction = false;
+
+   try
+   {
+      runInsertQuery("ROLLBACK;");
+   }
+   catch(const Exception &ex)
+   {
+      logprintf(LogConsumer::DatabaseFilter, "Database error rolling back transaction: %s", ex.what());
+   }
+}
+
+
+void DbQuery::enablePooling(bool enable)
+{
+   mPoolingEnabled = enable;
+
+   if(!enable)
+      closePooledConnections();
+}
+
+
+void DbQuery::closePooledConnections()
+{
+   poolLock.lock();
+   pooledConnections.deleteAndClear();
+   poolLock.unlock();
+}
+
+
+S32 DbQuery::getPooledConnectionCount()
+{
+   poolLock.lock();
+   S32 count = pooledConnections.size();
+   poolLock.unlock();
+
+   return count;
+}
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
@@ -903,7 +1567,15 @@ string DatabaseWriter::getSqliteSchema()
       "   server_id INTEGER NOT NULL,"
       "   date_awarded DATETIME NOT NULL  DEFAULT CURRENT_TIMESTAMP );"
 
-      "   CREATE UNIQUE INDEX player_achievements_accomplishment_id on player_achievements(achievement_id, player_name COLLATE BINARY);";
+      "   CREATE UNIQUE INDEX player_achievements_accomplishment_id on player_achievements(achievement_id, player_name COLLATE BINARY);"
+
+
+      /* stats batches already written, see DatabaseWriter::insertStatsBatch() */
+
+      "DROP TABLE IF EXISTS stats_batch;"
+      "CREATE TABLE stats_batch ("
+      "   batch_id CHAR(32) NOT NULL PRIMARY KEY,"
+      "   insertion_date TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP );";
 }
 
 
@@ -45,25 +45,54 @@ struct ServerInfo
    U64 id;
    string name;
    string ip;
+   string db;     // Which database the id came from
 
    // Quickie constructor
-   ServerInfo(U64 id, const string name, const string &ip) 
+   ServerInfo(U64 id, const string name, const string &ip, const string &db) 
    { 
       this->id = id; 
       this->name = name; 
       this->ip = ip;
+      this->db = db;
    }
 };
 
 
+struct AchievementRecord
+{
+   U8 achievementId;
+   string playerName;
+   string serverName;
+   string serverIP;
+};
+
+
+// Game reports and achievements that get written together, in a single transaction
+struct StatsBatch
+{
+   string batchId;      // Recorded with the batch, so a batch that was written is never written again; may be empty
+   Vector<GameStats> games;
+   Vector<AchievementRecord> achievements;
+
+   S32 size() const;
+   void clear();
+};
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
+struct DbConnection;     // A database connection and the statements we've prepared on it
+
 class DbQuery
 {
-#ifdef BF_WRITE_TO_MYSQL
-   Connection conn;
-#endif
+   DbConnection *mConnection;
+   bool mPooled;           // Connection goes back to the pool when we're done with it
+   bool mInTransaction;
+
+   mutable U32 mErrorCount;
+
+   static bool mPoolingEnabled;
 
 public:
    Query *mQuery;
@@ -77,6 +106,27 @@ public:
 
    U64 runSelectQuery(const string &sql, int(*callback)(void*, int, char**, char**), void *data) const;
    U64 runInsertQuery(const string &sql) const;
+
+   // Same again, for queries with ? placeholders, filled in order from params.  Statements are prepared once per 
+   // connection and reused, so use these for anything we run a lot.  These don't throw.
+   U64 runInsertQuery(const char *sql, const Vector<string> &params) const;
+   bool runSelectQuery(const char *sql, const Vector<string> &params, S32 cols, Vector<Vector<string> > &results) const;
+
+   U32 getErrorCount() const;       // Queries that have failed on this object
+
+   // Stats databases made before stats_batch was in the schema get it here, the first time each connection asks
+   bool createStatsBatchTable();
+
+   // A transaction still open when we're destroyed is rolled back
+   bool beginTransaction();
+   bool commitTransaction();
+   void rollbackTransaction();
+
+   // With pooling on, connections are kept open when a DbQuery is done with them, and handed to the next one that
+   // asks for the same database.  Off by default; the master turns it on.
+   static void enablePooling(bool enable);
+   static void closePooledConnections();
+   static S32 getPooledConnectionCount();
 };
 
 
@@ -91,7 +141,6 @@ private:
    char mDb[64];
    char mUser[64];
    char mPassword[64];
-   Vector<ServerInfo> cachedServers;
 
    S32 lastGameID;
 
@@ -122,9 +171,11 @@ public:
 
    static void setDumpSql(bool dump);
 
-   void insertStats(const GameStats &gameStats);
-   void insertAchievement(U8 achievementId, const StringTableEntry &playerNick, const string &serverName, const string &serverIP);
-   void insertLevelInfo(const string &hash, const string &levelName, const string &creator, 
+   // These return false if anything went wrong
+   bool insertStats(const GameStats &gameStats);
+   bool insertStatsBatch(const StatsBatch &batch);    // All or nothing; achievements, and batches, already on record are skipped
+   bool insertAchievement(U8 achievementId, const StringTableEntry &playerNick, const string &serverName, const string &serverIP);
+   bool insertLevelInfo(const string &hash, const string &levelName, const string &creator, 
                         const string &gameType, bool hasLevelGen, U8 teamCount, S32 winningScore, S32 gameDurationInSeconds);
 
    void getTopPlayers(const string &table, const string &col2, S32 count, Vector<string> &names, Vector<string> &scores);
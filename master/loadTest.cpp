@@ -0,0 +1,1065 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+// Master server load tester.  Starts a master on localhost, connects thousands of synthetic game servers and clients
+// to it, and has them do what real ones do: servers send status updates and ask about players, clients log in, list
+// servers, ask for arranged connections, and chat in the lobby.  Logins are checked against a sqlite stand-in for the
+// phpBB user table.  When time is up, we report how much got done, how long it took, and how much memory we used.
+//
+// Peers connect in process, using connectLocal(), rather than over UDP.  A real connection to the master has to
+// solve a client puzzle first, and doing that thousands of times would take longer than the test itself.  Each
+// master-side connection still gets its own address, so anything the master looks up by address works as usual.
+
+#include "master.h"
+#include "masterInterface.h"
+#include "MasterServerConnection.h"
+#include "LobbyChat.h"
+#include "database.h"
+
+#include "../zap/SharedConstants.h"
+#include "../zap/stringUtils.h"  // For itos
+#include "../zap/version.h"      // For MASTER_PROTOCOL_VERSION, CS_PROTOCOL_VERSION, BUILD_VERSION
+
+#include "tnlNetInterface.h"
+#include "tnlRandom.h"
+#include "tnlNonce.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <map>
+#include <string>
+
+using namespace TNL;
+using namespace std;
+using namespace Zap;
+using namespace DbWriter;
+
+
+namespace Master
+{
+
+enum RequestType
+{
+   ClientAuthRequest,         // Client logs in; done when it hears whether its name is verified
+   ServerAuthRequest,         // Server asks whether one of its players is verified
+   ServerQueryRequest,        // Client lists servers; done with the final, empty response
+   ArrangedConnectionRequest, // Client asks to connect to a server; done when the server's answer comes back
+   LobbyChatDelivery,         // Each chat message is sent, and done, once for every client that should hear it
+   HeartbeatRequest,          // Server status update; the master doesn't answer these, so they're only ever sent
+   RequestTypeCount
+};
+
+static const char *RequestNames[RequestTypeCount] = {
+   "Client auth", "Server auth", "Server query", "Arranged connection", "Lobby chat delivery", "Server heartbeat"
+};
+
+
+// Latencies, in buckets that get wider as they go up, so we can handle any number of samples in a fixed space
+class LatencyHistogram
+{
+private:
+   static const S32 BucketsPerDoubling = 8;
+   static const S32 BucketCount = BucketsPerDoubling * 32;     // 1 microsecond up to over an hour
+
+   U32 mBuckets[BucketCount];
+   U32 mCount;
+   F64 mMax;
+
+public:
+   LatencyHistogram()
+   {
+      memset(mBuckets, 0, sizeof(mBuckets));
+      mCount = 0;
+      mMax = 0;
+   }
+
+   void add(F64 ms)
+   {
+      F64 us = ms * 1000;
+      S32 bucket = us < 1 ? 0 : S32(log(us) / log(2.0) * BucketsPerDoubling);
+
+      if(bucket >= BucketCount)
+         bucket = BucketCount - 1;
+
+      mBuckets[bucket]++;
+      mCount++;
+
+      if(ms > mMax)
+         mMax = ms;
+   }
+
+   // In ms; this is the top of the bucket the percentile falls in, so it can be high by up to 9%
+   F64 getPercentile(F64 percentile) const
+   {
+      if(mCount == 0)
+         return 0;
+
+      U32 target = U32(ceil(mCount * percentile / 100));
+      U32 seen = 0;
+
+      for(S32 i = 0; i < BucketCount; i++)
+      {
+         seen += mBuckets[i];
+         if(seen >= target)
+            return min(pow(2.0, F64(i + 1) / BucketsPerDoubling) / 1000, mMax);
+      }
+
+      return mMax;
+   }
+
+   U32 getCount() const { return mCount; }
+   F64 getMax()   const { return mMax;   }
+};
+
+
+struct RequestStats
+{
+   U32 sent;
+   U32 completed;
+   U32 failed;
+   LatencyHistogram latency;
+
+   RequestStats() { sent = 0; completed = 0; failed = 0; }
+};
+
+static RequestStats gRequestStats[RequestTypeCount];
+
+
+static F64 getMsSince(S64 start)
+{
+   return Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+}
+
+
+static void completed(RequestType type, S64 start)
+{
+   gRequestStats[type].completed++;
+   gRequestStats[type].latency.add(getMsSince(start));
+}
+
+
+// Resident memory of this whole process, in KB; 0 if we can't tell on this platform
+static U32 getMemoryUsed()
+{
+#ifdef TNL_OS_LINUX
+   FILE *file = fopen("/proc/self/status", "r");
+   if(!file)
+      return 0;
+
+   char line[256];
+   U32 kb = 0;
+
+   while(fgets(line, sizeof(line), file))
+      if(strncmp(line, "VmRSS:", 6) == 0)
+      {
+         kb = atoi(line + 6);
+         break;
+      }
+
+   fclose(file);
+   return kb;
+#else
+   return 0;
+#endif
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+class LoadTest;
+
+// One end of a synthetic connection to the master; the other end is an ordinary MasterServerConnection
+class LoadTestPeer : public MasterServerInterface
+{
+   typedef MasterServerInterface Parent;
+
+protected:
+   virtual MasterConnectionType getConnectionType() const = 0;
+   virtual void writePeerInfo(BitStream *bstream) = 0;      // Whatever servers or clients send after the common part
+
+public:
+   S32 mClientId;             // Given to us by the master
+   U32 mNextActionTime;
+   S64 mConnectTime;
+
+   LoadTestPeer()
+   {
+      mClientId = 0;
+      mNextActionTime = 0;
+      mConnectTime = 0;
+   }
+
+   void writeConnectRequest(BitStream *bstream)
+   {
+      Parent::writeConnectRequest(bstream);
+
+      bstream->write(U32(MASTER_PROTOCOL_VERSION));
+      bstream->write(U32(CS_PROTOCOL_VERSION));
+      bstream->write(U32(BUILD_VERSION));
+      bstream->writeEnum(getConnectionType(), MasterConnectionTypeCount);
+
+      writePeerInfo(bstream);
+   }
+
+   bool readConnectAccept(BitStream *stream, NetConnection::TerminationReason &reason)
+   {
+      if(!Parent::readConnectAccept(stream, reason))
+         return false;
+
+      stream->read(&mClientId);
+      return true;
+   }
+
+   virtual void act(LoadTest *loadTest) = 0;
+};
+
+
+class LoadTestClient;
+
+class LoadTestServer : public LoadTestPeer
+{
+   typedef LoadTestPeer Parent;
+
+   S32 mIndex;
+   U32 mPlayerCount;
+   U32 mActions;
+
+   map<string, S64> mPendingAuth;      // Player name -> when we asked
+
+protected:
+   MasterConnectionType getConnectionType() const;
+   void writePeerInfo(BitStream *bstream);
+
+public:
+   LoadTestServer(S32 index = 0);
+
+   void act(LoadTest *loadTest);
+
+   TNL_DECLARE_RPC_OVERRIDE(m2sClientRequestedArrangedConnection, (U32 requestId, Vector<IPAddress> possibleAddresses,
+                                                                   ByteBufferPtr connectionParameters));
+   TNL_DECLARE_RPC_OVERRIDE(m2sSetAuthenticated_019, (Vector<U8> id, StringTableEntry name,
+                                                      RangedU32<0,AuthenticationStatusCount> status,
+                                                      Int<BADGE_COUNT> badges, U16 gamesPlayed));
+   TNL_DECLARE_NETCONNECTION(LoadTestServer);
+};
+
+
+class LoadTestClient : public LoadTestPeer
+{
+   typedef LoadTestPeer Parent;
+
+   U32 mNextQueryId;
+   U32 mPendingQueryId;
+   S64 mQueryTime;
+   Vector<IPAddress> mQueryResults;       // Servers in the response we're currently receiving
+   Vector<IPAddress> mServers;            // Servers from the last complete response
+
+   map<U32, S64> mPendingArranged;        // Request id -> when we asked
+   U32 mNextArrangedId;
+
+   void queryServers();
+   void requestArrangedConnection();
+   void chat(LoadTest *loadTest);
+
+protected:
+   MasterConnectionType getConnectionType() const;
+   void writePeerInfo(BitStream *bstream);
+
+public:
+   string mName;
+   bool mIsRegistered;        // Has an account in the stand-in user table
+   bool mIsInLobby;
+   bool mIsWaitingForAuth;
+   Nonce mId;
+
+   LoadTestClient(const string &name = "", bool isRegistered = false, bool isInLobby = false);
+
+   void act(LoadTest *loadTest);
+   void abandonRequests();    // We're about to go away; anything we're still waiting on won't be answered
+
+   TNL_DECLARE_RPC_OVERRIDE(m2cSetAuthenticated_019, (RangedU32<0, AuthenticationStatusCount> authStatus,
+                                                      Int<BADGE_COUNT> badges, U16 gamesPlayed, StringPtr correctedName));
+   TNL_DECLARE_RPC_OVERRIDE(m2cQueryServersResponse_019a, (U32 queryId, Vector<IPAddress> ipList, Vector<S32> serverIdList));
+   TNL_DECLARE_RPC_OVERRIDE(m2cArrangedConnectionAccepted, (U32 requestId, Vector<IPAddress> possibleAddresses,
+                                                            ByteBufferPtr connectionData));
+   TNL_DECLARE_RPC_OVERRIDE(m2cArrangedConnectionRejected, (U32 requestId, ByteBufferPtr rejectData));
+   TNL_DECLARE_RPC_OVERRIDE(m2cLobbyChatEvents, (Vector<U8> eventTypes, Vector<StringTableEntry> playerNicks,
+                                                 Vector<string> messages));
+   TNL_DECLARE_NETCONNECTION(LoadTestClient);
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+struct LoadTestOptions
+{
+   S32 servers;
+   S32 clients;
+   U32 seconds;
+   U32 port;
+   string database;
+
+   U32 clientInterval;        // ms between things a client does
+   U32 serverInterval;        // ms between server heartbeats
+   S32 lobbyPercent;          // Clients who join lobby chat
+   S32 registeredPercent;     // Clients whose names are in the user table
+   S32 reconnectPercent;      // Chance a client logs out and back in, instead of whatever else it would have done
+
+   LoadTestOptions()
+   {
+      servers = 200;
+      clients = 2000;
+      seconds = 30;
+      port = 25956;           // One up from the real master, so we can run alongside it
+      database = "loadtest.db";
+
+      clientInterval = 5000;
+      serverInterval = 5000;  // Any faster and the master's flood control starts kicking servers off
+      lobbyPercent = 25;
+      registeredPercent = 50;
+      reconnectPercent = 5;
+   }
+};
+
+
+class LoadTest
+{
+private:
+   LoadTestOptions mOptions;
+   MasterSettings mSettings;
+   MasterServer *mMaster;
+   NetInterface *mPeerInterface;
+
+   Vector<RefPtr<LoadTestServer> > mServers;
+   Vector<RefPtr<LoadTestClient> > mClients;
+
+   U32 mNextAddress;
+   U32 mLoops;
+
+   U32 mMemoryAtStart;
+   U32 mMemoryConnected;
+
+   bool connect(LoadTestPeer *peer);
+   LoadTestClient *createClient(const string &name, bool isRegistered, bool isInLobby);
+   void reconnect(S32 clientIndex);
+   void tick(U32 currentTime, U32 timeDelta);
+
+   static U32 getNextActionTime(U32 currentTime, U32 interval);
+
+public:
+   explicit LoadTest(const LoadTestOptions &options);
+   virtual ~LoadTest();
+
+   bool createDatabase();
+   bool connectPeers();
+   void run();
+   void report() const;
+
+   LoadTestClient *getRandomClient() const;
+   S32 getChatRecipientCount() const;
+};
+
+
+// Our stand-in for phpBB's user table; runs on the master's database threads
+static MasterServerConnection::PHPBB3AuthenticationStatus verifyLoadTestCredentials(string &username, const string &password)
+{
+   static const char *sql = "SELECT password FROM loadtest_users WHERE username = ?;";
+
+   Vector<string> params;
+   params.push_back(username);
+
+   Vector<Vector<string> > results;
+
+   DbQuery query(DatabaseWriter::sqliteFile.c_str());
+   if(!query.runSelectQuery(sql, params, 1, results))
+      return MasterServerConnection::CantConnect;
+
+   if(results.size() == 0)
+      return MasterServerConnection::UnknownUser;
+
+   return results[0][0] == password ? MasterServerConnection::Authenticated : MasterServerConnection::WrongPassword;
+}
+
+
+static const U32 FakeNetwork = 10 << 24;     // Peers pretend to be on 10.x.x.x
+static const U16 FakePort = 28000;
+static const char *LoadTestPassword = "loadtest";
+static const char *ChatPrefix = "loadtest ";
+static const F64 AuthTimeout = 10000;        // ms
+
+
+// Constructor
+LoadTest::LoadTest(const LoadTestOptions &options) : mSettings("")     // Not reading an INI file
+{
+   mOptions = options;
+   mMaster = NULL;
+   mPeerInterface = NULL;
+   mNextAddress = 1;
+   mLoops = 0;
+   mMemoryAtStart = 0;
+   mMemoryConnected = 0;
+
+   mSettings.mSettings.setVal(IniKey::Port, mOptions.port);
+   mSettings.mSettings.setVal(IniKey::JsonOutfile, string("loadtest_server.json"));
+}
+
+
+// Destructor
+LoadTest::~LoadTest()
+{
+   mServers.clear();
+   mClients.clear();
+
+   delete mPeerInterface;
+   delete mMaster;
+
+   MasterServerConnection::setCredentialVerifier(NULL);
+}
+
+
+// Start with a fresh stats database, plus a user table for registered clients
+bool LoadTest::createDatabase()
+{
+   remove(mOptions.database.c_str());
+
+   DatabaseWriter::sqliteFile = mOptions.database;
+   DatabaseWriter databaseWriter(DatabaseWriter::sqliteFile.c_str());     // Creates the stats tables
+
+   DbQuery query(DatabaseWriter::sqliteFile.c_str());
+   if(!query.mIsValid)
+      return false;
+
+   query.runInsertQuery("CREATE TABLE loadtest_users (username TEXT PRIMARY KEY NOT NULL, password TEXT NOT NULL);");
+
+   static const char *sql = "INSERT INTO loadtest_users (username, password) VALUES (?, ?);";
+
+   query.beginTransaction();
+
+   for(S32 i = 0; i < mOptions.clients; i++)
+   {
+      if(S32(i % 100) >= mOptions.registeredPercent)
+         continue;
+
+      Vector<string> params;
+      params.push_back("LoadTestClient" + itos(i));
+      params.push_back(LoadTestPassword);
+
+      query.runInsertQuery(sql, params);
+   }
+
+   if(!query.commitTransaction())
+      return false;
+
+   MasterServerConnection::setCredentialVerifier(verifyLoadTestCredentials);
+   return true;
+}
+
+
+// Give the peer an address of its own, then hook it up to a fresh connection on the master
+bool LoadTest::connect(LoadTestPeer *peer)
+{
+   IPAddress ip;
+   ip.netNum = FakeNetwork | mNextAddress++;
+   ip.port = FakePort;
+
+   Address address(ip);
+
+   MasterServerConnection *masterEnd = new MasterServerConnection();    // Deleted by connectLocal() if things go wrong
+   masterEnd->setNetAddress(address);
+   peer->setNetAddress(address);
+
+   peer->mConnectTime = Platform::getHighPrecisionTimerValue();
+
+   return peer->connectLocal(mPeerInterface, mMaster->getNetInterface(), masterEnd);
+}
+
+
+LoadTestClient *LoadTest::createClient(const string &name, bool isRegistered, bool isInLobby)
+{
+   LoadTestClient *client = new LoadTestClient(name, isRegistered, isInLobby);
+
+   if(!connect(client))
+   {
+      delete client;
+      return NULL;
+   }
+
+   gRequestStats[ClientAuthRequest].sent++;
+   client->mIsWaitingForAuth = true;
+
+   if(isInLobby)
+      client->c2mJoinGlobalChat();
+
+   return client;
+}
+
+
+// Spreads things out so every peer doesn't act at once
+U32 LoadTest::getNextActionTime(U32 currentTime, U32 interval)
+{
+   return currentTime + interval / 2 + Random::readI(0, interval);
+}
+
+
+bool LoadTest::connectPeers()
+{
+   mMemoryAtStart = getMemoryUsed();
+
+   mMaster = new MasterServer(&mSettings);
+   mPeerInterface = new NetInterface(Address(IPProtocol, Address::Any, 0));
+
+   S64 start = Platform::getHighPrecisionTimerValue();
+   U32 currentTime = Platform::getRealMilliseconds();
+
+   for(S32 i = 0; i < mOptions.servers; i++)
+   {
+      LoadTestServer *server = new LoadTestServer(i);
+      mServers.push_back(server);
+
+      if(!connect(server))
+      {
+         printf("Server %d could not connect to the master\n", i);
+         return false;
+      }
+
+      server->mNextActionTime = currentTime + Random::readI(0, mOptions.serverInterval);
+   }
+
+   for(S32 i = 0; i < mOptions.clients; i++)
+   {
+      bool isRegistered = S32(i % 100) < mOptions.registeredPercent;
+      bool isInLobby = Random::readI(0, 99) < U32(mOptions.lobbyPercent);
+
+      LoadTestClient *client = createClient("LoadTestClient" + itos(i), isRegistered, isInLobby);
+
+      if(!client)
+      {
+         printf("Client %d could not connect to the master\n", i);
+         return false;
+      }
+
+      mClients.push_back(client);
+      client->mNextActionTime = currentTime + Random::readI(0, mOptions.clientInterval);
+   }
+
+   F64 elapsed = getMsSince(start);
+   S32 peers = mOptions.servers + mOptions.clients;
+
+   printf("Connected %d servers and %d clients in %.0f ms (%.0f connections/sec)\n", mOptions.servers, mOptions.clients,
+          elapsed, elapsed > 0 ? peers * 1000 / elapsed : 0);
+
+   mMemoryConnected = getMemoryUsed();
+   return true;
+}
+
+
+void LoadTest::reconnect(S32 clientIndex)
+{
+   LoadTestClient *oldClient = mClients[clientIndex];
+   string name = oldClient->mName;
+   bool isRegistered = oldClient->mIsRegistered;
+   bool isInLobby = oldClient->mIsInLobby;
+
+   oldClient->abandonRequests();
+   oldClient->disconnect(NetConnection::ReasonSelfDisconnect, "");
+
+   LoadTestClient *client = createClient(name, isRegistered, isInLobby);
+
+   if(client)
+      mClients[clientIndex] = client;
+}
+
+
+LoadTestClient *LoadTest::getRandomClient() const
+{
+   if(mClients.size() == 0)
+      return NULL;
+
+   return mClients[Random::readI(0, mClients.size() - 1)];
+}
+
+
+// Chat goes to every client connected to the master but the one who said it
+S32 LoadTest::getChatRecipientCount() const
+{
+   return max(mMaster->getClientList()->size() - 1, 0);
+}
+
+
+void LoadTest::tick(U32 currentTime, U32 timeDelta)
+{
+   for(S32 i = 0; i < mServers.size(); i++)
+      if(S32(currentTime - mServers[i]->mNextActionTime) >= 0)
+      {
+         mServers[i]->act(this);
+         mServers[i]->mNextActionTime = getNextActionTime(currentTime, mOptions.serverInterval);
+      }
+
+   for(S32 i = 0; i < mClients.size(); i++)
+      if(S32(currentTime - mClients[i]->mNextActionTime) >= 0)
+      {
+         if(Random::readI(0, 99) < U32(mOptions.reconnectPercent))
+            reconnect(i);
+         else
+            mClients[i]->act(this);
+
+         mClients[i]->mNextActionTime = getNextActionTime(currentTime, mOptions.clientInterval);
+      }
+
+   mPeerInterface->processConnections();
+   mMaster->idle(timeDelta);
+
+   mLoops++;
+}
+
+
+void LoadTest::run()
+{
+   U32 start = Platform::getRealMilliseconds();
+   U32 lastTime = start;
+
+   while(Platform::getRealMilliseconds() - start < mOptions.seconds * 1000)
+   {
+      U32 currentTime = Platform::getRealMilliseconds();
+
+      tick(currentTime, currentTime - lastTime);
+      lastTime = currentTime;
+
+      Platform::sleep(1);
+   }
+}
+
+
+void LoadTest::report() const
+{
+   printf("\n%-22s %9s %9s %7s %9s %9s %9s %9s %9s\n", "Request", "Sent", "Done", "Failed", "Done/sec",
+          "p50 ms", "p90 ms", "p99 ms", "Max ms");
+
+   U32 totalSent = 0;
+
+   for(S32 i = 0; i < RequestTypeCount; i++)
+   {
+      const RequestStats &stats = gRequestStats[i];
+      const LatencyHistogram &latency = stats.latency;
+
+      totalSent += stats.sent;
+
+      if(i == HeartbeatRequest)     // Nothing comes back, so there's nothing to time
+         printf("%-22s %9u %9s %7s %9s", RequestNames[i], stats.sent, "-", "-", "-");
+      else
+         printf("%-22s %9u %9u %7u %9.1f", RequestNames[i], stats.sent, stats.completed, stats.failed,
+                F64(stats.completed) / mOptions.seconds);
+
+      if(latency.getCount() > 0)
+         printf(" %9.2f %9.2f %9.2f %9.2f\n", latency.getPercentile(50), latency.getPercentile(90),
+                latency.getPercentile(99), latency.getMax());
+      else
+         printf(" %9s %9s %9s %9s\n", "-", "-", "-", "-");
+   }
+
+   printf("\n%u requests to the master in %u seconds (%.1f/sec), %u loops\n", totalSent, mOptions.seconds,
+          F64(totalSent) / mOptions.seconds, mLoops);
+
+   const LobbyChat *lobbyChat = mMaster->getLobbyChat();
+   printf("Lobby chat: %d members, %u events relayed in %u messages\n", lobbyChat->getMembers()->size(),
+          lobbyChat->getEventsRelayed(), lobbyChat->getMessagesSent());
+
+   U32 memoryAtEnd = getMemoryUsed();
+   S32 peers = mOptions.servers + mOptions.clients;
+
+   if(memoryAtEnd == 0)
+      printf("Memory use: unavailable on this platform\n");
+   else
+      printf("Memory use: %u KB before starting the master, %u KB with everyone connected, %u KB at the end "
+             "(about %u bytes per peer, including our end of each connection)\n", mMemoryAtStart, mMemoryConnected,
+             memoryAtEnd, peers > 0 ? U32(U64(memoryAtEnd - mMemoryAtStart) * 1024 / peers) : 0);
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+TNL_IMPLEMENT_NETCONNECTION(LoadTestServer, NetClassGroupMaster, false);
+
+// Constructor
+LoadTestServer::LoadTestServer(S32 index)
+{
+   mIndex = index;
+   mPlayerCount = 0;
+   mActions = 0;
+}
+
+
+MasterConnectionType LoadTestServer::getConnectionType() const
+{
+   return MasterConnectionTypeServer;
+}
+
+
+void LoadTestServer::writePeerInfo(BitStream *bstream)
+{
+   bstream->write(U32(0));             // Bots
+   bstream->write(mPlayerCount);
+   bstream->write(U32(16));            // Max players
+   bstream->write(U32(0));             // Info flags
+
+   bstream->writeString("Load Test Level");
+   bstream->writeString("CTF");
+   bstream->writeString(("LoadTestServer" + itos(mIndex)).c_str());
+   bstream->writeString("Synthetic server from the master load test");
+}
+
+
+// A heartbeat every time; every other time, we also check up on a player, like a server does when someone joins
+void LoadTestServer::act(LoadTest *loadTest)
+{
+   mPlayerCount = (mPlayerCount + 1) % 16;       // Something has to change, or the master ignores the update
+   s2mUpdateServerStatus("Load Test Level", "CTF", 0, mPlayerCount, 16, 0);
+
+   gRequestStats[HeartbeatRequest].sent++;
+
+   mActions++;
+
+   // Players who went away before the master could answer never get one
+   for(map<string, S64>::iterator it = mPendingAuth.begin(); it != mPendingAuth.end(); )
+      if(getMsSince(it->second) > AuthTimeout)
+      {
+         gRequestStats[ServerAuthRequest].failed++;
+         mPendingAuth.erase(it++);
+      }
+      else
+         ++it;
+
+   if(mActions % 2 != 0)
+      return;
+
+   LoadTestClient *client = loadTest->getRandomClient();
+
+   if(!client || mPendingAuth.find(client->mName) != mPendingAuth.end())
+      return;
+
+   mPendingAuth[client->mName] = Platform::getHighPrecisionTimerValue();
+   gRequestStats[ServerAuthRequest].sent++;
+
+   s2mRequestAuthentication(client->mId.toVector(), client->mName.c_str());
+}
+
+
+TNL_IMPLEMENT_RPC_OVERRIDE(LoadTestServer, m2sClientRequestedArrangedConnection,
+                          (U32 requestId, Vector<IPAddress> possibleAddresses, ByteBufferPtr connectionParameters))
+{
+   IPAddress internalAddress = getNetAddress().toIPAddress();
+   ByteBufferPtr connectionData = new ByteBuffer(0);
+
+   s2mAcceptArrangedConnection(requestId, internalAddress, connectionData);
+}
+
+
+TNL_IMPLEMENT_RPC_OVERRIDE(LoadTestServer, m2sSetAuthenticated_019,
+                          (Vector<U8> id, StringTableEntry name, RangedU32<0,AuthenticationStatusCount> status,
+                           Int<BADGE_COUNT> badges, U16 gamesPlayed))
+{
+   map<string, S64>::iterator it = mPendingAuth.find(name.getString());
+
+   if(it == mPendingAuth.end())
+      return;
+
+   completed(ServerAuthRequest, it->second);
+   mPendingAuth.erase(it);
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+TNL_IMPLEMENT_NETCONNECTION(LoadTestClient, NetClassGroupMaster, false);
+
+// Constructor
+LoadTestClient::LoadTestClient(const string &name, bool isRegistered, bool isInLobby)
+{
+   mName = name;
+   mIsRegistered = isRegistered;
+   mIsInLobby = isInLobby;
+   mIsWaitingForAuth = false;
+
+   mNextQueryId = 1;
+   mPendingQueryId = 0;
+   mQueryTime = 0;
+   mNextArrangedId = 1;
+
+   mId.getRandom();
+}
+
+
+MasterConnectionType LoadTestClient::getConnectionType() const
+{
+   return MasterConnectionTypeClient;
+}
+
+
+void LoadTestClient::writePeerInfo(BitStream *bstream)
+{
+   bstream->writeString("");                                         // Controller
+   bstream->writeString(mName.c_str());
+   bstream->writeString(mIsRegistered ? LoadTestPassword : "");
+   bstream->writeInt(0, 8);                                          // Flags
+   mId.write(bstream);
+}
+
+
+// Roughly what people do while sitting in the menus
+void LoadTestClient::act(LoadTest *loadTest)
+{
+   U32 roll = Random::readI(0, 99);
+
+   if(mIsInLobby && roll < 30)
+      chat(loadTest);
+   else if(mServers.size() > 0 && roll < 60)
+      requestArrangedConnection();
+   else
+      queryServers();
+}
+
+
+void LoadTestClient::queryServers()
+{
+   if(mPendingQueryId != 0)      // Still waiting on the last one
+      return;
+
+   mPendingQueryId = mNextQueryId++;
+   mQueryTime = Platform::getHighPrecisionTimerValue();
+   mQueryResults.clear();
+
+   gRequestStats[ServerQueryRequest].sent++;
+   c2mQueryServers(mPendingQueryId);
+}
+
+
+void LoadTestClient::requestArrangedConnection()
+{
+   U32 requestId = mNextArrangedId++;
+   IPAddress server = mServers[Random::readI(0, mServers.size() - 1)];
+   ByteBufferPtr connectionParameters = new ByteBuffer(0);
+
+   mPendingArranged[requestId] = Platform::getHighPrecisionTimerValue();
+   gRequestStats[ArrangedConnectionRequest].sent++;
+
+   c2mRequestArrangedConnection(requestId, server, getNetAddress().toIPAddress(), connectionParameters);
+}
+
+
+// The message carries the time it was sent, so whoever hears it can tell how long it took.  Each one that should hear
+// it counts as a delivery sent, so we can tell if some never arrive.
+void LoadTestClient::chat(LoadTest *loadTest)
+{
+   char message[64];
+   dSprintf(message, sizeof(message), "%s%lld", ChatPrefix, (long long) Platform::getHighPrecisionTimerValue());
+
+   gRequestStats[LobbyChatDelivery].sent += loadTest->getChatRecipientCount();
+   c2mSendChat(message);
+}
+
+
+void LoadTestClient::abandonRequests()
+{
+   if(mIsWaitingForAuth)
+   {
+      gRequestStats[ClientAuthRequest].failed++;
+      mIsWaitingForAuth = false;
+   }
+
+   if(mPendingQueryId != 0)
+   {
+      gRequestStats[ServerQueryRequest].failed++;
+      mPendingQueryId = 0;
+   }
+
+   gRequestStats[ArrangedConnectionRequest].failed += U32(mPendingArranged.size());
+   mPendingArranged.clear();
+}
+
+
+TNL_IMPLEMENT_RPC_OVERRIDE(LoadTestClient, m2cSetAuthenticated_019,
+                          (RangedU32<0, AuthenticationStatusCount> authStatus, Int<BADGE_COUNT> badges, U16 gamesPlayed,
+                           StringPtr correctedName))
+{
+   if(!mIsWaitingForAuth)
+      return;
+
+   mIsWaitingForAuth = false;
+
+   // Registered clients should get verified, everyone else should be told they aren't
+   bool expected = mIsRegistered ? authStatus == AuthenticationStatusAuthenticatedName :
+                                   authStatus == AuthenticationStatusUnauthenticatedName;
+   if(expected)
+      completed(ClientAuthRequest, mConnectTime);
+   else
+      gRequestStats[ClientAuthRequest].failed++;
+}
+
+
+TNL_IMPLEMENT_RPC_OVERRIDE(LoadTestClient, m2cQueryServersResponse_019a,
+                          (U32 queryId, Vector<IPAddress> ipList, Vector<S32> serverIdList))
+{
+   if(queryId != mPendingQueryId)
+      return;
+
+   if(ipList.size() > 0)
+   {
+      for(S32 i = 0; i < ipList.size(); i++)
+         mQueryResults.push_back(ipList[i]);
+      return;
+   }
+
+   // An empty list means that's all of them
+   completed(ServerQueryRequest, mQueryTime);
+   mServers = mQueryResults;
+   mPendingQueryId = 0;
+}
+
+
+TNL_IMPLEMENT_RPC_OVERRIDE(LoadTestClient, m2cArrangedConnectionAccepted,
+                          (U32 requestId, Vector<IPAddress> possibleAddresses, ByteBufferPtr connectionData))
+{
+   map<U32, S64>::iterator it = mPendingArranged.find(requestId);
+
+   if(it == mPendingArranged.end())
+      return;
+
+   completed(ArrangedConnectionRequest, it->second);
+   mPendingArranged.erase(it);
+}
+
+
+TNL_IMPLEMENT_RPC_OVERRIDE(LoadTestClient, m2cArrangedConnectionRejected, (U32 requestId, ByteBufferPtr rejectData))
+{
+   map<U32, S64>::iterator it = mPendingArranged.find(requestId);
+
+   if(it == mPendingArranged.end())
+      return;
+
+   gRequestStats[ArrangedConnectionRequest].failed++;
+   mPendingArranged.erase(it);
+}
+
+
+TNL_IMPLEMENT_RPC_OVERRIDE(LoadTestClient, m2cLobbyChatEvents,
+                          (Vector<U8> eventTypes, Vector<StringTableEntry> playerNicks, Vector<string> messages))
+{
+   static const size_t PrefixLength = strlen(ChatPrefix);
+
+   for(S32 i = 0; i < messages.size(); i++)
+   {
+      if(messages[i].compare(0, PrefixLength, ChatPrefix) != 0)
+         continue;
+
+      S64 sendTime = strtoll(messages[i].c_str() + PrefixLength, NULL, 10);
+      completed(LobbyChatDelivery, sendTime);
+   }
+}
+
+
+static void printUsage()
+{
+   LoadTestOptions defaults;
+
+   printf("Usage: master_loadtest [options]\n"
+          "  -servers <n>      Game servers to simulate (%d)\n"
+          "  -clients <n>      Clients to simulate (%d)\n"
+          "  -seconds <n>      How long to run (%u)\n"
+          "  -port <n>         Port for the master to listen on (%u)\n"
+          "  -db <file>        Sqlite database to create, overwriting any already there (%s)\n"
+          "  -clientms <n>     Average ms between client requests (%u)\n"
+          "  -serverms <n>     Average ms between server heartbeats (%u)\n"
+          "  -lobby <pct>      Clients in lobby chat (%d)\n"
+          "  -registered <pct> Clients with verified names (%d)\n"
+          "  -reconnect <pct>  Chance a client logs out and back in instead of making a request (%d)\n",
+          defaults.servers, defaults.clients, defaults.seconds, defaults.port, defaults.database.c_str(),
+          defaults.clientInterval, defaults.serverInterval, defaults.lobbyPercent, defaults.registeredPercent,
+          defaults.reconnectPercent);
+}
+
+
+// Returns false if the command line doesn't make sense
+static bool readOptions(S32 argc, const char **argv, LoadTestOptions &options)
+{
+   for(S32 i = 1; i < argc; i++)
+   {
+      if(i + 1 >= argc)
+         return false;
+
+      const char *arg = argv[i];
+      const char *val = argv[++i];
+
+      if(strcmp(arg, "-servers") == 0)
+         options.servers = atoi(val);
+      else if(strcmp(arg, "-clients") == 0)
+         options.clients = atoi(val);
+      else if(strcmp(arg, "-seconds") == 0)
+         options.seconds = atoi(val);
+      else if(strcmp(arg, "-port") == 0)
+         options.port = atoi(val);
+      else if(strcmp(arg, "-db") == 0)
+         options.database = val;
+      else if(strcmp(arg, "-clientms") == 0)
+         options.clientInterval = atoi(val);
+      else if(strcmp(arg, "-serverms") == 0)
+         options.serverInterval = atoi(val);
+      else if(strcmp(arg, "-lobby") == 0)
+         options.lobbyPercent = atoi(val);
+      else if(strcmp(arg, "-registered") == 0)
+         options.registeredPercent = atoi(val);
+      else if(strcmp(arg, "-reconnect") == 0)
+         options.reconnectPercent = atoi(val);
+      else
+         return false;
+   }
+
+   return options.servers >= 0 && options.clients >= 0 && options.seconds > 0 &&
+          options.clientInterval > 0 && options.serverInterval > 0;
+}
+
+}
+
+using namespace Master;
+
+int main(int argc, const char **argv)
+{
+   LoadTestOptions options;
+
+   if(!readOptions(argc, argv, options))
+   {
+      printUsage();
+      return 1;
+   }
+
+   U8 seed[16];
+   memset(seed, 0, sizeof(seed));
+   U32 time = Platform::getRealMilliseconds();
+   memcpy(seed, &time, sizeof(time));
+   Random::addEntropy(seed, sizeof(seed));
+
+   printf("Master load test: %d servers, %d clients, %u seconds\n", options.servers, options.clients, options.seconds);
+
+   LoadTest loadTest(options);
+
+   if(!loadTest.createDatabase())
+   {
+      printf("Could not create database %s\n", options.database.c_str());
+      return 1;
+   }
+
+   if(!loadTest.connectPeers())
+      return 1;
+
+   loadTest.run();
+   loadTest.report();
+
+   return 0;
+}
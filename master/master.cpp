@@ -9,6 +9,8 @@
 #include "DatabaseAccessThread.h"
 #include "EasterEgg.h"
 #include "GameJoltConnector.h"
+#include "StatsBatcher.h"
+#include "LobbyChat.h"
 
 #include "../zap/stringUtils.h"  // For itos, replaceString
 #include "../zap/IniFile.h"      // For INI reading/writing
@@ -169,7 +171,14 @@ MasterServer::MasterServer(MasterSettings *settings)
 
    mLastMotd = mSettings->getMotd();            // When this changes, we'll broadcast a new MOTD to clients
    
-   mDatabaseAccessThread = new DatabaseAccessThread();    // Deleted in destructor
+   // Deleted in destructor; each of its threads keeps its own database connection from the pool
+   mDatabaseAccessThread = new DatabaseAccessThread(mSettings->getVal<U32>(IniKey::DatabaseThreads));
+#ifndef BF_NO_STATS
+   DbWriter::DbQuery::enablePooling(true);
+#endif
+
+   mStatsBatcher = new StatsBatcher(mSettings, mDatabaseAccessThread);    // Deleted in destructor
+   mLobbyChat = new LobbyChat();                                          // Deleted in destructor
 
    MasterServerConnection::setMasterServer(this);
 
@@ -183,9 +192,28 @@ MasterServer::MasterServer(MasterSettings *settings)
 // Destructor
 MasterServer::~MasterServer()
 {
-   delete mNetInterface;
+   delete mNetInterface;      // Connections tell mLobbyChat they're leaving as they go, so it must outlive them
+
+   // Get the stats we're holding on to into the database before the threads that write them go away.  We won't wait
+   // on a database that isn't answering, or on retries; whatever's left is logged when mStatsBatcher goes.
+   mStatsBatcher->flush();
+
+   U32 shutdownStarted = Platform::getRealMilliseconds();
+
+   while(mStatsBatcher->getBatchesInFlight() > 0 && Platform::getRealMilliseconds() - shutdownStarted < StatsShutdownWait)
+   {
+      mDatabaseAccessThread->idle();
+      Platform::sleep(10);
+   }
+
    delete mDatabaseAccessThread;
+   delete mStatsBatcher;
+   delete mLobbyChat;
    delete mEasterEggBasket;
+
+#ifndef BF_NO_STATS
+   DbWriter::DbQuery::enablePooling(false);     // Closes the connections the database threads were using
+#endif
 }
 
 
@@ -232,7 +260,20 @@ void MasterServer::writeJsonNow()
 
 const Vector<MasterServerConnection *> *MasterServer::getServerList() const
 {
-   return &mServerList;
+   return mServerRegistry.getServers();
+}
+
+
+// Servers that clients are allowed to see
+const Vector<MasterServerConnection *> *MasterServer::getListedServerList() const
+{
+   return mServerRegistry.getListedServers();
+}
+
+
+const ServerRegistry::QueryResponse &MasterServer::getServerQueryResponse(U32 protocolVersion, bool hostMode)
+{
+   return mServerRegistry.getQueryResponse(protocolVersion, hostMode);
 }
 
 
@@ -244,7 +285,13 @@ const Vector<MasterServerConnection *> *MasterServer::getClientList() const
 
 void MasterServer::addServer(MasterServerConnection *server)
 {
-   mServerList.push_back(server);
+   mServerRegistry.add(server);
+}
+
+
+void MasterServer::updateServer(MasterServerConnection *server)
+{
+   mServerRegistry.update(server);
 }
 
 
@@ -254,10 +301,9 @@ void MasterServer::addClient(MasterServerConnection *client)
 }
 
 
-void MasterServer::removeServer(S32 index)
+void MasterServer::removeServer(MasterServerConnection *server)
 {
-   TNLAssert(index >= 0 && index < mServerList.size(), "Index out of range!");
-   mServerList.erase_fast(index);
+   mServerRegistry.remove(server);
 }
 
 
@@ -292,6 +338,8 @@ void MasterServer::idle(const U32 timeDelta)
       mSettings->readConfigFile();
       mReadConfigTimer.reset();
 
+      mDatabaseAccessThread->setMaxThreads(mSettings->getVal<U32>(IniKey::DatabaseThreads));
+
       if(motdHasChanged())
       {
          broadcastMotd();
@@ -303,6 +351,7 @@ void MasterServer::idle(const U32 timeDelta)
    if(mCleanupTimer.update(timeDelta))
    {
       MasterServerConnection::removeOldEntriesFromRatingsCache();    //<== need non-static access
+      logDatabaseStats();
       mCleanupTimer.reset();
    }
 
@@ -368,23 +417,40 @@ void MasterServer::idle(const U32 timeDelta)
       {
          if(currentTime - c->mLeaveLobbyChatTimer > (U32)ONE_SECOND)
          {
-            c->isInLobbyChat = false;
-
-            const Vector<MasterServerConnection *> *clientList = getClientList();
-
-            for(S32 j = 0; j < clientList->size(); j++)
-               if(clientList->get(j) != c && clientList->get(j)->isInLobbyChat)
-                  clientList->get(j)->m2cPlayerLeftGlobalChat(c->mPlayerOrServerName);
-
+            mLobbyChat->leave(c);
             MasterServerConnection::gLeaveChatTimerList.erase(i);
          }
       }
    }
 
+   // Tell everyone about this tick's lobby chat comings, goings, and chatter, one message per client
+   mLobbyChat->flush(getClientList());
+
+   mStatsBatcher->idle(timeDelta);
    mDatabaseAccessThread->idle();
 }
 
 
+// Let whoever is watching the log know how the database is keeping up
+void MasterServer::logDatabaseStats() const
+{
+   DatabaseAccessStats stats = mDatabaseAccessThread->getStats(true);
+
+   logprintf("[%s] Database: %d threads, %d queued (peak %d), %d running, %d done, %d failed, latency avg %dms max %dms",
+             getTimeStamp().c_str(), stats.threads, stats.queued, stats.peakQueued, stats.running, 
+             stats.completed, stats.failed, stats.averageLatency, stats.maxLatency);
+
+   logprintf("[%s] Stats: %d records in %d batches written, %d pending, %d retries, %d batches awaiting retry, %d records dropped",
+             getTimeStamp().c_str(), mStatsBatcher->getRecordsWritten(), mStatsBatcher->getBatchesWritten(), 
+             mStatsBatcher->getPendingCount(), mStatsBatcher->getRetryCount(), mStatsBatcher->getFailedBatchCount(), 
+             mStatsBatcher->getRecordsDropped());
+
+   logprintf("[%s] Lobby chat: %d members, %d events relayed in %d messages",
+             getTimeStamp().c_str(), mLobbyChat->getMembers()->size(), mLobbyChat->getEventsRelayed(), 
+             mLobbyChat->getMessagesSent());
+}
+
+
 // Send MOTD to all connected clients -- used when MOTD has changed
 void MasterServer::broadcastMotd() const
 {
@@ -405,6 +471,18 @@ DatabaseAccessThread *MasterServer::getDatabaseAccessThread()
 }
 
 
+StatsBatcher *MasterServer::getStatsBatcher()
+{
+   return mStatsBatcher;
+}
+
+
+LobbyChat *MasterServer::getLobbyChat()
+{
+   return mLobbyChat;
+}
+
+
 EasterEggBasket *MasterServer::getEasterEggBasket()
 {
    return mEasterEggBasket;
@@ -6,6 +6,7 @@
 #include "masterInterface.h"
 
 #include "MasterServerConnection.h"
+#include "ServerRegistry.h"
 
 #include "../zap/IniFile.h"
 
@@ -45,6 +46,9 @@ using namespace Zap;
    SETTINGS_ITEM(string,    StatsDatabaseName,          "stats",    "stats_database_name",                  "",                         NULL, NULL, "" ) \
    SETTINGS_ITEM(string,    StatsDatabaseUsername,      "stats",    "stats_database_username",              "",                         NULL, NULL, "" ) \
    SETTINGS_ITEM(string,    StatsDatabasePassword,      "stats",    "stats_database_password",              "",                         NULL, NULL, "" ) \
+   SETTINGS_ITEM(U32,       DatabaseThreads,            "stats",    "database_threads",                     4,                          NULL, NULL, "" ) \
+   SETTINGS_ITEM(U32,       StatsBatchSize,             "stats",    "stats_batch_size",                     50,                         NULL, NULL, "" ) \
+   SETTINGS_ITEM(U32,       StatsBatchSeconds,          "stats",    "stats_batch_seconds",                  5,                          NULL, NULL, "" ) \
                                                                                                                                                          \
    /* GameJolt settings */                                                                                                                               \
    SETTINGS_ITEM(YesNo,     UseGameJolt,                "GameJolt", "UseGameJolt",                          Yes,                        NULL, NULL, "" ) \
@@ -109,6 +113,8 @@ public:
 
 class DatabaseAccessThread;
 class EasterEggBasket;
+class StatsBatcher;
+class LobbyChat;
 
 class MasterServer 
 {
@@ -129,16 +135,21 @@ private:
    Timer mPingGameJoltTimer;
 
    DatabaseAccessThread *mDatabaseAccessThread;
+   StatsBatcher *mStatsBatcher;
+   LobbyChat *mLobbyChat;
 
-   Vector<MasterServerConnection *> mServerList;
+   ServerRegistry mServerRegistry;
    Vector<MasterServerConnection *> mClientList;
 
    NetInterface *createNetInterface() const;
 
    bool motdHasChanged() const;
    void broadcastMotd() const;
+   void logDatabaseStats() const;
 
 public:
+   static const U32 StatsShutdownWait = 10000;  // ms we'll wait for stats to be written when shutting down
+
    MasterServer(MasterSettings *settings);      // Constructor
    ~MasterServer();                             // Destructor
 
@@ -155,16 +166,21 @@ public:
 
    NetInterface *getNetInterface() const;
    DatabaseAccessThread *getDatabaseAccessThread();
+   StatsBatcher *getStatsBatcher();
+   LobbyChat *getLobbyChat();
    void writeJsonDelayed();
    void writeJsonNow();
 
    const Vector<MasterServerConnection *> *getServerList() const;
+   const Vector<MasterServerConnection *> *getListedServerList() const;
+   const ServerRegistry::QueryResponse &getServerQueryResponse(U32 protocolVersion, bool hostMode);
    const Vector<MasterServerConnection *> *getClientList() const;
 
    void addServer(MasterServerConnection *server);
+   void updateServer(MasterServerConnection *server);    // Call after a server changes in a way that affects its listing
    void addClient(MasterServerConnection *client);
 
-   void removeServer(S32 index);
+   void removeServer(MasterServerConnection *server);
    void removeClient(S32 index);
 
    EasterEggBasket *getEasterEggBasket();
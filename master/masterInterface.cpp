@@ -31,6 +31,7 @@ static const S32 M_RPC_019  = 3;
 static const S32 M_RPC_019a = 4;
 static const S32 M_RPC_019d = 5;
 static const S32 M_RPC_020  = 6;
+static const S32 M_RPC_021  = 7;
 
 TNL_IMPLEMENT_RPC(MasterServerInterface, c2mQueryServers,
    (U32 queryId), (queryId),
@@ -152,6 +153,12 @@ TNL_IMPLEMENT_RPC(MasterServerInterface, m2cPlayerLeftGlobalChat,
    (playerNick),
    NetClassGroupMasterMask, RPCGuaranteedOrdered, RPCDirServerToClient, M_RPC_PRE_017) {}
 
+// Can get big when lots of players come and go at once
+TNL_IMPLEMENT_RPC(MasterServerInterface, m2cLobbyChatEvents, 
+   (Vector<U8> eventTypes, Vector<StringTableEntry> playerNicks, Vector<string> messages), 
+   (eventTypes, playerNicks, messages),
+   NetClassGroupMasterMask, RPCGuaranteedOrderedBigData, RPCDirServerToClient, M_RPC_021) {}
+
 
 // Implement a need-to-updrade verification service, without breaking older clients, by updgrading the version 1
 // All clients that implement only 0-verison events will ignore this.  In theory.
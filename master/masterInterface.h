@@ -23,6 +23,17 @@ static const char USED_EXTERNAL *MasterRequestTimedOut = "Timed Out";
 
 const S32 IP_MESSAGE_ADDRESS_COUNT = 30;
 
+// What happened, for each entry in an m2cLobbyChatEvents list
+enum LobbyChatEventType
+{
+   LobbyChatClientConnected,        // Someone connected to the master
+   LobbyChatClientDisconnected,     // ...or went away, which takes them out of lobby chat too
+   LobbyChatPlayerJoined,
+   LobbyChatPlayerLeft,
+   LobbyChatMessage,                // Takes the next string from the messages list
+   LobbyChatEventTypeCount
+};
+
 /// The MasterServerInterface is the RPC interface to the TNL example Master Server.
 /// The default Master Server tracks a list of public servers and allows clients
 /// to query for them based on different filter criteria, including maximum number of players,
@@ -162,6 +173,10 @@ public:
    TNL_DECLARE_RPC(m2cPlayerLeftGlobalChat, (StringTableEntry playerNick));
    TNL_DECLARE_RPC(m2cPlayersInGlobalChat, (Vector<StringTableEntry> playerNicks));
 
+   // 021 version: everything above that happened during one master tick, in order, in one message.  eventTypes are
+   // LobbyChatEventTypes; playerNicks has one entry per event, and messages one per LobbyChatMessage event.
+   TNL_DECLARE_RPC(m2cLobbyChatEvents, (Vector<U8> eventTypes, Vector<StringTableEntry> playerNicks, Vector<string> messages));
+
 
    TNL_DECLARE_RPC(s2mRequestAuthentication, (Vector<U8> id, StringTableEntry name));
 
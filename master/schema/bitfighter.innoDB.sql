@@ -38,6 +38,23 @@ CREATE TABLE IF NOT EXISTS `server` (
 --
 
 
+-- --------------------------------------------------------
+
+--
+-- Table structure for table `stats_batch`
+--
+
+CREATE TABLE IF NOT EXISTS `stats_batch` (
+  `batch_id` char(32) COLLATE utf8_unicode_ci NOT NULL,
+  `insertion_date` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`batch_id`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci ;
+
+--
+-- Dumping data for table `stats_batch`
+--
+
+
 -- --------------------------------------------------------
 
 --
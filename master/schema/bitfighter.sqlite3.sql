@@ -14,6 +14,12 @@ CREATE TABLE server (server_id INTEGER PRIMARY KEY  AUTOINCREMENT  NOT NULL, ser
 
 CREATE UNIQUE INDEX server_name_ip_unique ON server(server_name COLLATE BINARY, ip_address COLLATE BINARY);
 
+/* stats_batch */
+DROP TABLE IF EXISTS stats_batch;
+CREATE TABLE stats_batch (
+  batch_id CHAR(32) NOT NULL PRIMARY KEY,
+  insertion_date TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP);
+
 /*  stats_game */
 DROP TABLE IF EXISTS stats_game;
 CREATE TABLE stats_game (
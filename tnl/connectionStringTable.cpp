@@ -167,4 +167,10 @@ void ConnectionStringTable::packetRewind(PacketList *note, PacketEntry *p_entry)
       walk = next;
    }
 }
+
+void ConnectionStringTable::clearReceiveConfirmations()
+{
+   for(U32 i = 0; i < EntryCount; i++)
+      mEntryTable[i].receiveConfirmed = false;
+}
 };
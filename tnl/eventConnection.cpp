@@ -47,6 +47,14 @@ EventConnection::EventConnection()
    mNextSendEventSeq = FirstValidSendEventSeq;
    mNextRecvEventSeq = FirstValidSendEventSeq;
    mLastAckedEventSeq = -1;
+   mSavedSendEventQueueHead = NULL;
+   mSavedSendEventQueueTail = NULL;
+   mSavedUnorderedSendEventQueueHead = NULL;
+   mSavedUnorderedSendEventQueueTail = NULL;
+   mSavedNotifyEventList = NULL;
+   mSavedNextSendEventSeq = FirstValidSendEventSeq;
+   mSavedLastAckedEventSeq = -1;
+   mInEventSnapshot = false;
    mEventClassCount = 0;
    mEventClassBitSize = 0;
    mTNLDataBuffer = NULL;
@@ -56,6 +64,9 @@ static const U32 mTNLDataBufferMaxSize = 1024 * 1024 * 4;  // 4 MB
 
 EventConnection::~EventConnection()
 {
+   if(mInEventSnapshot)
+      endEventSnapshot();
+
    clearSendEvents();
    clearRecvEvents();
 }
@@ -104,6 +115,70 @@ void EventConnection::clearRecvEvents()
       delete mTNLDataBuffer;
 }
 
+void EventConnection::freeEventNotes(EventNote *list, bool delivered)
+{
+   while(list)
+   {
+      EventNote *temp = list;
+      list = temp->mNextEvent;
+
+      temp->mEvent->notifyDelivered(this, delivered);
+      mEventNoteChunker.free(temp);
+   }
+}
+
+void EventConnection::beginEventSnapshot()
+{
+   TNLAssert(!mInEventSnapshot, "Event snapshots don't nest!");
+   mInEventSnapshot = true;
+
+   mSavedSendEventQueueHead = mSendEventQueueHead;
+   mSavedSendEventQueueTail = mSendEventQueueTail;
+   mSavedUnorderedSendEventQueueHead = mUnorderedSendEventQueueHead;
+   mSavedUnorderedSendEventQueueTail = mUnorderedSendEventQueueTail;
+   mSavedNotifyEventList = mNotifyEventList;
+   mSavedNextSendEventSeq = mNextSendEventSeq;
+   mSavedLastAckedEventSeq = mLastAckedEventSeq;
+
+   mSendEventQueueHead = NULL;
+   mSendEventQueueTail = NULL;
+   mUnorderedSendEventQueueHead = NULL;
+   mUnorderedSendEventQueueTail = NULL;
+   mNotifyEventList = NULL;
+   mNextSendEventSeq = FirstValidSendEventSeq;
+   mLastAckedEventSeq = FirstValidSendEventSeq - 1;
+}
+
+void EventConnection::endEventSnapshot()
+{
+   TNLAssert(mInEventSnapshot, "No event snapshot to end!");
+   mInEventSnapshot = false;
+
+   // Whatever the snapshot didn't get around to writing is dropped, not sent with the regular stream
+   freeEventNotes(mSendEventQueueHead, false);
+   freeEventNotes(mUnorderedSendEventQueueHead, false);
+   freeEventNotes(mNotifyEventList, true);
+
+   mSendEventQueueHead = mSavedSendEventQueueHead;
+   mSendEventQueueTail = mSavedSendEventQueueTail;
+   mUnorderedSendEventQueueHead = mSavedUnorderedSendEventQueueHead;
+   mUnorderedSendEventQueueTail = mSavedUnorderedSendEventQueueTail;
+   mNotifyEventList = mSavedNotifyEventList;
+   mNextSendEventSeq = mSavedNextSendEventSeq;
+   mLastAckedEventSeq = mSavedLastAckedEventSeq;
+}
+
+S32 EventConnection::getNextUnackedEventSeq() const
+{
+   return mLastAckedEventSeq + 1;
+}
+
+void EventConnection::setNextRecvEventSeq(S32 seq)
+{
+   TNLAssert(!mWaitSeqEvents, "Events are still waiting on their predecessors!");
+   mNextRecvEventSeq = seq;
+}
+
 void EventConnection::writeConnectRequest(BitStream *stream)
 {
    Parent::writeConnectRequest(stream);
@@ -31,6 +31,8 @@
 #include "tnlNetObject.h"
 #include "tnlNetInterface.h"
 
+#include <algorithm>
+
 namespace TNL {
 
 GhostConnection::GhostConnection()
@@ -183,14 +185,31 @@ void GhostConnection::packetReceived(PacketNotify *pnotify)
    }
 }
 
-static S32 QSORT_CALLBACK prioritySort(const void *a, const void *b)
+static bool priorityLess(const GhostInfo *a, const GhostInfo *b)
 {
-   GhostInfo *ga = *((GhostInfo **) a);
-   GhostInfo *gb = *((GhostInfo **) b);
+   return a->priority < b->priority;
+}
+
+// Only the first few dozen ghosts usually fit in a packet, so rather than sorting every ghost that needs an
+// update, writePacket() calls this to pull the next few highest priority ghosts out as it needs them.
+// Moves the count highest priority ghosts in mGhostArray[0, end) to the top of that range, in ascending
+// order, and returns the index of the lowest of them.
+S32 GhostConnection::selectTopPriorityGhosts(S32 end, S32 count)
+{
+   GhostInfo **ghosts = mGhostArray.address();
+   S32 start = getMax(end - count, 0);
+
+   if(start > 0)
+      std::nth_element(ghosts, ghosts + start, ghosts + end, priorityLess);
 
-   F32 ret = ga->priority - gb->priority;
-   return (ret < 0) ? -1 : ((ret > 0) ? 1 : 0);
-} 
+   std::sort(ghosts + start, ghosts + end, priorityLess);
+
+   // Reset the array indices...
+   for(S32 i = 0; i < end; i++)
+      ghosts[i]->arrayIndex = i;
+
+   return start;
+}
 
 void GhostConnection::prepareWritePacket()
 {
@@ -371,13 +390,6 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
    }
    GhostRef *updateList = NULL;
 
-   if(mGhostZeroUpdateIndex != 0)
-      qsort(&mGhostArray[0], mGhostZeroUpdateIndex, sizeof(GhostInfo *), prioritySort);
-
-   // Reset the array indices...
-   for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
-      mGhostArray[i]->arrayIndex = i;
-
    U8 bitsNeededToSendMaxIndex = 0;
 
    while(maxIndex != 0)
@@ -394,8 +406,15 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
    U32 count = 0;
    bool have_something_to_send = bstream->getBitPosition() >= 256;
 
+   // Ghosts at or above sortedStart are in priority order.  Pushing a ghost to zero only ever shuffles
+   // ghosts above i, so everything below it is still waiting to be selected.
+   S32 sortedStart = mGhostZeroUpdateIndex;
+
    for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0 && !bstream->isFull(); i--)
    {
+      if(i < sortedStart)
+         sortedStart = selectTopPriorityGhosts(i + 1, PrioritySelectionChunk);
+
       GhostInfo *walk = mGhostArray[i];
       if(walk->flags & (GhostInfo::KillingGhost | GhostInfo::Ghosting))
          continue;
@@ -512,6 +531,86 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
    notify->ghostList = updateList;
 }
 
+S32 GhostConnection::writeGhostSnapshot(BitStream *bstream, S32 start)
+{
+   if(mConnectionParameters.mDebugObjectSizes)
+      bstream->writeInt(DebugChecksum, 32);
+
+   bstream->writeFlag(true);     // Ghosting is active
+
+   // Objects the remote host doesn't have yet, or is about to lose, will be taken care of by the regular stream
+   const U32 SkipFlags = GhostInfo::NotYetGhosted | GhostInfo::KillGhost | GhostInfo::KillingGhost;
+
+   U32 maxIndex = 0;
+   for(S32 i = 0; i < mGhostFreeIndex; i++)
+      if(mGhostArray[i]->index > maxIndex)
+         maxIndex = mGhostArray[i]->index;
+
+   U8 bitsNeededToSendMaxIndex = 0;
+
+   while(maxIndex != 0)
+   {
+      maxIndex >>= 1;
+      bitsNeededToSendMaxIndex++;
+   }
+
+   if(bitsNeededToSendMaxIndex < ID_BIT_OFFSET)
+      bitsNeededToSendMaxIndex = ID_BIT_OFFSET;
+
+   bool written = false;
+   S32 i;
+
+   for(i = start; i < mGhostFreeIndex; i++)
+   {
+      GhostInfo *walk = mGhostArray[i];
+      if((walk->flags & SkipFlags) || !walk->obj)
+         continue;
+
+      U32 updateStart = bstream->getBitPosition();
+      ConnectionStringTable::PacketEntry *strEntry = getCurrentWritePacketNotify()->stringList.stringTail;
+
+      bstream->writeFlag(true);     // Signals that an object will be coming
+
+      if(!written)
+         bstream->writeInt(bitsNeededToSendMaxIndex - ID_BIT_OFFSET, ID_BIT_SIZE);
+
+      bstream->writeInt(walk->index, bitsNeededToSendMaxIndex);
+      bstream->writeFlag(false);    // Not being deleted
+
+      if(mConnectionParameters.mDebugObjectSizes)
+         bstream->advanceBitPosition(BitStreamPosBitSize);
+
+      S32 startPos = bstream->getBitPosition();
+
+      bstream->writeInt(walk->obj->getClassId(getNetClassGroup()), mGhostClassBitSize);
+      NetObject::mIsInitialUpdate = true;
+      walk->obj->packUpdate(this, 0xFFFFFFFF, bstream);
+      NetObject::mIsInitialUpdate = false;
+
+      if(mConnectionParameters.mDebugObjectSizes)
+         bstream->writeIntAt(bstream->getBitPosition(), BitStreamPosBitSize, startPos - BitStreamPosBitSize);
+
+      if(!bstream->isValid() || bstream->getBitPosition() >= mWriteMaxBitSize)
+      {
+         mStringTable->packetRewind(&getCurrentWritePacketNotify()->stringList, strEntry);
+         bstream->setBitPosition(updateStart);
+         bstream->clearError();
+
+         if(written)
+            break;
+
+         TNLAssertV(false, ("%s is too big to fit in a packet on its own", walk->obj->getClassName()));
+         continue;
+      }
+
+      written = true;
+   }
+
+   bstream->writeFlag(false);    // Last object, no more coming
+
+   return i < mGhostFreeIndex ? i : -1;
+}
+
 void GhostConnection::readPacket(BitStream *bstream)
 {
    Parent::readPacket(bstream);
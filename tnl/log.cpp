@@ -91,22 +91,50 @@ void LogConsumer::setMsgType(MsgType msgType, bool enable)
 }
 
 
+// Messages logged on this thread are being held here, if it's not NULL
+static thread_local LogConsumer::HeldMessages *heldMessages = NULL;
+
+
 // Find all logs that are listenting to a specified MessageType and forward the message to them.  Static method.
 void LogConsumer::logString(LogConsumer::MsgType msgType, std::string message)
 {
+   if(heldMessages)
+   {
+      heldMessages->push_back(std::pair<MsgType, std::string>(msgType, message));
+      return;
+   }
+
    for(LogConsumer *walk = LogConsumer::getLinkedList(); walk; walk = walk->getNext())
       if(walk->mMsgTypes & msgType)     // Only log to the requested type of logfile
          walk->prepareAndLogString(message);
 }
 
 
-// Create reusable buffer for our logging functions.  Make it big because when we use datadumper 
-// in a script, some messages can get very long
-static char msg[1024 * 8];
+// Static method
+void LogConsumer::holdMessages(HeldMessages *messages)
+{
+   heldMessages = messages;
+}
+
+
+// Static method
+void LogConsumer::releaseMessages(HeldMessages &messages)
+{
+   for(size_t i = 0; i < messages.size(); i++)
+      logString(messages[i].first, messages[i].second);
+
+   messages.clear();
+}
+
+
+// Size of the buffer for our logging functions; big because when we use datadumper in a script, some messages can get
+// very long.  The buffer is on the stack, so threads can log at the same time.
+static const S32 MsgBufferSize = 1024 * 8;
 
 
 void LogConsumer::logprintf(const char *format, ...)
 {
+   char msg[MsgBufferSize];
    va_list args; 
    va_start(args, format); 
 
@@ -230,6 +258,7 @@ LogType *LogType::find(const char *name)
 // Logs to logfiles that have subscribed to specified message type
 void logprintf(LogConsumer::MsgType msgType, const char *format, ...)
 {
+   char msg[MsgBufferSize];
    va_list args; 
    va_start(args, format); 
 
@@ -246,6 +275,7 @@ void logprintf(LogConsumer::MsgType msgType, const char *format, ...)
 // Logs to general log
 void logprintf(const char *format, ...)
 {
+   char msg[MsgBufferSize];
    va_list args; 
    va_start(args, format); 
 
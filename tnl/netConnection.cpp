@@ -939,8 +939,12 @@ bool NetConnection::readConnectAccept(BitStream *stream, TerminationReason &reas
 bool NetConnection::connectLocal(NetInterface *connectionInterface, NetInterface *serverInterface)
 {
    Object *co = Object::create(getClassName());
+   return connectLocal(connectionInterface, serverInterface, dynamic_cast<NetConnection *>(co));
+}
+
+bool NetConnection::connectLocal(NetInterface *connectionInterface, NetInterface *serverInterface, NetConnection *server)
+{
    NetConnection *client = this;
-   NetConnection *server = dynamic_cast<NetConnection *>(co);
    NetConnection::TerminationReason reason;
    PacketStream stream;
 
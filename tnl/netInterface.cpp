@@ -353,8 +353,12 @@ void NetInterface::processConnections()
    }
 
    NetObject::collapseDirtyList(); // collapse all the mask bits...
+
+   // Every connection's packet for this tick goes out together, in as few system calls as possible
+   mSocket.beginSendBatch();
    for(S32 i = 0; i < mConnectionList.size(); i++)
       mConnectionList[i]->checkPacketSend(false, getCurrentTime());
+   mSocket.flushSendBatch();
 
    if(U32(getCurrentTime() - mLastTimeoutCheckTime) > TimeoutCheckInterval)
    {
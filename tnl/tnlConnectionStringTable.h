@@ -101,6 +101,9 @@ public:
    void packetReceived(PacketList *note);
    void packetDropped(PacketList *note);
    void packetRewind(PacketList *note, PacketEntry *p_entry);
+
+   /// Forgets which strings the other side has, so each will be sent in full the next time it is used
+   void clearReceiveConfirmations();
 };
 
 };
@@ -109,6 +109,19 @@ protected:
    /// Dispatches an event
    void processEvent(NetEvent *theEvent);
 
+   /// Event snapshots let a connection write out a self-contained burst of events -- everything a host joining
+   /// the stream partway through would need to catch up -- without disturbing the regular event stream.  Events
+   /// posted between beginEventSnapshot() and endEventSnapshot() are held apart and sequenced from the start,
+   /// and writePacket() writes them like any others.
+   void beginEventSnapshot();
+   void endEventSnapshot();
+
+   /// Sequence number of the first ordered event the remote host has not yet been sent, or has not acknowledged
+   S32 getNextUnackedEventSeq() const;
+
+   /// For hosts that skip around in a recorded event stream, sets the next ordered event sequence to expect
+   void setNextRecvEventSeq(S32 seq);
+
 
 //----------------------------------------------------------------
 // event manager functions/code:
@@ -128,6 +141,18 @@ private:
    S32 mNextRecvEventSeq;  ///< The next receive event sequence to process
    S32 mLastAckedEventSeq; ///< The last event the remote host is known to have processed
 
+   /// The regular send queue, set aside while an event snapshot is being written
+   EventNote *mSavedSendEventQueueHead;
+   EventNote *mSavedSendEventQueueTail;
+   EventNote *mSavedUnorderedSendEventQueueHead;
+   EventNote *mSavedUnorderedSendEventQueueTail;
+   EventNote *mSavedNotifyEventList;
+   S32 mSavedNextSendEventSeq;
+   S32 mSavedLastAckedEventSeq;
+   bool mInEventSnapshot;
+
+   void freeEventNotes(EventNote *list, bool delivered);
+
    enum {
       InvalidSendEventSeq = -1,
       FirstValidSendEventSeq = 0
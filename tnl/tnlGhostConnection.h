@@ -168,6 +168,13 @@ protected:
    void deleteLocalGhosts();
    bool validateGhostArray();
 
+   S32 selectTopPriorityGhosts(S32 end, S32 count);
+
+   /// Writes a ghost section that recreates every object the remote host already has, from scratch and under the
+   /// same ghost ids, for a reader joining the stream partway through.  Starts at mGhostArray[start] and stops
+   /// when the packet fills; returns where the next packet should pick up, or -1 once every ghost is written.
+   S32 writeGhostSnapshot(BitStream *bstream, S32 start);
+
    void freeGhostInfo(GhostInfo *);
 
    /// Notifies subclasses that the remote host is about to start ghosting objects.
@@ -209,6 +216,8 @@ public:
       GhostLookupTableSize = (1 << GhostLookupTableSizeShift), ///< Size of the hash table used to lookup source NetObjects by remote ghost ID.
       GhostLookupTableMask = (GhostLookupTableSize - 1),       ///< Hashing mask for table lookups.
 
+      PrioritySelectionChunk = 32,             ///< Number of ghosts put in priority order at a time when filling a packet.
+
    };
 
    void setScopeObject(NetObject *object);            ///< Sets the object that is queried at each packet to determine
@@ -31,6 +31,9 @@
 #include "tnl.h"
 #include <string.h>
 #include <stdarg.h>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace TNL
 {
@@ -120,6 +123,13 @@ public:
 
    static void logString(LogConsumer::MsgType msgType, std::string message);
 
+   typedef std::vector<std::pair<MsgType, std::string> > HeldMessages;
+
+   /// While set, messages logged on the calling thread are added to heldMessages rather than written anywhere; pass NULL
+   /// to go back to normal.  Lets a worker thread keep its messages for the main thread to log with releaseMessages().
+   static void holdMessages(HeldMessages *heldMessages);
+   static void releaseMessages(HeldMessages &heldMessages);
+
 private:
    S32 mMsgTypes;    // A bitmap of MsgType values
    void prepareAndLogString(std::string message);
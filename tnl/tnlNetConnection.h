@@ -361,6 +361,10 @@ public:
    /// Connects to a server interface within the same process.
    bool connectLocal(NetInterface *connectionInterface, NetInterface *localServerInterface);
 
+   /// Connects to a server interface within the same process, using the given connection object for the server's
+   /// end, which need not be the same class as this one.  The server connection is deleted if the connection fails.
+   bool connectLocal(NetInterface *connectionInterface, NetInterface *localServerInterface, NetConnection *serverConnection);
+
    /// Connects to a remote host that is also connecting to this connection (negotiated by a third party)
    void connectArranged(NetInterface *connectionInterface, const Vector<Address> &possibleAddresses, Nonce &myNonce, Nonce &remoteNonce, ByteBufferPtr sharedSecret, bool isInitiator, bool requestsKeyExchange = false, bool requestsCertificate = false);
 
@@ -144,14 +144,23 @@ enum NetError {
    UnknownError,          ///< There was some other, unknown error.
 };
 
+struct SocketBatch;
+
 /// The Socket class encapsulates a platform's network socket.
 class Socket
 {
    S32 mPlatformSocket;    ///< The OS-level socket
    U32 mTransportProtocol; ///< The transport type this socket uses.
+
+   SocketBatch *mBatch;    ///< Datagrams read ahead of time, and sends waiting to go out; created on first use
+   bool mBatchedIO;        ///< True if we should move several datagrams per system call when the OS allows it
+   bool mBatchingSends;    ///< True between beginSendBatch() and flushSendBatch()
+
+   SocketBatch *getBatch();
 public:
    enum {
       DefaultBufferSize = 32768, ///< The default send and receive buffer sizes
+      BatchSize = 32,            ///< Max datagrams moved per system call when batching
    };
 
    /// Opens a socket on the specified address/port
@@ -189,6 +198,24 @@ public:
    virtual NetError send(const U8 *buffer, S32 bufferSize);
 
    bool isWritable(U32 timeout = 0);
+
+   /// Holds on to packets passed to sendto() until flushSendBatch(), so they can go out several
+   /// per system call.  Only has an effect where the OS supports it (currently Linux sendmmsg);
+   /// elsewhere packets are sent right away, as usual.
+   void beginSendBatch();
+
+   /// Sends anything queued up since beginSendBatch().  Returns the first error, mapped as sendto() maps it.
+   NetError flushSendBatch();
+
+   /// Batched I/O is used by default wherever it is available; turning it off is mostly useful for benchmarking.
+   void setBatchedIO(bool enabled);
+
+   /// Returns true if this platform can send and receive several datagrams per system call.
+   static bool isBatchedIOAvailable();
+
+   /// Blocks until at least one of sockets has a packet waiting to be read, or timeoutMillis passes.
+   /// Returns true if there is something to read.  A timeout of 0 just checks, and never blocks.
+   static bool waitForIncoming(const Vector<Socket *> &sockets, U32 timeoutMillis);
 };
 
 //inline void read(BitStream &s, IPAddress *val)
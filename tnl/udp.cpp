@@ -108,9 +108,136 @@ typedef in_addr IN_ADDR;
 
 #include "tnlLog.h"
 
+// recvmmsg() and sendmmsg() let us move a whole batch of datagrams with a single system call
+#if defined(TNL_OS_LINUX) && defined(MSG_WAITFORONE)
+#  define TNL_BATCHED_IO
+#endif
+
 namespace TNL {
 
 static NetError getLastError();
+
+#if defined(TNL_BATCHED_IO)
+
+struct SocketBatch
+{
+   // Datagrams read by the last recvmmsg(), handed out one at a time by recvfrom()
+   U8 recvBuffers[Socket::BatchSize][MaxPacketDataSize];
+   SOCKADDR recvAddresses[Socket::BatchSize];
+   iovec recvVecs[Socket::BatchSize];
+   mmsghdr recvMsgs[Socket::BatchSize];
+   S32 recvCount;
+   S32 recvNext;
+
+   // Datagrams queued up by sendto() while batching sends
+   U8 sendBuffers[Socket::BatchSize][MaxPacketDataSize];
+   SOCKADDR sendAddresses[Socket::BatchSize];
+   iovec sendVecs[Socket::BatchSize];
+   mmsghdr sendMsgs[Socket::BatchSize];
+   S32 sendCount;
+
+   SocketBatch()
+   {
+      memset(recvMsgs, 0, sizeof(recvMsgs));
+      memset(sendMsgs, 0, sizeof(sendMsgs));
+
+      for(S32 i = 0; i < Socket::BatchSize; i++)
+      {
+         recvVecs[i].iov_base = recvBuffers[i];
+         recvMsgs[i].msg_hdr.msg_iov = &recvVecs[i];
+         recvMsgs[i].msg_hdr.msg_iovlen = 1;
+         recvMsgs[i].msg_hdr.msg_name = &recvAddresses[i];
+
+         sendVecs[i].iov_base = sendBuffers[i];
+         sendMsgs[i].msg_hdr.msg_iov = &sendVecs[i];
+         sendMsgs[i].msg_hdr.msg_iovlen = 1;
+         sendMsgs[i].msg_hdr.msg_name = &sendAddresses[i];
+      }
+
+      recvCount = 0;
+      recvNext = 0;
+      sendCount = 0;
+   }
+
+   bool hasQueuedRecvs() const
+   {
+      return recvNext < recvCount;
+   }
+
+   // Returns the size of the datagram copied into buffer, or SOCKET_ERROR if there isn't one
+   S32 recvfrom(S32 platformSocket, SOCKADDR *address, U8 *buffer, S32 bufferSize)
+   {
+      if(!hasQueuedRecvs())
+      {
+         for(S32 i = 0; i < Socket::BatchSize; i++)
+         {
+            recvVecs[i].iov_len = MaxPacketDataSize;
+            recvMsgs[i].msg_hdr.msg_namelen = sizeof(SOCKADDR);
+         }
+
+         S32 count = recvmmsg(platformSocket, recvMsgs, Socket::BatchSize, MSG_DONTWAIT, NULL);
+         if(count <= 0)
+            return SOCKET_ERROR;
+
+         recvCount = count;
+         recvNext = 0;
+      }
+
+      S32 index = recvNext++;
+      S32 size = min(S32(recvMsgs[index].msg_len), bufferSize);
+
+      memcpy(buffer, recvBuffers[index], size);
+      *address = recvAddresses[index];
+
+      return size;
+   }
+
+   void queueSend(const SOCKADDR &address, socklen_t addressSize, const U8 *buffer, S32 bufferSize)
+   {
+      memcpy(sendBuffers[sendCount], buffer, bufferSize);
+      sendVecs[sendCount].iov_len = bufferSize;
+      sendAddresses[sendCount] = address;
+      sendMsgs[sendCount].msg_hdr.msg_namelen = addressSize;
+      sendCount++;
+   }
+
+   // Returns the first error, if any, as sendto() would have reported it
+   NetError flushSends(S32 platformSocket)
+   {
+      NetError error = NoError;
+      S32 sent = 0;
+
+      // sendmmsg() fails only if it can't send the first datagram; like any other dropped UDP packet, that one is
+      // lost, and we carry on with the rest as if each had been sent on its own
+      while(sent < sendCount)
+      {
+         S32 count = sendmmsg(platformSocket, sendMsgs + sent, sendCount - sent, 0);
+         if(count <= 0)
+         {
+            if(error == NoError)
+               error = getLastError();
+
+            count = 1;
+         }
+
+         sent += count;
+      }
+
+      sendCount = 0;
+
+      return error;
+   }
+};
+
+#else
+
+struct SocketBatch
+{
+   bool hasQueuedRecvs() const { return false; }
+};
+
+#endif
+
 static S32 initCount = 0;
 
 static bool init()
@@ -222,6 +349,9 @@ Socket::Socket(const Address &bindAddress, U32 sendBufferSize, U32 recvBufferSiz
    init();
    mPlatformSocket = INVALID_SOCKET;
    mTransportProtocol = bindAddress.transport;
+   mBatch = NULL;
+   mBatchedIO = isBatchedIOAvailable();
+   mBatchingSends = false;
 
    const char *socketType;
 
@@ -331,6 +461,9 @@ Socket::~Socket()
 
    TNL_JOURNAL_WRITE_BLOCK(Socket::~Socket, ;)
 
+   flushSendBatch();
+   delete mBatch;
+
    if(mPlatformSocket != INVALID_SOCKET)
       closesocket(mPlatformSocket);
    shutdown();
@@ -352,6 +485,21 @@ NetError Socket::sendto(const Address &address, const U8 *buffer, S32 bufferSize
    socklen_t addressSize;
 
    TNLToSocketAddress(address, &destAddress, &addressSize);
+
+#if defined(TNL_BATCHED_IO)
+   if(mBatchingSends && bufferSize <= S32(MaxPacketDataSize))
+   {
+      NetError error = NoError;
+
+      // Packets already queued go out now; any trouble they have is reported here, since this is the call that sent them
+      if(getBatch()->sendCount == BatchSize)
+         error = mBatch->flushSends(mPlatformSocket);
+
+      mBatch->queueSend(destAddress, addressSize, buffer, bufferSize);
+      return error;
+   }
+#endif
+
    if(::sendto(mPlatformSocket, (const char*)buffer, bufferSize, 0,
          &destAddress, addressSize) == SOCKET_ERROR)
       return getLastError();
@@ -384,7 +532,13 @@ NetError Socket::recvfrom(Address *address, U8 *buffer, S32 bufferSize, S32 *out
    socklen_t addrLen = sizeof(sa);
    S32 bytesRead = SOCKET_ERROR;
 
-   bytesRead = ::recvfrom(mPlatformSocket, (char *) buffer, bufferSize, 0, &sa, &addrLen);
+#if defined(TNL_BATCHED_IO)
+   // Keep handing out anything read ahead, even if batching has since been turned off
+   if((mBatchedIO && mTransportProtocol == IPProtocol) || (mBatch && mBatch->hasQueuedRecvs()))
+      bytesRead = getBatch()->recvfrom(mPlatformSocket, &sa, buffer, bufferSize);
+   else
+#endif
+      bytesRead = ::recvfrom(mPlatformSocket, (char *) buffer, bufferSize, 0, &sa, &addrLen);
    if(bytesRead == SOCKET_ERROR)
    {
       TNL_JOURNAL_WRITE_BLOCK(Socket::recvfrom,
@@ -482,6 +636,74 @@ bool Socket::isWritable(U32 timeoutMillis)
    return FD_ISSET(mPlatformSocket, &fds);
 }
 
+SocketBatch *Socket::getBatch()
+{
+   if(!mBatch)
+      mBatch = new SocketBatch();
+
+   return mBatch;
+}
+
+void Socket::beginSendBatch()
+{
+   mBatchingSends = mBatchedIO && mTransportProtocol == IPProtocol;
+}
+
+NetError Socket::flushSendBatch()
+{
+   NetError error = NoError;
+
+#if defined(TNL_BATCHED_IO)
+   if(mBatch && mBatch->sendCount > 0)
+      error = mBatch->flushSends(mPlatformSocket);
+#endif
+
+   mBatchingSends = false;
+
+   return error;
+}
+
+void Socket::setBatchedIO(bool enabled)
+{
+   flushSendBatch();
+   mBatchedIO = enabled && isBatchedIOAvailable();
+}
+
+bool Socket::isBatchedIOAvailable()
+{
+#if defined(TNL_BATCHED_IO)
+   return true;
+#else
+   return false;
+#endif
+}
+
+bool Socket::waitForIncoming(const Vector<Socket *> &sockets, U32 timeoutMillis)
+{
+   // Datagrams we've already read ahead won't show up in select()
+   for(S32 i = 0; i < sockets.size(); i++)
+      if(sockets[i]->mBatch && sockets[i]->mBatch->hasQueuedRecvs())
+         return true;
+
+   fd_set fds;
+   FD_ZERO(&fds);
+
+   S32 maxSocket = 0;
+   for(S32 i = 0; i < sockets.size(); i++)
+   {
+      FD_SET(sockets[i]->mPlatformSocket, &fds);
+      maxSocket = max(maxSocket, sockets[i]->mPlatformSocket);
+   }
+
+   // Unlike isWritable(), a 0 timeout means don't wait at all
+   timeval timeoutval;
+   timeoutval.tv_sec = timeoutMillis / 1000;
+   timeoutval.tv_usec = (timeoutMillis % 1000) * 1000;
+
+   // select() returns the number of sockets with data waiting, 0 on timeout
+   return ::select(maxSocket + 1, &fds, 0, 0, &timeoutval) > 0;
+}
+
 #if defined ( TNL_OS_WIN32 )
 void Socket::getInterfaceAddresses(Vector<Address> *addressVector)
 {
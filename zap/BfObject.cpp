@@ -25,6 +25,8 @@
 #include "MathUtils.h"           // For sq()
 #include "stringUtils.h"         // For itos()
 
+#include <atomic>
+
 using namespace TNL;
 
 namespace Zap
@@ -412,11 +414,11 @@ bool EditorObject::isInEditor() const
 // BfObject - the declarations are in GameObject.h
 
 
+// Atomic, because levels can be put together on a background thread while a game is being played
 static S32 getNextDefaultId() 
 {
-   static S32 nextId = 0;
-   nextId--;
-   return nextId;
+   static std::atomic<S32> nextId(0);
+   return --nextId;
 }
 
 
@@ -426,8 +428,20 @@ BfObject::BfObject()
    mGame = NULL;
    mObjectTypeNumber = UnknownTypeNumber;
 
-   assignNewSerialNumber();
-   assignNewUserAssignedId();
+   // Objects bots make while thinking in parallel get their ids when they're added to the game, which happens in bot
+   // order, rather than in whatever order the threads get here; see RobotManager::think()
+   mIdPending = LuaWorldLock::getThinker() >= 0;
+
+   if(mIdPending)
+   {
+      mSerialNumber = 0;
+      mUserAssignedId = 0;
+   }
+   else
+   {
+      assignNewSerialNumber();
+      assignNewUserAssignedId();
+   }
 
    mTeam = -1;
    mDisableCollisionCount = 0;
@@ -475,10 +489,9 @@ void BfObject::assignNewUserAssignedId()
 // to which wall, even as walls are being moved around, and wall edits are undone/redone.
 void BfObject::assignNewSerialNumber()
 {
-   static S32 mNextSerialNumber = 0;
+   static std::atomic<S32> mNextSerialNumber(0);
 
-   mNextSerialNumber++;
-   mSerialNumber = mNextSerialNumber;
+   mSerialNumber = ++mNextSerialNumber;
 }
 
 
@@ -622,6 +635,16 @@ void BfObject::addToGame(Game *game, GridDatabase *database)
    TNLAssert(mGame == NULL, "Error: Object already in a game in BfObject::addToGame.");
    TNLAssert(game != NULL,  "Error: Adding to a NULL game in BfObject::addToGame.");
 
+   if(mIdPending)
+   {
+      assignNewSerialNumber();
+
+      if(mUserAssignedId == 0)      // The script may have given it one
+         assignNewUserAssignedId();
+
+      mIdPending = false;
+   }
+
    mGame = game;
    if(database)
       addToDatabase(database);
@@ -1019,7 +1042,7 @@ S32 BfObject::radiusDamage(Point pos, S32 innerRad, S32 outerRad, TestFunc objec
    Rect queryRect(pos, pos);
    queryRect.expand(Point(outerRad, outerRad));
 
-   fillVector.clear();
+   FillVector fillVector;
    findObjects(objectTypeTest, fillVector, queryRect);
 
    // No damage calculated on the client
@@ -1407,24 +1430,24 @@ void BfObject::writeThisTeam(BitStream *stream)
 // Lua interface
 //               Fn name         Param profiles     Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getClassId,     ARRAYDEF({{            END }               }), 1 ) \
-   METHOD(CLASS, getObjType,     ARRAYDEF({{            END }               }), 1 ) \
-   METHOD(CLASS, getId,          ARRAYDEF({{            END }               }), 1 ) \
-   METHOD(CLASS, setId,          ARRAYDEF({{ INT,       END }               }), 1 ) \
-   METHOD(CLASS, getLoc,         ARRAYDEF({{            END }               }), 1 ) \
-   METHOD(CLASS, setLoc,         ARRAYDEF({{ PT,        END }               }), 1 ) \
-   METHOD(CLASS, getPos,         ARRAYDEF({{            END }               }), 1 ) \
-   METHOD(CLASS, setPos,         ARRAYDEF({{ PT,        END }               }), 1 ) \
-   METHOD(CLASS, getTeamIndex,   ARRAYDEF({{            END }               }), 1 ) \
-   METHOD(CLASS, setTeam,        ARRAYDEF({{ TEAM_INDX, END }               }), 1 ) \
-   METHOD(CLASS, removeFromGame, ARRAYDEF({{            END }               }), 1 ) \
-   METHOD(CLASS, setGeom,        ARRAYDEF({{ PT,        END }, { GEOM, END }}), 2 ) \
-   METHOD(CLASS, getGeom,        ARRAYDEF({{            END }               }), 1 ) \
-   METHOD(CLASS, clone,          ARRAYDEF({{            END }               }), 1 ) \
-   METHOD(CLASS, isSelected,     ARRAYDEF({{            END }               }), 1 ) \
-   METHOD(CLASS, setSelected,    ARRAYDEF({{ BOOL,      END }               }), 1 ) \
-   METHOD(CLASS, getOwner,       ARRAYDEF({{            END }               }), 1 ) \
-   METHOD(CLASS, setOwner,       ARRAYDEF({{ STR,       END }               }), 1 ) \
+   METHOD(CLASS, getClassId,     ARRAYDEF({{            END }               }), 1, ReadsWorld   ) \
+   METHOD(CLASS, getObjType,     ARRAYDEF({{            END }               }), 1, ReadsWorld   ) \
+   METHOD(CLASS, getId,          ARRAYDEF({{            END }               }), 1, ReadsWorld   ) \
+   METHOD(CLASS, setId,          ARRAYDEF({{ INT,       END }               }), 1, ChangesWorld ) \
+   METHOD(CLASS, getLoc,         ARRAYDEF({{            END }               }), 1, ReadsWorld   ) \
+   METHOD(CLASS, setLoc,         ARRAYDEF({{ PT,        END }               }), 1, ChangesWorld ) \
+   METHOD(CLASS, getPos,         ARRAYDEF({{            END }               }), 1, ReadsWorld   ) \
+   METHOD(CLASS, setPos,         ARRAYDEF({{ PT,        END }               }), 1, ChangesWorld ) \
+   METHOD(CLASS, getTeamIndex,   ARRAYDEF({{            END }               }), 1, ReadsWorld   ) \
+   METHOD(CLASS, setTeam,        ARRAYDEF({{ TEAM_INDX, END }               }), 1, ChangesWorld ) \
+   METHOD(CLASS, removeFromGame, ARRAYDEF({{            END }               }), 1, ChangesWorld ) \
+   METHOD(CLASS, setGeom,        ARRAYDEF({{ PT,        END }, { GEOM, END }}), 2, ChangesWorld ) \
+   METHOD(CLASS, getGeom,        ARRAYDEF({{            END }               }), 1, ReadsWorld   ) \
+   METHOD(CLASS, clone,          ARRAYDEF({{            END }               }), 1, ChangesWorld ) \
+   METHOD(CLASS, isSelected,     ARRAYDEF({{            END }               }), 1, ReadsWorld   ) \
+   METHOD(CLASS, setSelected,    ARRAYDEF({{ BOOL,      END }               }), 1, ChangesWorld ) \
+   METHOD(CLASS, getOwner,       ARRAYDEF({{            END }               }), 1, ReadsWorld   ) \
+   METHOD(CLASS, setOwner,       ARRAYDEF({{ STR,       END }               }), 1, ChangesWorld ) \
 
 GENERATE_LUA_METHODS_TABLE(BfObject, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(BfObject, LUA_METHODS);
@@ -242,6 +242,7 @@ private:
 
    S32 mSerialNumber;         // Autoincremented serial number  
    S32 mUserAssignedId;       // Id assigned to some objects in the editor
+   bool mIdPending;           // Made by a thinking bot; gets its ids when it's added to the game
    U8 mOriginalTypeNumber;    // Used during final delete to help database remove the item
 
 protected:
@@ -0,0 +1,212 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotController.h"
+
+#include "SBotController.h"
+
+#include "Level.h"
+#include "robot.h"
+#include "ServerGame.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace Zap
+{
+
+// Constructor
+WorldView::WorldView(Robot *bot, U32 deltaT)
+{
+   mBot = bot;
+   mDeltaT = deltaT;
+}
+
+
+Robot *WorldView::getBot() const
+{
+   return mBot;
+}
+
+
+ServerGame *WorldView::getGame() const
+{
+   return static_cast<ServerGame *>(mBot->getGame());
+}
+
+
+GameType *WorldView::getGameType() const
+{
+   return mBot->getGame()->getGameType();
+}
+
+
+U32 WorldView::getDeltaT() const
+{
+   return mDeltaT;
+}
+
+
+void WorldView::findVisibleObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector) const
+{
+   mBot->findVisibleObjects(types, fillVector);
+}
+
+
+void WorldView::findAllObjects(U8 type, Vector<DatabaseObject *> &fillVector) const
+{
+   mBot->getGame()->getLevel()->findObjects(type, fillVector);
+}
+
+
+Ship *WorldView::findClosestEnemy() const
+{
+   return mBot->findClosestEnemy();
+}
+
+
+bool WorldView::canSeePoint(const Point &point) const
+{
+   return mBot->canSeePoint(point);
+}
+
+
+bool WorldView::getWaypoint(const Point &target, Point &waypoint) const
+{
+   return mBot->getWaypoint(target, waypoint);
+}
+
+
+bool WorldView::getFiringSolution(BfObject *target, F32 &angle) const
+{
+   return mBot->getFiringSolution(target, angle);
+}
+
+
+void WorldView::setThrust(Move &move, F32 speed, F32 angle) const
+{
+   move.x = speed * cos(angle);
+   move.y = speed * sin(angle);
+}
+
+
+bool WorldView::fireWeapon(Move &move, WeaponType weapon) const
+{
+   if(!mBot->readyWeapon(weapon))
+      return false;
+
+   move.fire = true;
+   return true;
+}
+
+
+bool WorldView::fireModule(Move &move, ShipModule module) const
+{
+   S32 slot = mBot->findModuleSlot(module);
+
+   if(slot == NONE)
+      return false;
+
+   move.modulePrimary[slot] = true;
+   return true;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+const char *BotController::NativePrefix = "native:";
+
+
+struct ControllerFactory {
+   string name;
+   BotController::Factory factory;
+};
+
+
+// Our built-in bots are always there
+static Vector<ControllerFactory> &getFactories()
+{
+   static Vector<ControllerFactory> factories;
+
+   if(factories.size() == 0)
+   {
+      ControllerFactory sBot = { "s_bot", SBotController::create };
+      factories.push_back(sBot);
+   }
+
+   return factories;
+}
+
+
+bool BotController::isNativeName(const string &scriptName)
+{
+   return scriptName.compare(0, strlen(NativePrefix), NativePrefix) == 0;
+}
+
+
+void BotController::registerFactory(const string &name, Factory factory)
+{
+   Vector<ControllerFactory> &factories = getFactories();
+
+   for(S32 i = 0; i < factories.size(); i++)
+      if(factories[i].name == name)
+      {
+         factories[i].factory = factory;
+         return;
+      }
+
+   ControllerFactory entry = { name, factory };
+   factories.push_back(entry);
+}
+
+
+BotController *BotController::create(const string &scriptName, const Vector<string> &args)
+{
+   if(!isNativeName(scriptName))
+      return NULL;
+
+   string name = scriptName.substr(strlen(NativePrefix));
+   const Vector<ControllerFactory> &factories = getFactories();
+
+   for(S32 i = 0; i < factories.size(); i++)
+      if(factories[i].name == name)
+         return factories[i].factory(args);
+
+   return NULL;
+}
+
+
+// Destructor
+BotController::~BotController()
+{
+   // Do nothing
+}
+
+
+string BotController::getName()
+{
+   return "";
+}
+
+
+void BotController::onShipSpawned(Ship *ship)                                              { }
+void BotController::onShipKilled(Ship *ship, BfObject *damagingObject, BfObject *shooter)   { }
+void BotController::onPlayerJoined(LuaPlayerInfo *player)                                  { }
+void BotController::onPlayerLeft(LuaPlayerInfo *player)                                    { }
+void BotController::onPlayerTeamChanged(LuaPlayerInfo *player)                             { }
+void BotController::onMsgReceived(const char *message, LuaPlayerInfo *sender, bool global) { }
+void BotController::onNexusOpened()                                                        { }
+void BotController::onNexusClosed()                                                        { }
+void BotController::onShipEnteredZone(Ship *ship, Zone *zone)                              { }
+void BotController::onShipLeftZone(Ship *ship, Zone *zone)                                 { }
+void BotController::onObjectEnteredZone(MoveObject *object, Zone *zone)                    { }
+void BotController::onObjectLeftZone(MoveObject *object, Zone *zone)                       { }
+void BotController::onScoreChanged(S32 scoreChange, S32 teamIndex, LuaPlayerInfo *player)  { }
+void BotController::onGameOver()                                                           { }
+void BotController::onCoreDestroyed(CoreItem *core)                                        { }
+
+
+} /* namespace Zap */
@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _BOT_CONTROLLER_H_
+#define _BOT_CONTROLLER_H_
+
+#include "Point.h"
+#include "WeaponInfo.h"       // For WeaponType
+#include "shipItems.h"        // For ShipModule
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+class BfObject;
+class CoreItem;
+class DatabaseObject;
+class GameType;
+class LuaPlayerInfo;
+class Move;
+class MoveObject;
+class Robot;
+class ServerGame;
+class Ship;
+class Zone;
+
+// What a native bot gets to look at when it's time to think.  Mostly the same questions a bot script can ask, answered
+// by the same code; the bot's own ship is there in full.  Only valid during the onTick it's passed to.
+class WorldView
+{
+private:
+   Robot *mBot;
+   U32 mDeltaT;
+
+public:
+   WorldView(Robot *bot, U32 deltaT);     // Constructor
+
+   Robot *getBot() const;                 // Our own ship
+   ServerGame *getGame() const;
+   GameType *getGameType() const;
+   U32 getDeltaT() const;                 // Time since our last tick, in ms
+
+   // Finding stuff
+   void findVisibleObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector) const;
+   void findAllObjects(U8 type, Vector<DatabaseObject *> &fillVector) const;
+   Ship *findClosestEnemy() const;        // Within scanner range; NULL if there isn't one
+
+   // Getting around
+   bool canSeePoint(const Point &point) const;
+   bool getWaypoint(const Point &target, Point &waypoint) const;
+
+   // Fighting; these fill in move, the same way their Lua counterparts fill in the bot's move
+   bool getFiringSolution(BfObject *target, F32 &angle) const;
+   void setThrust(Move &move, F32 speed, F32 angle) const;
+   bool fireWeapon(Move &move, WeaponType weapon) const;      // False if we don't have weapon
+   bool fireModule(Move &move, ShipModule module) const;      // False if we don't have module
+};
+
+
+// A bot written in C++.  A Robot with one of these has no Lua at all: the controller gets a view of the world and the
+// bot's move every time a script would get onTick, and it hears every event a script could subscribe to.
+//
+// Controllers are made by name, from a table of factories; a bot file name of "native:<name>" anywhere a bot script
+// can be given (addbot, level files, DefaultRobotScript) gets that controller instead of a script.  Events and ticks
+// are delivered on the main thread.
+class BotController
+{
+public:
+   typedef BotController *(*Factory)(const Vector<string> &args);
+
+   static const char *NativePrefix;
+
+   static bool isNativeName(const string &scriptName);
+   static void registerFactory(const string &name, Factory factory);    // Replaces any with the same name
+
+   // Makes the controller called for by scriptName, a "native:" name, passing it args; NULL if there isn't one
+   static BotController *create(const string &scriptName, const Vector<string> &args);
+
+   virtual ~BotController();
+
+   virtual string getName();              // Returning "" gets the bot a stock name
+
+   virtual void onTick(const WorldView &view, Move &move) = 0;
+
+   // EventManager's events, with the same arguments as their Lua handlers.  The defaults do nothing.
+   virtual void onShipSpawned(Ship *ship);
+   virtual void onShipKilled(Ship *ship, BfObject *damagingObject, BfObject *shooter);
+   virtual void onPlayerJoined(LuaPlayerInfo *player);
+   virtual void onPlayerLeft(LuaPlayerInfo *player);
+   virtual void onPlayerTeamChanged(LuaPlayerInfo *player);
+   virtual void onMsgReceived(const char *message, LuaPlayerInfo *sender, bool global);
+   virtual void onNexusOpened();
+   virtual void onNexusClosed();
+   virtual void onShipEnteredZone(Ship *ship, Zone *zone);
+   virtual void onShipLeftZone(Ship *ship, Zone *zone);
+   virtual void onObjectEnteredZone(MoveObject *object, Zone *zone);
+   virtual void onObjectLeftZone(MoveObject *object, Zone *zone);
+   virtual void onScoreChanged(S32 scoreChange, S32 teamIndex, LuaPlayerInfo *player);
+   virtual void onGameOver();
+   virtual void onCoreDestroyed(CoreItem *core);
+};
+
+
+} /* namespace Zap */
+#endif
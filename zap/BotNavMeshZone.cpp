@@ -276,13 +276,11 @@ bool BotNavMeshZone::buildBotNavMeshZoneConnectionsRecastStyle(const Vector<BotN
 }
 
 
-static Vector<DatabaseObject *> zones;
-
 // Returns index of zone containing specified point
 static BotNavMeshZone *findZoneTouchingCircle(const GridDatabase *botZoneDatabase, const Point &centerPoint, F32 radius)
 {
    Rect rect(centerPoint, radius);
-   zones.clear();
+   FillVector zones;
    botZoneDatabase->findObjects(BotNavMeshZoneTypeNumber, zones, rect);
 
    const Vector<Point> *poly;
@@ -952,12 +950,12 @@ void BotNavMeshZone::buildBotNavMeshZoneConnections(const Vector<BotNavMeshZone
    NeighboringZone neighbor;
 
    // Figure out which zones are adjacent to which, and find the "gateway" between them
-   for(S32 i = 0; i < zones.size() - 1; i++)
+   for(S32 i = 0; i < allZones.size() - 1; i++)
    {
-      for(S32 j = i + 1; j < zones.size(); j++)
+      for(S32 j = i + 1; j < allZones.size(); j++)
       {
          // Do zones i and j touch?  First a quick and dirty bounds check:
-         if(!zones[i]->getExtent().intersectsOrBorders(zones[j]->getExtent()))
+         if(!allZones[i]->getExtent().intersectsOrBorders(allZones[j]->getExtent()))
             continue;
 
          if(zonesTouch(allZones.get(i)->getOutline(), allZones.get(j)->getOutline(), 1.0, bordStart, bordEnd))
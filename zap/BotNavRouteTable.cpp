@@ -0,0 +1,421 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotNavRouteTable.h"
+
+#include "BotNavMeshZone.h"
+#include "MathUtils.h"
+
+#include "tnlLog.h"
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+
+namespace Zap
+{
+
+// Declare our statics
+const U16 BotNavRouteTable::NoRoute;
+const U32 BotNavRouteTable::MaxTableBytes;
+
+
+// Constructor
+BotNavRouteTable::BuilderThread::BuilderThread(BotNavRouteTable *table)
+{
+   mTable = table;
+}
+
+
+U32 BotNavRouteTable::BuilderThread::run()
+{
+   mTable->buildAllRows();
+   mTable->mBuilderDone.increment();
+
+   return 0;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+BotNavRouteTable::BotNavRouteTable(const Vector<BotNavMeshZone *> &zones, U32 maxBytes)
+{
+   for(S32 i = 0; i < zones.size(); i++)
+      mCenters.push_back(zones[i]->getCenter());
+
+   initialize(maxBytes);
+
+   // Zones are numbered by their place in the list, same as AStar assumes
+   for(S32 i = 0; i < zones.size(); i++)
+   {
+      const Vector<NeighboringZone> &neighbors = zones[i]->getNeighbors();
+
+      for(S32 j = 0; j < neighbors.size(); j++)
+         addLink(i, neighbors[j].zoneID, neighbors[j].borderCenter, neighbors[j].distTo);
+   }
+
+   finishGraph();
+}
+
+
+// Constructor
+BotNavRouteTable::BotNavRouteTable(const Vector<Point> &zoneCenters, U32 maxBytes)
+{
+   mCenters = zoneCenters;
+   initialize(maxBytes);
+}
+
+
+// Destructor
+BotNavRouteTable::~BotNavRouteTable()
+{
+   mStopBuilding = true;
+   waitUntilBuilt();
+
+   for(S32 i = 0; i < mCenters.size(); i++)
+      delete [] mRows[i].load();
+
+   delete [] mRows;
+}
+
+
+void BotNavRouteTable::initialize(U32 maxBytes)
+{
+   S32 zoneCount = mCenters.size();
+
+   mRows = new std::atomic<U16 *>[zoneCount];
+
+   for(S32 i = 0; i < zoneCount; i++)
+      mRows[i] = NULL;
+
+   S32 rowBytes = zoneCount * sizeof(U16);
+   mMaxRows = rowBytes > 0 ? MAX(S32(maxBytes / rowBytes), 1) : 0;
+   mEvicting = mMaxRows < zoneCount;
+
+   if(mEvicting)
+      mLastUsed.resize(zoneCount);
+
+   mQueryCount = 0;
+
+   mBuilder = NULL;
+   mStopBuilding = false;
+   mRowsBuilt = 0;
+}
+
+
+// A link can be one-way, as teleporters are
+void BotNavRouteTable::addLink(U16 fromZone, U16 toZone, const Point &gateway, F32 cost)
+{
+   TNLAssert(fromZone < mCenters.size() && toZone < mCenters.size(), "Link to a zone we don't have!");
+
+   Link link;
+   link.zone = toZone;
+   link.gateway = gateway;
+   link.cost = cost;
+
+   mLinks.push_back(link);
+   mLinkFrom.push_back(fromZone);
+}
+
+
+// Sort the links by the zone they start from, and make a backwards copy sorted by the zone they go to
+void BotNavRouteTable::finishGraph()
+{
+   S32 zoneCount = mCenters.size();
+
+   mFirstLink.resize(zoneCount + 1);
+   mFirstLinkIn.resize(zoneCount + 1);
+
+   for(S32 i = 0; i <= zoneCount; i++)
+   {
+      mFirstLink[i] = 0;
+      mFirstLinkIn[i] = 0;
+   }
+
+   // Count the links in and out of each zone...
+   for(S32 i = 0; i < mLinks.size(); i++)
+   {
+      mFirstLink[mLinkFrom[i] + 1]++;
+      mFirstLinkIn[mLinks[i].zone + 1]++;
+   }
+
+   // ...so we know where each zone's links start...
+   for(S32 i = 0; i < zoneCount; i++)
+   {
+      mFirstLink[i + 1] += mFirstLink[i];
+      mFirstLinkIn[i + 1] += mFirstLinkIn[i];
+   }
+
+   // ...and drop each one in place
+   Vector<S32> nextOut(mFirstLink);
+   Vector<S32> nextIn(mFirstLinkIn);
+
+   Vector<Link> links(mLinks.size());
+   links.resize(mLinks.size());
+   mLinksIn.resize(mLinks.size());
+
+   for(S32 i = 0; i < mLinks.size(); i++)
+   {
+      links[nextOut[mLinkFrom[i]]++] = mLinks[i];
+
+      Link &linkIn = mLinksIn[nextIn[mLinks[i].zone]++];
+      linkIn = mLinks[i];
+      linkIn.zone = mLinkFrom[i];
+   }
+
+   mLinks = links;
+   mLinkFrom.clear();
+}
+
+
+// Searches outward from target along the links into each zone, so that when we reach a zone, we know the quickest way from
+// there to target starts with the zone we reached it from
+void BotNavRouteTable::computeRow(U16 target, U16 *row) const
+{
+   S32 zoneCount = mCenters.size();
+
+   // Local, so rows can be worked out on more than one thread at once
+   Vector<F32> cost(zoneCount);
+   cost.resize(zoneCount);
+
+   for(S32 i = 0; i < zoneCount; i++)
+   {
+      row[i] = NoRoute;
+      cost[i] = F32_MAX;
+   }
+
+   typedef pair<F32, U16> QueueEntry;
+   std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > queue;
+
+   row[target] = target;
+   cost[target] = 0;
+   queue.push(QueueEntry(0, target));
+
+   while(!queue.empty())
+   {
+      QueueEntry entry = queue.top();
+      queue.pop();
+
+      U16 zone = entry.second;
+
+      if(entry.first > cost[zone])     // We've already been here by a quicker way
+         continue;
+
+      for(S32 i = mFirstLinkIn[zone]; i < mFirstLinkIn[zone + 1]; i++)
+      {
+         const Link &link = mLinksIn[i];
+         F32 newCost = entry.first + link.cost;
+
+         if(newCost < cost[link.zone])
+         {
+            cost[link.zone] = newCost;
+            row[link.zone] = zone;
+            queue.push(QueueEntry(newCost, link.zone));
+         }
+      }
+   }
+}
+
+
+// When we're evicting, the caller must hold mMutex
+const U16 *BotNavRouteTable::getRow(U16 target)
+{
+   U16 *row = mRows[target].load();
+
+   if(row)
+   {
+      if(mEvicting)
+         mLastUsed[target] = mQueryCount;
+
+      return row;
+   }
+
+   row = new U16[mCenters.size()];
+   computeRow(target, row);
+
+   if(mEvicting)
+   {
+      // Make room by throwing out whichever row has gone unused the longest
+      if(mCachedTargets.size() >= mMaxRows)
+      {
+         S32 oldest = 0;
+
+         for(S32 i = 1; i < mCachedTargets.size(); i++)
+            if(mQueryCount - mLastUsed[mCachedTargets[i]] > mQueryCount - mLastUsed[mCachedTargets[oldest]])
+               oldest = i;
+
+         delete [] mRows[mCachedTargets[oldest]].load();
+         mRows[mCachedTargets[oldest]] = NULL;
+         mCachedTargets.erase_fast(oldest);
+      }
+
+      mRows[target] = row;
+      mCachedTargets.push_back(target);
+      mLastUsed[target] = mQueryCount;
+
+      return row;
+   }
+
+   // The builder thread, or another bot, might have beaten us to it; if so, use theirs
+   U16 *existing = NULL;
+
+   if(!mRows[target].compare_exchange_strong(existing, row))
+   {
+      delete [] row;
+      return existing;
+   }
+
+   mRowsBuilt++;
+   return row;
+}
+
+
+// Runs on the builder thread
+void BotNavRouteTable::buildAllRows()
+{
+   for(S32 i = 0; i < mCenters.size() && !mStopBuilding; i++)
+      if(!mRows[i].load())
+         getRow(i);
+}
+
+
+void BotNavRouteTable::startBuilding()
+{
+   if(mEvicting || mBuilder || mCenters.size() == 0)
+      return;
+
+   mBuilder = new BuilderThread(this);
+
+   // Not the end of the world; bots will work the rows out as they need them
+   if(!mBuilder->start())
+   {
+      logprintf(LogConsumer::LogWarning, "Could not start thread to build bot routes");
+      delete mBuilder;
+      mBuilder = NULL;
+   }
+}
+
+
+void BotNavRouteTable::waitUntilBuilt()
+{
+   if(!mBuilder)
+      return;
+
+   mBuilderDone.wait();
+
+   delete mBuilder;
+   mBuilder = NULL;
+}
+
+
+bool BotNavRouteTable::isFullyBuilt() const
+{
+   return !mEvicting && mRowsBuilt == mCenters.size();
+}
+
+
+bool BotNavRouteTable::isEvicting() const
+{
+   return mEvicting;
+}
+
+
+S32 BotNavRouteTable::getZoneCount() const
+{
+   return mCenters.size();
+}
+
+
+const BotNavRouteTable::Link *BotNavRouteTable::findLink(U16 fromZone, U16 toZone) const
+{
+   const Link *best = NULL;
+
+   // There may be more than one way across, through a teleporter, say; the search went the cheapest way
+   for(S32 i = mFirstLink[fromZone]; i < mFirstLink[fromZone + 1]; i++)
+      if(mLinks[i].zone == toZone && (!best || mLinks[i].cost < best->cost))
+         best = &mLinks[i];
+
+   return best;
+}
+
+
+U16 BotNavRouteTable::getNextZone(U16 fromZone, U16 toZone)
+{
+   if(mEvicting)
+   {
+      mMutex.lock();
+      mQueryCount++;
+   }
+
+   U16 next = getRow(toZone)[fromZone];
+
+   if(mEvicting)
+      mMutex.unlock();
+
+   return next;
+}
+
+
+F32 BotNavRouteTable::getRouteCost(U16 fromZone, U16 toZone)
+{
+   if(mEvicting)
+   {
+      mMutex.lock();
+      mQueryCount++;
+   }
+
+   const U16 *row = getRow(toZone);
+   F32 cost = row[fromZone] == NoRoute ? -1 : 0;
+
+   if(row[fromZone] != NoRoute)
+      for(U16 zone = fromZone; zone != toZone; zone = row[zone])
+         cost += findLink(zone, row[zone])->cost;
+
+   if(mEvicting)
+      mMutex.unlock();
+
+   return cost;
+}
+
+
+Vector<Point> BotNavRouteTable::findPath(U16 startZone, U16 targetZone, const Point &target)
+{
+   Vector<Point> path;
+
+   if(mEvicting)
+   {
+      mMutex.lock();
+      mQueryCount++;
+   }
+
+   // The whole path comes out of the same row
+   const U16 *row = getRow(targetZone);
+
+   if(row[startZone] != NoRoute)
+   {
+      // Walk from the start to the target, then turn it around so the next place to go is last
+      path.push_back(mCenters[startZone]);
+
+      for(U16 zone = startZone; zone != targetZone; zone = row[zone])
+      {
+         path.push_back(findLink(zone, row[zone])->gateway);
+         path.push_back(mCenters[row[zone]]);
+      }
+
+      path.push_back(target);
+      path.reverse();
+   }
+
+   if(mEvicting)
+      mMutex.unlock();
+
+   return path;
+}
+
+
+} /* namespace Zap */
@@ -0,0 +1,112 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _BOT_NAV_ROUTE_TABLE_H_
+#define _BOT_NAV_ROUTE_TABLE_H_
+
+#include "Point.h"
+
+#include "tnlThread.h"
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <atomic>
+
+using namespace TNL;
+
+namespace Zap
+{
+
+class BotNavMeshZone;
+
+// Answers "which zone do I head for next?" for any pair of bot nav zones, so a bot's flight plan comes from following the
+// answers from its own zone to its target's, with no searching.  The answers for each target zone are worked out all at
+// once, by searching backwards from the target, and kept in a row of one entry per zone.
+//
+// When every row fits in MaxTableBytes, a background thread fills the whole table as soon as the level's zones are built,
+// and rows are never thrown away.  On levels too big for that, rows are worked out when a bot first asks for them, and the
+// least recently used ones make way for new ones once we're at the limit.
+class BotNavRouteTable
+{
+public:
+   static const U16 NoRoute = U16_MAX;
+   static const U32 MaxTableBytes = 16 * 1024 * 1024;
+
+private:
+   struct Link
+   {
+      U16 zone;            // Zone at the other end
+      F32 cost;            // Same as NeighboringZone::distTo, so routes come out the way AStar would find them
+      Point gateway;       // Middle of the border between the zones
+   };
+
+   class BuilderThread : public Thread
+   {
+   private:
+      BotNavRouteTable *mTable;
+
+   public:
+      explicit BuilderThread(BotNavRouteTable *table);
+      U32 run();
+   };
+
+   // The zone graph, copied out of the zones so the builder thread never looks at game objects.  The links out of zone i
+   // are mLinks[mFirstLink[i]] up to mLinks[mFirstLink[i + 1]]; mLinksIn is the same thing backwards, for searching from
+   // the target.
+   Vector<Point> mCenters;
+   Vector<S32> mFirstLink;
+   Vector<Link> mLinks;
+   Vector<S32> mFirstLinkIn;
+   Vector<Link> mLinksIn;
+   Vector<U16> mLinkFrom;              // Used while the graph is being put together
+
+   std::atomic<U16 *> *mRows;          // mRows[target][zone] is the next zone from zone toward target, or NoRoute
+   S32 mMaxRows;                       // How many rows we can keep without going over our memory budget
+   bool mEvicting;                     // True when not every row fits, so rows come and go
+
+   // Only used when mEvicting; queries take turns, so nobody is using a row when it goes
+   Mutex mMutex;
+   Vector<U16> mCachedTargets;         // Targets that have a row
+   Vector<U32> mLastUsed;              // When each target's row was last used, counted in queries
+   U32 mQueryCount;
+
+   BuilderThread *mBuilder;
+   Semaphore mBuilderDone;
+   std::atomic<bool> mStopBuilding;
+   std::atomic<S32> mRowsBuilt;
+
+   void initialize(U32 maxBytes);
+   void computeRow(U16 target, U16 *row) const;
+   const U16 *getRow(U16 target);
+   void buildAllRows();
+
+   const Link *findLink(U16 fromZone, U16 toZone) const;
+
+public:
+   explicit BotNavRouteTable(const Vector<BotNavMeshZone *> &zones, U32 maxBytes = MaxTableBytes);  // Constructor
+   explicit BotNavRouteTable(const Vector<Point> &zoneCenters, U32 maxBytes = MaxTableBytes);       // Constructor
+   virtual ~BotNavRouteTable();                                                                     // Destructor
+
+   // For tables made from zone centers; add the links, then call finishGraph() before using the table
+   void addLink(U16 fromZone, U16 toZone, const Point &gateway, F32 cost);
+   void finishGraph();
+
+   void startBuilding();               // Fills the table on a background thread, if it fits
+   void waitUntilBuilt();
+   bool isFullyBuilt() const;
+   bool isEvicting() const;
+   S32 getZoneCount() const;
+
+   U16 getNextZone(U16 fromZone, U16 toZone);      // NoRoute if there's no way there
+   F32 getRouteCost(U16 fromZone, U16 toZone);     // -1 if there's no way there
+
+   // Same as AStar::findPath(): target first, then the center of its zone, working back through gateways and zone centers
+   // to the center of startZone, so the next place to go is last.  Empty if there's no way there.
+   Vector<Point> findPath(U16 startZone, U16 targetZone, const Point &target);
+};
+
+
+} /* namespace Zap */
+#endif
@@ -0,0 +1,307 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotZoneCache.h"
+
+#include "BotNavMeshZone.h"
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+namespace Zap
+{
+
+// Declare our statics
+const U32 BotZoneCache::Version;
+const string BotZoneCache::CacheDir = "zonecache";     // Lives alongside levelinfo.db
+
+static const U32 Magic = 0x434E4642;         // "BFNC"
+static const U32 ByteOrderMark = 0x01020304;
+static const S32 HashLength = 32;            // MD5, in hex
+
+
+struct CacheHeader
+{
+   U32 magic;
+   U32 version;
+   U32 byteOrderMark;
+   U32 fileSize;
+   U32 zoneCount;
+   U32 vertexCount;
+   U32 neighborCount;
+   U32 reserved;
+   char levelHash[HashLength];
+};
+
+
+struct CacheZone
+{
+   U32 firstVertex;
+   U32 vertexCount;
+   U32 firstNeighbor;
+   U32 neighborCount;
+};
+
+
+struct CacheVertex
+{
+   F32 x, y;
+};
+
+
+struct CacheNeighbor
+{
+   U32 zoneId;
+   CacheVertex borderStart;
+   CacheVertex borderEnd;
+   CacheVertex borderCenter;
+   CacheVertex center;
+   F32 distTo;
+};
+
+
+// Every record is a multiple of 4 bytes, so each array stays aligned, whatever comes before it
+static_assert(sizeof(CacheHeader) == 64 && sizeof(CacheZone) == 16 && sizeof(CacheVertex) == 8 && sizeof(CacheNeighbor) == 40,
+              "Zone cache records must not change size");
+
+
+static CacheVertex toCacheVertex(const Point &point)
+{
+   CacheVertex vertex;
+   vertex.x = point.x;
+   vertex.y = point.y;
+
+   return vertex;
+}
+
+
+static Point toPoint(const CacheVertex &vertex)
+{
+   return Point(vertex.x, vertex.y);
+}
+
+
+string BotZoneCache::getCacheFileName(const string &dir, const string &levelHash)
+{
+   return joindir(dir, levelHash + ".bfzones");
+}
+
+
+bool BotZoneCache::save(const string &filename, const string &levelHash, const Vector<BotNavMeshZone *> &allZones)
+{
+   if(levelHash.length() != HashLength)
+      return false;
+
+   Vector<CacheZone> zones;
+   Vector<CacheVertex> vertices;
+   Vector<CacheNeighbor> neighbors;
+
+   for(S32 i = 0; i < allZones.size(); i++)
+   {
+      TNLAssert(i == allZones[i]->getZoneId(), "These should be the same!");
+
+      const Vector<Point> &outline = *allZones[i]->getOutline();
+      const Vector<NeighboringZone> &zoneNeighbors = allZones[i]->getNeighbors();
+
+      CacheZone zone;
+      zone.firstVertex = vertices.size();
+      zone.vertexCount = outline.size();
+      zone.firstNeighbor = neighbors.size();
+      zone.neighborCount = zoneNeighbors.size();
+      zones.push_back(zone);
+
+      for(S32 j = 0; j < outline.size(); j++)
+         vertices.push_back(toCacheVertex(outline[j]));
+
+      for(S32 j = 0; j < zoneNeighbors.size(); j++)
+      {
+         CacheNeighbor neighbor;
+         neighbor.zoneId       = zoneNeighbors[j].zoneID;
+         neighbor.borderStart  = toCacheVertex(zoneNeighbors[j].borderStart);
+         neighbor.borderEnd    = toCacheVertex(zoneNeighbors[j].borderEnd);
+         neighbor.borderCenter = toCacheVertex(zoneNeighbors[j].borderCenter);
+         neighbor.center       = toCacheVertex(zoneNeighbors[j].center);
+         neighbor.distTo       = zoneNeighbors[j].distTo;
+         neighbors.push_back(neighbor);
+      }
+   }
+
+   CacheHeader header;
+   memset(&header, 0, sizeof(header));
+
+   header.magic         = Magic;
+   header.version       = Version;
+   header.byteOrderMark = ByteOrderMark;
+   header.zoneCount     = zones.size();
+   header.vertexCount   = vertices.size();
+   header.neighborCount = neighbors.size();
+   header.fileSize      = sizeof(CacheHeader) + zones.size()     * sizeof(CacheZone) +
+                                                vertices.size()  * sizeof(CacheVertex) +
+                                                neighbors.size() * sizeof(CacheNeighbor);
+   memcpy(header.levelHash, levelHash.c_str(), HashLength);
+
+   // Write to a temp file, then move it into place, so another server starting the same level never sees half a file
+   string tempFilename = filename + ".tmp";
+   FILE *file = fopen(tempFilename.c_str(), "wb");
+
+   if(!file)
+      return false;
+
+   bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+   if(ok && zones.size() > 0)
+      ok = fwrite(zones.address(), sizeof(CacheZone), zones.size(), file) == U32(zones.size());
+   if(ok && vertices.size() > 0)
+      ok = fwrite(vertices.address(), sizeof(CacheVertex), vertices.size(), file) == U32(vertices.size());
+   if(ok && neighbors.size() > 0)
+      ok = fwrite(neighbors.address(), sizeof(CacheNeighbor), neighbors.size(), file) == U32(neighbors.size());
+
+   ok = fclose(file) == 0 && ok;
+
+   // rename won't replace an existing file everywhere
+   if(ok)
+   {
+      remove(filename.c_str());
+      ok = rename(tempFilename.c_str(), filename.c_str()) == 0;
+   }
+
+   if(!ok)
+   {
+      logprintf(LogConsumer::LogWarning, "Could not write bot zone cache %s", filename.c_str());
+      remove(tempFilename.c_str());
+   }
+
+   return ok;
+}
+
+
+// Everything in the file has to add up before we'll use any of it
+static bool isValid(const Vector<U8> &data, const string &levelHash)
+{
+   if(data.size() < (S32)sizeof(CacheHeader))
+      return false;
+
+   const CacheHeader &header = *(const CacheHeader *)data.address();
+
+   if(header.magic != Magic || header.version != BotZoneCache::Version || header.byteOrderMark != ByteOrderMark ||
+         header.fileSize != U32(data.size()) || memcmp(header.levelHash, levelHash.c_str(), HashLength) != 0)
+      return false;
+
+   // Added up in 64 bits, so a damaged header can't wrap around to the right answer
+   if(U64(header.zoneCount)   * sizeof(CacheZone) + U64(header.vertexCount) * sizeof(CacheVertex) +
+      U64(header.neighborCount) * sizeof(CacheNeighbor) + sizeof(CacheHeader) != header.fileSize)
+      return false;
+
+   if(header.zoneCount == 0 || header.zoneCount > U16_MAX)
+      return false;
+
+   const CacheZone *zones = (const CacheZone *)(data.address() + sizeof(CacheHeader));
+   const CacheNeighbor *neighbors = (const CacheNeighbor *)
+         (data.address() + sizeof(CacheHeader) + header.zoneCount * sizeof(CacheZone) + header.vertexCount * sizeof(CacheVertex));
+
+   for(U32 i = 0; i < header.zoneCount; i++)
+   {
+      if(zones[i].vertexCount < 3 || zones[i].firstVertex > header.vertexCount ||
+            zones[i].vertexCount > header.vertexCount - zones[i].firstVertex)
+         return false;
+
+      if(zones[i].firstNeighbor > header.neighborCount || zones[i].neighborCount > header.neighborCount - zones[i].firstNeighbor)
+         return false;
+   }
+
+   for(U32 i = 0; i < header.neighborCount; i++)
+      if(neighbors[i].zoneId >= header.zoneCount)
+         return false;
+
+   return true;
+}
+
+
+bool BotZoneCache::load(const string &filename, const string &levelHash, GridDatabase &botZoneDatabase,
+                        Vector<BotNavMeshZone *> &allZones, bool triangulateZones)
+{
+   allZones.deleteAndClear();
+
+   if(levelHash.length() != HashLength)
+      return false;
+
+   FILE *file = fopen(filename.c_str(), "rb");
+
+   if(!file)
+      return false;
+
+   Vector<U8> data;
+
+   fseek(file, 0, SEEK_END);
+   long size = ftell(file);
+   fseek(file, 0, SEEK_SET);
+
+   if(size > 0)
+   {
+      data.resize(size);
+
+      if(fread(data.address(), 1, size, file) != size_t(size))
+         data.clear();
+   }
+
+   fclose(file);
+
+   if(!isValid(data, levelHash))
+   {
+      logprintf(LogConsumer::LogWarning, "Ignoring out of date or damaged bot zone cache %s", filename.c_str());
+      return false;
+   }
+
+   const CacheHeader &header = *(const CacheHeader *)data.address();
+
+   const U8 *pos = data.address() + sizeof(CacheHeader);
+   const CacheZone *zones = (const CacheZone *)pos;
+   pos += header.zoneCount * sizeof(CacheZone);
+   const CacheVertex *vertices = (const CacheVertex *)pos;
+   pos += header.vertexCount * sizeof(CacheVertex);
+   const CacheNeighbor *neighbors = (const CacheNeighbor *)pos;
+
+   allZones.resize(header.zoneCount);
+
+   for(U32 i = 0; i < header.zoneCount; i++)
+   {
+      BotNavMeshZone *zone = new BotNavMeshZone(i);     // Will be cleaned up when allZones is cleared
+
+      // See buildBotMeshZones() for why
+      if(!triangulateZones)
+         zone->disableTriangulation();
+
+      for(U32 j = 0; j < zones[i].vertexCount; j++)
+         zone->addVert(toPoint(vertices[zones[i].firstVertex + j]), true);
+
+      zone->addToZoneDatabase(&botZoneDatabase);
+      allZones[i] = zone;
+   }
+
+   for(U32 i = 0; i < header.zoneCount; i++)
+      for(U32 j = 0; j < zones[i].neighborCount; j++)
+      {
+         const CacheNeighbor &cached = neighbors[zones[i].firstNeighbor + j];
+
+         NeighboringZone neighbor;
+         neighbor.zoneID       = U16(cached.zoneId);
+         neighbor.borderStart  = toPoint(cached.borderStart);
+         neighbor.borderEnd    = toPoint(cached.borderEnd);
+         neighbor.borderCenter = toPoint(cached.borderCenter);
+         neighbor.center       = toPoint(cached.center);
+         neighbor.distTo       = cached.distTo;
+
+         allZones[i]->addNeighbor(neighbor);
+      }
+
+   return true;
+}
+
+
+} /* namespace Zap */
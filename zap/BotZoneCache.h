@@ -0,0 +1,47 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _BOT_ZONE_CACHE_H_
+#define _BOT_ZONE_CACHE_H_
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+class BotNavMeshZone;
+class GridDatabase;
+
+// Keeps the bot zones we build for a level in a file named for the level's hash, so the next time the level is played, we
+// can skip building them.  The file is a header followed by three arrays of fixed size records -- zones, their vertices,
+// and their neighbors -- laid out just as they are in memory, so loading is a single read with nothing to parse.  Neighbors
+// are stored exactly as built, teleporter links included.
+//
+// Records are in the byte order of the machine that wrote them; a file from a machine that does things the other way
+// around just looks stale, and gets rebuilt.  Bump Version whenever the layout, or the way zones are built, changes.
+class BotZoneCache
+{
+public:
+   static const U32 Version = 1;
+   static const string CacheDir;
+
+   static string getCacheFileName(const string &dir, const string &levelHash);
+
+   static bool save(const string &filename, const string &levelHash, const Vector<BotNavMeshZone *> &allZones);
+
+   // Returns false if there's no usable cache, in which case allZones and botZoneDatabase are left empty
+   static bool load(const string &filename, const string &levelHash, GridDatabase &botZoneDatabase,
+                    Vector<BotNavMeshZone *> &allZones, bool triangulateZones);
+};
+
+
+} /* namespace Zap */
+#endif
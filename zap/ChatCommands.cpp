@@ -595,6 +595,39 @@ void clearCacheHandler(ClientGame *game, const Vector<string> &words)
 }
 
 
+// The server does all the work for these three; see GameType::processServerCommand()
+static void passToServer(ClientGame *game, const Vector<string> &words)
+{
+   Vector<StringPtr> args;
+
+   for(S32 i = 1; i < words.size(); i++)
+      args.push_back(StringPtr(words[i]));
+
+   game->sendCommand(StringTableEntry(words[0], false), args);
+}
+
+
+void scriptStatsHandler(ClientGame *game, const Vector<string> &words)
+{
+   if(game->hasAdmin("!!! Need admin permissions to see script stats"))
+      passToServer(game, words);
+}
+
+
+void eventStatsHandler(ClientGame *game, const Vector<string> &words)
+{
+   if(game->hasAdmin("!!! Need admin permissions to see event stats"))
+      passToServer(game, words);
+}
+
+
+void luaProfileHandler(ClientGame *game, const Vector<string> &words)
+{
+   if(game->hasAdmin("!!! Need admin permissions to profile scripts"))
+      passToServer(game, words);
+}
+
+
 void pmHandler(ClientGame *game, const Vector<string> &words)
 {
    if(words.size() < 3)
@@ -136,6 +136,9 @@ void rateMapHandler            (ClientGame *game, const Vector<string> &args);
 void pauseHandler              (ClientGame *game, const Vector<string> &args);
 void lockTeams                 (ClientGame *game, const Vector<string> &args);
 void unlockTeams               (ClientGame *game, const Vector<string> &args);
+void scriptStatsHandler        (ClientGame *game, const Vector<string> &args);
+void eventStatsHandler         (ClientGame *game, const Vector<string> &args);
+void luaProfileHandler         (ClientGame *game, const Vector<string> &args);
 
 
 // The following are only available in debug builds!
@@ -96,6 +96,9 @@ namespace Zap
    { "setservername",      &ChatCommands::setServerNameHandler,       { STR },        1, ADMIN_COMMANDS_2, 0,  1,  {"<name>"},              "Set server name" },
    { "setserverdescr",     &ChatCommands::setServerDescrHandler,      { STR },        1, ADMIN_COMMANDS_2, 0,  1,  {"<descr>"},             "Set server description" },
    { "setserverwelcome",   &ChatCommands::setServerWelcomeMsgHandler, { STR },        1, ADMIN_COMMANDS_2, 0,  1,  {"<message>"},           "Set server welcome message (use blank to disable)" },
+   { "scriptstats",        &ChatCommands::scriptStatsHandler,         { },            0, ADMIN_COMMANDS_2, 1,  1,  { "" },                  "Show CPU used by bots and levelgens, busiest first" },
+   { "eventstats",         &ChatCommands::eventStatsHandler,          { STR },        1, ADMIN_COMMANDS_2, 1,  1,  {"[reset]"},             "Show how often each script event has fired, or start over" },
+   { "luaprofile",         &ChatCommands::luaProfileHandler,          { STR, STR },   2, ADMIN_COMMANDS_2, 1,  1,  {"<start | stop>","[name]"}, "Profile scripts whose name contains [name]; stop saves to log folder" },
 
    { "setownerpass", &ChatCommands::setOwnerPassHandler,       { STR },        1, OWNER_COMMANDS,  0,  1,  {"[passwd]"},            "Set owner password" },
    { "setadminpass", &ChatCommands::setAdminPassHandler,       { STR },        1, OWNER_COMMANDS,  0,  1,  {"[passwd]"},            "Set admin password" },
@@ -837,7 +837,7 @@ void ClientGame::idle(U32 timeDelta)
          {
             static const S32 HelpSearchRadius = 200;
             Rect searchRect = Rect(localPlayerShip->getPos(), HelpSearchRadius);
-            fillVector.clear();
+            FillVector fillVector;
             mLevel->findObjects((TestFunc)hasRelatedHelpItem, fillVector, searchRect);
 
             if(mUIManager->isShowingInGameHelp())
@@ -70,6 +70,10 @@
    SETTINGS_ITEM(string,             LevelDir,                 "Host",           "LevelDir",                 "",                              NULL,     NULL,     "Specify where level files are stored; can be overridden on command line with -leveldir param.")                                \
    SETTINGS_ITEM(U32,                MaxPlayers,               "Host",           "MaxPlayers",               127,                             NULL,     NULL,     "The max number of players that can play on your server.")                                                                      \
    SETTINGS_ITEM(S32,                MaxBots,                  "Host",           "MaxBots",                  10,                              NULL,     NULL,     "The max number of bots allowed on this server.")                                                                               \
+   SETTINGS_ITEM(U32,                BotThinkThreads,          "Host",           "BotThinkThreads",          0,                               NULL,     NULL,     "Threads for bots to think on, each bot with a Lua state of its own; 0 keeps bots in one shared state, thinking in turn")       \
+   SETTINGS_ITEM(U32,                ScriptCallTimeLimit,      "Host",           "ScriptCallTimeLimit",      1000,                            NULL,     NULL,     "Milliseconds a single call into a bot or levelgen may run before the script is killed; 0 for no limit")                        \
+   SETTINGS_ITEM(U32,                ScriptTickBudget,         "Host",           "ScriptTickBudget",         5,                               NULL,     NULL,     "Milliseconds per tick a bot or levelgen may use, on average; scripts using more skip ticks to make up for it; 0 for no limit") \
+   SETTINGS_ITEM(YesNo,              DeferScriptEvents,        "Host",           "DeferScriptEvents",        No,                              NULL,     NULL,     "Hold zone, spawn and kill events back until the end of each tick, then hand them to bots and levelgens all at once")           \
    SETTINGS_ITEM(YesNo,              AddRobots,                "Host",           "AddRobots",                No,                              NULL,     NULL,     "Add robot players to this server.")                                                                                            \
    SETTINGS_ITEM(S32,                MinBalancedPlayers,       "Host",           "MinBalancedPlayers",       6,                               NULL,     NULL,     "The minimum number of players ensured in each map.  Bots will be added up to this number.")                                    \
    SETTINGS_ITEM(YesNo,              EnableServerVoiceChat,    "Host",           "EnableServerVoiceChat",    Yes,                             NULL,     NULL,     "If false, prevents any voice chat in a server.")                                                                               \
@@ -89,8 +93,16 @@
    SETTINGS_ITEM(string,             GlobalLevelScript,        "Host",           "GlobalLevelScript",        "",                              NULL,     NULL,     "Specify a levelgen that will get run on every level")                                                                          \
    SETTINGS_ITEM(YesNo,              GameRecording,            "Host",           "GameRecording",            No,                              NULL,     NULL,     "If Yes, games will be recorded; if No, they will not.  This is typically set via the menu.")                                   \
    SETTINGS_ITEM(YesNo,              GameRecordingDownload,    "Host",           "GameRecordingDownload",    No,                              NULL,     NULL,     "If Yes, other players can download")                                                                                           \
+   SETTINGS_ITEM(U32,                RecordingBufferSize,      "Host",           "RecordingBufferSize",      128,                             NULL,     NULL,     "Size, in KB, of the buffer holding recorded games until they are written to disk")                                             \
+   SETTINGS_ITEM(YesNo,              RecordingBufferGrow,      "Host",           "RecordingBufferGrow",      Yes,                             NULL,     NULL,     "If Yes, hold on to recorded data in memory when the disk falls behind; if No, stop recording instead")                         \
+   SETTINGS_ITEM(U32,                RecordingCompression,     "Host",           "RecordingCompression",     6,                               NULL,     NULL,     "Deflate compression level for recorded games, from 1 (fastest) to 9 (smallest); 0 writes them uncompressed")                   \
    SETTINGS_ITEM(U32,                MaxFpsServer,             "Host",           "MaxFPS",                   100,                             NULL,     NULL,     "Maximum FPS the dedicated server will run at.  Higher values use more CPU (and power), lower may increase lag.\n"              \
                                                                                                                                                                   "Specify 0 for no limit. Negative values will not make Bitfighter run backwards.  Sorry.  (default = 100)")                     \
+   SETTINGS_ITEM(string,             Arenas,                   "Host",           "Arenas",                   "",                              NULL,     NULL,     "Dedicated servers only: comma-separated names of extra arenas to host in this process.  Configure each in an\n"                \
+                                                                                                                                                                  "[Arena:<name>] section, which can override any [Host] key (ServerAddress is a must), plus Playlist.")                          \
+   SETTINGS_ITEM(YesNo,              AdaptiveSpatialIndex,     "Host",           "AdaptiveSpatialIndex",     Yes,                             NULL,     NULL,     "Size the object search grid to fit each level as it is loaded; speeds up very large levels (Yes/No)")                          \
+   SETTINGS_ITEM(YesNo,              EventDrivenLoop,          "Host",           "EventDrivenLoop",          No,                              NULL,     NULL,     "Dedicated servers only: sleep until a packet arrives or the next tick is due instead of polling, and tick at a steady MaxFPS") \
+   SETTINGS_ITEM(U32,                TickStatsInterval,        "Host",           "TickStatsInterval",        0,                               NULL,     NULL,     "Dedicated servers only: log main loop tick timing every this many seconds (0 = never)")                                        \
    MYSQL_SETTINGS_TABLE_ENTRY                                                                                                                                                                                                                                                                     \
                                                                                                                                                                                                                                                                                                   \
    SETTINGS_ITEM(YesNo,              VotingEnabled,            "Host-Voting",    "VoteEnable",               No,                              NULL,     NULL,     "Enable voting on this server")                                                                                                 \
@@ -246,16 +246,16 @@ REGISTER_LUA_CLASS(EditorPlugin);
 
 //               Fn name    Param profiles         Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getGridSize,        ARRAYDEF({{ END          }                    }), 1 ) \
-   METHOD(CLASS, getSelectedObjects, ARRAYDEF({{ END          }                    }), 1 ) \
-   METHOD(CLASS, getAllObjects,      ARRAYDEF({{ END          }                    }), 1 ) \
-   METHOD(CLASS, showMessage,        ARRAYDEF({{ STR,     END }, { STR, BOOL, END }}), 2 ) \
-   METHOD(CLASS, setDisplayCenter,   ARRAYDEF({{ PT,      END }                    }), 1 ) \
-   METHOD(CLASS, setDisplayExtents,  ARRAYDEF({{ PT, PT,  END }                    }), 1 ) \
-   METHOD(CLASS, setDisplayZoom,     ARRAYDEF({{ NUM_GE0, END }                    }), 1 ) \
-   METHOD(CLASS, getDisplayCenter,   ARRAYDEF({{ END          }                    }), 1 ) \
-   METHOD(CLASS, getDisplayExtents,  ARRAYDEF({{ END          }                    }), 1 ) \
-   METHOD(CLASS, getDisplayZoom,     ARRAYDEF({{ END          }                    }), 1 ) \
+   METHOD(CLASS, getGridSize,        ARRAYDEF({{ END          }                    }), 1, ReadsWorld   ) \
+   METHOD(CLASS, getSelectedObjects, ARRAYDEF({{ END          }                    }), 1, ReadsWorld   ) \
+   METHOD(CLASS, getAllObjects,      ARRAYDEF({{ END          }                    }), 1, ReadsWorld   ) \
+   METHOD(CLASS, showMessage,        ARRAYDEF({{ STR,     END }, { STR, BOOL, END }}), 2, ChangesWorld ) \
+   METHOD(CLASS, setDisplayCenter,   ARRAYDEF({{ PT,      END }                    }), 1, ChangesWorld ) \
+   METHOD(CLASS, setDisplayExtents,  ARRAYDEF({{ PT, PT,  END }                    }), 1, ChangesWorld ) \
+   METHOD(CLASS, setDisplayZoom,     ARRAYDEF({{ NUM_GE0, END }                    }), 1, ChangesWorld ) \
+   METHOD(CLASS, getDisplayCenter,   ARRAYDEF({{ END          }                    }), 1, ReadsWorld   ) \
+   METHOD(CLASS, getDisplayExtents,  ARRAYDEF({{ END          }                    }), 1, ReadsWorld   ) \
+   METHOD(CLASS, getDisplayZoom,     ARRAYDEF({{ END          }                    }), 1, ReadsWorld   ) \
 
 GENERATE_LUA_METHODS_TABLE(EditorPlugin, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(EditorPlugin, LUA_METHODS);
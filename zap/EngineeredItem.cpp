@@ -206,7 +206,7 @@ bool EngineerModuleDeployer::canCreateObjectAtLocation(const Level *level, const
 
    Vector<Point> candidateForceFieldGeom = ForceField::computeGeom(forceFieldStart, forceFieldEnd);
 
-   fillVector.clear();
+   FillVector fillVector;
    level->findObjects(ForceFieldProjectorTypeNumber, fillVector, queryRect);
 
    for(S32 i = 0; i < fillVector.size(); i++)
@@ -1153,15 +1153,15 @@ void EngineeredItem::doneEditingAttrs(EditorAttributeMenuUI *attributeMenu)
  */
 //               Fn name              Param profiles  Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, isActive,             ARRAYDEF({{       END }}), 1 ) \
-   METHOD(CLASS, getMountAngle,        ARRAYDEF({{       END }}), 1 ) \
-   METHOD(CLASS, getHealth,            ARRAYDEF({{       END }}), 1 ) \
-   METHOD(CLASS, setHealth,            ARRAYDEF({{ NUM,  END }}), 1 ) \
-   METHOD(CLASS, getDisabledThreshold, ARRAYDEF({{       END }}), 1 ) \
-   METHOD(CLASS, getHealRate,          ARRAYDEF({{       END }}), 1 ) \
-   METHOD(CLASS, setHealRate,          ARRAYDEF({{ INT,  END }}), 1 ) \
-   METHOD(CLASS, getEngineered,        ARRAYDEF({{       END }}), 1 ) \
-   METHOD(CLASS, setEngineered,        ARRAYDEF({{ BOOL, END }}), 1 ) \
+   METHOD(CLASS, isActive,             ARRAYDEF({{       END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getMountAngle,        ARRAYDEF({{       END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getHealth,            ARRAYDEF({{       END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setHealth,            ARRAYDEF({{ NUM,  END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, getDisabledThreshold, ARRAYDEF({{       END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getHealRate,          ARRAYDEF({{       END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setHealRate,          ARRAYDEF({{ INT,  END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, getEngineered,        ARRAYDEF({{       END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setEngineered,        ARRAYDEF({{ BOOL, END }}), 1, ChangesWorld ) \
 
 GENERATE_LUA_METHODS_TABLE(EngineeredItem, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(EngineeredItem, LUA_METHODS);
@@ -2190,7 +2190,7 @@ void Turret::idle(IdleCallPath path)
    queryRect.unionPoint(aimPos + cross * TurretPerceptionDistance);
    queryRect.unionPoint(aimPos - cross * TurretPerceptionDistance);
    queryRect.unionPoint(aimPos + mAnchorNormal * TurretPerceptionDistance);
-   fillVector.clear();
+   FillVector fillVector;
    findObjects((TestFunc)isTurretTargetType, fillVector, queryRect);    // Get all potential targets
 
    BfObject *bestTarget = NULL;
@@ -2339,9 +2339,9 @@ void Turret::onGeomChanged()
  */
 //               Fn name     Param profiles  Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getAimAngle,  ARRAYDEF({{      END }}), 1 ) \
-   METHOD(CLASS, setAimAngle,  ARRAYDEF({{ NUM, END }}), 1 ) \
-   METHOD(CLASS, setWeapon,    ARRAYDEF({{ WEAP_ENUM, END }}), 1 ) \
+   METHOD(CLASS, getAimAngle,  ARRAYDEF({{      END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setAimAngle,  ARRAYDEF({{ NUM, END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, setWeapon,    ARRAYDEF({{ WEAP_ENUM, END }}), 1, ChangesWorld ) \
 
 
 GENERATE_LUA_METHODS_TABLE(Turret, LUA_METHODS);
@@ -2664,7 +2664,7 @@ void Mortar::idle(IdleCallPath path)
    Point cross(mAnchorNormal.y, -mAnchorNormal.x);
 
    Rect queryRect(mZone);
-   fillVector.clear();
+   FillVector fillVector;
    findObjects((TestFunc)isTurretTargetType, fillVector, queryRect);    // Get all potential targets
 
    BfObject *bestTarget = NULL;
@@ -2819,7 +2819,7 @@ void Mortar::onGeomChanged()
  */
 //               Fn name     Param profiles  Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, setWeapon,    ARRAYDEF({{ WEAP_ENUM, END }}), 1 ) \
+   METHOD(CLASS, setWeapon,    ARRAYDEF({{ WEAP_ENUM, END }}), 1, ChangesWorld ) \
 
 
 GENERATE_LUA_METHODS_TABLE(Mortar, LUA_METHODS);
@@ -5,18 +5,23 @@
 
 #include "EventManager.h"
 
+#include "BotController.h"
 #include "CoreGame.h"
 #include "playerInfo.h"          // For RobotPlayerInfo constructor
 #include "robot.h"
 #include "Zone.h"
 
+#include "stringUtils.h"
+
 //#include "../lua/luaprofiler-2.0.2/src/luaprofiler.h"      // For... the profiler!
 
 #ifndef ZAP_DEDICATED
 #  include "UI.h"
 #endif
 
+#include <algorithm>
 #include <math.h>
+#include <map>
 
 
 #define hypot _hypot    // Kill some warnings
@@ -36,6 +41,44 @@ bool EventManager::anyPending = false;
 static Vector<Subscription>      subscriptions         [EventManager::EventTypes];
 static Vector<Subscription>      pendingSubscriptions  [EventManager::EventTypes];
 static Vector<LuaScriptRunner *> pendingUnsubscriptions[EventManager::EventTypes];
+static Vector<Robot *>           nativeListeners;
+
+
+// An event held back in deferred mode, with whatever objects its handler gets passed (see pushEventArgs()).  These are
+// safe pointers, as things can be destroyed before the end of the tick; an event whose main object is gone is dropped.
+struct QueuedEvent {
+   EventManager::EventType eventType;     // EventManager::EventTypes once coalesced away
+   const Game *game;                      // Whose scripts hear it; the active game when it was fired
+   SafePtr<BfObject> args[3];
+};
+
+typedef pair<const BfObject *, const BfObject *> ZoneEventKey;    // Object, zone
+
+static Vector<QueuedEvent> queuedEvents;
+static map<ZoneEventKey, S32> lastZoneEvent[2];    // Index in queuedEvents of the latest entry or exit; [0] ships, [1] objects
+
+// Who's getting the batch being delivered; entries are NULLed if they go away mid-batch
+static Vector<LuaScriptRunner *> batchSubscribers;
+static Vector<Robot *>           batchNativeListeners;
+
+// An event fired while bots were thinking in parallel, with whatever its fireEvent() took.  Nothing is deleted while
+// bots think -- anything that would do it waits until they're done, as do these -- so plain pointers are fine here.
+struct HeldEvent {
+   EventManager::EventType eventType;
+   S32 thinker;                           // Index of the bot whose thinking fired it, see LuaWorldLock::getThinker()
+   BfObject *args[3];
+   LuaScriptRunner *sender;               // MsgReceived, and the player events
+   string message;
+   LuaPlayerInfo *playerInfo;
+   bool global;
+   S32 score;
+   S32 teamIndex;
+   U32 deltaT;
+};
+
+static Vector<HeldEvent> heldEvents;
+
+static const S32 MaxFlushPasses = 4;    // Handlers can fire events of their own; how many rounds of those we'll deliver
 
 bool EventManager::mConstructed = false;  // Prevent duplicate instantiation
 
@@ -62,9 +105,14 @@ EventManager::EventManager()
 {
    TNLAssert(!mConstructed, "There is only one EventManager to rule them all!");
 
+   mActiveGame = NULL;
    mIsPaused = false;
    mStepCount = -1;
+   mDeferred = false;
+   mFlushing = false;
    mConstructed = true;
+
+   resetEventCounts();
 }
 
 
@@ -86,6 +134,11 @@ void EventManager::shutdown()
 {
    if(eventManager)
    {
+      queuedEvents.clear();
+      heldEvents.clear();
+      lastZoneEvent[0].clear();
+      lastZoneEvent[1].clear();
+
       delete eventManager;
       eventManager = NULL;
    }
@@ -108,7 +161,7 @@ void EventManager::subscribe(LuaScriptRunner *subscriber, EventType eventType, S
    if(isSubscribed(subscriber, eventType) || isPendingSubscribed(subscriber, eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
+   lua_State *L = subscriber->getLuaState();
 
    // Make sure the script has the proper event listener
    bool ok = LuaScriptRunner::loadFunction(L, subscriber->getScriptId(), eventDefs[eventType].function);     // -- function
@@ -187,6 +240,10 @@ void EventManager::unsubscribeImmediate(LuaScriptRunner *subscriber, EventType e
    removeFromSubscribedList        (subscriber, eventType);
    removeFromPendingSubscribeList  (subscriber, eventType);
    removeFromPendingUnsubscribeList(subscriber, eventType);    // Probably not really necessary...
+
+   S32 index = batchSubscribers.getIndex(subscriber);
+   if(index != -1)
+      batchSubscribers[index] = NULL;
 }
 
 
@@ -245,38 +302,91 @@ void EventManager::update()
 }
 
 
-// onNexusOpened, onNexusClosed
+void EventManager::addNativeListener(Robot *bot)
+{
+   TNLAssert(bot->getController(), "Only for native bots!");
+
+   if(!nativeListeners.contains(bot))
+      nativeListeners.push_back(bot);
+}
+
+
+void EventManager::removeNativeListener(Robot *bot)
+{
+   S32 index = nativeListeners.getIndex(bot);
+
+   if(index != -1)
+      nativeListeners.erase(index);    // Keep the order, so bots hear things in the order they joined
+
+   index = batchNativeListeners.getIndex(bot);
+   if(index != -1)
+      batchNativeListeners[index] = NULL;
+}
+
+
+// onNexusOpened, onNexusClosed, onGameOver
 void EventManager::fireEvent(EventType eventType)
 {
-   if(suppressEvents(eventType))   
+   if(suppressEvents(eventType) || holdEvent(eventType) || deferEvent(eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
+   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   {
+      if(!isListening(subscriptions[eventType][i], eventType))
+         continue;
+
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+      fire(L, subscriptions[eventType][i].subscriber, eventType, subscriptions[eventType][i].context);
+   }
 
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+   for(S32 i = 0; i < nativeListeners.size(); i++)
+   {
+      if(!isListening(nativeListeners[i], eventType))
+         continue;
+
+      BotController *controller = nativeListeners[i]->getController();
+      mDeliveredCount[eventType]++;
+
+      if(eventType == NexusOpenedEvent)
+         controller->onNexusOpened();
+      else if(eventType == NexusClosedEvent)
+         controller->onNexusClosed();
+      else if(eventType == GameOverEvent)
+         controller->onGameOver();
+   }
 }
 
 
 // onTick
 void EventManager::fireEvent(EventType eventType, U32 deltaT)
 {
-   if(suppressEvents(eventType))   
+   if(suppressEvents(eventType))
       return;
 
-   if(eventType == TickEvent)
-      mStepCount--;   
+   if(HeldEvent *event = holdEvent(eventType))
+   {
+      event->deltaT = deltaT;
+      return;
+   }
 
-   lua_State *L = LuaScriptRunner::getL();
+   if(deferEvent(eventType))
+      return;
 
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   if(eventType == TickEvent)
+      mStepCount--;   
 
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(!isListening(subscriptions[eventType][i], eventType))
+         continue;
+
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       lua_pushinteger(L, deltaT);   // -- deltaT
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, subscriptions[eventType][i].subscriber, eventType, subscriptions[eventType][i].context);
    }
 }
 
@@ -284,51 +394,72 @@ void EventManager::fireEvent(EventType eventType, U32 deltaT)
 // onCoreDestroyed
 void EventManager::fireEvent(EventType eventType, CoreItem *core)
 {
-   if(suppressEvents(eventType))
+   if(suppressEvents(eventType) || holdEvent(eventType, core) || deferEvent(eventType, core))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(!isListening(subscriptions[eventType][i], eventType))
+         continue;
+
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       core->push(L);                // -- core
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, subscriptions[eventType][i].subscriber, eventType, subscriptions[eventType][i].context);
    }
+
+   for(S32 i = 0; i < nativeListeners.size(); i++)
+      if(isListening(nativeListeners[i], eventType))
+      {
+         nativeListeners[i]->getController()->onCoreDestroyed(core);
+         mDeliveredCount[eventType]++;
+      }
 }
 
 
 // onShipSpawned
 void EventManager::fireEvent(EventType eventType, Ship *ship)
 {
-   if(suppressEvents(eventType))   
+   if(suppressEvents(eventType) || holdEvent(eventType, ship) || deferEvent(eventType, ship))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(!isListening(subscriptions[eventType][i], eventType))
+         continue;
+
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       ship->push(L);                // -- ship
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, subscriptions[eventType][i].subscriber, eventType, subscriptions[eventType][i].context);
    }
+
+   for(S32 i = 0; i < nativeListeners.size(); i++)
+      if(isListening(nativeListeners[i], eventType))
+      {
+         nativeListeners[i]->getController()->onShipSpawned(ship);
+         mDeliveredCount[eventType]++;
+      }
 }
 
 
 // onShipKilled
 void EventManager::fireEvent(EventType eventType, Ship *ship, BfObject *damagingObject, BfObject *shooter)
 {
-   if(suppressEvents(eventType))
+   if(suppressEvents(eventType) || holdEvent(eventType, ship, damagingObject, shooter) || 
+      deferEvent(eventType, ship, damagingObject, shooter))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(!isListening(subscriptions[eventType][i], eventType))
+         continue;
+
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       ship->push(L);                // -- ship
 
       if(damagingObject)
@@ -341,8 +472,15 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, BfObject *damaging
       else
          lua_pushnil(L);
 
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, subscriptions[eventType][i].subscriber, eventType, subscriptions[eventType][i].context);
    }
+
+   for(S32 i = 0; i < nativeListeners.size(); i++)
+      if(isListening(nativeListeners[i], eventType))
+      {
+         nativeListeners[i]->getController()->onShipKilled(ship, damagingObject, shooter);
+         mDeliveredCount[eventType]++;
+      }
 }
 
 
@@ -350,17 +488,30 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, BfObject *damaging
 // callerId will be NULL when player sends message
 void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType, const char *message, LuaPlayerInfo *playerInfo, bool global)
 {
-   if(suppressEvents(eventType))   
+   if(suppressEvents(eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
+   if(HeldEvent *event = holdEvent(eventType))
+   {
+      event->sender = sender;
+      event->message = message ? message : "";
+      event->playerInfo = playerInfo;
+      event->global = global;
+      return;
+   }
 
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   if(deferEvent(eventType))
+      return;
 
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
       if(sender == subscriptions[eventType][i].subscriber)    // Don't alert sender about own message!
          continue;
+      if(!isListening(subscriptions[eventType][i], eventType))
+         continue;
+
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
       lua_pushstring(L, message);   // -- message
 
@@ -371,7 +522,16 @@ void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType, const
 
       lua_pushboolean(L, global);   // -- message, player, isGlobal
 
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, subscriptions[eventType][i].subscriber, eventType, subscriptions[eventType][i].context);
+   }
+
+   for(S32 i = 0; i < nativeListeners.size(); i++)
+   {
+      if(sender == nativeListeners[i] || !isListening(nativeListeners[i], eventType))
+         continue;
+
+      nativeListeners[i]->getController()->onMsgReceived(message, playerInfo, global);
+      mDeliveredCount[eventType]++;
    }
 }
 
@@ -379,20 +539,47 @@ void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType, const
 // onPlayerJoined, onPlayerLeft, onPlayerTeamChanged
 void EventManager::fireEvent(LuaScriptRunner *player, EventType eventType, LuaPlayerInfo *playerInfo)
 {
-   if(suppressEvents(eventType))   
+   if(suppressEvents(eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
+   if(HeldEvent *event = holdEvent(eventType))
+   {
+      event->sender = player;
+      event->playerInfo = playerInfo;
+      return;
+   }
 
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   if(deferEvent(eventType))
+      return;
 
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
       if(player == subscriptions[eventType][i].subscriber)    // Don't trouble player with own joinage or leavage!
          continue;
+      if(!isListening(subscriptions[eventType][i], eventType))
+         continue;
+
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
       playerInfo->push(L);          // -- playerInfo
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, subscriptions[eventType][i].subscriber, eventType, subscriptions[eventType][i].context);
+   }
+
+   for(S32 i = 0; i < nativeListeners.size(); i++)
+   {
+      if(player == nativeListeners[i] || !isListening(nativeListeners[i], eventType))
+         continue;
+
+      BotController *controller = nativeListeners[i]->getController();
+      mDeliveredCount[eventType]++;
+
+      if(eventType == PlayerJoinedEvent)
+         controller->onPlayerJoined(playerInfo);
+      else if(eventType == PlayerLeftEvent)
+         controller->onPlayerLeft(playerInfo);
+      else if(eventType == PlayerTeamChangedEvent)
+         controller->onPlayerTeamChanged(playerInfo);
    }
 }
 
@@ -400,15 +587,17 @@ void EventManager::fireEvent(LuaScriptRunner *player, EventType eventType, LuaPl
 // onShipEnteredZone, onShipLeftZone
 void EventManager::fireEvent(EventType eventType, Ship *ship, Zone *zone)
 {
-   if(suppressEvents(eventType))   
+   if(suppressEvents(eventType) || holdEvent(eventType, ship, zone) || deferEvent(eventType, ship, zone))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(!isListening(subscriptions[eventType][i], eventType))
+         continue;
+
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       try   
       {
          // Passing ship, zone, zoneType, zoneId
@@ -417,7 +606,7 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, Zone *zone)
          lua_pushinteger(L, zone->getObjectTypeNumber());   // -- ship, zone, zone->objTypeNumber
          lua_pushinteger(L, zone->getUserAssignedId());     // -- ship, zone, zone->objTypeNumber, zone->id
 
-         fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+         fire(L, subscriptions[eventType][i].subscriber, eventType, subscriptions[eventType][i].context);
       }
       catch(LuaException &e)
       {
@@ -426,21 +615,36 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, Zone *zone)
          return;
       }
    }
+
+   for(S32 i = 0; i < nativeListeners.size(); i++)
+   {
+      if(!isListening(nativeListeners[i], eventType))
+         continue;
+
+      mDeliveredCount[eventType]++;
+
+      if(eventType == ShipEnteredZoneEvent)
+         nativeListeners[i]->getController()->onShipEnteredZone(ship, zone);
+      else
+         nativeListeners[i]->getController()->onShipLeftZone(ship, zone);
+   }
 }
 
 
 // ObjectEnteredZoneEvent, ObjectLeftZoneEvent
 void EventManager::fireEvent(EventType eventType, MoveObject *object, Zone *zone)
 {
-   if(suppressEvents(eventType))   
+   if(suppressEvents(eventType) || holdEvent(eventType, object, zone) || deferEvent(eventType, object, zone))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(!isListening(subscriptions[eventType][i], eventType))
+         continue;
+
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       try   
       {
          // Passing object, zone, zoneType, zoneId
@@ -449,7 +653,7 @@ void EventManager::fireEvent(EventType eventType, MoveObject *object, Zone *zone
          lua_pushinteger(L, zone->getObjectTypeNumber());   // -- object, zone, zone->objTypeNumber
          lua_pushinteger(L, zone->getUserAssignedId());     // -- object, zone, zone->objTypeNumber, zone->id
 
-         fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+         fire(L, subscriptions[eventType][i].subscriber, eventType, subscriptions[eventType][i].context);
       }
       catch(LuaException &e)
       {
@@ -458,6 +662,19 @@ void EventManager::fireEvent(EventType eventType, MoveObject *object, Zone *zone
          return;
       }
    }
+
+   for(S32 i = 0; i < nativeListeners.size(); i++)
+   {
+      if(!isListening(nativeListeners[i], eventType))
+         continue;
+
+      mDeliveredCount[eventType]++;
+
+      if(eventType == ObjectEnteredZoneEvent)
+         nativeListeners[i]->getController()->onObjectEnteredZone(object, zone);
+      else
+         nativeListeners[i]->getController()->onObjectLeftZone(object, zone);
+   }
 }
 
 
@@ -467,12 +684,25 @@ void EventManager::fireEvent(EventType eventType, S32 score, S32 teamIndex, LuaP
    if(suppressEvents(eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
+   if(HeldEvent *event = holdEvent(eventType))
+   {
+      event->score = score;
+      event->teamIndex = teamIndex;
+      event->playerInfo = playerInfo;
+      return;
+   }
 
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   if(deferEvent(eventType))
+      return;
 
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(!isListening(subscriptions[eventType][i], eventType))
+         continue;
+
+      lua_State *L = subscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       lua_pushinteger(L, score);       // -- score
       lua_pushinteger(L, teamIndex);   // -- score, team
 
@@ -481,15 +711,37 @@ void EventManager::fireEvent(EventType eventType, S32 score, S32 teamIndex, LuaP
       else
          lua_pushnil(L);
 
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, subscriptions[eventType][i].subscriber, eventType, subscriptions[eventType][i].context);
    }
+
+   for(S32 i = 0; i < nativeListeners.size(); i++)
+      if(isListening(nativeListeners[i], eventType))
+      {
+         nativeListeners[i]->getController()->onScoreChanged(score, teamIndex, playerInfo);
+         mDeliveredCount[eventType]++;
+      }
+}
+
+
+// onTick for a single bot -- bots thinking in parallel are skipped by the regular TickEvent, and get theirs here
+void EventManager::fireTickEvent(LuaScriptRunner *subscriber, U32 deltaT)
+{
+   lua_State *L = subscriber->getLuaState();
+
+   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
+   lua_pushinteger(L, deltaT);   // -- deltaT
+   fire(L, subscriber, TickEvent, RobotContext);
 }
 
 
 // Actually fire the event, called by one of the fireEvent() methods above
 // Returns true if there was an error, false if everything ran ok
-bool EventManager::fire(lua_State *L, LuaScriptRunner *scriptRunner, const char *function, ScriptContext context)
+bool EventManager::fire(lua_State *L, LuaScriptRunner *scriptRunner, EventType eventType, ScriptContext context)
 {
+   const char *function = eventDefs[eventType].function;
+
+   mDeliveredCount[eventType]++;
    setScriptContext(L, context);
 
    try 
@@ -504,6 +756,524 @@ bool EventManager::fire(lua_State *L, LuaScriptRunner *scriptRunner, const char
 }
 
 
+// Scripts belonging to other games sharing this process shouldn't hear about our events.  Bots with their own Lua state
+// get their onTick from RobotManager::think() instead.
+bool EventManager::isListening(const Subscription &subscription, EventType eventType)
+{
+   return isListening(subscription, eventType, mActiveGame);
+}
+
+
+// The same, for an event fired by game, which may not be the one running now; NULL means it's for everyone
+bool EventManager::isListening(const Subscription &subscription, EventType eventType, const Game *game)
+{
+   if(game && subscription.subscriber->getLuaGame() != game)
+      return false;
+
+   // Scripts over their CPU budget sit out ticks; see LuaScriptRunner::checkTickBudget()
+   if(eventType == TickEvent && subscription.subscriber->isThrottled())
+      return false;
+
+   if(!subscription.subscriber->hasOwnLuaState())
+      return true;
+
+   return eventType != TickEvent;
+}
+
+
+// Native bots belonging to other games don't hear our events either
+bool EventManager::isListening(Robot *nativeBot, EventType eventType)
+{
+   return isListening(nativeBot, eventType, mActiveGame);
+}
+
+
+bool EventManager::isListening(Robot *nativeBot, EventType eventType, const Game *game)
+{
+   return !game || nativeBot->getGame() == game;
+}
+
+
+// While bots think in parallel, returns a new entry in heldEvents for the caller to fill in the rest of, and the event
+// goes no further for now; otherwise returns NULL.  Every call from Lua into C++ holds the LuaWorldLock, so only one
+// thread at a time gets here, but we take it anyway, in case an event ever comes from somewhere else.
+HeldEvent *EventManager::holdEvent(EventType eventType, BfObject *arg1, BfObject *arg2, BfObject *arg3)
+{
+   if(!LuaWorldLock::isEnabled())
+      return NULL;
+
+   LuaWorldLock lock;
+
+   heldEvents.push_back(HeldEvent());
+   HeldEvent &event = heldEvents.last();
+
+   event.eventType = eventType;
+   event.thinker = LuaWorldLock::getThinker();
+   event.args[0] = arg1;
+   event.args[1] = arg2;
+   event.args[2] = arg3;
+   event.sender = NULL;
+   event.playerInfo = NULL;
+   event.global = false;
+   event.score = 0;
+   event.teamIndex = 0;
+   event.deltaT = 0;
+
+   return &event;
+}
+
+
+static bool thinksFirst(const HeldEvent &a, const HeldEvent &b)
+{
+   return a.thinker < b.thinker;
+}
+
+
+// Called on the main thread, once bots are done thinking.  Handlers can fire events of their own; those aren't held.
+void EventManager::fireHeldEvents()
+{
+   TNLAssert(!LuaWorldLock::isEnabled(), "Bots are still thinking!");
+
+   if(heldEvents.size() == 0)
+      return;
+
+   std::vector<HeldEvent> events;
+   events.swap(heldEvents.getStlVector());
+
+   std::stable_sort(events.begin(), events.end(), thinksFirst);
+
+   for(U32 i = 0; i < events.size(); i++)
+   {
+      const HeldEvent &event = events[i];
+
+      switch(event.eventType)
+      {
+         case TickEvent:
+            fireEvent(event.eventType, event.deltaT);
+            break;
+
+         case ShipSpawnedEvent:
+            fireEvent(event.eventType, static_cast<Ship *>(event.args[0]));
+            break;
+
+         case ShipKilledEvent:
+            fireEvent(event.eventType, static_cast<Ship *>(event.args[0]), event.args[1], event.args[2]);
+            break;
+
+         case PlayerJoinedEvent:
+         case PlayerLeftEvent:
+         case PlayerTeamChangedEvent:
+            fireEvent(event.sender, event.eventType, event.playerInfo);
+            break;
+
+         case MsgReceivedEvent:
+            fireEvent(event.sender, event.eventType, event.message.c_str(), event.playerInfo, event.global);
+            break;
+
+         case ShipEnteredZoneEvent:
+         case ShipLeftZoneEvent:
+            fireEvent(event.eventType, static_cast<Ship *>(event.args[0]), static_cast<Zone *>(event.args[1]));
+            break;
+
+         case ObjectEnteredZoneEvent:
+         case ObjectLeftZoneEvent:
+            fireEvent(event.eventType, static_cast<MoveObject *>(event.args[0]), static_cast<Zone *>(event.args[1]));
+            break;
+
+         case ScoreChangedEvent:
+            fireEvent(event.eventType, event.score, event.teamIndex, event.playerInfo);
+            break;
+
+         case CoreDestroyedEvent:
+            fireEvent(event.eventType, static_cast<CoreItem *>(event.args[0]));
+            break;
+
+         default:    // NexusOpened, NexusClosed, GameOver
+            fireEvent(event.eventType);
+            break;
+      }
+   }
+}
+
+
+// Counts the event.  In deferred mode, world events are queued here, and we return true to say they've been dealt with
+// for now; anything else first gets everything queued so far delivered, so handlers hear about things in order.
+bool EventManager::deferEvent(EventType eventType, BfObject *arg1, BfObject *arg2, BfObject *arg3)
+{
+   mFiredCount[eventType]++;
+
+   if(!mDeferred)
+      return false;
+
+   bool isZoneEvent = false;
+
+   switch(eventType)
+   {
+      case ShipEnteredZoneEvent:
+      case ShipLeftZoneEvent:
+      case ObjectEnteredZoneEvent:
+      case ObjectLeftZoneEvent:
+         isZoneEvent = true;
+         break;
+
+      case ShipSpawnedEvent:
+      case ShipKilledEvent:
+      case CoreDestroyedEvent:
+         break;
+
+      default:
+         flushDeferredEvents();
+         return false;
+   }
+
+   if(isZoneEvent && coalesceZoneEvent(eventType, arg1, arg2))
+      return true;
+
+   QueuedEvent event;
+   event.eventType = eventType;
+   event.game = mActiveGame;
+   event.args[0] = arg1;
+   event.args[1] = arg2;
+   event.args[2] = arg3;
+
+   queuedEvents.push_back(event);
+
+   return true;
+}
+
+
+// For zone events: returns true if this one merges with one already queued for the same object and zone, in which case
+// it shouldn't be queued itself.  Entering then leaving (or leaving then entering) leaves things as they were, so both
+// go; the same thing twice is only worth saying once.
+bool EventManager::coalesceZoneEvent(EventType eventType, BfObject *object, BfObject *zone)
+{
+   S32 kind = (eventType == ShipEnteredZoneEvent || eventType == ShipLeftZoneEvent) ? 0 : 1;
+   ZoneEventKey key(object, zone);
+
+   map<ZoneEventKey, S32>::iterator it = lastZoneEvent[kind].find(key);
+
+   // Nothing queued for this pair -- or what was is for something that's since been destroyed, and this is its successor
+   if(it == lastZoneEvent[kind].end() || queuedEvents[it->second].args[0].isNull())
+   {
+      lastZoneEvent[kind][key] = queuedEvents.size();    // Where this one is about to go
+      return false;
+   }
+
+   QueuedEvent &previous = queuedEvents[it->second];
+
+   mCoalescedCount[eventType]++;
+
+   if(previous.eventType != eventType)
+   {
+      mCoalescedCount[previous.eventType]++;
+      previous.eventType = EventTypes;
+      lastZoneEvent[kind].erase(it);
+   }
+
+   return true;
+}
+
+
+// Hand out everything queued in deferred mode.  Events fired by the handlers get delivered too, for a few rounds; if
+// that's not enough for them all, the rest wait for our next call.
+void EventManager::flushDeferredEvents()
+{
+   if(mFlushing || queuedEvents.size() == 0)
+      return;
+
+   TNLAssert(!LuaWorldLock::isEnabled(), "Can't deliver events while bots are thinking!");
+
+   mFlushing = true;
+
+   S32 first = 0;
+
+   for(S32 pass = 0; pass < MaxFlushPasses && first < queuedEvents.size(); pass++)
+   {
+      S32 last = queuedEvents.size();
+
+      // Events fired from here on can only merge with each other
+      lastZoneEvent[0].clear();
+      lastZoneEvent[1].clear();
+
+      deliverQueuedEvents(first, last);
+      first = last;
+   }
+
+   if(first < queuedEvents.size())
+   {
+      std::vector<QueuedEvent> &events = queuedEvents.getStlVector();
+      events.erase(events.begin(), events.begin() + first);
+   }
+   else
+      queuedEvents.clear();     // Keeps its memory for next tick
+
+   lastZoneEvent[0].clear();
+   lastZoneEvent[1].clear();
+
+   mFlushing = false;
+}
+
+
+// Deliver queuedEvents[first] through queuedEvents[last - 1], all of one listener's at a time.  New events can be queued
+// while we're at it, so we only ever hold on to an index into queuedEvents, never a reference.
+void EventManager::deliverQueuedEvents(S32 first, S32 last)
+{
+   U32 typesQueued = 0;
+
+   for(S32 i = first; i < last; i++)
+      if(queuedEvents[i].eventType != EventTypes)
+         typesQueued |= BIT(queuedEvents[i].eventType);
+
+   if(typesQueued == 0)
+      return;
+
+   // Find everyone who wants any of these events, once each, along with which ones they want
+   Vector<Subscription> subscribers;
+   Vector<U32> subscribedTypes;
+
+   batchSubscribers.clear();
+
+   for(S32 eventType = 0; eventType < EventTypes; eventType++)
+   {
+      if(!(typesQueued & BIT(eventType)))
+         continue;
+
+      for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+      {
+         S32 index = batchSubscribers.getIndex(subscriptions[eventType][i].subscriber);
+
+         if(index == -1)
+         {
+            index = subscribers.size();
+            subscribers.push_back(subscriptions[eventType][i]);
+            subscribedTypes.push_back(0);
+            batchSubscribers.push_back(subscriptions[eventType][i].subscriber);
+         }
+
+         subscribedTypes[index] |= BIT(eventType);
+      }
+   }
+
+   for(S32 i = 0; i < subscribers.size(); i++)
+   {
+      for(S32 j = first; j < last && batchSubscribers[i]; j++)    // Stop if the handler got the subscriber killed
+      {
+         EventType eventType = queuedEvents[j].eventType;
+
+         if(eventType == EventTypes || !(subscribedTypes[i] & BIT(eventType)) ||
+             !isListening(subscribers[i], eventType, queuedEvents[j].game))
+            continue;
+
+         lua_State *L = subscribers[i].subscriber->getLuaState();
+         TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
+         try
+         {
+            if(pushEventArgs(L, queuedEvents[j]))
+               fire(L, subscribers[i].subscriber, eventType, subscribers[i].context);
+         }
+         catch(LuaException &e)
+         {
+            handleEventFiringError(L, subscribers[i], eventType, e.what());
+         }
+      }
+   }
+
+   batchSubscribers.clear();
+
+   // Then the native bots, the same way
+   batchNativeListeners = nativeListeners;
+
+   for(S32 i = 0; i < batchNativeListeners.size(); i++)
+      for(S32 j = first; j < last && batchNativeListeners[i]; j++)
+      {
+         EventType eventType = queuedEvents[j].eventType;
+
+         if(eventType == EventTypes || !isListening(batchNativeListeners[i], eventType, queuedEvents[j].game))
+            continue;
+
+         QueuedEvent event = queuedEvents[j];     // A copy, in case the controller fires events of its own
+
+         if(fireNativeEvent(batchNativeListeners[i]->getController(), event))
+            mDeliveredCount[eventType]++;
+      }
+
+   batchNativeListeners.clear();
+}
+
+
+// Push a queued event's arguments, the same ones fireEvent() would have; returns false, having pushed nothing, if the 
+// object the event is about has gone away
+bool EventManager::pushEventArgs(lua_State *L, const QueuedEvent &event)
+{
+   BfObject *object = event.args[0];
+
+   if(!object)
+      return false;
+
+   switch(event.eventType)
+   {
+      case ShipSpawnedEvent:
+      case CoreDestroyedEvent:
+         object->push(L);                 // -- object
+         return true;
+
+      case ShipKilledEvent:
+         object->push(L);                 // -- ship
+
+         for(S32 i = 1; i < 3; i++)       // -- ship, damagingObject, shooter
+         {
+            BfObject *arg = event.args[i];
+
+            if(arg)
+               arg->push(L);
+            else
+               lua_pushnil(L);
+         }
+         return true;
+
+      case ShipEnteredZoneEvent:
+      case ShipLeftZoneEvent:
+      case ObjectEnteredZoneEvent:
+      case ObjectLeftZoneEvent:
+      {
+         BfObject *zone = event.args[1];
+
+         if(!zone)
+            return false;
+
+         object->push(L);                                   // -- object
+         zone->push(L);                                     // -- object, zone
+         lua_pushinteger(L, zone->getObjectTypeNumber());   // -- object, zone, zone->objTypeNumber
+         lua_pushinteger(L, zone->getUserAssignedId());     // -- object, zone, zone->objTypeNumber, zone->id
+         return true;
+      }
+
+      default:
+         TNLAssert(false, "Not an event we queue!");
+         return false;
+   }
+}
+
+
+// Returns false if the event's objects have gone away, and nothing was called
+bool EventManager::fireNativeEvent(BotController *controller, const QueuedEvent &event)
+{
+   BfObject *object = event.args[0];
+   BfObject *other  = event.args[1];
+
+   if(!object)
+      return false;
+
+   switch(event.eventType)
+   {
+      case ShipSpawnedEvent:
+         controller->onShipSpawned(static_cast<Ship *>(object));
+         return true;
+
+      case ShipKilledEvent:
+         controller->onShipKilled(static_cast<Ship *>(object), other, event.args[2]);
+         return true;
+
+      case CoreDestroyedEvent:
+         controller->onCoreDestroyed(static_cast<CoreItem *>(object));
+         return true;
+
+      default:
+         break;
+   }
+
+   // The rest are zone events
+   if(!other)
+      return false;
+
+   Zone *zone = static_cast<Zone *>(other);
+
+   switch(event.eventType)
+   {
+      case ShipEnteredZoneEvent:
+         controller->onShipEnteredZone(static_cast<Ship *>(object), zone);
+         break;
+      case ShipLeftZoneEvent:
+         controller->onShipLeftZone(static_cast<Ship *>(object), zone);
+         break;
+      case ObjectEnteredZoneEvent:
+         controller->onObjectEnteredZone(static_cast<MoveObject *>(object), zone);
+         break;
+      case ObjectLeftZoneEvent:
+         controller->onObjectLeftZone(static_cast<MoveObject *>(object), zone);
+         break;
+      default:
+         TNLAssert(false, "Not an event we queue!");
+         return false;
+   }
+
+   return true;
+}
+
+
+void EventManager::setDeferred(bool deferred)
+{
+   if(!deferred)
+      flushDeferredEvents();
+
+   mDeferred = deferred;
+}
+
+
+bool EventManager::isDeferred() const
+{
+   return mDeferred;
+}
+
+
+U32 EventManager::getFiredCount(EventType eventType) const
+{
+   return mFiredCount[eventType];
+}
+
+
+U32 EventManager::getDeliveredCount(EventType eventType) const
+{
+   return mDeliveredCount[eventType];
+}
+
+
+U32 EventManager::getCoalescedCount(EventType eventType) const
+{
+   return mCoalescedCount[eventType];
+}
+
+
+void EventManager::resetEventCounts()
+{
+   for(S32 i = 0; i < EventTypes; i++)
+   {
+      mFiredCount[i] = 0;
+      mDeliveredCount[i] = 0;
+      mCoalescedCount[i] = 0;
+   }
+}
+
+
+void EventManager::getEventReport(Vector<string> &lines) const
+{
+   for(S32 i = 0; i < EventTypes; i++)
+   {
+      if(mFiredCount[i] == 0)
+         continue;
+
+      string line = string(eventDefs[i].name) + ": fired " + itos(mFiredCount[i]) + ", " + 
+                    itos(mDeliveredCount[i]) + " handlers run";
+
+      if(mCoalescedCount[i] > 0)
+         line += ", " + itos(mCoalescedCount[i]) + " merged away";
+
+      lines.push_back(line);
+   }
+}
+
+
 void EventManager::handleEventFiringError(lua_State *L, const Subscription &subscriber, EventType eventType, const char *errorMsg)
 {
    if(subscriber.context == RobotContext)
@@ -524,13 +1294,29 @@ void EventManager::handleEventFiringError(lua_State *L, const Subscription &subs
 // If true, events will not fire!
 bool EventManager::suppressEvents(EventType eventType)
 {
-   if(subscriptions[eventType].size() == 0)
+   if(subscriptions[eventType].size() == 0 && (eventType == TickEvent || nativeListeners.size() == 0))
       return true;
 
    return mIsPaused && mStepCount <= 0;    // Paused bots should still respond to events as long as stepCount > 0
 }
 
 
+void EventManager::setActiveGame(const Game *game)
+{
+   // What we've held back belongs to the game that's been running, and deferring is for the length of its tick only
+   if(game != mActiveGame)
+      setDeferred(false);
+
+   mActiveGame = game;
+}
+
+
+const Game *EventManager::getActiveGame() const
+{
+   return mActiveGame;
+}
+
+
 void EventManager::setPaused(bool isPaused)
 {
    mIsPaused = isPaused;
@@ -16,7 +16,10 @@ using namespace TNL;
 namespace Zap
 {
 
+class BfObject;
+class BotController;
 class CoreItem;
+class Game;
 class LuaPlayerInfo;
 class LuaScriptRunner;
 class MoveObject;
@@ -24,6 +27,8 @@ class Robot;
 class Ship;
 class Zone;
 
+struct HeldEvent;
+struct QueuedEvent;
 struct Subscription; 
 
 class EventManager
@@ -71,7 +76,6 @@ enum EventType {
 
 private:
    // Some helper functions
-   bool isSubscribed         (LuaScriptRunner *subscriber, EventType eventType);
    bool isPendingSubscribed  (LuaScriptRunner *subscriber, EventType eventType);
    bool isPendingUnsubscribed(LuaScriptRunner *subscriber, EventType eventType);
 
@@ -80,10 +84,32 @@ private:
    void removeFromPendingUnsubscribeList(LuaScriptRunner *subscriber, EventType eventType);
 
    void handleEventFiringError(lua_State *L, const Subscription &subscriber, EventType eventType, const char *errorMsg);
-   bool fire(lua_State *L, LuaScriptRunner *scriptRunner, const char *function, ScriptContext context);
+   bool fire(lua_State *L, LuaScriptRunner *scriptRunner, EventType eventType, ScriptContext context);
+   bool isListening(const Subscription &subscription, EventType eventType);
+   bool isListening(const Subscription &subscription, EventType eventType, const Game *game);
+   bool isListening(Robot *nativeBot, EventType eventType);
+   bool isListening(Robot *nativeBot, EventType eventType, const Game *game);
+
+   HeldEvent *holdEvent(EventType eventType, BfObject *arg1 = NULL, BfObject *arg2 = NULL, BfObject *arg3 = NULL);
+
+   // Deferred mode, see setDeferred()
+   bool deferEvent(EventType eventType, BfObject *arg1 = NULL, BfObject *arg2 = NULL, BfObject *arg3 = NULL);
+   bool coalesceZoneEvent(EventType eventType, BfObject *object, BfObject *zone);
+   void deliverQueuedEvents(S32 first, S32 last);
+   bool pushEventArgs(lua_State *L, const QueuedEvent &event);
+   bool fireNativeEvent(BotController *controller, const QueuedEvent &event);
       
+   const Game *mActiveGame;  // Game whose scripts hear events right now; NULL means everyone does
    bool mIsPaused;
    S32 mStepCount;           // If running for a certain number of steps, this will be > 0, while mIsPaused will be true
+   bool mDeferred;           // Holding world events back until the end of the tick
+   bool mFlushing;           // Delivering the ones we held back
+
+   // For profiling; see getEventReport()
+   U32 mFiredCount[EventTypes];        // Events fired while anyone was listening
+   U32 mDeliveredCount[EventTypes];    // Handlers run, Lua and native
+   U32 mCoalescedCount[EventTypes];    // Zone events merged away in deferred mode
+
    static bool mConstructed;
 
 public:
@@ -101,6 +127,8 @@ public:
    //static Vector<pendingUnsubscriptions *> pendingUnsubscriptions[EventTypes];
    static bool anyPending;
 
+   bool isSubscribed(LuaScriptRunner *subscriber, EventType eventType);
+
    void subscribe  (LuaScriptRunner *subscriber, EventType eventType, ScriptContext context, bool failSilently = false);
    void unsubscribe(LuaScriptRunner *subscriber, EventType eventType);
 
@@ -108,6 +136,10 @@ public:
    void unsubscribeImmediate(LuaScriptRunner *subscriber, EventType eventType); 
    void update();                                                      // Act on events sitting in the pending lists
 
+   // Bots with a native controller hear every event but ticks, through their controller's callbacks
+   void addNativeListener(Robot *bot);
+   void removeNativeListener(Robot *bot);
+
    // We'll have several different signatures for this one...
    void fireEvent(EventType eventType);
    void fireEvent(EventType eventType, U32 deltaT);      // Tick
@@ -120,11 +152,40 @@ public:
    void fireEvent(EventType eventType, MoveObject *object, Zone *zone); // ObjectEnteredZoneEvent, ObjectLeftZoneEvent
    void fireEvent(EventType eventType, S32 score, S32 teamIndex, LuaPlayerInfo *playerInfo);
 
+   void fireTickEvent(LuaScriptRunner *subscriber, U32 deltaT);
+
+   // A dedicated server can run several games at once; only scripts in the active one will hear events
+   void setActiveGame(const Game *game);
+   const Game *getActiveGame() const;
+
    // Allow the pausing of event firing for debugging purposes
    void setPaused(bool isPaused);
    void togglePauseStatus();
    bool isPaused();
    void addSteps(S32 steps);        // Each robot will cause the step counter to decrement
+
+   // Events fired while bots think in parallel (see RobotManager::think()) are held, rather than delivered from whatever
+   // thread they came from, until fireHeldEvents() fires them on the main thread.  They go in the order of the bots that
+   // caused them (see LuaWorldLock::getThinker()), then the order they were fired in, so the result doesn't depend on how
+   // the threads ran.
+   void fireHeldEvents();
+
+   // In deferred mode, the events the simulation fires by the thousand (ships spawning and dying, cores being destroyed, 
+   // and ships and objects entering and leaving zones) are queued as they happen and handed out by flushDeferredEvents(), 
+   // which the server calls once a tick.  Each listener then gets all of its events in one go, in the order they fired.  
+   // A zone entry and exit by the same object in the same tick cancel out, and repeats are dropped.  Any other event 
+   // flushes the queue before it fires, so nobody hears about things out of order.  Each event goes to the scripts of
+   // the game that was active when it fired.  Deferred mode lasts until the end of the tick, or until another game
+   // becomes active, whichever comes first.
+   void setDeferred(bool deferred);
+   bool isDeferred() const;
+   void flushDeferredEvents();
+
+   U32 getFiredCount(EventType eventType) const;
+   U32 getDeliveredCount(EventType eventType) const;
+   U32 getCoalescedCount(EventType eventType) const;
+   void resetEventCounts();
+   void getEventReport(Vector<string> &lines) const;     // One line per event type we've seen, for /eventstats
 };
 
 
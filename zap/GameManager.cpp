@@ -6,8 +6,10 @@
 #include "GameManager.h"
 
 #include "DisplayManager.h"
+#include "EventManager.h"
 #include "FontManager.h"
 #include "ServerGame.h"
+#include "gameNetInterface.h"
 #include "SoundSystem.h"
 #include "VideoSystem.h"
 #include "Console.h"
@@ -28,12 +30,14 @@ namespace Zap
 
 // Declare statics
 ServerGame *GameManager::mServerGame = NULL;
+Vector<ServerGame *> GameManager::mServerGames;
 
 #ifndef ZAP_DEDICATED
    Vector<ClientGame *> GameManager::mClientGames;
 #endif
 
-GameManager::HostingModePhase GameManager::mHostingModePhase = GameManager::NotHosting;
+TickStats GameManager::mTickStats;
+
 Console *GameManager::gameConsole = NULL;    // For the moment, we'll just have one console for everything.  This may change later, but probably won't.
 
 #ifndef BF_NO_CONSOLE
@@ -103,6 +107,13 @@ void GameManager::abortHosting_noLevels()
 
       logprintf(LogConsumer::LogError,     "No levels found in folder %s.  Cannot host a game.", levelDir);
       logprintf(LogConsumer::ServerFilter, "No levels found in folder %s.  Cannot host a game.", levelDir);
+
+      // Other arenas on this server can carry on without this one
+      if(mServerGames.size() > 1)
+      {
+         deleteServerGame(mServerGame);
+         return;
+      }
    }
 
 #ifndef ZAP_DEDICATED
@@ -152,22 +163,106 @@ void GameManager::setServerGame(ServerGame *serverGame)
    TNLAssert(serverGame, "Expect a valid serverGame here!");
    TNLAssert(!mServerGame, "Already have a ServerGame!");
 
-   mServerGame = serverGame;
+   mServerGames.push_back(serverGame);
+   setCurrentServerGame(serverGame);
 }
 
 
+// Deletes all our ServerGames
 void GameManager::deleteServerGame()
 {
-   // mServerGame might be NULL here; for example when quitting after losing a connection to the game server
-   delete mServerGame;     // Kill the serverGame (leaving the clients running)
-   mServerGame = NULL;
+   // mServerGames might be empty here; for example when quitting after losing a connection to the game server
+   while(mServerGames.size() > 0)
+      deleteServerGame(mServerGames.last());    // Kill the serverGame (leaving the clients running)
 }
 
 
+// Each arena runs in turn; whichever one is running is the current ServerGame
 void GameManager::idleServerGame(U32 timeDelta)
 {
-   if(mServerGame)
-      mServerGame->idle(timeDelta);
+   for(S32 i = 0; i < mServerGames.size(); i++)
+   {
+      setCurrentServerGame(mServerGames[i]);
+      mServerGames[i]->idle(timeDelta);
+   }
+}
+
+
+// Host another arena in this process, alongside the one passed to setServerGame().  The new game becomes current.
+void GameManager::addServerGame(ServerGame *serverGame)
+{
+   TNLAssert(serverGame, "Expect a valid serverGame here!");
+   TNLAssert(mServerGames.size() > 0, "Use setServerGame() for the first ServerGame!");
+   TNLAssert(serverGame->isDedicated() && mServerGames[0]->isDedicated(), "Only dedicated servers can host multiple arenas!");
+
+   mServerGames.push_back(serverGame);
+   setCurrentServerGame(serverGame);
+}
+
+
+const Vector<ServerGame *> *GameManager::getServerGames()
+{
+   return &mServerGames;
+}
+
+
+// Code that reaches for GameManager::getServerGame(), and scripts listening for events, will see this game
+void GameManager::setCurrentServerGame(ServerGame *serverGame)
+{
+   mServerGame = serverGame;
+   EventManager::get()->setActiveGame(serverGame);
+}
+
+
+void GameManager::deleteServerGame(ServerGame *serverGame)
+{
+   S32 index = mServerGames.getIndex(serverGame);
+   TNLAssert(index != -1, "Unknown ServerGame!");
+
+   // Make it current so anything fired while it shuts down stays inside it
+   setCurrentServerGame(serverGame);
+   delete serverGame;
+
+   mServerGames.erase(index);
+   setCurrentServerGame(mServerGames.size() > 0 ? mServerGames[0] : NULL);
+}
+
+
+// Dedicated servers with nobody playing anywhere can take it easy
+bool GameManager::allServerGamesSuspended()
+{
+   for(S32 i = 0; i < mServerGames.size(); i++)
+      if(!mServerGames[i]->isSuspended())
+         return false;
+
+   return true;
+}
+
+
+// Sleep until one of our arenas has a packet waiting, or timeout ms pass; returns true if there's something to read
+bool GameManager::waitForIncomingPackets(U32 timeout)
+{
+   Vector<Socket *> sockets(mServerGames.size());
+
+   for(S32 i = 0; i < mServerGames.size(); i++)
+      sockets.push_back(&mServerGames[i]->getNetInterface()->getSocket());
+
+   return Socket::waitForIncoming(sockets, timeout);
+}
+
+
+// Handle any waiting packets right away rather than at the next tick; the game itself doesn't advance
+void GameManager::readIncomingPackets()
+{
+   ServerGame *current = mServerGame;
+
+   for(S32 i = 0; i < mServerGames.size(); i++)
+   {
+      setCurrentServerGame(mServerGames[i]);
+      mServerGames[i]->getNetInterface()->checkIncomingPackets();
+   }
+
+   setCurrentServerGame(current);
 }
 
 
@@ -234,17 +329,24 @@ void GameManager::idle(U32 timeDelta)
 
 void GameManager::setHostingModePhase(HostingModePhase phase)
 {
-   mHostingModePhase = phase;
+   if(mServerGame)
+      mServerGame->setHostingModePhase(phase);
 }
 
 
 GameManager::HostingModePhase GameManager::getHostingModePhase()
 {
-   return mHostingModePhase;
+   return mServerGame ? mServerGame->getHostingModePhase() : NotHosting;
 }
 
 
 // Returns the first GameSettings object we can find.  This is a method of desperation.
+TickStats *GameManager::getTickStats()
+{
+   return &mTickStats;
+}
+
+
 GameSettings *GameManager::getAnyGameSettings()
 {
 #ifndef ZAP_DEDICATED
@@ -252,8 +354,8 @@ GameSettings *GameManager::getAnyGameSettings()
       return getClientGames()->get(0)->getSettings();
 #endif
 
-   if(getServerGame())
-      return getServerGame()->getSettings();
+   if(mServerGames.size() > 0)
+      return mServerGames[0]->getSettings();
 
    TNLAssert(false, "Who am I, and why am I here?");     // Bonus points if you know who said this!
 
@@ -293,9 +395,9 @@ void GameManager::shutdownBitfighter()
    deleteClientGames();
 #endif
 
-   if(getServerGame())
+   if(mServerGames.size() > 0)
    {
-      settings = getServerGame()->getSettings();
+      settings = mServerGames[0]->getSettings();   // Extra arenas have their own settings, which die with them
       deleteServerGame();
    }
 
@@ -8,6 +8,7 @@
 
 #include "tnlVector.h"
 #include "Console.h"
+#include "TickStats.h"
 
 using namespace TNL;
 
@@ -33,12 +34,12 @@ public:
    };
 
 private:
-   static ServerGame *mServerGame;
+   static ServerGame *mServerGame;              // The ServerGame we're working with right now
+   static Vector<ServerGame *> mServerGames;    // All hosted games; a dedicated server can run several arenas
 #ifndef ZAP_DEDICATED
    static Vector<ClientGame *> mClientGames;
 #endif
-
-   static HostingModePhase mHostingModePhase;
+   static TickStats mTickStats;
 
 public:
    static ::Console *gameConsole;
@@ -58,6 +59,17 @@ public:
    static void deleteServerGame();
    static void idleServerGame(U32 timeDelta);
 
+   // Additional arenas, dedicated server only
+   static void addServerGame(ServerGame *serverGame);
+   static const Vector<ServerGame *> *getServerGames();
+   static void setCurrentServerGame(ServerGame *serverGame);
+   static void deleteServerGame(ServerGame *serverGame);
+   static bool allServerGamesSuspended();
+
+   // For the event-driven server loop
+   static bool waitForIncomingPackets(U32 timeout);
+   static void readIncomingPackets();
+
    static void reset();    // Only used by testing
 
 
@@ -75,10 +87,11 @@ public:
 
    // Other
    static void idle(U32 timeDelta);
-   static void setHostingModePhase(HostingModePhase);
+   static void setHostingModePhase(HostingModePhase);    // These refer to the current ServerGame
    static HostingModePhase getHostingModePhase();
 
    static GameSettings *getAnyGameSettings();
+   static TickStats *getTickStats();
 };
 
 } 
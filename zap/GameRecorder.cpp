@@ -9,6 +9,8 @@
 #include "ServerGame.h"
 #include "stringUtils.h"
 #include "Level.h"         // Needed, sorry, resharper!
+#include "RingBuffer.h"
+#include "RecordingFile.h"
 
 #include "tnlThread.h"
 #include "tnlBitStream.h"
@@ -18,6 +20,7 @@
 #include "version.h"
 
 #include <algorithm>
+#include <atomic>
 
 namespace Zap
 {
@@ -27,86 +30,184 @@ namespace Zap
 // fwrite might have multiple 1-second freeze on VPS server or heavy disk access
 // Having fwrite in separate thread might fix the game from freezing/lagging
 // if run in VPS server or with heavy disk access
+//
+// The game thread hands data over through a RingBuffer, and never waits on the disk.  If the disk falls so far
+// behind that the ring fills up, we either hold on to the extra in memory until the ring has room again, or stop
+// recording, depending on the RecordingBufferGrow setting.  Stopping at a whole packet leaves a file that plays
+// fine up to that point; skipping packets and carrying on would not.
+//
+// Compressing happens here too, so the game thread never pays for it.
 
 class WriteBufferThread : public Thread
 {
 private:
-   FILE *f;
-   U32 lastPos;
-   U32 currPos;
-   U8 buffer[1024*128];
+   RecordingFileWriter file;
+   RingBuffer ring;
    TNL::Semaphore sem1;
-   U32 threadPos;
-   bool exitNow;
+   std::atomic<bool> exitNow;
+   std::atomic<bool> finished;
+   std::atomic<U32> bytesWritten;      // Bytes that have made it to the file
+   std::atomic<U32> fileSize;          // What they came to after compression
+
+   // Everything below belongs to the game thread
+   bool growWhenFull;
+   bool stopped;                       // Ran out of room and gave up
+   Vector<U8> overflow;                // Data waiting for room in the ring
+   U32 overflowPos;                    // Start of the data in overflow still waiting
+
+   U32 bytesQueued;
+   U32 bytesDropped;
+   U32 highWaterMark;                  // Most bytes ever waiting to be written
+   U32 fullCount;                      // Times we found the ring full
+   F64 stallTime;                      // Time the game thread spent waiting on the disk, in ms
+
+   // Move as much of the overflow into the ring as will fit
+   void drainOverflow()
+   {
+      U32 size = min(U32(overflow.size()) - overflowPos, ring.getFreeSpace());
+      if(size == 0)
+         return;
+
+      ring.write(&overflow[overflowPos], size);
+      overflowPos += size;
+
+      if(overflowPos == U32(overflow.size()))
+      {
+         overflow.clear();
+         overflowPos = 0;
+      }
+
+      sem1.increment();
+   }
+
 public:
 
-   WriteBufferThread(FILE *file)
+   WriteBufferThread(FILE *f, S32 compressionLevel, U32 capacity, bool growWhenFull) : file(f, compressionLevel), ring(capacity)
    {
-      TNLAssert(file != 0, "Must have a file handle");
-      lastPos = 0;
-      currPos = 0;
-      threadPos = 0;
       exitNow = false;
-      f = file;
+      finished = false;
+      bytesWritten = 0;
+      fileSize = 0;
+
+      this->growWhenFull = growWhenFull;
+      stopped = false;
+      overflowPos = 0;
+
+      bytesQueued = 0;
+      bytesDropped = 0;
+      highWaterMark = 0;
+      fullCount = 0;
+      stallTime = 0;
+
       if(!start())
       {
          logprintf(LogConsumer::LogWarning, "Failed to create thread for recorder, games may not record");
-         fclose(f);
-         f = NULL;
+         file.close();
+         finished = true;
+         stopped = true;
       }
    }
+
    ~WriteBufferThread()
    {
+      finish();
+   }
+
+
+   // Writes out everything still waiting, and waits for the thread to end.  Shutting down is the one time the
+   // game thread has to wait for the disk.
+   void finish()
+   {
+      if(exitNow)
+         return;
+
+      S64 start = Platform::getHighPrecisionTimerValue();
+
+      while(overflowPos < U32(overflow.size()))
+      {
+         drainOverflow();
+         Platform::sleep(1);
+      }
+
       exitNow = true;
       sem1.increment();
-      while(f != 0)         // Wait until the other thread is done
+      while(!finished)         // Wait until the other thread is done
          Platform::sleep(1);
+
+      stallTime += Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
    }
 
 
-   U8 *getBuffer(U32 size)
+   // All or nothing, so the file always ends on a whole packet or record
+   void write(const U8 *data, U32 size)
    {
-      if(currPos + size > sizeof(buffer))
+      if(stopped)
       {
-         lastPos = currPos;
-         currPos = 0;
+         bytesDropped += size;
+         return;
       }
-      U32 t = threadPos;
-      while(t > currPos && t < currPos + size) // Buffer too full, waiting...
+
+      drainOverflow();
+
+      if(overflow.size() != 0 || !ring.write(data, size))
       {
-         Platform::sleep(1);
-         t = threadPos;
+         fullCount++;
+
+         if(!growWhenFull)
+         {
+            logprintf(LogConsumer::LogWarning, "Recorder can't keep up with the game, stopping recording");
+            stopped = true;
+            bytesDropped += size;
+            return;
+         }
+
+         overflow.getStlVector().insert(overflow.getStlVector().end(), data, data + size);
       }
-      return &buffer[currPos];
+
+      bytesQueued += size;
+      highWaterMark = max(highWaterMark, ring.getCapacity() - ring.getFreeSpace() + U32(overflow.size()) - overflowPos);
+
+      sem1.increment();
    }
-   void addBuffer(U32 size)
+
+   // Where the next bytes will land in the file
+   U32 getBytesQueued()
    {
-      currPos += size;
-      sem1.increment();
+      return bytesQueued;
+   }
+
+   string getStats()
+   {
+      return "written " + itos(bytesWritten.load()) + " bytes (" + itos(fileSize.load()) + " on disk), dropped " + itos(bytesDropped) + ", high water " + 
+             itos(highWaterMark) + " of " + itos(ring.getCapacity()) + ", full " + itos(fullCount) + 
+             " times, stalled " + ftos(F32(stallTime), 1) + " ms";
    }
 
    U32 run()
    {
-      U32 currPos1 = currPos; // currPos could change anytime by other thread
-      while(!exitNow || currPos1 != threadPos)
+      while(true)
       {
-         if(currPos1 < threadPos)
-         {
+         // Check before looking at the ring, so we can't miss anything written just before exitNow was set
+         bool exiting = exitNow;
 
-            fwrite(&buffer[threadPos], 1, lastPos - threadPos, f);
-            threadPos = 0;
-         }
-         else if(currPos1 > threadPos)
+         const U8 *data;
+         U32 size = ring.peek(&data);
+
+         if(size > 0)
          {
-            fwrite(&buffer[threadPos], 1, currPos1 - threadPos, f);
-            threadPos = currPos1;
+            file.write(data, size);
+            ring.consume(size);
+            bytesWritten += size;
+            fileSize = file.getBytesWritten();
          }
+         else if(exiting)
+            break;
          else
             sem1.wait();  // Waits until sem1.increment
-         currPos1 = currPos;
       }
-      fclose(f);
-      f = 0;
+      file.close();
+      fileSize = file.getBytesWritten();
+      finished = true;
       return 0;
    }
 };
@@ -159,12 +260,24 @@ static string newRecordingFileName(const string &dir, const string &levelName, c
    return file;
 }
 
+static void writeU32(Vector<U8> &data, U32 value)
+{
+   data.push_back(U8(value));
+   data.push_back(U8(value >> 8));
+   data.push_back(U8(value >> 16));
+   data.push_back(U8(value >> 24));
+}
+
+
 // Constructor
 GameRecorderServer::GameRecorderServer(ServerGame *game)
 {
    mWriter = NULL;
    mGame = game;
    mMilliSeconds = 0;
+   mRecordedTime = 0;
+   mLastKeyframeTime = 0;
+   mKeyframePending = false;
    mWriteMaxBitSize = U32_MAX;
    mPackUnpackShipEnergyMeter = true;
 
@@ -175,7 +288,9 @@ GameRecorderServer::GameRecorderServer(ServerGame *game)
       string filename = joindir(dir, mFileName);
       FILE *file = fopen(filename.c_str(), "wb");
       if(file)
-         mWriter = new WriteBufferThread(file);
+         mWriter = new WriteBufferThread(file, game->getSettings()->getSetting<U32>(IniKey::RecordingCompression),
+                                         game->getSettings()->getSetting<U32>(IniKey::RecordingBufferSize) * 1024,
+                                         game->getSettings()->getSetting<YesNo>(IniKey::RecordingBufferGrow));
    }
 
    if(mWriter)
@@ -192,12 +307,12 @@ GameRecorderServer::GameRecorderServer(ServerGame *game)
       mConnectionParameters.mIsInitiator = false;
       mConnectionParameters.mDebugObjectSizes = false;
 
-      U8 *data = mWriter->getBuffer(4);
+      U8 data[4];
       data[0] = CS_PROTOCOL_VERSION;
       data[1] = U8(mGhostClassCount);
       data[2] = U8(mEventClassCount);
       data[3] = U8(mEventClassCount >> 8) | 0x10;
-      mWriter->addBuffer(4);
+      mWriter->write(data, 4);
       gameRecorderScoping(this, game);
 
       s2cSetServerName(game->getSettings()->getHostName());
@@ -208,7 +323,19 @@ GameRecorderServer::GameRecorderServer(ServerGame *game)
 GameRecorderServer::~GameRecorderServer()
 {
    if(mWriter)
+   {
+      writeIndex();
+      mWriter->finish();
+
+      logprintf(LogConsumer::ServerFilter, "Recorded %s: %s", mFileName.c_str(), mWriter->getStats().c_str());
       delete mWriter;
+   }
+}
+
+
+string GameRecorderServer::getWriterStats() const
+{
+   return mWriter ? mWriter->getStats() : "not recording";
 }
 
 
@@ -237,11 +364,36 @@ void GameRecorderServer::idle(U32 MilliSeconds)
       return;
    }
 
+   U32 ms = MilliSeconds + mMilliSeconds;
+   mMilliSeconds = 0;
+
+   recordPacket(ms);
+
+   if(mRecordedTime - mLastKeyframeTime >= KeyframeInterval)
+      mKeyframePending = true;
+
+   // A keyframe has to wait for a moment when every update has been written, so it matches what the stream has sent.
+   // In a busy game that moment may not come on its own, so we write out what's left, in packets where no time passes.
+   if(mKeyframePending)
+   {
+      for(S32 i = 0; i < MaxKeyframeCatchUpPackets && mGhostZeroUpdateIndex != 0; i++)
+         recordPacket(0);
+
+      if(mGhostZeroUpdateIndex == 0)
+         writeKeyframe();
+   }
+}
+
+
+// Write one packet of whatever the stream has to send, with the ms since the last one
+void GameRecorderServer::recordPacket(U32 ms)
+{
    GhostPacketNotify notify;
    mNotifyQueueTail = &notify;
 
-   U8 *data = mWriter->getBuffer(16383 + 3);
-   BitStream bstream(&data[3], 16383);
+   // A packet as big as RecordMarker would look like the start of a record
+   U8 data[MaxPacketSize + 3];
+   BitStream bstream(&data[3], MaxPacketSize);
 
    prepareWritePacket();
    GhostConnection::writePacket(&bstream, &notify);
@@ -251,12 +403,149 @@ void GameRecorderServer::idle(U32 MilliSeconds)
 
    bstream.zeroToByteBoundary();
    U32 size = bstream.getBytePosition();
-   U32 ms = MilliSeconds + mMilliSeconds;
-   mMilliSeconds = 0;
    data[0] = U8(size);
    data[1] = U8((size >> 8) & 63) | U8((ms >> 8) << 6);
    data[2] = U8(ms);
-   mWriter->addBuffer(bstream.getBytePosition() + 3);
+   mWriter->write(data, bstream.getBytePosition() + 3);
+
+   mRecordedTime += ms;
+}
+
+
+// Header and data go to the writer in one piece, so if it runs out of room, it drops the whole record, not half
+void GameRecorderServer::writeRecord(U8 type, const Vector<U8> &data)
+{
+   Vector<U8> record(data.size() + 8);
+
+   record.push_back(U8(RecordMarker));
+   record.push_back(U8(RecordMarker >> 8));
+   record.push_back(0);                // No time passes
+   record.push_back(type);
+   writeU32(record, data.size());
+
+   record.getStlVector().insert(record.getStlVector().end(), data.address(), data.address() + data.size());
+
+   mWriter->write(record.address(), record.size());
+}
+
+
+// Add one keyframe packet to data, as a 2 byte size followed by the packet itself
+static void addKeyframePacket(Vector<U8> &data, BitStream &bstream)
+{
+   bstream.zeroToByteBoundary();
+   U32 size = bstream.getBytePosition();
+
+   data.push_back(U8(size));
+   data.push_back(U8(size >> 8));
+
+   for(U32 i = 0; i < size; i++)
+      data.push_back(bstream.getBuffer()[i]);
+}
+
+
+// A keyframe is a record holding the packets a brand new connection would need to catch up to this point: every
+// object we've ghosted, under the same ghost ids, followed by the events each object sends when it first arrives.
+// Playback skips keyframes when playing straight through, and jumps to them when seeking.  The record holds the
+// event sequence the regular stream carries on with, then the packets, each with a 2 byte size, ending with a 0.
+void GameRecorderServer::writeKeyframe()
+{
+   Vector<U8> keyframe;
+   writeU32(keyframe, getNextUnackedEventSeq());
+
+   // Strings we send here might not be seen by someone playing straight through, so make sure the regular stream
+   // sends everything in full again too
+   mStringTable->clearReceiveConfirmations();
+
+   GhostPacketNotify notify;
+   mNotifyQueueTail = &notify;
+   beginEventSnapshot();
+
+   U8 data[16383];
+
+   // Ghosts go first, so the events that follow have somewhere to go
+   S32 next = 0;
+   while(next != -1)
+   {
+      BitStream bstream(data, sizeof(data));
+      EventConnection::writePacket(&bstream, &notify);
+      next = writeGhostSnapshot(&bstream, next);
+      addKeyframePacket(keyframe, bstream);
+   }
+
+   NetObject::setRPCDestConnection(this);
+
+   if(mGame->getGameType())
+      mGame->getGameType()->onGhostAvailable(this);
+
+   for(S32 i = 0; i < mGhostFreeIndex; i++)
+   {
+      NetObject *obj = mGhostArray[i]->obj;
+
+      if(obj && obj != mGame->getGameType() && !(mGhostArray[i]->flags & GhostInfo::NotYetGhosted))
+      {
+         NetObject::setRPCDestConnection(this);    // Some objects reset this when they're done
+         obj->onGhostAvailable(this);
+      }
+   }
+
+   NetObject::setRPCDestConnection(NULL);
+
+   s2cSetServerName(mGame->getSettings()->getHostName());
+
+   while(EventConnection::isDataToTransmit())
+   {
+      BitStream bstream(data, sizeof(data));
+      EventConnection::writePacket(&bstream, &notify);
+      bstream.writeFlag(false);        // No ghosts in this one
+
+      // Don't let the strings count as received; see above
+      mStringTable->packetDropped(&notify.stringList);
+      notify.stringList.stringHead = NULL;
+      notify.stringList.stringTail = NULL;
+
+      EventConnection::packetReceived(&notify);
+      notify.eventList = NULL;
+
+      addKeyframePacket(keyframe, bstream);
+   }
+
+   endEventSnapshot();
+
+   mStringTable->packetDropped(&notify.stringList);
+   mNotifyQueueTail = NULL;
+
+   keyframe.push_back(0);
+   keyframe.push_back(0);
+
+   mKeyframeTimes.push_back(mRecordedTime);
+   mKeyframeOffsets.push_back(mWriter->getBytesQueued());
+   mLastKeyframeTime = mRecordedTime;
+   mKeyframePending = false;
+
+   writeRecord(KeyframeRecord, keyframe);
+}
+
+
+// The index lets playback find keyframes without reading through the whole file.  It ends with its own position
+// and IndexMagic, so playback can find it by looking at the last 8 bytes.
+void GameRecorderServer::writeIndex()
+{
+   Vector<U8> index;
+   U32 position = mWriter->getBytesQueued();
+
+   writeU32(index, mRecordedTime);
+   writeU32(index, mKeyframeTimes.size());
+
+   for(S32 i = 0; i < mKeyframeTimes.size(); i++)
+   {
+      writeU32(index, mKeyframeTimes[i]);
+      writeU32(index, mKeyframeOffsets[i]);
+   }
+
+   writeU32(index, position);
+   writeU32(index, IndexMagic);
+
+   writeRecord(IndexRecord, index);
 }
 
 
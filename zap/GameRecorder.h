@@ -27,7 +27,31 @@ private:
    TNL::NetObject mNetObj;
    U32 mMilliSeconds;
 
+   U32 mRecordedTime;                  // Sum of the times written with each packet so far
+   U32 mLastKeyframeTime;
+   bool mKeyframePending;              // One is due, and goes out as soon as the stream has caught up
+   Vector<U32> mKeyframeTimes;
+   Vector<U32> mKeyframeOffsets;       // File position of each keyframe record
+
+   void recordPacket(U32 ms);
+   void writeRecord(U8 type, const Vector<U8> &data);
+   void writeKeyframe();
+   void writeIndex();
+
 public:
+   // Recordings start with a 4 byte header, followed by a stream of packets, each preceded by 3 bytes giving its
+   // size and the ms since the previous one.  A size of RecordMarker introduces one of our own records instead:
+   // a type byte, a 4 byte length, then that many bytes of record data.  Older versions don't write any records.
+   enum RecordingConstants {
+      RecordMarker = 0x3FFF,
+      MaxPacketSize = RecordMarker - 1, // In bytes; one more would be read as a marker
+      KeyframeRecord = 1,              // Everything a player needs to start playing from this point
+      IndexRecord = 2,                 // Time and position of every keyframe; always the last thing in the file
+      KeyframeInterval = 10000,        // In ms
+      MaxKeyframeCatchUpPackets = 8,   // Extra packets we'll write in one go to get a keyframe out
+      IndexMagic = 0x58524642          // Last 4 bytes of a file with an index, preceded by the index's position
+   };
+
    string mFileName;
 
    static string buildGameRecorderExtension();
@@ -36,6 +60,8 @@ public:
    ~GameRecorderServer();
 
    void idle(TNL::U32 MilliSeconds);
+
+   string getWriterStats() const;      // How well the disk is keeping up
 };
 
 }
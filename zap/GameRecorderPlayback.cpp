@@ -72,7 +72,6 @@ static void resetRenderState(ClientGame *game)
 
 GameRecorderPlayback::GameRecorderPlayback(ClientGame *game, const char *filename) : GameConnection(game, false)
 {
-   mFile = NULL;
    mGame = game;
    mMilliSeconds = 0;
    mSizeToRead = 0;
@@ -80,14 +79,12 @@ GameRecorderPlayback::GameRecorderPlayback(ClientGame *game, const char *filenam
    mTotalTime = 0;
    mIsButtonHeldDown = false;
 
-   if(!mFile)
-      mFile = fopen(filename, "rb");
-
-   if(mFile)
+   // Compressed recordings get decompressed as we go, without anything here having to know
+   if(mFile.open(filename))
    {
       U8 data[4];
       data[0] = 0;
-      fread(data, 1, 4, mFile);
+      mFile.read(data, 4);
       mGhostClassCount = data[1];
       mEventClassCount = U32(data[2]) | (U32(data[3]) << 8);
       if(mEventClassCount & 0x1000)
@@ -99,8 +96,7 @@ GameRecorderPlayback::GameRecorderPlayback(ClientGame *game, const char *filenam
          mEventClassCount > NetClassRep::getNetClassCount(getNetClassGroup(), NetClassTypeEvent) || 
          mGhostClassCount > NetClassRep::getNetClassCount(getNetClassGroup(), NetClassTypeObject))
       {
-         fclose(mFile); // Wrong version, warn about this problem?
-         mFile = NULL;
+         mFile.close(); // Wrong version, warn about this problem?
       }
 
       setGhostFrom(false);
@@ -113,34 +109,118 @@ GameRecorderPlayback::GameRecorderPlayback(ClientGame *game, const char *filenam
    mConnectionParameters.mDebugObjectSizes = false;
 
 
-   if(mFile)
+   if(mFile.isOpen())
+   {
+      S32 filepos = mFile.tell();
+
+      if(!readIndex())
+         scanRecording();
+
+      mFile.seek(filepos, SEEK_SET);
+   }
+}
+
+
+static U32 readU32(const U8 *data)
+{
+   return U32(data[0]) | (U32(data[1]) << 8) | (U32(data[2]) << 16) | (U32(data[3]) << 24);
+}
+
+
+// Reads the header of a record, having already read the 3 bytes that mark it as one
+static bool readRecordHeader(RecordingFileReader &file, U8 &type, U32 &size)
+{
+   U8 data[5];
+   if(file.read(data, 5) != 5)
+      return false;
+
+   type = data[0];
+   size = readU32(&data[1]);
+   return true;
+}
+
+
+// Recordings with an index tell us their length and where their keyframes are up front; see GameRecorderServer
+bool GameRecorderPlayback::readIndex()
+{
+   U8 data[8];
+   if(!mFile.seek(-8, SEEK_END) || mFile.read(data, 8) != 8 || readU32(&data[4]) != GameRecorderServer::IndexMagic)
+      return false;
+
+   U8 type;
+   U32 size;
+   if(!mFile.seek(readU32(data), SEEK_SET) || mFile.read(data, 3) != 3 || 
+         !readRecordHeader(mFile, type, size) || type != GameRecorderServer::IndexRecord || size < 16)
+      return false;
+
+   Vector<U8> index(size);
+   index.resize(size);
+
+   if(mFile.read(index.address(), size) != size)
+      return false;
+
+   U32 count = readU32(&index[4]);
+   if(count > (size - 16) / 8)
+      return false;
+
+   mTotalTime = readU32(&index[0]);
+
+   for(U32 i = 0; i < count; i++)
+   {
+      mKeyframeTimes.push_back(readU32(&index[8 + i * 8]));
+      mKeyframeOffsets.push_back(readU32(&index[12 + i * 8]));
+   }
+
+   return true;
+}
+
+
+// For recordings from older versions, or that never got their index written, we have to read through the
+// whole file to find out how long it is
+void GameRecorderPlayback::scanRecording()
+{
+   mFile.seek(4, SEEK_SET);
+
+   while(true)
    {
-      S32 filepos = ftell(mFile);
-      while(true)
+      S32 recordPos = mFile.tell();
+
+      U8 data[3];
+      if(mFile.read(data, 3) != 3)
+         break;
+      U32 size = (U32(data[1] & 63) << 8) + data[0];
+      U32 milli = S32((U32(data[1] >> 6) << 8) + data[2]);
+      if(size == 0)
+         break;
+
+      if(size == GameRecorderServer::RecordMarker)
       {
-         U8 data[3];
-         if(fread(data, 1, 3, mFile) != 3)
-            break;
-         U32 size = (U32(data[1] & 63) << 8) + data[0];
-         U32 milli = S32((U32(data[1] >> 6) << 8) + data[2]);
-         if(size == 0)
+         U8 type;
+         if(!readRecordHeader(mFile, type, size) || type == GameRecorderServer::IndexRecord)
             break;
-         mTotalTime += milli;
-         fseek(mFile, size, SEEK_CUR);
+
+         if(type == GameRecorderServer::KeyframeRecord)
+         {
+            mKeyframeTimes.push_back(mTotalTime);
+            mKeyframeOffsets.push_back(recordPos);
+         }
       }
-      fseek(mFile, filepos, SEEK_SET);
+
+      mTotalTime += milli;
+
+      if(!mFile.seek(size, SEEK_CUR))
+         break;
    }
 }
 
 
 GameRecorderPlayback::~GameRecorderPlayback()
 {
-   if(mFile)
-      fclose(mFile);
+   mFile.close();
 }
 
 
-bool GameRecorderPlayback::isValid()     { return mFile != NULL; }
+bool GameRecorderPlayback::isValid()     { return mFile.isOpen(); }
 bool GameRecorderPlayback::lostContact() { return false; }
 
 
@@ -203,7 +283,7 @@ void GameRecorderPlayback::updateSpectate()
 
 void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
 {
-   if(!mFile)
+   if(!mFile.isOpen())
    {
       //disconnect(ReasonShutdown, "");
       return;
@@ -228,7 +308,7 @@ void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
          mPacketRecvBytesTotal += mSizeToRead;
          mPacketRecvCount++;
 
-         if(fread(data, 1, mSizeToRead, mFile) == mSizeToRead)
+         if(mFile.read(data, mSizeToRead) == mSizeToRead)
          {
             BitStream bstream(data, mSizeToRead);
             GhostConnection::readPacket(&bstream);
@@ -236,11 +316,31 @@ void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
          mSizeToRead = 0;
       }
 
-      if(fread(data, 1, 3, mFile) != 3)
+      if(mFile.read(data, 3) != 3)
          break; // Could not read 3 bytes
 
       U32 size = (U32(data[1] & 63) << 8) + data[0];
       U32 milli = S32((U32(data[1] >> 6) << 8) + data[2]);
+
+      // Keyframes are only for seeking; when playing straight through, everything in them is already here
+      if(size == GameRecorderServer::RecordMarker)
+      {
+         U8 type;
+         if(!readRecordHeader(mFile, type, size) || type == GameRecorderServer::IndexRecord)
+         {
+            mMilliSeconds = S32_MAX;
+            break;
+         }
+
+         if(!mFile.seek(size, SEEK_CUR))
+         {
+            mMilliSeconds = S32_MAX;
+            break;
+         }
+
+         continue;
+      }
+
       mCurrentTime += milli;
       mMilliSeconds += milli;
 
@@ -260,7 +360,7 @@ void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
 }
 
 
-void GameRecorderPlayback::restart()
+void GameRecorderPlayback::resetState()
 {
    deleteLocalGhosts();
    mMilliSeconds = 0;
@@ -268,9 +368,77 @@ void GameRecorderPlayback::restart()
    mCurrentTime = 0;
    clearRecvEvents();
    mGame->clearClientList();
+}
+
+
+void GameRecorderPlayback::restart()
+{
+   resetState();
 
-   if(mFile)
-      fseek(mFile, 4, SEEK_SET);
+   if(mFile.isOpen())
+      mFile.seek(4, SEEK_SET);
+}
+
+
+// Rebuilds the game from a keyframe, leaving us ready to read the packets that follow it
+bool GameRecorderPlayback::loadKeyframe(S32 index)
+{
+   resetState();
+
+   U8 header[3];
+   U8 type;
+   U32 size;
+
+   if(!mFile.seek(mKeyframeOffsets[index], SEEK_SET) || mFile.read(header, 3) != 3 ||
+         !readRecordHeader(mFile, type, size) || type != GameRecorderServer::KeyframeRecord || size < 6)
+      return false;
+
+   Vector<U8> keyframe(size);
+   keyframe.resize(size);
+
+   if(mFile.read(keyframe.address(), size) != size)
+      return false;
+
+   U32 pos = 4;
+
+   while(pos + 2 <= size)
+   {
+      U32 packetSize = U32(keyframe[pos]) | (U32(keyframe[pos + 1]) << 8);
+      pos += 2;
+
+      if(packetSize == 0 || pos + packetSize > size)
+         break;
+
+      BitStream bstream(&keyframe[pos], packetSize);
+      GhostConnection::readPacket(&bstream);
+      pos += packetSize;
+   }
+
+   // Pick up the regular stream's events where the keyframe left them
+   setNextRecvEventSeq(readU32(&keyframe[0]));
+
+   mCurrentTime = mKeyframeTimes[index];
+
+   return true;
+}
+
+
+// Jumps to the closest keyframe at or before time, if that gets us there sooner, and plays forward from there
+void GameRecorderPlayback::seek(U32 time)
+{
+   S32 keyframe = -1;
+   for(S32 i = 0; i < mKeyframeTimes.size() && mKeyframeTimes[i] <= time; i++)
+      keyframe = i;
+
+   if(keyframe != -1 && (time < mCurrentTime || mKeyframeTimes[keyframe] > mCurrentTime))
+   {
+      if(!loadKeyframe(keyframe))
+         restart();
+   }
+   else if(time < mCurrentTime)
+      restart();
+
+   processMoreData(time - mCurrentTime);
 }
 
 // --------
@@ -516,13 +684,7 @@ bool PlaybackGameUserInterface::onKeyDown(InputCode inputCode)
          if(x2 > 1)
             x2 = 1;
 
-         U32 time = U32(x2 * mPlaybackConnection->mTotalTime);
-
-         // TODO: maybe we need to seek more efficiency by avoiding having to start all over from the beginning
-         if(time < mPlaybackConnection->mCurrentTime)
-            mPlaybackConnection->restart();
-
-         mPlaybackConnection->processMoreData(time - mPlaybackConnection->mCurrentTime);
+         mPlaybackConnection->seek(U32(x2 * mPlaybackConnection->mTotalTime));
          resetRenderState(getGame());
 
          return true;
@@ -7,10 +7,13 @@
 #define _GAMERECORDERPLAYBACK_H_
 
 #include "gameConnection.h"
+#include "RecordingFile.h"
 
 #include "UIMenus.h"
 #include "UIItemListSelectMenu.h"
 
+#include "Test.h"
+
 #include <stdio.h>
 
 namespace Zap 
@@ -26,13 +29,21 @@ class GameRecorderPlayback : public GameConnection
    typedef GameConnection Parent;
 
 private:
-   FILE *mFile;
+   RecordingFileReader mFile;
 
    ClientGame *mGame;
    S32 mMilliSeconds;
    U32 mSizeToRead;
    SafePtr<ClientInfo> mClientInfoSpectating;
 
+   Vector<U32> mKeyframeTimes;
+   Vector<U32> mKeyframeOffsets;    // File position of each keyframe record
+
+   bool readIndex();
+   void scanRecording();
+   void resetState();
+   bool loadKeyframe(S32 index);
+
 public:
    GameRecorderPlayback(ClientGame *game, const char *filename);
    ~GameRecorderPlayback();
@@ -52,6 +63,10 @@ public:
    void updateSpectate();
    void processMoreData(TNL::U32 MilliSeconds);
    void restart();
+   void seek(U32 time);
+
+   // Test access
+   FRIEND_TEST(GameRecorderTest, SeekMatchesLinearPlayback);
 };
 
 
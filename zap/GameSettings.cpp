@@ -598,11 +598,13 @@ string GameSettings::getLevelLoc()
 // Note that game CAN be NULL here.
 LevelSource *GameSettings::chooseLevelSource(Game *game)
 {
-	if(game->getPlaylist() != "")
+   string playlistFile = game ? game->getPlaylist() : getPlaylistFile();
+
+	if(playlistFile != "")
    {
       string levelDir = getFolderManager()->getLevelDir();
 
-      string playlist = checkName(game->getPlaylist(), levelDir, ".playlist");
+      string playlist = checkName(playlistFile, levelDir, ".playlist");
 
       // Create a list of levels for hosting a game from a file, but does not read the files or do any validation of them
       Vector<string> list = PlaylistLevelSource::findAllFilesInPlaylist(playlist, levelDir);
@@ -613,6 +615,63 @@ LevelSource *GameSettings::chooseLevelSource(Game *game)
 }
 
 
+// Names of any extra arenas we should host, from the [Host] Arenas key
+Vector<string> GameSettings::getArenaNames()
+{
+   Vector<string> names;
+   parseString(getSetting<string>(IniKey::Arenas), names, ',');
+
+   Vector<string> arenaNames;
+   for(S32 i = 0; i < names.size(); i++)
+   {
+      string name = trim(names[i]);
+      if(name != "" && !arenaNames.contains(name))
+         arenaNames.push_back(name);
+   }
+
+   return arenaNames;
+}
+
+
+string GameSettings::getArenaSection(const string &arenaName)
+{
+   return "Arena:" + arenaName;
+}
+
+
+// Build the settings for an extra arena.  Arenas start with our INI settings and cmd line, minus anything that
+// identifies a particular server; their own INI section then fills those in, and can override anything else in [Host].
+shared_ptr<GameSettings> GameSettings::createArenaSettings(const string &arenaName)
+{
+   shared_ptr<GameSettings> arenaSettings(new GameSettings());
+   staticSelf = this;      // GameSettings::get() should keep returning the main settings
+
+   static const ParamId perServerParams[] = { 
+      SERVER_PASSWORD, HOST_NAME, HOST_DESCRIPTION, MAX_PLAYERS_PARAM, HOST_ADDRESS, LEVEL_LIST, USE_FILE, LEVEL_DIR 
+   };
+
+   for(S32 i = 0; i < PARAM_COUNT; i++)
+      arenaSettings->mCmdLineParams[i] = mCmdLineParams[i];
+
+   for(U32 i = 0; i < ARRAYSIZE(perServerParams); i++)
+      arenaSettings->mCmdLineParams[perServerParams[i]].clear();
+
+   // Level locations go where the cmd line ones would, so they win out over anything else when the dirs are resolved
+   string levelDir = iniFile.getValue(getArenaSection(arenaName), "LevelDir", "");
+   if(levelDir != "")
+      arenaSettings->mCmdLineParams[LEVEL_DIR].push_back(levelDir);
+
+   string playlist = iniFile.getValue(getArenaSection(arenaName), "Playlist", "");
+   if(playlist != "")
+      arenaSettings->mCmdLineParams[USE_FILE].push_back(playlist);
+
+   arenaSettings->resolveDirs();
+   loadArenaSettingsFromINI(&iniFile, arenaSettings.get(), getArenaSection(arenaName));
+
+   return arenaSettings;
+}
+
+
 LoadoutTracker GameSettings::getLoadoutPreset(S32 index) 
 { 
    TNLAssert(index >= 0 && index < mLoadoutPresets.size(), "Preset index out of range!") ;
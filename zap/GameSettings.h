@@ -274,6 +274,11 @@ public:
 
    LevelSource *chooseLevelSource(Game *game); // determines what levelsource you want to use
 
+   // Extra arenas hosted by a dedicated server
+   Vector<string> getArenaNames();
+   shared_ptr<GameSettings> createArenaSettings(const string &arenaName);
+   static string getArenaSection(const string &arenaName);
+
    LoadoutTracker getLoadoutPreset(S32 index);
    void setLoadoutPreset(const LoadoutTracker *preset, S32 index);
 
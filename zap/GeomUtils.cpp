@@ -461,7 +461,7 @@ bool segmentsColinear(const Point &p1, const Point &p2, const Point &p3, const P
 
 bool pointOnSegment(const Point &c, const Point &a, const Point &b, F32 closeEnough)
 {
-   static Point closest;
+   Point closest;
 
    return c.distSquared(a) < closeEnough || c.distSquared(b) < closeEnough || 
          (findNormalPoint(c, a, b, closest) && c.distSquared(closest) < closeEnough);
@@ -4,7 +4,7 @@
 //------------------------------------------------------------------------------
 
 #include "Level.h"
-
+#include "BotNavRouteTable.h"
 #include "Colors.h"
 #include "EngineeredItem.h"
 #include "game.h"
@@ -49,6 +49,8 @@ namespace Zap
       // Clean up our GameType -- it's a RefPtr, so will be deleted when all refs are removed
       //if(mGameType.isValid() && !mGameType->isGhost())
       //   mGameType.set(NULL);
+
+      delete mBotRouteTable;
    }
 
 
@@ -60,6 +62,7 @@ namespace Zap
       mGame = NULL;
       mTeamManager.reset(new TeamManager(this));    // mTeamManager is a shared_ptr, so cleanup is handled automatically
       mLevelDatabaseId = LevelDatabase::NOT_IN_DATABASE;
+      mBotRouteTable = NULL;
    }
 
 
@@ -106,6 +109,19 @@ namespace Zap
    }
 
 
+   BotNavRouteTable *Level::getBotRouteTable() const
+   {
+      return mBotRouteTable;
+   }
+
+
+   void Level::setBotRouteTable(BotNavRouteTable *routeTable)
+   {
+      delete mBotRouteTable;
+      mBotRouteTable = routeTable;
+   }
+
+
    void Level::beginBatchGeomUpdate()
    {
       mWallEdgeManager.beginBatchGeomUpdate();
@@ -202,6 +218,16 @@ namespace Zap
          first = false;
       }
 
+      // Now that we know how big the level is, fit our spatial databases to it
+      if(GridDatabase::getAdaptiveBucketSizing())
+      {
+         Rect extents = getExtents();
+
+         sizeBucketsToExtents(extents);
+         mBotZoneDatabase.sizeBucketsToExtents(extents);
+         mWallEdgeManager.sizeBucketsToExtents(extents);
+      }
+
       // Build wall edge geometry
       Vector<Point> wallEdgePoints;  // <== not used
       buildWallEdgeGeometry(wallEdgePoints);
@@ -27,6 +27,7 @@ namespace Zap
 {
 
 class BotNavMeshZone;
+class BotNavRouteTable;
 class Game;
 class GameType;
 class PolyWall;
@@ -61,6 +62,7 @@ private:
    // Zone-related
    GridDatabase mBotZoneDatabase;
    Vector<BotNavMeshZone *> mAllZones;
+   BotNavRouteTable *mBotRouteTable;
 
    void initialize();
    void parseLevelLine(const string &line, const string &levelFileName);
@@ -112,6 +114,9 @@ public:
    GridDatabase &getBotZoneDatabase();
    Vector<BotNavMeshZone *> &getBotZoneList();
 
+   BotNavRouteTable *getBotRouteTable() const;
+   void setBotRouteTable(BotNavRouteTable *routeTable);     // We take ownership
+
    string getHash() const;
 
    bool getAddedToGame() const;
@@ -0,0 +1,280 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelPreparer.h"
+
+#include "barrier.h"
+#include "gameType.h"
+#include "GeomUtils.h"
+#include "Level.h"
+#include "ServerGame.h"
+#include "WallItem.h"
+
+#include "Md5Utils.h"
+
+#include <fstream>
+#include <sstream>
+
+
+namespace Zap
+{
+
+// Constructor
+LevelPreparer::WorkerThread::WorkerThread(LevelPreparer *preparer, Job job)
+{
+   mPreparer = preparer;
+   mJob = job;
+}
+
+
+U32 LevelPreparer::WorkerThread::run()
+{
+   LogConsumer::holdMessages(&mPreparer->mHeldMessages);
+
+   if(mJob == ReadFileJob)
+      mPreparer->readFile();
+   else
+      mPreparer->buildZones();
+
+   LogConsumer::holdMessages(NULL);
+
+   mPreparer->mWorkerDone = true;
+   mPreparer->mWorkerExited.increment();
+
+   return 0;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+LevelPreparer::LevelPreparer(S32 levelIndex, const string &filename, U64 sqliteLevelId, bool globalLevelgens,
+                             bool triangulateZones, bool cacheZones, bool usingDatabaseZoneCache)
+{
+   mLevelIndex = levelIndex;
+   mFilename = filename;
+   mSqliteLevelId = sqliteLevelId;
+
+   mBuildZones = !globalLevelgens;
+   mTriangulateZones = triangulateZones;
+   mCacheZones = cacheZones;
+   mUsingDatabaseZoneCache = usingDatabaseZoneCache;
+
+   mStage = ReadingFile;
+   mLevel = NULL;
+
+   mWorker = NULL;
+   mWorkerDone = false;
+
+   mFileRead = false;
+   mZonesBuilt = false;
+   mZoneCreationFailed = false;
+   mZonesFromCache = false;
+}
+
+
+// Destructor
+LevelPreparer::~LevelPreparer()
+{
+   // A worker can't be interrupted, but it won't be long
+   waitForWorker();
+
+   delete mLevel;
+}
+
+
+void LevelPreparer::start()
+{
+   if(!startWorker(ReadFileJob))
+      mStage = Failed;
+}
+
+
+bool LevelPreparer::startWorker(Job job)
+{
+   TNLAssert(!mWorker, "Already have a worker!");
+
+   mWorkerDone = false;
+   mWorker = new WorkerThread(this, job);
+
+   if(mWorker->start())
+      return true;
+
+   logprintf(LogConsumer::LogWarning, "Could not start thread to prepare level %s", mFilename.c_str());
+
+   delete mWorker;
+   mWorker = NULL;
+
+   return false;
+}
+
+
+void LevelPreparer::waitForWorker()
+{
+   if(!mWorker)
+      return;
+
+   mWorkerExited.wait();
+
+   delete mWorker;
+   mWorker = NULL;
+
+   LogConsumer::releaseMessages(mHeldMessages);
+}
+
+
+// Runs on a worker thread
+void LevelPreparer::readFile()
+{
+   ifstream file(mFilename.c_str(), ios_base::in | ios_base::binary);
+
+   if(file.fail())
+      return;
+
+   ostringstream contents;
+   contents << file.rdbuf();
+   mContents = contents.str();
+
+   istringstream stream(mContents);
+   mHash = Md5::getHashFromStream(stream);
+
+   mFileRead = true;
+}
+
+
+// Runs on a worker thread.  Works out the same zones the server would if it had loaded the level itself; see
+// ServerGame::buildBotMeshZones().
+void LevelPreparer::buildZones()
+{
+   // The server turns each wall into a series of Barriers when it adds the level to the game; we make our own, just for
+   // building zones with, the same way Barrier::constructBarriers() does
+   Vector<DatabaseObject *> barriers;
+   Rect extents = mLevel->getExtents();
+
+   const Vector<DatabaseObject *> *wallItems = mLevel->findObjects_fast(WallItemTypeNumber);
+
+   for(S32 i = 0; i < wallItems->size(); i++)
+   {
+      WallItem *wallItem = static_cast<WallItem *>(wallItems->get(i));
+      F32 width = (F32)wallItem->getWidth();
+
+      Vector<Point> barrierEnds;
+      constructBarrierEndPoints(wallItem->getOutline(), width, barrierEnds);
+
+      for(S32 j = 0; j < barrierEnds.size(); j += 2)
+      {
+         Vector<Point> points;
+         points.push_back(barrierEnds[j]);
+         points.push_back(barrierEnds[j + 1]);
+
+         Barrier *barrier = new Barrier(points, width, false);
+         extents.unionRect(barrier->getExtent());      // As they would be in the game's world extents
+         barriers.push_back(barrier);
+      }
+   }
+
+   mZoneCreationFailed = !ServerGame::buildBotMeshZones(mLevel, &extents, barriers, mTriangulateZones, mCacheZones,
+                                                        mUsingDatabaseZoneCache, mZonesFromCache);
+   mZonesBuilt = true;
+
+   barriers.deleteAndClear();
+}
+
+
+// Main thread -- turn the file into a Level, and get the zones started if we're doing them
+void LevelPreparer::onFileRead()
+{
+   if(!mFileRead)
+   {
+      mStage = Failed;
+      return;
+   }
+
+   mLevel = new Level();
+
+   istringstream stream(mContents);
+   mLevel->loadLevelFromStream(stream, mFilename, mHash, mSqliteLevelId);
+   mContents.clear();
+
+   // Levelgens could change the geometry once the level is in play, so their zones have to wait until then
+   if(mBuildZones && mLevel->getGameType()->getScriptName() == "" && startWorker(BuildZonesJob))
+      mStage = BuildingZones;
+   else
+      mStage = Ready;
+}
+
+
+void LevelPreparer::advance(bool wait)
+{
+   while(mStage == ReadingFile || mStage == BuildingZones)
+   {
+      if(!wait && !mWorkerDone)
+         return;
+
+      waitForWorker();
+
+      if(mStage == ReadingFile)
+         onFileRead();
+      else
+         mStage = Ready;
+   }
+}
+
+
+void LevelPreparer::idle()
+{
+   advance(false);
+}
+
+
+S32 LevelPreparer::getLevelIndex() const
+{
+   return mLevelIndex;
+}
+
+
+const string &LevelPreparer::getFilename() const
+{
+   return mFilename;
+}
+
+
+LevelPreparer::Stage LevelPreparer::getStage() const
+{
+   return mStage;
+}
+
+
+Level *LevelPreparer::takeLevel()
+{
+   advance(true);
+
+   Level *level = mLevel;
+   mLevel = NULL;
+
+   return level;
+}
+
+
+bool LevelPreparer::hasBotZones() const
+{
+   return mZonesBuilt;
+}
+
+
+bool LevelPreparer::getZoneCreationFailed() const
+{
+   return mZoneCreationFailed;
+}
+
+
+bool LevelPreparer::getZonesFromCache() const
+{
+   return mZonesFromCache;
+}
+
+
+} /* namespace Zap */
@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _LEVEL_PREPARER_H_
+#define _LEVEL_PREPARER_H_
+
+#include "tnlLog.h"
+#include "tnlThread.h"
+#include "tnlTypes.h"
+
+#include <atomic>
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+class Level;
+
+// Gets the next level ready while the current one is still being played, so that switching to it is mostly a matter of
+// handing over the Level.  The level file is read and hashed on a worker thread.  The main thread then turns it into a
+// Level -- objects, wall edges, snapped turrets and such -- since creating objects touches things that are shared with
+// the game in progress.  Then, for levels without levelgens, a worker builds the bot zones and route table, by far the
+// slowest part of a level change on levels that aren't in the zone cache.
+//
+// Nothing but the worker touches the Level while it's working, and the worker's log messages are held until the main
+// thread picks them up, so the worker never has to share anything with the game.
+class LevelPreparer
+{
+public:
+   enum Stage {
+      ReadingFile,
+      BuildingZones,
+      Ready,
+      Failed
+   };
+
+private:
+   enum Job {
+      ReadFileJob,
+      BuildZonesJob
+   };
+
+   class WorkerThread : public Thread
+   {
+   private:
+      LevelPreparer *mPreparer;
+      Job mJob;
+
+   public:
+      WorkerThread(LevelPreparer *preparer, Job job);
+      U32 run();
+   };
+
+   S32 mLevelIndex;
+   string mFilename;
+   U64 mSqliteLevelId;
+
+   // How to build zones; mirrors what ServerGame does for levels it loads itself
+   bool mBuildZones;
+   bool mTriangulateZones;
+   bool mCacheZones;
+   bool mUsingDatabaseZoneCache;
+
+   Stage mStage;
+   Level *mLevel;
+
+   WorkerThread *mWorker;
+   std::atomic<bool> mWorkerDone;
+   Semaphore mWorkerExited;
+   LogConsumer::HeldMessages mHeldMessages;
+
+   // Results from the workers
+   string mContents;
+   string mHash;
+   bool mFileRead;
+   bool mZonesBuilt;
+   bool mZoneCreationFailed;
+   bool mZonesFromCache;
+
+   void readFile();
+   void buildZones();
+
+   bool startWorker(Job job);
+   void waitForWorker();
+   void onFileRead();
+   void advance(bool wait);
+
+public:
+   LevelPreparer(S32 levelIndex, const string &filename, U64 sqliteLevelId, bool globalLevelgens,
+                 bool triangulateZones, bool cacheZones, bool usingDatabaseZoneCache);    // Constructor
+   virtual ~LevelPreparer();                                                              // Destructor
+
+   void start();
+   void idle();      // Moves things along when a worker is done; never waits
+
+   S32 getLevelIndex() const;
+   const string &getFilename() const;
+   Stage getStage() const;
+
+   // Waits for whatever is left to do, then gives the Level to the caller, who is now responsible for deleting it.  Returns
+   // NULL if the level couldn't be prepared.
+   Level *takeLevel();
+
+   bool hasBotZones() const;           // True if the Level we handed over already has its zones
+   bool getZoneCreationFailed() const;
+   bool getZonesFromCache() const;
+};
+
+
+} /* namespace Zap */
+#endif
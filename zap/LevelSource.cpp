@@ -405,6 +405,13 @@ string LevelSource::getLevelFileName(S32 index)
 }
 
 
+// Full path of the file the level will be loaded from; "" if the level doesn't come from a file we can get at
+string LevelSource::findLevelFile(S32 index) const
+{
+   return "";
+}
+
+
 void LevelSource::setLevelFileName(S32 index, const string &filename)
 {
    mLevelInfos[index].filename = filename;
@@ -500,7 +507,7 @@ Level *MultiLevelSource::getLevel(S32 index) const
 
    const LevelInfo &levelInfo = mLevelInfos[index];
 
-   string filename = FolderManager::findLevelFile(levelInfo.folder, levelInfo.filename);
+   string filename = findLevelFile(index);
 
    if(filename == "")
    {
@@ -521,6 +528,13 @@ Level *MultiLevelSource::getLevel(S32 index) const
 }
 
 
+// Returns the full path of the level's file, or "" if it can't be found
+string MultiLevelSource::findLevelFile(S32 index) const
+{
+   return FolderManager::findLevelFile(mLevelInfos[index].folder, mLevelInfos[index].filename);
+}
+
+
 // Returns a textual level descriptor good for logging and error messages and such
 string MultiLevelSource::getLevelFileDescriptor(S32 index) const
 {
@@ -730,32 +744,12 @@ PlaylistLevelSource::~PlaylistLevelSource()
 
 
 // Load specified level, put results in gameObjectDatabase
-Level *PlaylistLevelSource::getLevel(S32 index) const
+// Playlists find their levels in the level folder; MultiLevelSource::getLevel() does the rest
+string PlaylistLevelSource::findLevelFile(S32 index) const
 {
-   TNLAssert(index >= 0 && index < mLevelInfos.size(), "Index out of bounds!");
-
-   const LevelInfo *levelInfo = &mLevelInfos[index];
-
    FolderManager *folderManager = mGameSettings->getFolderManager();
 
-   string filename = folderManager->findLevelFile(folderManager->getLevelDir(), levelInfo->filename);
-
-   if(filename == "")
-   {
-      logprintf("Unable to find level file \"%s\".  Skipping...", levelInfo->filename.c_str());
-      return NULL;
-   }
-
-   Level *level = new Level();      // Will be deleted by caller
-
-   if(!level->loadLevelFromFile(filename, levelInfo->getSqliteLevelId()))
-   {
-      logprintf("Unable to process level file \"%s\".  Skipping...", levelInfo->filename.c_str());
-      delete level;
-      return NULL;
-   }
-
-   return level;
+   return folderManager->findLevelFile(folderManager->getLevelDir(), mLevelInfos[index].filename);
 }
 
 
@@ -816,6 +810,13 @@ Level *TestPlaylistLevelSource::getLevel(S32 index) const
 }
 
 
+// Our levels aren't in files
+string TestPlaylistLevelSource::findLevelFile(S32 index) const
+{
+   return "";
+}
+
+
 bool TestPlaylistLevelSource::isEmptyLevelDirOk() const
 {
    return true;      // No folder needed -- we're testing!
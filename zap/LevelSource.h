@@ -119,6 +119,7 @@ public:
    virtual bool populateLevelInfoFromSourceByIndex(S32 levelInfoIndex);
 
    virtual Level *getLevel(S32 index) const = 0;
+   virtual string findLevelFile(S32 index) const;
    virtual bool loadLevels(FolderManager *folderManager);
    virtual string getLevelFileDescriptor(S32 index) const = 0;
    virtual bool isEmptyLevelDirOk() const = 0;
@@ -147,6 +148,7 @@ public:
 
    bool loadLevels(FolderManager *folderManager);
    Level *getLevel(S32 index) const;
+   string findLevelFile(S32 index) const;
    string getLevelFileDescriptor(S32 index) const;
    virtual bool isEmptyLevelDirOk() const;
 
@@ -184,7 +186,7 @@ public:
    PlaylistLevelSource(const Vector<string> &levelList, const string &folder, GameSettings *settings);     // Constructor
    virtual ~PlaylistLevelSource();                                                                                                                // Destructor
 
-   virtual Level *getLevel(S32 index) const;
+   virtual string findLevelFile(S32 index) const;
 
    static Vector<string> findAllFilesInPlaylist(const string &fileName, const string &levelDir);
 };
@@ -202,6 +204,7 @@ public:
    TestPlaylistLevelSource(const Vector<string> &levelList, GameSettings *settings);     // Constructor
 
    Level *getLevel(S32 index) const;
+   string findLevelFile(S32 index) const;
    bool isEmptyLevelDirOk() const;
 };
 
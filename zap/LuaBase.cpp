@@ -807,6 +807,39 @@ S32 returnPoints(lua_State *L, const Vector<Point> *points)
 }
 
 
+// A script that searches every tick can pass in a table for the results, and we'll fill that, rather than make it a new
+// one each time.  If the stack holds such a table, we'll use it, otherwise we add a new one.  Either way, the table ends
+// up at index 1, ready for lua_rawseti(L, 1, ...).
+void prepareResultTable(lua_State *L, S32 sizeHint)
+{
+   if(lua_gettop(L) > 0 && lua_istable(L, -1))
+   {
+      TNLAssert(lua_gettop(L) == 1 || dumpStack(L), "Should only have table!");
+      return;
+   }
+
+   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack not cleared!");
+
+   lua_createtable(L, sizeHint, 0);       // Create a table, with enough slots pre-allocated for our data
+}
+
+
+// Returns the table from prepareResultTable(), now holding count results.  A table that has been used before may have
+// more than that in it, so we clear whatever is left over from last time.
+S32 returnResultTable(lua_State *L, S32 count)
+{
+   for(S32 i = (S32)lua_objlen(L, 1); i > count; i--)
+   {
+      lua_pushnil(L);
+      lua_rawseti(L, 1, i);
+   }
+
+   TNLAssert(lua_gettop(L) == 1 || dumpStack(L), "Stack has unexpected items on it!");
+
+   return 1;
+}
+
+
 S32 returnPolygons(lua_State *L, const Vector<Vector<Point> > &polys)
 {
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack not clean!");
@@ -1027,4 +1060,115 @@ void setScriptContext(lua_State *L, ScriptContext context)
    lua_setfield(L, LUA_REGISTRYINDEX, SCRIPT_CONTEXT_KEY);     // Pops the int we just pushed from the stack
 }
 
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Declare and Initialize statics:
+Mutex LuaWorldLock::mMutex;
+ThreadStorage LuaWorldLock::mDepth;
+ThreadStorage LuaWorldLock::mThinker;
+bool LuaWorldLock::mEnabled = false;
+
+
+// Constructor
+LuaWorldLock::LuaWorldLock()
+{
+   mLocked = mEnabled;
+
+   if(mLocked)
+      lock();
+}
+
+
+// Destructor
+LuaWorldLock::~LuaWorldLock()
+{
+   if(mLocked)
+      unlock();
+}
+
+
+void LuaWorldLock::lock()
+{
+   mMutex.lock();
+   mDepth.set((void *)((size_t)mDepth.get() + 1));
+}
+
+
+void LuaWorldLock::unlock()
+{
+   mDepth.set((void *)((size_t)mDepth.get() - 1));
+   mMutex.unlock();
+}
+
+
+void LuaWorldLock::setEnabled(bool enabled)
+{
+   mEnabled = enabled;
+}
+
+
+bool LuaWorldLock::isEnabled()
+{
+   return mEnabled;
+}
+
+
+// luaL_error() longjmps (or, depending on how LuaJIT was built, unwinds) back to the nearest lua_pcall(), so any lock taken
+// by the C++ function that raised it may still be held.  Our Mutex is recursive, so that's harmless until the thread is
+// done running Lua; call this then.
+void LuaWorldLock::releaseAll()
+{
+   while(mDepth.get())
+      unlock();
+}
+
+
+void LuaWorldLock::setThinker(S32 index)
+{
+   mThinker.set((void *)size_t(index + 1));
+}
+
+
+S32 LuaWorldLock::getThinker()
+{
+   return S32((size_t)mThinker.get()) - 1;
+}
+
+
+// Saves function and everything on the stack (the object it was called on, then its args) in a list in L's registry.  We
+// hold the LuaWorldLock, but L belongs to the bot running on this thread, so nobody else is using it.
+void LuaWorldLock::deferCall(lua_State *L, lua_CFunction function)
+{
+   S32 args = lua_gettop(L);                                // -- <<args>>
+
+   lua_getfield(L, LUA_REGISTRYINDEX, DEFERRED_CALLS_KEY);  // -- <<args>>, calls
+
+   if(!lua_istable(L, -1))
+   {
+      lua_pop(L, 1);                                        // -- <<args>>
+      lua_newtable(L);                                      // -- <<args>>, calls
+      lua_pushvalue(L, -1);                                 // -- <<args>>, calls, calls
+      lua_setfield(L, LUA_REGISTRYINDEX, DEFERRED_CALLS_KEY);  // -- <<args>>, calls
+   }
+
+   lua_createtable(L, args + 1, 1);                         // -- <<args>>, calls, call
+
+   lua_pushcfunction(L, function);                          // -- <<args>>, calls, call, function
+   lua_rawseti(L, -2, 1);                                   // -- <<args>>, calls, call
+
+   for(S32 i = 1; i <= args; i++)
+   {
+      lua_pushvalue(L, i);                                  // -- <<args>>, calls, call, arg
+      lua_rawseti(L, -2, i + 1);                            // -- <<args>>, calls, call
+   }
+
+   lua_pushinteger(L, args);                                // Args can be nil, so the table can't tell us how many
+   lua_setfield(L, -2, "n");
+
+   lua_rawseti(L, -2, (S32)lua_objlen(L, -2) + 1);          // -- <<args>>, calls
+   lua_settop(L, 0);                                        // --
+}
+
 };
@@ -10,6 +10,7 @@
 #include "LuaException.h"     // LuaException def
 
 #include "Point.h"
+#include "tnlThread.h"
 #include "tnlTypes.h"
 #include "tnlVector.h"
 
@@ -147,6 +148,10 @@ S32 returnNil(lua_State *L);
 S32 returnPoint(lua_State *L, const Point &point);
 S32 returnPoints(lua_State *L, const Vector<Point> *);
 S32 returnPolygons(lua_State *L, const Vector<Vector<Point> > &polys);
+
+// For searches: the results go into the table the script passed in, if there is one, otherwise a new one
+void prepareResultTable(lua_State *L, S32 sizeHint);
+S32 returnResultTable(lua_State *L, S32 count);
 S32 returnMenuItem(lua_State *L, MenuItem *menuItem);
 S32 returnShip(lua_State *L, Ship *ship);                // Handles null references properly
 S32 returnTeam(lua_State *L, Team *team);
@@ -209,6 +214,54 @@ string prettyPrintParamList(const LuaFunctionArgList &functionInfo);
 bool dumpTable(lua_State *L, S32 tableIndex, const char *msg = "");
 bool dumpStack(lua_State* L, const char *msg = "");
 
+
+// Every binding says, in its class's LUA_METHODS table, whether it changes the world -- anything other bots could see.
+// A bot steering its own ship reads the world only; nobody looks at a bot's move until everyone is done thinking.
+enum LuaMethodEffect
+{
+   ReadsWorld,
+   ChangesWorld
+};
+
+
+// While bots think in parallel (see RobotManager::think()), every call from Lua into C++ holds this lock, so only
+// one thread at a time touches the game or the shared Lua state.  Plain Lua code runs without it.  The rest of the
+// time the lock is disabled, and taking it costs no more than checking a flag.
+class LuaWorldLock
+{
+private:
+   static Mutex mMutex;
+   static ThreadStorage mDepth;     // How many times this thread holds mMutex
+   static ThreadStorage mThinker;   // Index + 1 of the bot this thread is thinking for, or 0
+   static bool mEnabled;
+
+   bool mLocked;
+
+   static void lock();
+   static void unlock();
+
+public:
+   LuaWorldLock();      // Constructor -- takes the lock, if enabled
+   ~LuaWorldLock();     // Destructor -- releases it
+
+   // Only change this from the main thread, while no other thread is running Lua
+   static void setEnabled(bool enabled);
+   static bool isEnabled();
+
+   // An error raised from Lua may skip our destructor; this drops whatever the current thread still holds
+   static void releaseAll();
+
+   // Which bot, by its place in RobotManager's list of thinkers, the current thread is thinking for; -1 if none
+   static void setThinker(S32 index);
+   static S32 getThinker();
+
+   // While bots think, a ChangesWorld call is not made, but saved with its arguments in the calling bot's Lua state, to be
+   // made for real on the main thread once all bots are done; see LuaScriptRunner::runDeferredCalls()
+   static void deferCall(lua_State *L, lua_CFunction function);
+};
+
+#define DEFERRED_CALLS_KEY "deferred_calls"
+
 static const int MAX_PROFILE_ARGS = 6;          // Max used so far = 3
 static const int MAX_PROFILES = 4;              // Max used so far = 2
 
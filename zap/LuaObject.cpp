@@ -54,9 +54,9 @@ LuaObject::~LuaObject()
 }
 
 
-void LuaObject::trackThisItem()
+// L is the state of the script creating the object, which isn't always the shared one
+void LuaObject::trackThisItem(lua_State *L)
 {
-   lua_State *L = LuaScriptRunner::getL();
    string scriptId = LuaScriptRunner::getScriptId(L);
 
    mScriptId = scriptId;
@@ -26,7 +26,7 @@ public:
    LuaObject();            // Constructor
    virtual ~LuaObject();   // Destructor
 
-   void trackThisItem();
+   void trackThisItem(lua_State *L);
    void untrackThisItem();
    static void eraseAllPotentiallyUntrackedObjects(const string &scriptId);
    
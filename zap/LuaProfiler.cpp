@@ -0,0 +1,294 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LuaProfiler.h"
+
+#ifdef LUA_JITLIBNAME     // Only LuaJIT has a JIT compiler to turn off
+extern "C" {
+#  include <luajit.h>
+}
+#endif
+
+#include "stringUtils.h"
+
+#include "tnlPlatform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+namespace Zap
+{
+
+ThreadStorage LuaProfiler::mCurrent;
+
+static const S32 MaxStackDepth = 64;
+
+
+// Constructor
+LuaProfiler::LuaProfiler()
+{
+   mLastSample = 0;
+   mDepth = 0;
+}
+
+
+// Destructor
+LuaProfiler::~LuaProfiler()
+{
+   // Do nothing
+}
+
+
+LuaProfiler *LuaProfiler::getCurrent()
+{
+   return (LuaProfiler *)mCurrent.get();
+}
+
+
+void LuaProfiler::setCurrent(LuaProfiler *profiler)
+{
+   mCurrent.set(profiler);
+}
+
+
+// Profiling a script in a state turns the JIT compiler off for the whole state, so everything in it runs slower; turn it back
+// on once there's nothing left to profile there
+void LuaProfiler::setJitEnabled(lua_State *L, bool enabled)
+{
+#ifdef LUA_JITLIBNAME
+   if(!enabled)
+      luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_FLUSH);     // Compiled code would otherwise go on running
+
+   luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | (enabled ? LUAJIT_MODE_ON : LUAJIT_MODE_OFF));
+#endif
+}
+
+
+// Something like "getWaypoint@s_bot.bot:112" for a Lua function, or "Robot:getWaypoint" for a C++ one
+static string getFrameName(const lua_Debug &ar, const char *className, const char *defaultName)
+{
+   string name = ar.name ? ar.name : defaultName ? defaultName : "?";
+
+   if(strcmp(ar.what, "C") == 0)
+      return className ? string(className) + ":" + name : name;
+
+   string file = extractFilename(ar.short_src);
+
+   if(strcmp(ar.what, "main") == 0)
+      return "(main chunk)@" + file;
+
+   return name + "@" + file + ":" + itos(ar.linedefined);
+}
+
+
+// The stack of functions running in L, outermost first, separated by semicolons.  firstLevel is the innermost one wanted; 0
+// is the function running right now.  If that's a C++ method, className says whose.
+string LuaProfiler::getStack(lua_State *L, S32 firstLevel, const char *className) const
+{
+   Vector<lua_Debug> levels;
+   lua_Debug ar;
+
+   for(S32 level = firstLevel; level < firstLevel + MaxStackDepth && lua_getstack(L, level, &ar); level++)
+   {
+      lua_getinfo(L, "Sn", &ar);
+      levels.push_back(ar);
+   }
+
+   // The outermost function was called by us, not by Lua, so we know its name better than Lua does
+   bool complete = !lua_getstack(L, firstLevel + levels.size(), &ar);
+   const char *outermostName = complete && mCallNames.size() > 0 ? mCallNames[0] : NULL;
+
+   Vector<string> frames;
+
+   for(S32 i = 0; i < levels.size(); i++)
+      frames.push_back(getFrameName(levels[i], i == 0 ? className : NULL, i == levels.size() - 1 ? outermostName : NULL));
+
+   string stack;
+
+   for(S32 i = frames.size() - 1; i >= 0; i--)
+   {
+      // Semicolons separate the frames; make sure there are no others
+      for(U32 j = 0; j < frames[i].length(); j++)
+         if(frames[i][j] == ';')
+            frames[i][j] = ':';
+
+      stack += frames[i];
+
+      if(i > 0)
+         stack += ";";
+   }
+
+   return stack;
+}
+
+
+void LuaProfiler::charge(const string &stack, S64 now)
+{
+   mStacks[stack] += now - mLastSample;
+   mLastSample = now;
+}
+
+
+void LuaProfiler::beginCall(const char *function)
+{
+   mCallNames.push_back(function);
+
+   // A nested call is already covered by the one it's nested in
+   if(mDepth++ == 0)
+      mLastSample = Platform::getHighPrecisionTimerValue();
+}
+
+
+void LuaProfiler::endCall()
+{
+   mCallNames.pop_back();
+
+   // Whatever ran since the last sample is lost; it's never more than a few instructions' worth, or the tail end of a
+   // method that raised an error
+   if(--mDepth == 0)
+      mBindings.clear();
+}
+
+
+// Called from the instruction hook, so we're always in Lua code here
+void LuaProfiler::sample(lua_State *L)
+{
+   charge(getStack(L, 0), Platform::getHighPrecisionTimerValue());
+}
+
+
+void LuaProfiler::enterBinding(lua_State *L, const char *className)
+{
+   // Time up to now was spent by whoever called us
+   charge(getStack(L, 1), Platform::getHighPrecisionTimerValue());
+   mBindings.push_back(getStack(L, 0, className));
+}
+
+
+void LuaProfiler::exitBinding()
+{
+   if(mBindings.size() == 0)
+      return;
+
+   charge(mBindings.last(), Platform::getHighPrecisionTimerValue());
+   mBindings.pop_back();
+}
+
+
+F64 LuaProfiler::getTotalTime() const
+{
+   S64 total = 0;
+
+   for(map<string, S64>::const_iterator it = mStacks.begin(); it != mStacks.end(); it++)
+      total += it->second;
+
+   return Platform::getHighPrecisionMilliseconds(total);
+}
+
+
+struct FunctionTime
+{
+   string name;
+   S64 self;      // Time running the function itself
+   S64 total;     // Time running it and everything it called
+
+   FunctionTime() { self = 0; total = 0; }
+};
+
+
+static bool selfTimeCompare(const FunctionTime &a, const FunctionTime &b)
+{
+   return a.self > b.self;
+}
+
+
+void LuaProfiler::getFlatProfile(Vector<string> &lines) const
+{
+   map<string, FunctionTime> functions;
+
+   for(map<string, S64>::const_iterator it = mStacks.begin(); it != mStacks.end(); it++)
+   {
+      Vector<string> frames;
+      parseString(it->first, frames, ';');
+
+      // Recursive functions appear more than once in a stack, but the time only counts once towards their total
+      map<string, bool> seen;
+
+      for(S32 i = 0; i < frames.size(); i++)
+      {
+         FunctionTime &function = functions[frames[i]];
+         function.name = frames[i];
+
+         if(!seen[frames[i]])
+            function.total += it->second;
+
+         seen[frames[i]] = true;
+
+         if(i == frames.size() - 1)
+            function.self += it->second;
+      }
+   }
+
+   Vector<FunctionTime> sorted;
+
+   for(map<string, FunctionTime>::const_iterator it = functions.begin(); it != functions.end(); it++)
+      sorted.push_back(it->second);
+
+   sorted.sort(selfTimeCompare);
+
+   for(S32 i = 0; i < sorted.size(); i++)
+   {
+      char line[64];
+      snprintf(line, sizeof(line), "%8.2f ms self %8.2f ms total  ", Platform::getHighPrecisionMilliseconds(sorted[i].self),
+               Platform::getHighPrecisionMilliseconds(sorted[i].total));
+
+      lines.push_back(line + sorted[i].name);
+   }
+}
+
+
+bool LuaProfiler::writeFoldedStacks(const string &filename) const
+{
+   FILE *f = fopen(filename.c_str(), "w");
+
+   if(!f)
+      return false;
+
+   for(map<string, S64>::const_iterator it = mStacks.begin(); it != mStacks.end(); it++)
+   {
+      S64 microseconds = S64(Platform::getHighPrecisionMilliseconds(it->second) * 1000);
+
+      if(microseconds > 0)
+         fprintf(f, "%s %lld\n", it->first.c_str(), (long long)microseconds);
+   }
+
+   fclose(f);
+   return true;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+LuaProfiler::BindingCall::BindingCall(lua_State *L, const char *className)
+{
+   mProfiler = getCurrent();
+
+   if(mProfiler)
+      mProfiler->enterBinding(L, className);
+}
+
+
+// Destructor
+LuaProfiler::BindingCall::~BindingCall()
+{
+   if(mProfiler)
+      mProfiler->exitBinding();
+}
+
+
+} /* namespace Zap */
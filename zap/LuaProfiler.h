@@ -0,0 +1,80 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _LUA_PROFILER_H_
+#define _LUA_PROFILER_H_
+
+#include "LuaInc.h"
+
+#include "tnlThread.h"
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <map>
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+// Works out where a script spends its time.  While a profiled script runs, LuaScriptRunner's instruction hook calls sample()
+// every so often, and each call into C++ goes through a BindingCall; either way, the time since the last of these is charged
+// to the Lua stack as it stands, with the C++ method at the top if we were in one.  So every millisecond the script runs is
+// counted once, against the functions that were running at the time.
+//
+// LuaJIT doesn't run hooks in compiled code, so profiled scripts need to run in the interpreter; see setJitEnabled().
+class LuaProfiler
+{
+private:
+   static ThreadStorage mCurrent;      // The profiler of the script running on this thread, if it is being profiled
+
+   map<string, S64> mStacks;           // Time spent in each stack, "outer;inner;innermost" to timer ticks
+   Vector<string> mBindings;           // Stacks of the C++ methods we're in the middle of
+   Vector<const char *> mCallNames;    // Functions we were asked to call, outermost first; Lua can't name them itself
+   S64 mLastSample;
+   S32 mDepth;                         // Calls into the script we're in the middle of
+
+   void charge(const string &stack, S64 now);
+
+public:
+   LuaProfiler();             // Constructor
+   virtual ~LuaProfiler();    // Destructor
+
+   static LuaProfiler *getCurrent();
+   static void setCurrent(LuaProfiler *profiler);
+
+   static void setJitEnabled(lua_State *L, bool enabled);
+
+   string getStack(lua_State *L, S32 firstLevel, const char *className = NULL) const;
+
+   void beginCall(const char *function);
+   void endCall();
+   void sample(lua_State *L);
+
+   void enterBinding(lua_State *L, const char *className);
+   void exitBinding();
+
+   F64 getTotalTime() const;                                // ms
+   void getFlatProfile(Vector<string> &lines) const;        // Busiest function first
+   bool writeFoldedStacks(const string &filename) const;    // In the format flame graph tools read, with times in microseconds
+
+
+   // Put one of these at the top of a C++ method called from Lua, and its time will be charged to it
+   class BindingCall
+   {
+   private:
+      LuaProfiler *mProfiler;
+
+   public:
+      BindingCall(lua_State *L, const char *className);     // Constructor
+      ~BindingCall();                                       // Destructor
+   };
+};
+
+
+} /* namespace Zap */
+#endif
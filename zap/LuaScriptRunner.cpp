@@ -26,6 +26,7 @@
 
 #include "tnlLog.h"            // For logprintf
 #include "tnlAssert.h"
+#include "tnlPlatform.h"
 
 #include <sstream>             // For enum code
 #include <string>
@@ -42,11 +43,16 @@ lua_State *LuaScriptRunner::L = NULL;
 string LuaScriptRunner::mScriptingDir;
 
 deque<string> LuaScriptRunner::mCachedScripts;
+map<string, string> LuaScriptRunner::mBytecode;
+Vector<LuaScriptRunner *> LuaScriptRunner::mRunners;
+Mutex LuaScriptRunner::mRunnersMutex;
 
 void LuaScriptRunner::clearScriptCache()
 {
 	while(mCachedScripts.size() != 0)
 		mCachedScripts.pop_front();
+
+   mBytecode.clear();
 }
 
 
@@ -57,14 +63,31 @@ LuaScriptRunner::LuaScriptRunner()
    mLuaGame = NULL;
    mLevel = NULL;
 
-   static U32 mNextScriptId = 0;
+   static U32 mNextScriptId = 0;   // Guarded by mRunnersMutex
 
    // Initialize all subscriptions to unsubscribed -- bits will automatically subscribe to onTick later
    for(S32 i = 0; i < EventManager::EventTypes; i++)
       mSubscriptions[i] = false;
 
+   mRunnersMutex.lock();
    mScriptId = "script" + itos(mNextScriptId++);
+   mRunners.push_back(this);
+   mRunnersMutex.unlock();
+
    mScriptType = ScriptTypeInvalid;
+   mLuaState = NULL;
+
+   mCpuTime = 0;
+   mTickCpuTime = 0;
+   mThrottleDebt = 0;
+   mInstructions = 0;
+   mCalls = 0;
+   mTicksRun = 0;
+   mTicksSkipped = 0;
+   mThrottled = false;
+   mThrottleLogged = false;
+   mTicking = false;
+   mProfiler = NULL;
 
    LUAW_CONSTRUCTOR_INITIALIZATIONS;
 }
@@ -87,9 +110,20 @@ LuaScriptRunner::~LuaScriptRunner()
    LuaObject::eraseAllPotentiallyUntrackedObjects(scriptId);
 
    // And delete the script's environment table from the Lua instance
-   deleteScript(scriptId);
+   if(!mLuaState)
+      deleteScript(scriptId);
 
    LUAW_DESTRUCTOR_CLEANUP;
+
+   // Closing our own state collects everything in it, which releases our proxies, so it must come after the cleanup above
+   if(mLuaState)
+      lua_close(mLuaState);
+
+   mRunnersMutex.lock();
+   mRunners.erase_fast(mRunners.getIndex(this));
+   mRunnersMutex.unlock();
+
+   delete mProfiler;
 }
 
 
@@ -103,6 +137,44 @@ lua_State *LuaScriptRunner::getL()
 }
 
 
+lua_State *LuaScriptRunner::getLuaState() const
+{
+   return mLuaState ? mLuaState : L;
+}
+
+
+bool LuaScriptRunner::hasOwnLuaState() const
+{
+   return mLuaState != NULL;
+}
+
+
+// Normally every script runs in L.  A script given a state of its own here is isolated from all the others, so it can run
+// on a thread of its own (see RobotManager::think()).  The state is built from the same cached bytecode as everyone else's,
+// so this is cheap, and it goes away along with the script.
+bool LuaScriptRunner::createLuaState()
+{
+   TNLAssert(!mLuaState, "Already have a Lua state!");
+
+   lua_State *L = lua_open();
+
+   if(!L)
+   {
+      logprintf(LogConsumer::LogError, "%s Could not create a Lua state for %s", getErrorMessagePrefix(), mScriptName.c_str());
+      return false;
+   }
+
+   if(!configureNewLuaInstance(L))
+   {
+      lua_close(L);
+      return false;
+   }
+
+   mLuaState = L;
+   return true;
+}
+
+
 Game *LuaScriptRunner::getLuaGame() const
 {
    return mLuaGame;
@@ -129,6 +201,8 @@ const char *LuaScriptRunner::getScriptId()
 // Return false if there was an error, true if not
 bool LuaScriptRunner::runScript(bool cacheScript)
 {
+   lua_State *L = getLuaState();
+
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
    return prepareEnvironment() && loadScript(cacheScript) && runMain();
@@ -142,6 +216,8 @@ static const char *LUA_SCRIPTIDKEY = "__ScriptId__";
 // Starts with a function on the stack
 void LuaScriptRunner::setEnvironment()
 {               
+   lua_State *L = getLuaState();
+
    // Grab the script's environment table from the registry, place it on the stack
    lua_getfield(L, LUA_REGISTRYINDEX, getScriptId());    // Push REGISTRY[scriptId] onto stack           -- function, table
 
@@ -199,6 +275,8 @@ bool LuaScriptRunner::loadAndRunGlobalFunction(lua_State *L, const char *key, Sc
 // This function can safely throw errors.
 void LuaScriptRunner::pushStackTracer()
 {
+   lua_State *L = getLuaState();
+
    // _stackTracer is a function included in lua_helper_functions that manages the stack trace; it should ALWAYS be present.
    if(!loadFunction(L, getScriptId(), "_stackTracer"))
       throw LuaException("Method _stackTracer() could not be found!\n"
@@ -209,8 +287,10 @@ void LuaScriptRunner::pushStackTracer()
 // Use this method to load an external script directly into the currently running script's
 // environment.  This loaded script will be cleared when the parent script terminates
 bool LuaScriptRunner::loadCompileRunEnvironmentScript(const string &scriptName) {
+   lua_State *L = getLuaState();
+
    // The timer is loaded in each script
-   loadCompileScript(joindir(mScriptingDir, scriptName).c_str());
+   loadCompileCachedScript(L, joindir(mScriptingDir, scriptName).c_str());
    setEnvironment();
 
    S32 err = lua_pcall(L, 0, 0, 0);
@@ -243,6 +323,8 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
    // from the editor.  In that case, we'll want to see script changes take place immediately, and we're willing to pay a small
    // performance penalty on level load to get that.
 
+   lua_State *L = getLuaState();
+
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
    try
@@ -250,7 +332,9 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
       pushStackTracer();            // -- _stackTracer
 
       if(!cacheScript)
-         loadCompileScript(mScriptName.c_str());
+         loadCompileScript(L, mScriptName.c_str());
+      else if(mLuaState)            // Our state is brand new, so there's nothing in its registry; use the shared bytecode
+         loadCompileCachedScript(L, mScriptName.c_str());
       else  
       {
          bool found = false;
@@ -274,7 +358,7 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
             }
 
             // Load new script into cache using full name as registry key
-            loadCompileSaveScript(mScriptName.c_str(), mScriptName.c_str());
+            loadCompileSaveScript(L, mScriptName.c_str(), mScriptName.c_str());
             mCachedScripts.push_back(mScriptName);
          }
 
@@ -291,7 +375,7 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
       // The script has been compiled, and the result is sitting on the stack.  The next step is to run it; this executes all the 
       // "loose" code and loads the functions into the current environment.  It does not directly execute any of the functions.
       // Any errors are handed off to the stack tracer we pushed onto the stack earlier.
-      if(lua_pcall(L, 0, 0, -2))      // Passing 0 args, expecting none back
+      if(runProtected(L, 0, 0, -2, NULL))   // Passing 0 args, expecting none back
       {
           // We can't load the script as requested.  Sorry!
          string msg = "Error starting script:\n" + string(lua_tostring(L, -1));
@@ -315,6 +399,8 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
 
 bool LuaScriptRunner::runString(const string &code)
 {
+   lua_State *L = getLuaState();
+
    luaL_loadstring(L, code.c_str());
    setEnvironment();
    return !lua_pcall(L, 0, 0, 0);
@@ -335,7 +421,7 @@ bool LuaScriptRunner::runMain(const Vector<string> &args)
    if(mScriptName == "")
       return true;
 
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   TNLAssert(lua_gettop(getLuaState()) == 0 || dumpStack(getLuaState()), "Stack dirty!");
 
    setLuaArgs(args);
    bool error = runFunction("main", 0);
@@ -346,6 +432,8 @@ bool LuaScriptRunner::runMain(const Vector<string> &args)
 // Returns true if there was an error, false if everything ran ok
 bool LuaScriptRunner::runFunction(const char *function, S32 returnValues)
 {
+   lua_State *L = getLuaState();
+
    S32 args = lua_gettop(L);  // Number of args on stack     // -- <<args>>
 
    pushStackTracer();                                        // -- <<args>>, _stackTracer
@@ -369,7 +457,7 @@ bool LuaScriptRunner::runFunction(const char *function, S32 returnValues)
       lua_insert(L, 1);                                      // -- _stackTracer, function, <<args>>
    }
 
-   S32 error = lua_pcall(L, args, returnValues, -2 - args);  // -- _stackTracer, <<return values>>
+   S32 error = runProtected(L, args, returnValues, -2 - args, function);  // -- _stackTracer, <<return values>>
 
    if(!error)
    {
@@ -391,6 +479,10 @@ bool LuaScriptRunner::runFunction(const char *function, S32 returnValues)
 
 void LuaScriptRunner::handleError(const string &message)
 {
+   LuaWorldLock lock;      // We might be on one of the threads bots think on, and killScript() touches the game
+
+   lua_State *L = getLuaState();
+
    logprintf(LogConsumer::LogError, "%s\n%s", getErrorMessagePrefix(), message.c_str());
    logprintf(LogConsumer::LogError, "Dump of Lua/C++ stack:");
    dumpStack(L);
@@ -401,6 +493,386 @@ void LuaScriptRunner::handleError(const string &message)
 }
 
 
+// Calls that would have changed the world while bots were thinking were saved by LuaWorldLock::deferCall(); make them
+// now, in the order the script made them.  An error kills the script, just as it would have if the call had been made
+// right away, only later.
+void LuaScriptRunner::runDeferredCalls()
+{
+   lua_State *L = getLuaState();
+
+   TNLAssert(!LuaWorldLock::isEnabled(), "Bots are still thinking!");
+   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
+   lua_getfield(L, LUA_REGISTRYINDEX, DEFERRED_CALLS_KEY);     // -- calls
+
+   if(!lua_istable(L, -1))
+   {
+      lua_pop(L, 1);                                           // --
+      return;
+   }
+
+   // The calls can fire events whose handlers run in this state; anything they defer goes into a new list
+   lua_pushnil(L);                                             // -- calls, nil
+   lua_setfield(L, LUA_REGISTRYINDEX, DEFERRED_CALLS_KEY);     // -- calls
+
+   S32 count = (S32)lua_objlen(L, 1);
+
+   for(S32 i = 1; i <= count; i++)
+   {
+      lua_rawgeti(L, 1, i);                                    // -- calls, call
+      lua_getfield(L, 2, "n");                                 // -- calls, call, n
+      S32 args = (S32)lua_tointeger(L, -1);
+      lua_pop(L, 1);                                           // -- calls, call
+
+      pushStackTracer();                                       // -- calls, call, _stackTracer
+
+      for(S32 j = 1; j <= args + 1; j++)
+         lua_rawgeti(L, 2, j);                                 // -- calls, call, _stackTracer, function, <<args>>
+
+      if(runProtected(L, args, 0, 3, "deferred call"))         // -- calls, call, _stackTracer, [error]
+      {
+         string msg = lua_tostring(L, -1);
+         lua_pop(L, 1);
+
+         handleError("In a call made while bots were thinking:\n" + msg);    // Clears the stack
+         return;
+      }
+
+      lua_pop(L, 2);                                           // -- calls
+   }
+
+   lua_pop(L, 1);                                              // --
+}
+
+
+// What a thread is running right now.  Calls can nest, as when a script does something that fires an event some other script
+// handles; time spent in the inner call is charged to the inner script only.
+struct ScriptCall
+{
+   ScriptCall *caller;
+   S64 start;
+   F64 calleeTime;      // ms spent in nested calls
+   U32 timeLimit;       // ms, or 0 for none
+   U32 hookCount;
+   U32 hookInterval;    // Instructions between hook calls, or 0 if there's no hook
+   LuaProfiler *profiler;
+   bool timedOut;
+};
+
+static ThreadStorage currentCall;      // ScriptCall *
+
+// The hook runs every this many Lua instructions; often enough to catch a runaway script soon after it runs out of time,
+// rarely enough that reading the clock doesn't cost much.  Profiling needs a closer look.
+static const S32 WatchdogInterval = 10000;
+static const S32 ProfileInterval = 1000;
+
+
+void LuaScriptRunner::watchdogHook(lua_State *L, lua_Debug *ar)
+{
+   ScriptCall *call = (ScriptCall *)currentCall.get();
+
+   if(!call)
+      return;
+
+   if(call->timedOut)
+      luaL_error(L, "Out of time");
+
+   call->hookCount++;
+
+   if(call->profiler)
+      call->profiler->sample(L);
+
+   if(call->timeLimit == 0 || 
+      Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - call->start) < call->timeLimit)
+      return;
+
+   // From here on, raise an error at every instruction, so the script can't just pcall() its way past this
+   call->timedOut = true;
+   lua_sethook(L, watchdogHook, LUA_MASKCOUNT, 1);
+   luaL_error(L, "Out of time");
+}
+
+
+// Calls lua_pcall(), keeping track of how long the script runs, and stopping it if it goes on too long.  The stop is an
+// error, which the caller handles like any other, usually by killing the script.
+//
+// LuaJIT doesn't run hooks inside compiled code, so a tight loop that never calls back into C++ can escape the time limit
+// once it gets compiled; anything else will be caught.
+S32 LuaScriptRunner::runProtected(lua_State *L, S32 args, S32 returnValues, S32 errorHandler, const char *function)
+{
+   S32 base = lua_gettop(L) - args - 1;     // Whatever pcall leaves, results or an error, goes above this
+
+   ScriptCall call;
+
+   call.caller = (ScriptCall *)currentCall.get();
+   call.start = Platform::getHighPrecisionTimerValue();
+   call.calleeTime = 0;
+   call.timeLimit = mLuaGame ? mLuaGame->getSettings()->getSetting<U32>(IniKey::ScriptCallTimeLimit) : 0;
+   call.hookCount = 0;
+   call.profiler = mProfiler;
+   call.timedOut = false;
+
+   // Instruction hooks slow Lua down, so we only set one while we have a limit to enforce or a profile to take.  A nested
+   // call into the same state can use the hook that's already there, if it runs often enough.
+   lua_Hook callerHook = lua_gethook(L);
+   S32 callerHookMask = lua_gethookmask(L);
+   S32 callerHookCount = lua_gethookcount(L);
+
+   S32 interval = mProfiler ? ProfileInterval : WatchdogInterval;
+   bool setHook = (call.timeLimit > 0 || mProfiler) && (!callerHook || callerHookCount > interval);
+
+   if(setHook)
+      lua_sethook(L, watchdogHook, LUA_MASKCOUNT, interval);
+
+   call.hookInterval = setHook ? interval : callerHook ? callerHookCount : 0;
+
+   LuaProfiler *callerProfiler = LuaProfiler::getCurrent();
+   LuaProfiler::setCurrent(mProfiler);
+
+   if(mProfiler)
+      mProfiler->beginCall(function);
+
+   currentCall.set(&call);
+   S32 error = lua_pcall(L, args, returnValues, errorHandler);
+   currentCall.set(call.caller);
+
+   if(mProfiler)
+      mProfiler->endCall();
+
+   LuaProfiler::setCurrent(callerProfiler);
+
+   // Put things back the way the call we're nested in, if any, had them; that includes undoing what a time out does
+   if(setHook || call.timedOut)
+      lua_sethook(L, callerHook, callerHookMask, callerHookCount);
+
+   F64 elapsed = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - call.start);
+
+   if(call.caller)
+      call.caller->calleeTime += elapsed;
+
+   mCpuTime     += elapsed - call.calleeTime;
+   mTickCpuTime += elapsed - call.calleeTime;
+   mInstructions += U64(call.hookCount) * call.hookInterval;
+   mCalls++;
+
+   // Whatever the script made of our errors along the way, this is what happened
+   if(call.timedOut)
+   {
+      lua_pop(L, lua_gettop(L) - base);
+      lua_pushfstring(L, "Script ran for more than %d ms without returning, and was stopped (see ScriptCallTimeLimit in the INI)",
+                      call.timeLimit);
+      error = LUA_ERRRUN;
+   }
+
+   return error;
+}
+
+
+// Called once a tick, before the script gets its tick.  Time used beyond the per-tick budget piles up as debt, which the
+// script works off by sitting out ticks, so one using three times its budget ends up running every third tick.  Returns
+// false if the script should sit this one out.
+bool LuaScriptRunner::checkTickBudget()
+{
+   U32 budget = mLuaGame ? mLuaGame->getSettings()->getSetting<U32>(IniKey::ScriptTickBudget) : 0;
+
+   F64 used = mTicking ? mTickCpuTime : 0;      // Loading and starting up don't count
+   mTickCpuTime = 0;
+   mTicking = true;
+
+   if(budget == 0)
+      mThrottleDebt = 0;
+   else
+      mThrottleDebt = max(mThrottleDebt + used - budget, 0.0);
+
+   mThrottled = mThrottleDebt > 0;
+
+   if(!mThrottled)
+   {
+      mTicksRun++;
+      return true;
+   }
+
+   mTicksSkipped++;
+
+   if(!mThrottleLogged)
+   {
+      LuaWorldLock lock;      // We might be on one of the threads bots think on
+
+      logprintf(LogConsumer::LogWarning, "%s is using more than its %d ms per tick CPU budget, and will skip ticks to make up for it",
+                getScriptDescription().c_str(), budget);
+      mThrottleLogged = true;
+   }
+
+   return false;
+}
+
+
+bool LuaScriptRunner::isThrottled() const
+{
+   return mThrottled;
+}
+
+
+string LuaScriptRunner::getScriptDescription()
+{
+   return extractFilename(mScriptName) + " (" + mScriptId + ")";
+}
+
+
+// One line per script that has run since the last report, busiest first
+void LuaScriptRunner::getCpuUsageReport(Vector<string> &lines)
+{
+   Vector<LuaScriptRunner *> runners;
+
+   mRunnersMutex.lock();
+
+   for(S32 i = 0; i < mRunners.size(); i++)
+   {
+      if(mRunners[i]->mCalls == 0)
+         continue;
+
+      S32 j = runners.size();
+      runners.push_back(mRunners[i]);
+
+      for(; j > 0 && runners[j - 1]->mCpuTime < mRunners[i]->mCpuTime; j--)
+         runners[j] = runners[j - 1];
+
+      runners[j] = mRunners[i];
+   }
+
+   for(S32 i = 0; i < runners.size(); i++)
+   {
+      LuaScriptRunner *runner = runners[i];
+      U32 ticks = runner->mTicksRun + runner->mTicksSkipped;
+
+      lines.push_back(runner->getScriptDescription() + ": " + 
+            ftos(F32(runner->mCpuTime), 1) + " ms in " + itos(runner->mCalls) + " calls, " +
+            ftos(ticks ? F32(runner->mCpuTime / ticks) : 0, 2) + " ms/tick, ~" + 
+            ftos(F32(runner->mInstructions / 1000000.0), 1) + "M instructions, " +
+            itos(runner->mTicksSkipped) + " ticks skipped");
+   }
+
+   mRunnersMutex.unlock();
+}
+
+
+void LuaScriptRunner::logCpuUsage()
+{
+   Vector<string> lines;
+   getCpuUsageReport(lines);
+
+   if(lines.size() > 0)
+      logprintf(LogConsumer::ServerFilter, "Script CPU usage:");
+
+   for(S32 i = 0; i < lines.size(); i++)
+      logprintf(LogConsumer::ServerFilter, "   %s", lines[i].c_str());
+
+   mRunnersMutex.lock();
+
+   for(S32 i = 0; i < mRunners.size(); i++)
+   {
+      LuaScriptRunner *runner = mRunners[i];
+
+      runner->mCpuTime = 0;
+      runner->mInstructions = 0;
+      runner->mCalls = 0;
+      runner->mTicksRun = 0;
+      runner->mTicksSkipped = 0;
+      runner->mThrottleLogged = false;
+   }
+
+   mRunnersMutex.unlock();
+}
+
+
+bool LuaScriptRunner::isProfiling() const
+{
+   return mProfiler != NULL;
+}
+
+
+S32 LuaScriptRunner::startProfiling(const string &name)
+{
+   S32 count = 0;
+
+   mRunnersMutex.lock();
+
+   for(S32 i = 0; i < mRunners.size(); i++)
+   {
+      LuaScriptRunner *runner = mRunners[i];
+
+      if(runner->mProfiler || lcase(runner->getScriptDescription()).find(lcase(name)) == string::npos)
+         continue;
+
+      runner->mProfiler = new LuaProfiler();
+      LuaProfiler::setJitEnabled(runner->getLuaState(), false);
+      count++;
+   }
+
+   mRunnersMutex.unlock();
+
+   return count;
+}
+
+
+// Each profile goes to a file of its own, as folded stacks (see LuaProfiler::writeFoldedStacks()), and the log gets the
+// flat profile; summary gets the top few lines of each
+S32 LuaScriptRunner::stopProfiling(const string &dir, Vector<string> &summary)
+{
+   static const S32 SummaryLines = 3;
+
+   S32 count = 0;
+
+   makeSureFolderExists(dir);
+
+   mRunnersMutex.lock();
+
+   for(S32 i = 0; i < mRunners.size(); i++)
+   {
+      LuaScriptRunner *runner = mRunners[i];
+
+      if(!runner->mProfiler)
+         continue;
+
+      string description = runner->getScriptDescription();
+      string filename = joindir(dir, "luaprofile_" + extractFilenameNoExtension(runner->mScriptName) + "_" + 
+                                     runner->mScriptId + ".folded");
+
+      Vector<string> lines;
+      runner->mProfiler->getFlatProfile(lines);
+
+      logprintf(LogConsumer::ServerFilter, "Lua profile of %s, %.1f ms in all:", description.c_str(), 
+                runner->mProfiler->getTotalTime());
+
+      for(S32 j = 0; j < lines.size(); j++)
+         logprintf(LogConsumer::ServerFilter, "   %s", lines[j].c_str());
+
+      if(runner->mProfiler->writeFoldedStacks(filename))
+         logprintf(LogConsumer::ServerFilter, "Wrote folded stacks to %s", filename.c_str());
+      else
+         logprintf(LogConsumer::LogError, "Could not write Lua profile to %s", filename.c_str());
+
+      summary.push_back(description + ", " + ftos(F32(runner->mProfiler->getTotalTime()), 1) + " ms:");
+
+      for(S32 j = 0; j < lines.size() && j < SummaryLines; j++)
+         summary.push_back(lines[j]);
+
+      delete runner->mProfiler;
+      runner->mProfiler = NULL;
+      LuaProfiler::setJitEnabled(runner->getLuaState(), true);    // Nobody else in the state is being profiled any more
+      count++;
+   }
+
+   mRunnersMutex.unlock();
+
+   // In case a script was deleted while being profiled
+   if(L)
+      LuaProfiler::setJitEnabled(L, true);
+
+   return count;
+}
+
+
 // Start Lua and get everything configured
 bool LuaScriptRunner::startLua(const string &scriptingDir)
 {
@@ -449,10 +921,10 @@ bool LuaScriptRunner::configureNewLuaInstance(lua_State *L)
       luaL_openlibs(L);    // Load the standard libraries
 
       // This allows the safe use of 'require' in our scripts
-      setModulePath();
+      setModulePath(L);
 
       // Register all our classes in the global namespace... they will be copied below when we copy the environment
-      registerClasses();            // Perform class and global function registration once per lua_State
+      registerClasses(L);           // Perform class and global function registration once per lua_State
       registerLooseFunctions(L);    // Register some functions not associated with a particular class
 
       // Set scads of global vars in the Lua instance that mimic the use of the enums we use everywhere.
@@ -461,19 +933,19 @@ bool LuaScriptRunner::configureNewLuaInstance(lua_State *L)
       setGlobalObjectArrays(L);
 
       // Immediately execute the lua helper functions (these are global and need to be loaded before sandboxing)
-      loadCompileRunHelper("lua_helper_functions.lua");
+      loadCompileRunHelper(L, "lua_helper_functions.lua");
 
       // Load our vector library
-      loadCompileRunHelper("luavec.lua");
+      loadCompileRunHelper(L, "luavec.lua");
 
       // Load our helper functions and store copies of the compiled code in the registry where we can use them for starting new scripts
-      loadCompileSaveHelper("robot_helper_functions.lua",    ROBOT_HELPER_FUNCTIONS_KEY);
-      loadCompileSaveHelper("levelgen_helper_functions.lua", LEVELGEN_HELPER_FUNCTIONS_KEY);
-      loadCompileSaveHelper("timer.lua",                     SCRIPT_TIMER_KEY);
+      loadCompileSaveHelper(L, "robot_helper_functions.lua",    ROBOT_HELPER_FUNCTIONS_KEY);
+      loadCompileSaveHelper(L, "levelgen_helper_functions.lua", LEVELGEN_HELPER_FUNCTIONS_KEY);
+      loadCompileSaveHelper(L, "timer.lua",                     SCRIPT_TIMER_KEY);
 
       // Perform sandboxing now
       // Only code executed before this point can access dangerous functions
-      loadCompileRunHelper("sandbox.lua");
+      loadCompileRunHelper(L, "sandbox.lua");
 
       return true;
    }
@@ -485,17 +957,18 @@ bool LuaScriptRunner::configureNewLuaInstance(lua_State *L)
 }
 
 
-void LuaScriptRunner::loadCompileSaveHelper(const string &scriptName, const char *registryKey)
+void LuaScriptRunner::loadCompileSaveHelper(lua_State *L, const string &scriptName, const char *registryKey)
 {
-   loadCompileSaveScript(joindir(mScriptingDir, scriptName).c_str(), registryKey);
+   loadCompileCachedScript(L, joindir(mScriptingDir, scriptName).c_str());
+   lua_setfield(L, LUA_REGISTRYINDEX, registryKey);   // Save compiled code in registry
 }
 
 
 // Load a script from the scripting directory by basename (e.g. "my_script.lua").
 // Throws LuaException when there's an error compiling or running the script.
-void LuaScriptRunner::loadCompileRunHelper(const string &scriptName)
+void LuaScriptRunner::loadCompileRunHelper(lua_State *L, const string &scriptName)
 {
-   loadCompileScript(joindir(mScriptingDir, scriptName).c_str());
+   loadCompileCachedScript(L, joindir(mScriptingDir, scriptName).c_str());
    if(lua_pcall(L, 0, 0, 0))
       throw LuaException("Error running " + scriptName + ": " + string(lua_tostring(L, -1)));
 }
@@ -503,16 +976,16 @@ void LuaScriptRunner::loadCompileRunHelper(const string &scriptName)
 
 // Load script from specified file, compile it, and store it in the registry.
 // All callers of this script have catch blocks, so we can throw errors if something goes wrong.
-void LuaScriptRunner::loadCompileSaveScript(const char *filename, const char *registryKey)
+void LuaScriptRunner::loadCompileSaveScript(lua_State *L, const char *filename, const char *registryKey)
 {
-   loadCompileScript(filename);                       // Throws if there is an error
+   loadCompileScript(L, filename);                    // Throws if there is an error
    lua_setfield(L, LUA_REGISTRYINDEX, registryKey);   // Save compiled code in registry
 }
 
 
 // Load script and place on top of the stack.
 // All callers of this script have catch blocks, so we can throw errors if something goes wrong.
-void LuaScriptRunner::loadCompileScript(const char *filename)
+void LuaScriptRunner::loadCompileScript(lua_State *L, const char *filename)
 {
    // luaL_loadfile: Loads a file as a Lua chunk. This function uses lua_load to load the chunk in the file named filename. 
    // If filename is NULL, then it loads from the standard input. The first line in the file is ignored if it starts with a #.
@@ -526,6 +999,34 @@ void LuaScriptRunner::loadCompileScript(const char *filename)
 }
 
 
+// Collects the output of lua_dump()
+static int writeBytecode(lua_State *L, const void *data, size_t size, void *bytecode)
+{
+   static_cast<string *>(bytecode)->append(static_cast<const char *>(data), size);
+   return 0;
+}
+
+
+// Like loadCompileScript(), but the compiled code is kept, so the next Lua state to want this file doesn't have to read
+// and compile it again.  Throws LuaException when there's an error.
+void LuaScriptRunner::loadCompileCachedScript(lua_State *L, const char *filename)
+{
+   map<string, string>::iterator it = mBytecode.find(filename);
+
+   if(it == mBytecode.end())
+   {
+      loadCompileScript(L, filename);                 // -- function
+      lua_dump(L, writeBytecode, &mBytecode[filename]);
+      return;
+   }
+
+   const string chunkName = "@" + string(filename);   // Same name luaL_loadfile() would give it, for error messages
+
+   if(luaL_loadbuffer(L, it->second.data(), it->second.size(), chunkName.c_str()) != 0)
+      throw LuaException("Error loading script " + string(filename) + "\n" + string(lua_tostring(L, -1)));
+}
+
+
 // Delete script's environment from the registry -- actually set the registry entry to nil so the table can be collected
 void LuaScriptRunner::deleteScript(const char *name)
 {
@@ -557,6 +1058,8 @@ const char *LuaScriptRunner::getScriptId(lua_State *L)
 
 bool LuaScriptRunner::prepareEnvironment()              
 {
+   lua_State *L = getLuaState();
+
    if(!L)
    {
       logprintf(LogConsumer::LogError, "%s %s.", getErrorMessagePrefix(), 
@@ -605,11 +1108,13 @@ void LuaScriptRunner::logError(const char *format, ...)
    vsnprintf(buffer, sizeof(buffer), format, args);
    va_end(args);
 
-   logErrorHandler(buffer, getErrorMessagePrefix());
+   LuaWorldLock lock;      // Logging isn't safe while bots are thinking on other threads
+
+   logErrorHandler(getLuaState(), buffer, getErrorMessagePrefix());
 }
 
 
-void LuaScriptRunner::logErrorHandler(const char *msg, const char *prefix) 
+void LuaScriptRunner::logErrorHandler(lua_State *L, const char *msg, const char *prefix) 
 { 
    // Log the error to the logging system and also to the game console
    logprintf(LogConsumer::LogError, "%s %s", prefix, msg);
@@ -634,7 +1139,7 @@ static string getStackTraceLine(lua_State *L, S32 level)
 */
 
 // Register classes needed by all script runners
-void LuaScriptRunner::registerClasses()
+void LuaScriptRunner::registerClasses(lua_State *L)
 {
    LuaW_Registrar::registerClasses(L);    // Register all objects that use our automatic registration scheme
 }
@@ -644,6 +1149,8 @@ void LuaScriptRunner::registerClasses()
 // By Lua convention, we'll put the name of the script into the 0th element.
 void LuaScriptRunner::setLuaArgs(const Vector<string> &args)
 {
+   lua_State *L = getLuaState();
+
    S32 stackDepth = lua_gettop(L);
 
    lua_getfield(L, LUA_REGISTRYINDEX, getScriptId()); // Put script's env table onto the stack  -- ..., env_table
@@ -667,7 +1174,7 @@ void LuaScriptRunner::setLuaArgs(const Vector<string> &args)
 
 
 // Set up paths so that we can use require to load code in our scripts 
-void LuaScriptRunner::setModulePath()   
+void LuaScriptRunner::setModulePath(lua_State *L)   
 {
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
@@ -1018,21 +1525,39 @@ void LuaScriptRunner::setGlobalObjectArrays(lua_State *L)
  */
 //               Fn name    Param profiles         Profile count
 #define LUA_METHODS(CLASS, METHOD) \
-      METHOD(CLASS, pointCanSeePoint,      ARRAYDEF({{ PT, PT, END }}), 1 ) \
-      METHOD(CLASS, findObjectById,        ARRAYDEF({{ INT, END }}), 1 )    \
-      METHOD(CLASS, findAllObjects,        ARRAYDEF({{ INTS, END }, { END }}), 2 ) \
-      METHOD(CLASS, findAllObjectsInArea,  ARRAYDEF({{ PT, PT, INTS, END }}), 1 ) \
-      METHOD(CLASS, addItem,               ARRAYDEF({{ BFOBJ, END }}), 1 )  \
-      METHOD(CLASS, getGameInfo,           ARRAYDEF({{ END }}), 1 )         \
-      METHOD(CLASS, getPlayerCount,        ARRAYDEF({{ END }}), 1 )         \
-      METHOD(CLASS, getBotScripts,         ARRAYDEF({{ END }}), 1 )         \
-      METHOD(CLASS, subscribe,             ARRAYDEF({{ EVENT, END }}), 1 )  \
-      METHOD(CLASS, unsubscribe,           ARRAYDEF({{ EVENT, END }}), 1 )  \
+      METHOD(CLASS, pointCanSeePoint,      ARRAYDEF({{ PT, PT, END }}), 1, ReadsWorld   ) \
+      METHOD(CLASS, findObjectById,        ARRAYDEF({{ INT, END }}), 1, ReadsWorld   ) \
+      METHOD(CLASS, findAllObjects,        ARRAYDEF({{ INTS, END }, { END }, { TABLE, INTS, END }, { TABLE, END }}), 4, ReadsWorld   ) \
+      METHOD(CLASS, findAllObjectsInArea,  ARRAYDEF({{ PT, PT, INTS, END }, { TABLE, PT, PT, INTS, END }}), 2, ReadsWorld   ) \
+      METHOD(CLASS, addItem,               ARRAYDEF({{ BFOBJ, END }}), 1, ChangesWorld ) \
+      METHOD(CLASS, getGameInfo,           ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+      METHOD(CLASS, getPlayerCount,        ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+      METHOD(CLASS, getBotScripts,         ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+      METHOD(CLASS, subscribe,             ARRAYDEF({{ EVENT, END }}), 1, ChangesWorld ) \
+      METHOD(CLASS, unsubscribe,           ARRAYDEF({{ EVENT, END }}), 1, ChangesWorld ) \
 
 
 GENERATE_LUA_FUNARGS_TABLE(LuaScriptRunner, LUA_METHODS);
 GENERATE_LUA_METHODS_TABLE(LuaScriptRunner, LUA_METHODS);
 
+// Loose functions are wrapped in this, so they take the LuaWorldLock just like class methods do (see luaW_doMethod())
+static int callLooseFunction(lua_State *L)
+{
+   LuaWorldLock lock;
+   LuaProfiler::BindingCall profile(L, NULL);
+
+   lua_CFunction function = (lua_CFunction)lua_touserdata(L, lua_upvalueindex(1));
+   return function(L);
+}
+
+
+static void pushLooseFunction(lua_State *L, lua_CFunction function)
+{
+   lua_pushlightuserdata(L, (void *)function);
+   lua_pushcclosure(L, callLooseFunction, 1);
+}
+
+
 void LuaScriptRunner::registerLooseFunctions(lua_State *L)
 {
    ProfileMap moduleProfiles = LuaModuleRegistrarBase::getModuleProfiles();
@@ -1046,7 +1571,7 @@ void LuaScriptRunner::registerLooseFunctions(lua_State *L)
          for(U32 i = 0; i < profiles.size(); i++)
          {
             LuaStaticFunctionProfile &profile = profiles[i];
-            lua_pushcfunction(L, profile.function);                 // -- fn
+            pushLooseFunction(L, profile.function);                 // -- fn
             lua_setglobal(L, profile.functionName);                 // --
          }
       }
@@ -1058,7 +1583,7 @@ void LuaScriptRunner::registerLooseFunctions(lua_State *L)
          for(U32 i = 0; i < profiles.size(); i++)
          {
             LuaStaticFunctionProfile &profile = profiles[i];
-            lua_pushcfunction(L, profile.function);                 // -- table, fn
+            pushLooseFunction(L, profile.function);                 // -- table, fn
             lua_setfield(L, -2, profile.functionName);              // -- table
          }
          lua_setglobal(L, (*it).first.c_str());                     // --
@@ -1141,6 +1666,10 @@ S32 LuaScriptRunner::lua_findObjectById(lua_State *L)
  * If no object types are provided, this function will return every object on
  * the level (warning, may be slow).
  *
+ * Scripts that search often can pass in a table of their own as the first
+ * argument, and it will be filled with the results (and returned) in place of
+ * a new table.  Anything already in the table is replaced.
+ *
  * @param [objType] ObjTypes specifying what types of objects to find.
  *
  * @return A table with any found objects.
@@ -1158,13 +1687,13 @@ S32 LuaScriptRunner::lua_findAllObjects(lua_State *L)
 
    TNLAssert(mLevel != NULL, "Grid Database must not be NULL!");
 
-   fillVector.clear();
-   static Vector<U8> types;
+   FillVector fillVector;
+   static thread_local Vector<U8> types;
 
    types.clear();
 
    // We expect the stack to look like this: -- objType1, objType2, ...
-   // or this, if using the deprecated fill table option -- [fillTable], objType1, objType2, ...
+   // or this, if using the fill table option -- [fillTable], objType1, objType2, ...
    // We'll work our way down from the top of the stack (element -1) until we find something that is not a number.
    // We expect that when we find something that is not a number, the stack will only contain a fillTable.  If the stack
    // is empty at that point, we'll add a table later.
@@ -1193,34 +1722,16 @@ S32 LuaScriptRunner::lua_findAllObjects(lua_State *L)
       results = &fillVector;
    }
    
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack not cleared!");
-
-
-   // This will guarantee a table at the top of the stack to return our found objects
-   if(!lua_istable(L, -1))
-   {
-      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack not cleared!");
-
-      lua_createtable(L, results->size(), 0);    // Create a table, with enough slots pre-allocated for our data
-   }
-   else
-      logprintf(LogConsumer::LuaBotMessage, "Usage of a fill table with findAllObjects() "
-            "is deprecated and will be removed in the future.  Instead, don't use one");
-
-   TNLAssert((lua_gettop(L) == 1 && lua_istable(L, -1)) || dumpStack(L), "Should only have table!");
-
-   S32 pushed = 0;      // Count of items we put into our table
+   // This will guarantee a table at the bottom of the stack to return our found objects
+   prepareResultTable(L, results->size());
 
    for(S32 i = 0; i < results->size(); i++)
    {
       static_cast<BfObject *>(results->get(i))->push(L);
-      pushed++;      // Increment pushed before using it because Lua uses 1-based arrays
-      lua_rawseti(L, 1, pushed);
+      lua_rawseti(L, 1, i + 1);
    }
 
-   TNLAssert(lua_gettop(L) == 1 || dumpStack(L), "Stack has unexpected items on it!");
-
-   return 1;
+   return returnResultTable(L, results->size());
 }
 
 
@@ -1233,7 +1744,8 @@ S32 LuaScriptRunner::lua_findAllObjects(lua_State *L)
  * constructed from the two points given, with each point positioned at opposite
  * corners.
  *
- * @note See LuaScriptRunner::findAllObjects for a code example
+ * @note See LuaScriptRunner::findAllObjects for a code example, and for how
+ * to reuse a table for the results
  *
  * @param point1 One corner of a search rectangle.
  * @param point2 Another corner of a search rectangle diagonally opposite to the
@@ -1248,15 +1760,15 @@ S32 LuaScriptRunner::lua_findAllObjectsInArea(lua_State *L)
 
    TNLAssert(mLevel != NULL, "Grid Database must not be NULL!");
 
-   static Vector<U8> types;
+   static thread_local Vector<U8> types;
 
    types.clear();
-   fillVector.clear();
+   FillVector fillVector;
 
    bool hasBotZoneType = false;
 
    // We expect the stack to look like this: -- point1, point2, objType1, objType2, ...
-   // or this, if using the deprecated fill table option -- [fillTable], point1, point2, objType1, objType2, ...
+   // or this, if using the fill table option -- [fillTable], point1, point2, objType1, objType2, ...
    // We'll work our way down from the top of the stack (element -1) until we find something that is not a number.
    while(lua_gettop(L) > 0 && lua_isnumber(L, -1))
    {
@@ -1283,19 +1795,8 @@ S32 LuaScriptRunner::lua_findAllObjectsInArea(lua_State *L)
 
    mLevel->findObjects(types, fillVector, searchArea);
 
-   // This will guarantee a table at the top of the stack to return our found objects
-   if(!lua_istable(L, -1))
-   {
-      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack not cleared!");
-
-      lua_createtable(L, fillVector.size(), 0);    // Create a table, with enough slots pre-allocated for our data
-   }
-   else
-      logprintf(LogConsumer::LuaBotMessage, "Usage of a fill table with findAllObjectsInArea() "
-            "is deprecated and will be removed in the future.  Instead, don't use one");
-
-   // Create a table, with enough slots pre-allocated for our data
-   lua_createtable(L, fillVector.size(), 0);
+   // This will guarantee a table at the bottom of the stack to return our found objects
+   prepareResultTable(L, fillVector.size());
 
    for(S32 i = 0; i < fillVector.size(); i++)
    {
@@ -1303,9 +1804,7 @@ S32 LuaScriptRunner::lua_findAllObjectsInArea(lua_State *L)
       lua_rawseti(L, 1, i + 1);
    }
 
-   TNLAssert(lua_gettop(L) == 1 || dumpStack(L), "Stack has unexpected items on it!");
-
-   return 1;
+   return returnResultTable(L, fillVector.size());
 }
 
 
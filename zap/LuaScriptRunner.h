@@ -14,6 +14,7 @@
 #include "tnlVector.h"
 
 #include <deque>
+#include <map>
 #include <string>
 
 using namespace std;
@@ -45,25 +46,49 @@ class MenuItem;
 
 class LuaScriptRunner
 {
+   friend class EventManager;    // Needs to know which game a subscriber belongs to
 
 private:
    static deque<string> mCachedScripts;
+   static map<string, string> mBytecode;   // Compiled scripts, by filename, for loading into new Lua states
 
    static string mScriptingDir;
 
+   // Every script there is, for CPU usage reports.  Scripts can be created off the main thread, so hold mRunnersMutex
+   // while using the list.
+   static Vector<LuaScriptRunner *> mRunners;
+   static Mutex mRunnersMutex;
+
+   // CPU usage since the last report, and what we're doing about it -- see runProtected() and checkTickBudget()
+   F64 mCpuTime;              // ms
+   F64 mTickCpuTime;          // ms used since the last tick
+   F64 mThrottleDebt;         // ms used over budget, to be worked off by skipping ticks
+   U64 mInstructions;         // Roughly; only counted while there's a call time limit
+   U32 mCalls;
+   U32 mTicksRun;
+   U32 mTicksSkipped;
+   bool mThrottled;
+   bool mThrottleLogged;
+   bool mTicking;             // False until the first tick, so startup time isn't held against the script
+
+   LuaProfiler *mProfiler;    // NULL unless we're being profiled
+
+   static void watchdogHook(lua_State *L, lua_Debug *ar);
+
    void setLuaArgs(const Vector<string> &args);
-   static void setModulePath();
+   static void setModulePath(lua_State *L);
 
-   static void loadCompileSaveHelper(const string &scriptName, const char *registryKey);
-   static void loadCompileRunHelper(const string &scriptName);
-   static void loadCompileSaveScript(const char *filename, const char *registryKey);
-   static void loadCompileScript(const char *filename);
+   static void loadCompileSaveHelper(lua_State *L, const string &scriptName, const char *registryKey);
+   static void loadCompileRunHelper(lua_State *L, const string &scriptName);
+   static void loadCompileSaveScript(lua_State *L, const char *filename, const char *registryKey);
+   static void loadCompileScript(lua_State *L, const char *filename);
+   static void loadCompileCachedScript(lua_State *L, const char *filename);
 
    void pushStackTracer();      // Put error handler function onto the stack
 
    static void setEnums(lua_State *L);                       // Set a whole slew of enum values that we want the scripts to have access to
    static void setGlobalObjectArrays(lua_State *L);          // And some objects
-   static void logErrorHandler(const char *msg, const char *prefix);
+   static void logErrorHandler(lua_State *L, const char *msg, const char *prefix);
 
 protected:
    enum ScriptType {
@@ -82,6 +107,7 @@ protected:
    Level *mLevel;                // Pointer to our current level
 
    static lua_State *L;          // Main Lua state variable
+   lua_State *mLuaState;         // This script's very own Lua state, or NULL if it runs in L like everyone else
    string mScriptName;           // Fully qualified script name, with path and everything
    Vector<string> mScriptArgs;   // List of arguments passed to the script
 
@@ -94,15 +120,21 @@ protected:
    virtual bool prepareEnvironment();
 
    static int luaPanicked(lua_State *L);  // Handle a total freakout by Lua
-   static void registerClasses();
+   static void registerClasses(lua_State *L);
    void setEnvironment();                 // Sets the environment for the function on the top of the stack to that associated with name
 
    bool loadCompileRunEnvironmentScript(const string &scriptName);
 
    static void deleteScript(const char *name);  // Remove saved script from the Lua registry
 
+   bool createLuaState();        // Give this script a Lua state of its own; call before prepareEnvironment()
+
    static void registerLooseFunctions(lua_State *L);     // Register some functions not associated with a particular class
 
+   // lua_pcall(), with CPU accounting and limits; function is only used to label profiles
+   S32 runProtected(lua_State *L, S32 args, S32 returnValues, S32 errorHandler, const char *function);
+   bool checkTickBudget();
+
    static S32 findObjectById(lua_State *L, const Vector<DatabaseObject *> *objects);
 
 
@@ -135,6 +167,8 @@ public:
    virtual const char *getErrorMessagePrefix();
 
    static lua_State *getL();
+   lua_State *getLuaState() const;                    // The state this script runs in
+   bool hasOwnLuaState() const;
    static const char *getScriptId(lua_State *L);
 
    static bool startLua(const string &scriptingDir);  // Create L
@@ -151,6 +185,7 @@ public:
 
    bool runFunction(const char *function, S32 returnValues);
    void handleError(const string &message);
+   void runDeferredCalls();            // Make the calls put off while bots were thinking; main thread only
 
 
    const char *getScriptId();
@@ -159,6 +194,17 @@ public:
 
    void logError(const char *format, ...);
 
+   bool isThrottled() const;                          // True if sitting out ticks for using too much CPU
+   virtual string getScriptDescription();             // How this script is listed in CPU usage reports
+
+   static void getCpuUsageReport(Vector<string> &lines);
+   static void logCpuUsage();                         // Write the report to the log, and start over
+
+   // Profiling -- only start or stop while no script is running
+   bool isProfiling() const;
+   static S32 startProfiling(const string &name);     // Profile every script whose description contains name; returns how many
+   static S32 stopProfiling(const string &dir, Vector<string> &summary);   // Writes profiles to dir; returns how many
+
    S32 doSubscribe(lua_State *L, ScriptContext context);
    S32 doUnsubscribe(lua_State *L);
 
@@ -167,10 +213,18 @@ public:
    template <class T>
    void tickTimer(U32 deltaT)          
    {
+      if(!checkTickBudget())
+         return;
+
+      lua_State *L = getLuaState();
+
       TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
       clearStack(L);
 
-      luaW_push<T>(L, static_cast<T *>(this));           // -- this
+      {
+         LuaWorldLock lock;      // Bots may be thinking on other threads
+         luaW_push<T>(L, static_cast<T *>(this));        // -- this
+      }
       lua_pushnumber(L, deltaT);                         // -- this, deltaT
 
       // Note that we don't care if this generates an error... if it does the error handler will
@@ -218,13 +272,13 @@ public:
 // Starting with a definition like the following:
 /*
  #define LUA_METHODS(CLASS, METHOD) \
-    METHOD(CLASS, addDest,    ARRAYDEF({{ PT,  END }}), 1 ) \
-    METHOD(CLASS, delDest,    ARRAYDEF({{ INT, END }}), 1 ) \
-    METHOD(CLASS, clearDests, ARRAYDEF({{      END }}), 1 ) \
+    METHOD(CLASS, addDest,    ARRAYDEF({{ PT,  END }}), 1, ChangesWorld ) \
+    METHOD(CLASS, delDest,    ARRAYDEF({{ INT, END }}), 1, ChangesWorld ) \
+    METHOD(CLASS, clearDests, ARRAYDEF({{      END }}), 1, ChangesWorld ) \
 */
 
-#define LUA_METHOD_ITEM(class_, name, b, c) \
-{ #name, luaW_doMethod<class_, &class_::lua_## name > },
+#define LUA_METHOD_ITEM(class_, name, b, c, effect) \
+{ #name, luaW_doMethod<class_, &class_::lua_## name, effect > },
 
 
 #define GENERATE_LUA_METHODS_TABLE(class_, table_) \
@@ -237,16 +291,16 @@ const luaL_Reg class_::luaMethods[] =              \
 // Generates something like the following:
 // const luaL_Reg Teleporter::luaMethods[] =
 // {
-//       { "addDest",    luaW_doMethod<Teleporter, &Teleporter::lua_addDest >    }
-//       { "delDest",    luaW_doMethod<Teleporter, &Teleporter::lua_delDest >    }
-//       { "clearDests", luaW_doMethod<Teleporter, &Teleporter::lua_clearDests > }
+//       { "addDest",    luaW_doMethod<Teleporter, &Teleporter::lua_addDest, ChangesWorld >    }
+//       { "delDest",    luaW_doMethod<Teleporter, &Teleporter::lua_delDest, ChangesWorld >    }
+//       { "clearDests", luaW_doMethod<Teleporter, &Teleporter::lua_clearDests, ChangesWorld > }
 //       { NULL, NULL }
 // };
 
 
 ////////////////////////////////////////
 
- #define LUA_FUNARGS_ITEM(class_, name, profiles, profileCount) \
+ #define LUA_FUNARGS_ITEM(class_, name, profiles, profileCount, effect) \
 { #name, {profiles, profileCount } },
  
 
@@ -52,6 +52,7 @@ extern "C"
 
 #include "LuaBase.h"   
 #include "LuaException.h"   
+#include "LuaProfiler.h"
 
 #include <string>
 #include <vector>
@@ -84,6 +85,61 @@ inline int luaW_correctindex(lua_State* L, int index, int correction)
 template <class T> class LuaProxy;
 
 
+// Pushing an object looks up its userdata in the cache table for its class, which is several string lookups away in the
+// registry.  Once an object has been pushed, we also keep its userdata in a handles table, keyed by its proxy, that sits
+// directly in the registry under a key of its own.  That makes pushing an object for the second time, which is what
+// happens every time a script searches for something, two quick lookups.  Values are weak, so this holds nothing alive
+// that the cache table wouldn't.
+inline void *luaW_handlesKey()
+{
+   static char key;
+   return &key;
+}
+
+
+// Pushes the userdata we already have for proxy and returns true; otherwise leaves the stack as it was and returns false
+inline bool luaW_pushHandle(lua_State *L, void *proxy)
+{
+   lua_pushlightuserdata(L, luaW_handlesKey());       // -- key
+   lua_rawget(L, LUA_REGISTRYINDEX);                  // -- handles_table
+
+   if(!lua_istable(L, -1))
+   {
+      lua_pop(L, 1);                                  // -- <<empty>>
+      return false;
+   }
+
+   lua_pushlightuserdata(L, proxy);                   // -- handles_table, &proxy
+   lua_rawget(L, -2);                                 // -- handles_table, userdata (or nil)
+   lua_remove(L, -2);                                 // -- userdata (or nil)
+
+   if(lua_isnil(L, -1))
+   {
+      lua_pop(L, 1);                                  // -- <<empty>>
+      return false;
+   }
+
+   return true;
+}
+
+
+// Remembers the userdata on top of the stack as the one for proxy; leaves the stack as it was
+inline void luaW_setHandle(lua_State *L, void *proxy)
+{
+   lua_pushlightuserdata(L, luaW_handlesKey());       // -- userdata, key
+   lua_rawget(L, LUA_REGISTRYINDEX);                  // -- userdata, handles_table
+
+   if(lua_istable(L, -1))
+   {
+      lua_pushlightuserdata(L, proxy);                // -- userdata, handles_table, &proxy
+      lua_pushvalue(L, -3);                           // -- userdata, handles_table, &proxy, userdata
+      lua_rawset(L, -3);                              // -- userdata, handles_table
+   }
+
+   lua_pop(L, 1);                                     // -- userdata
+}
+
+
 // Here we will specify whether to use our proxy system for objects managed in LuaW
 // or use (mostly) upstream behavior
 inline bool luaW_shouldCreateProxy(lua_State* L)
@@ -369,6 +425,40 @@ T* luaW_opt(lua_State* L, int index, T* fallback = NULL, bool strict = false)
 template <typename T>
 bool luaW_hold(lua_State* L, T* obj);
 
+// Creates a userdata for proxy, adds it to our cache table, and leaves it on the stack
+template <typename T>
+void luaW_pushNewProxy(lua_State* L, T* obj, LuaProxy<T>* proxy)
+{
+   // Add a new entry to our cache table (a weak table; more about those here: http://lua-users.org/wiki/WeakTablesTutorial).
+   // Note that from here on down, we'll fall back on the normal LuaW push code, except for the bit at the end where
+   // we add it to the table.
+   LuaWrapper<T>::identifier(L, obj);                 // -- id
+   luaW_wrapperfield<T>(L, LUAW_CACHE_KEY);           // -- id, cache_table
+
+   lua_pushvalue(L, -2);                              // -- id, cache_table, id
+
+   // Create the new luaW_userdata and place it in the cache
+   lua_pop(L, 1); // ... id cache
+   lua_insert(L, -2); // ... cache id
+   luaW_Userdata* ud = static_cast<luaW_Userdata*>(lua_newuserdata(L, sizeof(luaW_Userdata))); // ... cache id obj
+   ud->data = proxy;
+   ud->cast = LuaWrapper<T>::cast;
+   lua_pushvalue(L, -1); // ... cache id obj obj
+   lua_insert(L, -4); // ... obj cache id obj
+   lua_settable(L, -3); // ... obj cache
+
+   // Set the class metatable on userdata
+   luaL_getmetatable(L, LuaWrapper<T>::classname); // ... obj cache mt
+   lua_setmetatable(L, -3); // ... obj cache
+
+   // Cleanup
+   lua_pop(L, 1); // ... obj
+   TNLAssert(lua_isuserdata(L, -1) || dumpStack(L, "Expect userdata"), "Expected userdata!");
+
+   luaW_setUsingProxy(L, obj, true);
+   luaW_hold<T>(L, obj);     // Tell luaW to collect the proxy when it's done with it
+}
+
 // Analogous to lua_push(boolean|string|*)
 //
 // Pushes a userdata of type T onto the stack. If this object already exists in
@@ -383,12 +473,16 @@ void luaW_push(lua_State* L, T* obj)
       return;
    }
 
+   // Get the object's proxy, or create one if it doesn't yet exist
+   LuaProxy<T> *proxy = obj->getLuaProxy();
+
+   // Pushed it before?
+   if(proxy && luaW_pushHandle(L, proxy))
+      return;
+
    // Should we be using proxies for our objects?
    if(luaW_shouldCreateProxy(L))
    {
-      // Get the object's proxy, or create one if it doesn't yet exist
-      LuaProxy<T> *proxy = obj->getLuaProxy();
-
       if(proxy)         // Retrieve the userdata for this proxy from our cache table
       {
          luaW_wrapperfield<T>(L, LUAW_CACHE_KEY);        // -- cache_table
@@ -399,48 +493,29 @@ void luaW_push(lua_State* L, T* obj)
          // Here: retrieves and pushes cache_table[id]
          lua_gettable(L, -2);                            // -- cache_table, userdata
 
-         TNLAssert(lua_isuserdata(L, -1) ||
-               dumpStack(L, "Expect table, userdata") || dumpTable(L, -2, "Cached Userdatas"),
-               "Expected userdata!");
-         TNLAssert(proxy == luaW_toProxy<T>(L, -1), "Cached object is not the one we expect!");
-
          // Clean up the stack
          lua_remove(L, -2);                              // -- userdata
+
+         // A bot with a Lua state of its own may be the first to see an object whose proxy was made in another
+         // state; it gets its own userdata for the same proxy
+         if(lua_isnil(L, -1))
+         {
+            lua_pop(L, 1);                               // -- <<empty>>
+            proxy->addRef();
+            luaW_pushNewProxy<T>(L, obj, proxy);         // -- userdata
+         }
+
+         TNLAssert(lua_isuserdata(L, -1) || dumpStack(L, "Expect userdata"), "Expected userdata!");
+         TNLAssert(proxy == luaW_toProxy<T>(L, -1), "Cached object is not the one we expect!");
       }
       else
       {
          // Create a new proxy
          proxy = new LuaProxy<T>(obj);
-
-         // Add a new entry to our cache table (a weak table; more about those here: http://lua-users.org/wiki/WeakTablesTutorial).
-         // Note that from here on down, we'll fall back on the normal LuaW push code, except for the bit at the end where
-         // we add it to the table.
-         LuaWrapper<T>::identifier(L, obj);                 // -- id
-         luaW_wrapperfield<T>(L, LUAW_CACHE_KEY);           // -- id, cache_table
-
-         lua_pushvalue(L, -2);                              // -- id, cache_table, id
-
-         // Create the new luaW_userdata and place it in the cache
-         lua_pop(L, 1); // ... id cache
-         lua_insert(L, -2); // ... cache id
-         luaW_Userdata* ud = static_cast<luaW_Userdata*>(lua_newuserdata(L, sizeof(luaW_Userdata))); // ... cache id obj
-         ud->data = proxy;
-         ud->cast = LuaWrapper<T>::cast;
-         lua_pushvalue(L, -1); // ... cache id obj obj
-         lua_insert(L, -4); // ... obj cache id obj
-         lua_settable(L, -3); // ... obj cache
-
-         // Set the class metatable on userdata
-         luaL_getmetatable(L, LuaWrapper<T>::classname); // ... obj cache mt
-         lua_setmetatable(L, -3); // ... obj cache
-
-         // Cleanup
-         lua_pop(L, 1); // ... obj
-         TNLAssert(lua_isuserdata(L, -1) || dumpStack(L, "Expect userdata"), "Expected userdata!");
-
-         luaW_setUsingProxy(L, obj, true);
-         luaW_hold<T>(L, obj);     // Tell luaW to collect the proxy when it's done with it
+         luaW_pushNewProxy<T>(L, obj, proxy);            // -- userdata
       }
+
+      luaW_setHandle(L, proxy);                          // -- userdata
    }  // useLuaProxy
 
    // No proxy: Use upstream behavior
@@ -567,6 +642,8 @@ void luaW_postconstructor(lua_State* L, int numargs)
 template <typename T>
 inline int luaW_new(lua_State* L, int args)
 {
+    LuaWorldLock lock;
+
     T* obj = LuaWrapper<T>::allocator(L);    // Create our new T
     luaW_push<T>(L, obj);                    // Push it on the stack for Lua to find
 //    luaW_hold<T>(L, obj);  // luaW_hold is called in luaW_push with our proxy system in place
@@ -668,6 +745,8 @@ int luaW_gc(lua_State* L)
    // automatically at the end of a game.  Other objects, like LuaPlayerInfo, are
    // deleted when its owning ClientInfo object is cleaned up.  This pattern must be
    // followed
+   LuaWorldLock lock;      // Collection can happen on any thread bots think on
+
    luaW_Userdata* pud = static_cast<luaW_Userdata*>(lua_touserdata(L, 1));
 
    if(luaW_isUsingProxy<T>(L, pud->data))
@@ -675,7 +754,8 @@ int luaW_gc(lua_State* L)
       LuaProxy<T>* proxy = luaW_toProxy<T>(L, 1);
       TNLAssert(proxy, "Expected a proxy!");
 
-      if(proxy)
+      // Other Lua states may still be using it
+      if(proxy && proxy->release() == 0)
          delete proxy;
    }
 
@@ -769,6 +849,15 @@ inline void luaW_initialize(lua_State* L)
         lua_setfield(L, -2, "__mode"); // ... nil LuaWrapper {}
         lua_setfield(L, -2, LUAW_CACHE_METATABLE_KEY); // ... nil LuaWrapper
 
+        // Create the handles table, straight in the registry, with weak values like the cache table
+        lua_pushlightuserdata(L, luaW_handlesKey()); // ... nil LuaWrapper key
+        lua_newtable(L); // ... nil LuaWrapper key {}
+        lua_newtable(L); // ... nil LuaWrapper key {} {}
+        lua_pushstring(L, "v"); // ... nil LuaWrapper key {} {} "v"
+        lua_setfield(L, -2, "__mode"); // ... nil LuaWrapper key {} {}
+        lua_setmetatable(L, -2); // ... nil LuaWrapper key {}
+        lua_rawset(L, LUA_REGISTRYINDEX); // ... nil LuaWrapper
+
         lua_pop(L, 1); // ... nil
     }
     lua_pop(L, 1); // ...
@@ -1162,6 +1251,7 @@ class LuaProxy
 private:
     bool mDefunct;
     T *mProxiedObject;
+    S32 mRefCount;      // Number of Lua states holding a userdata for this proxy
 
 public:
     // Default constructor
@@ -1173,6 +1263,7 @@ public:
       mProxiedObject = obj;
       obj->setLuaProxy(this);
       mDefunct = false;
+      mRefCount = 1;
     }
 
    // Destructor
@@ -1187,6 +1278,9 @@ public:
    bool isDefunct()        { return mDefunct;       }
 
    void setDefunct(bool isDefunct) { mDefunct = isDefunct; }
+
+   void addRef()  { mRefCount++; }
+   S32  release() { return --mRefCount; }    // Returns how many references remain
 };
 
 
@@ -1230,7 +1324,7 @@ public:
 
 #define LUA_REGISTER_WITH_TRACKER \
 {                                 \
-   LuaObject::trackThisItem();    \
+   LuaObject::trackThisItem(L);   \
 }
 
 
@@ -1241,9 +1335,21 @@ public:
 
 // Runs a method on a proxied object.  Returns nil if the proxied object no longer exists, so Lua scripts may need to check for this.
 // Wraps a standard method (one that takes L as a single parameter) within a proxy check. 
-template <typename T, int (T::*methodName)(lua_State * )>
+template <typename T, int (T::*methodName)(lua_State * ), LuaMethodEffect effect>
 int luaW_doMethod(lua_State *L)
 {
+   LuaWorldLock lock;
+
+   // While bots think in parallel, anything that changes the world waits until they're done, so it happens in the same
+   // order however the threads run; see RobotManager::think()
+   if(effect == ChangesWorld && LuaWorldLock::isEnabled())
+   {
+      LuaWorldLock::deferCall(L, luaW_doMethod<T, methodName, effect>);
+      return 0;
+   }
+
+   LuaProfiler::BindingCall profile(L, LuaWrapper<T>::classname);
+
    T *w = luaW_check<T>(L, 1);
    if(w) 
    {
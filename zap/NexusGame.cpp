@@ -1188,10 +1188,10 @@ bool NexusZone::collide(BfObject *hitObject)
  */
 //               Fn name         Param profiles     Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, setOpen,       ARRAYDEF({{ BOOL,    END }}), 1 ) \
-   METHOD(CLASS, isOpen,        ARRAYDEF({{          END }}), 1 ) \
-   METHOD(CLASS, setOpenTime,   ARRAYDEF({{ INT_GE0, END }}), 1 ) \
-   METHOD(CLASS, setClosedTime, ARRAYDEF({{ INT_GE0, END }}), 1 ) \
+   METHOD(CLASS, setOpen,       ARRAYDEF({{ BOOL,    END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, isOpen,        ARRAYDEF({{          END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setOpenTime,   ARRAYDEF({{ INT_GE0, END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, setClosedTime, ARRAYDEF({{ INT_GE0, END }}), 1, ChangesWorld ) \
 
 GENERATE_LUA_METHODS_TABLE(NexusZone, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(NexusZone, LUA_METHODS);
@@ -0,0 +1,394 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "RecordingFile.h"
+
+#include "tnlLog.h"
+
+#ifndef BF_NO_RECORDING_COMPRESSION
+#  include "zlib.h"
+#endif
+
+#include <algorithm>
+#include <string.h>
+
+
+namespace Zap
+{
+
+
+static void writeU32(U8 *data, U32 value)
+{
+   data[0] = U8(value);
+   data[1] = U8(value >> 8);
+   data[2] = U8(value >> 16);
+   data[3] = U8(value >> 24);
+}
+
+
+static U32 readU32(const U8 *data)
+{
+   return U32(data[0]) | (U32(data[1]) << 8) | (U32(data[2]) << 16) | (U32(data[3]) << 24);
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+RecordingFileWriter::RecordingFileWriter(FILE *file, S32 compressionLevel)
+{
+   TNLAssert(file != NULL, "Must have a file handle");
+
+   mFile = file;
+   mCompressionLevel = isCompressionAvailable() ? std::max(0, std::min(9, compressionLevel)) : 0;
+   mBytesWritten = 0;
+
+   if(mCompressionLevel > 0)
+   {
+      U8 magic[4];
+      writeU32(magic, CompressedMagic);
+      fwrite(magic, 1, sizeof(magic), mFile);
+      mBytesWritten += sizeof(magic);
+
+      mFrame.reserve(FrameSize);
+   }
+}
+
+
+// Destructor
+RecordingFileWriter::~RecordingFileWriter()
+{
+   close();
+}
+
+
+bool RecordingFileWriter::isCompressionAvailable()
+{
+#ifdef BF_NO_RECORDING_COMPRESSION
+   return false;
+#else
+   return true;
+#endif
+}
+
+
+void RecordingFileWriter::write(const U8 *data, U32 size)
+{
+   TNLAssert(mFile, "File is already closed!");
+
+   if(mCompressionLevel == 0)
+   {
+      mBytesWritten += (U32)fwrite(data, 1, size, mFile);
+      return;
+   }
+
+   while(size > 0)
+   {
+      U32 count = std::min(size, U32(FrameSize - mFrame.size()));
+      mFrame.getStlVector().insert(mFrame.getStlVector().end(), data, data + count);
+      data += count;
+      size -= count;
+
+      if(mFrame.size() == FrameSize)
+         writeFrame();
+   }
+}
+
+
+void RecordingFileWriter::writeFrame()
+{
+   if(mFrame.size() == 0)
+      return;
+
+   U32 rawSize = mFrame.size();
+   U32 compressedSize = rawSize;
+   const U8 *frameData = mFrame.address();
+
+#ifndef BF_NO_RECORDING_COMPRESSION
+   uLongf destSize = compressBound(rawSize);
+   mCompressed.resize(destSize);
+
+   // Store the frame as-is in the unlikely case compressing it doesn't help
+   if(compress2(mCompressed.address(), &destSize, mFrame.address(), rawSize, mCompressionLevel) == Z_OK &&
+         destSize < rawSize)
+   {
+      compressedSize = U32(destSize);
+      frameData = mCompressed.address();
+   }
+#endif
+
+   U8 header[FrameHeaderSize];
+   writeU32(&header[0], compressedSize);
+   writeU32(&header[4], rawSize);
+
+   fwrite(header, 1, sizeof(header), mFile);
+   fwrite(frameData, 1, compressedSize, mFile);
+   mBytesWritten += sizeof(header) + compressedSize;
+
+   mFrame.clear();
+}
+
+
+void RecordingFileWriter::close()
+{
+   if(!mFile)
+      return;
+
+   if(mCompressionLevel > 0)
+      writeFrame();
+
+   fclose(mFile);
+   mFile = NULL;
+}
+
+
+U32 RecordingFileWriter::getBytesWritten() const
+{
+   return mBytesWritten;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+RecordingFileReader::RecordingFileReader()
+{
+   mFile = NULL;
+   mCompressed = false;
+   mPosition = 0;
+   mSize = 0;
+   mLoadedFrame = -1;
+}
+
+
+// Destructor
+RecordingFileReader::~RecordingFileReader()
+{
+   close();
+}
+
+
+bool RecordingFileReader::open(const char *filename)
+{
+   close();
+
+   mFile = fopen(filename, "rb");
+   if(!mFile)
+      return false;
+
+   U8 magic[4];
+   mCompressed = fread(magic, 1, sizeof(magic), mFile) == sizeof(magic) &&
+                 readU32(magic) == RecordingFileWriter::CompressedMagic;
+
+   if(!mCompressed)
+   {
+      fseek(mFile, 0, SEEK_SET);
+      return true;
+   }
+
+   if(!RecordingFileWriter::isCompressionAvailable())
+   {
+      logprintf(LogConsumer::LogWarning, "Can't play %s: this build can't read compressed recordings", filename);
+      close();
+      return false;
+   }
+
+   return scanFrames();
+}
+
+
+// Reads every frame header, so we know where to find any position in the file.  A frame cut short, most likely
+// by the server going down mid-game, is treated as the end of the file.
+bool RecordingFileReader::scanFrames()
+{
+   if(fseek(mFile, 0, SEEK_END) != 0)
+      return false;
+
+   U32 fileSize = U32(ftell(mFile));
+   U32 offset = 4;
+   U32 start = 0;
+
+   while(offset + RecordingFileWriter::FrameHeaderSize <= fileSize)
+   {
+      U8 header[RecordingFileWriter::FrameHeaderSize];
+
+      if(fseek(mFile, offset, SEEK_SET) != 0 || fread(header, 1, sizeof(header), mFile) != sizeof(header))
+         break;
+
+      U32 compressedSize = readU32(&header[0]);
+      U32 rawSize = readU32(&header[4]);
+
+      if(rawSize == 0 || rawSize > RecordingFileWriter::FrameSize || compressedSize > rawSize ||
+            compressedSize > fileSize - offset - sizeof(header))
+         break;
+
+      mFrameOffsets.push_back(offset);
+      mFrameStarts.push_back(start);
+
+      offset += sizeof(header) + compressedSize;
+      start += rawSize;
+   }
+
+   mSize = start;
+   mPosition = 0;
+
+   return true;
+}
+
+
+void RecordingFileReader::close()
+{
+   if(mFile)
+      fclose(mFile);
+
+   mFile = NULL;
+   mCompressed = false;
+   mPosition = 0;
+   mSize = 0;
+   mFrameOffsets.clear();
+   mFrameStarts.clear();
+   mLoadedFrame = -1;
+   mFrameData.clear();
+}
+
+
+bool RecordingFileReader::isOpen() const
+{
+   return mFile != NULL;
+}
+
+
+bool RecordingFileReader::isCompressed() const
+{
+   return mCompressed;
+}
+
+
+// Finds the frame holding position, which must be less than mSize
+S32 RecordingFileReader::findFrame(U32 position) const
+{
+   // Reading usually carries on in the frame we already have
+   if(mLoadedFrame != -1 && position >= mFrameStarts[mLoadedFrame] &&
+         (mLoadedFrame == mFrameStarts.size() - 1 || position < mFrameStarts[mLoadedFrame + 1]))
+      return mLoadedFrame;
+
+   S32 first = 0;
+   S32 last = mFrameStarts.size() - 1;
+
+   while(first < last)
+   {
+      S32 middle = (first + last + 1) / 2;
+
+      if(mFrameStarts[middle] <= position)
+         first = middle;
+      else
+         last = middle - 1;
+   }
+
+   return first;
+}
+
+
+bool RecordingFileReader::loadFrame(S32 index)
+{
+   if(index == mLoadedFrame)
+      return true;
+
+   mLoadedFrame = -1;
+
+   U8 header[RecordingFileWriter::FrameHeaderSize];
+
+   if(fseek(mFile, mFrameOffsets[index], SEEK_SET) != 0 || fread(header, 1, sizeof(header), mFile) != sizeof(header))
+      return false;
+
+   U32 compressedSize = readU32(&header[0]);
+   U32 rawSize = readU32(&header[4]);
+
+   mFrameData.resize(rawSize);
+
+   if(compressedSize == rawSize)       // Stored as-is
+   {
+      if(fread(mFrameData.address(), 1, rawSize, mFile) != rawSize)
+         return false;
+   }
+   else
+   {
+      mCompressedData.resize(compressedSize);
+      if(fread(mCompressedData.address(), 1, compressedSize, mFile) != compressedSize)
+         return false;
+
+#ifndef BF_NO_RECORDING_COMPRESSION
+      uLongf destSize = rawSize;
+      if(uncompress(mFrameData.address(), &destSize, mCompressedData.address(), compressedSize) != Z_OK ||
+            destSize != rawSize)
+      {
+         logprintf(LogConsumer::LogWarning, "Recording is corrupt at frame %d", index);
+         return false;
+      }
+#endif
+   }
+
+   mLoadedFrame = index;
+   return true;
+}
+
+
+U32 RecordingFileReader::read(void *data, U32 size)
+{
+   if(!mCompressed)
+      return (U32)fread(data, 1, size, mFile);
+
+   U32 copied = 0;
+
+   while(copied < size && mPosition < mSize)
+   {
+      S32 index = findFrame(mPosition);
+      if(!loadFrame(index))
+         break;
+
+      U32 offset = mPosition - mFrameStarts[index];
+      U32 count = std::min(size - copied, U32(mFrameData.size()) - offset);
+
+      memcpy((U8 *)data + copied, &mFrameData[offset], count);
+      copied += count;
+      mPosition += count;
+   }
+
+   return copied;
+}
+
+
+bool RecordingFileReader::seek(S32 offset, S32 origin)
+{
+   if(!mCompressed)
+      return fseek(mFile, offset, origin) == 0;
+
+   S64 position = offset;
+
+   if(origin == SEEK_CUR)
+      position += mPosition;
+   else if(origin == SEEK_END)
+      position += mSize;
+
+   if(position < 0 || position > mSize)
+      return false;
+
+   mPosition = U32(position);
+   return true;
+}
+
+
+U32 RecordingFileReader::tell() const
+{
+   if(!mCompressed)
+      return U32(ftell(mFile));
+
+   return mPosition;
+}
+
+
+} /* namespace Zap */
@@ -0,0 +1,93 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _RECORDING_FILE_H_
+#define _RECORDING_FILE_H_
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <stdio.h>
+
+using namespace TNL;
+
+namespace Zap
+{
+
+// Game recordings are stored either as-is, or as a series of deflate compressed frames.  A compressed file starts
+// with CompressedMagic, followed by frames, each made up of a 4 byte compressed size, a 4 byte uncompressed size,
+// and the compressed data.  A frame whose two sizes match is stored uncompressed.  Every frame stands on its own,
+// so reading can start at any of them, which is what keeps seeking cheap.
+//
+// Positions are always given as if the file were not compressed, so nothing above this level needs to know the
+// difference.
+class RecordingFileWriter
+{
+private:
+   FILE *mFile;
+   S32 mCompressionLevel;        // 0 for none, otherwise 1 (fastest) to 9 (smallest)
+   Vector<U8> mFrame;            // Data waiting for the frame to fill up
+   Vector<U8> mCompressed;       // Scratch space for compressing it
+   U32 mBytesWritten;            // Bytes that have gone to the file, compressed or not
+
+   void writeFrame();
+
+public:
+   enum RecordingFileConstants {
+      CompressedMagic = 0x5A524642,    // "BFRZ"; plain recordings start with CS_PROTOCOL_VERSION instead
+      FrameSize = 64 * 1024,           // Uncompressed bytes per frame
+      FrameHeaderSize = 8
+   };
+
+   RecordingFileWriter(FILE *file, S32 compressionLevel);    // Constructor; takes ownership of file
+   virtual ~RecordingFileWriter();                           // Destructor; closes the file if still open
+
+   void write(const U8 *data, U32 size);
+   void close();                 // Writes out the last partial frame and closes the file
+
+   U32 getBytesWritten() const;
+
+   static bool isCompressionAvailable();
+};
+
+
+class RecordingFileReader
+{
+private:
+   FILE *mFile;
+   bool mCompressed;
+
+   // Everything below is only used for compressed files
+   U32 mPosition;                // As if the file were uncompressed
+   U32 mSize;
+   Vector<U32> mFrameOffsets;    // Where each frame's header is in the file
+   Vector<U32> mFrameStarts;     // Uncompressed position of the first byte of each frame
+   S32 mLoadedFrame;             // Which frame is in mFrameData, or -1
+   Vector<U8> mFrameData;
+   Vector<U8> mCompressedData;
+
+   bool scanFrames();
+   S32 findFrame(U32 position) const;
+   bool loadFrame(S32 index);
+
+public:
+   RecordingFileReader();           // Constructor
+   virtual ~RecordingFileReader();  // Destructor
+
+   bool open(const char *filename);
+   void close();
+
+   bool isOpen() const;
+   bool isCompressed() const;
+
+   // These work just like fread, fseek, and ftell, except seek returns true when it works
+   U32 read(void *data, U32 size);
+   bool seek(S32 offset, S32 origin);
+   U32 tell() const;
+};
+
+
+} /* namespace Zap */
+#endif
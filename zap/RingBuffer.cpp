@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "RingBuffer.h"
+
+#include "tnlAssert.h"
+
+#include <string.h>
+
+
+namespace Zap
+{
+
+
+RingBuffer::RingBuffer(U32 capacity)
+{
+   TNLAssert(capacity > 0 && capacity <= (1U << 31), "Invalid ring buffer capacity!");
+
+   mCapacity = 1;
+   while(mCapacity < capacity)
+      mCapacity <<= 1;
+
+   mMask = mCapacity - 1;
+   mBuffer = new U8[mCapacity];
+
+   mWritePos = 0;
+   mReadPos = 0;
+}
+
+
+RingBuffer::~RingBuffer()
+{
+   delete [] mBuffer;
+}
+
+
+U32 RingBuffer::getCapacity() const
+{
+   return mCapacity;
+}
+
+
+// The reader only ever frees up space, so the answer can only get better after we look
+U32 RingBuffer::getFreeSpace() const
+{
+   return mCapacity - (mWritePos.load(std::memory_order_relaxed) - mReadPos.load(std::memory_order_acquire));
+}
+
+
+bool RingBuffer::write(const void *data, U32 size)
+{
+   U32 writePos = mWritePos.load(std::memory_order_relaxed);
+
+   if(size > mCapacity - (writePos - mReadPos.load(std::memory_order_acquire)))
+      return false;
+
+   // Might have to wrap around the end
+   U32 start = writePos & mMask;
+   U32 firstPart = size < mCapacity - start ? size : mCapacity - start;
+
+   memcpy(&mBuffer[start], data, firstPart);
+   memcpy(mBuffer, (const U8 *)data + firstPart, size - firstPart);
+
+   // Release, so the reader sees the bytes before it sees the new position
+   mWritePos.store(writePos + size, std::memory_order_release);
+
+   return true;
+}
+
+
+// The writer only ever adds data, so the answer can only get bigger after we look
+U32 RingBuffer::getUsedSpace() const
+{
+   return mWritePos.load(std::memory_order_acquire) - mReadPos.load(std::memory_order_relaxed);
+}
+
+
+U32 RingBuffer::peek(const U8 **data) const
+{
+   U32 readPos = mReadPos.load(std::memory_order_relaxed);
+   U32 used = mWritePos.load(std::memory_order_acquire) - readPos;
+
+   U32 start = readPos & mMask;
+   *data = &mBuffer[start];
+
+   return used < mCapacity - start ? used : mCapacity - start;
+}
+
+
+void RingBuffer::consume(U32 size)
+{
+   TNLAssert(size <= getUsedSpace(), "Consuming more than was written!");
+
+   // Release, so we're done reading the bytes before the writer can reuse them
+   mReadPos.store(mReadPos.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+
+} /* namespace Zap */
@@ -0,0 +1,50 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _RING_BUFFER_H_
+#define _RING_BUFFER_H_
+
+#include "tnlTypes.h"
+
+#include <atomic>
+
+using namespace TNL;
+
+namespace Zap
+{
+
+// A ring of bytes shared by exactly two threads: one that writes, and one that reads.  Neither ever waits on the
+// other -- the writer is told when there's no room, and the reader when there's nothing to read -- so it's up to
+// the callers to decide what to do about it.
+class RingBuffer
+{
+private:
+   U8 *mBuffer;
+   U32 mCapacity;                // Always a power of 2, so positions can wrap around U32_MAX safely
+   U32 mMask;
+
+   std::atomic<U32> mWritePos;   // Total bytes ever written; only the writer changes this
+   std::atomic<U32> mReadPos;    // Total bytes ever read; only the reader changes this
+
+public:
+   explicit RingBuffer(U32 capacity);     // Constructor; capacity gets rounded up to a power of 2
+   virtual ~RingBuffer();                 // Destructor
+
+   U32 getCapacity() const;
+
+   // Writer side
+   U32 getFreeSpace() const;
+   bool write(const void *data, U32 size);         // All or nothing; returns false if there isn't room for it all
+
+   // Reader side
+   U32 getUsedSpace() const;
+   U32 peek(const U8 **data) const;                // Points data at the next readable bytes and returns how many
+                                                   // there are in a row -- possibly fewer than getUsedSpace()
+   void consume(U32 size);                         // Done with size bytes from peek()
+};
+
+
+} /* namespace Zap */
+#endif
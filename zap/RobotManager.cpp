@@ -6,6 +6,7 @@
 #include "RobotManager.h"
 
 #include "ClientInfo.h"
+#include "EventManager.h"
 #include "robot.h"
 #include "ServerGame.h"
 #include "Level.h"
@@ -22,13 +23,15 @@ RobotManager::RobotManager(ServerGame *game, GameSettingsPtr settings)
    mAutoLevelTeams    = settings->getSetting<YesNo>(IniKey::AddRobots);
    mTargetPlayerCount = settings->getSetting<S32>(IniKey::MinBalancedPlayers);
    mGame = game;
+   mThinkPool = NULL;
+   mThinkThreads = 0;
 }
 
 
 // Destructor
 RobotManager::~RobotManager()
 {
-   // Do nothing
+   delete mThinkPool;
 }
 
 
@@ -397,4 +400,80 @@ void RobotManager::clearMoves()
 }
 
 
+// Bots with a native controller get their onTick here, one after another, on the main thread.  They cost so little next
+// to a script that there's nothing to gain from spreading them over threads.
+void RobotManager::tickNativeBots(U32 deltaT)
+{
+   if(EventManager::get()->isPaused())
+      return;
+
+   for(S32 i = 0; i < mRobots.size(); i++)
+      if(mRobots[i]->getController() && !mRobots[i]->isDeleted())
+         mRobots[i]->tickController(deltaT);
+}
+
+
+// Bots with a Lua state of their own (see BotThinkThreads) do all their thinking here, at once, spread over a pool of
+// threads, instead of one at a time as the main loop gets to them.  While they think, any call they make into C++ holds
+// the LuaWorldLock, and anything that would change the world -- other than steering their own ships -- waits, as do any
+// events fired along the way.  Afterwards, on this thread, the events are fired, then each bot's calls are made, bot by
+// bot, in the same order every time, so the world ends up the same however the threads ran.  tickDeltaT is the time to
+// pass to onTick, or 0 if it's not time for one.
+void RobotManager::think(U32 timeDelta, U32 tickDeltaT)
+{
+   mThinkers.clear();
+
+   for(S32 i = 0; i < mRobots.size(); i++)
+      if(mRobots[i]->hasOwnLuaState() && !mRobots[i]->isDeleted())
+         mThinkers.push_back(mRobots[i]);
+
+   if(mThinkers.size() == 0)
+      return;
+
+   // This thread thinks too, so the pool needs one fewer
+   U32 threads = mGame->getSettings()->getSetting<U32>(IniKey::BotThinkThreads);
+
+   if(!mThinkPool || threads != mThinkThreads)
+   {
+      delete mThinkPool;
+      mThinkPool = new WorkerPool(threads > 0 ? threads - 1 : 0);
+      mThinkThreads = threads;
+   }
+
+   EventManager *eventManager = EventManager::get();
+
+   for(S32 i = 0; i < mThinkers.size(); i++)
+   {
+      Robot *robot = mThinkers[i];
+
+      // The main loop will set the same time again, after we're done
+      Move move = robot->getCurrentMove();
+      move.time = timeDelta;
+      robot->setCurrentMove(move);
+
+      robot->prepareToThink(tickDeltaT > 0 && eventManager->isSubscribed(robot, EventManager::TickEvent) ? tickDeltaT : 0);
+   }
+
+   LuaWorldLock::setEnabled(true);
+   mThinkPool->run(this, mThinkers.size());
+   LuaWorldLock::setEnabled(false);
+
+   eventManager->fireHeldEvents();
+
+   for(S32 i = 0; i < mThinkers.size(); i++)
+      if(!mThinkers[i]->isDeleted())         // Removed by someone else's calls; what it asked for goes with it
+         mThinkers[i]->runDeferredCalls();
+}
+
+
+void RobotManager::run(S32 index)
+{
+   LuaWorldLock::setThinker(index);
+   mThinkers[index]->think();
+   LuaWorldLock::setThinker(-1);
+
+   LuaWorldLock::releaseAll();
+}
+
+
 } 
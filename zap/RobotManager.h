@@ -9,6 +9,7 @@
 #include "GameSettings.h"
 #include "ClientInfo.h"       // For ClientClass enum
 #include "TeamConstants.h"    // For NO_TEAM def
+#include "WorkerPool.h"
 
 #include "tnlTypes.h"
 
@@ -21,11 +22,17 @@ namespace Zap
 class ServerGame;
 class Robot;
 
-class RobotManager
+class RobotManager : private WorkerPool::Job
 {
 private:
    Vector<Robot *> mRobots;      // Grand master list of all robots in the current game
 
+   WorkerPool *mThinkPool;       // Threads bots think on, when BotThinkThreads is set
+   U32 mThinkThreads;            // The BotThinkThreads setting mThinkPool was made for
+   Vector<Robot *> mThinkers;    // Bots thinking this tick
+
+   void run(S32 index);          // Think for one bot; called by mThinkPool
+
    bool mManagerActive;          // True when the manager is active
    bool mAutoLevelTeams;         // When true, bots will be added/removed to make sure all teams are even
    
@@ -71,6 +78,8 @@ public:
    void deleteAllBots();
 
    void clearMoves();
+   void tickNativeBots(U32 deltaT);
+   void think(U32 timeDelta, U32 tickDeltaT);
 };
 
 }
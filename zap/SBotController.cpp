@@ -0,0 +1,531 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "SBotController.h"
+
+#include "flagItem.h"
+#include "gameType.h"
+#include "goalZone.h"
+#include "NexusGame.h"
+#include "projectile.h"
+#include "robot.h"
+#include "ServerGame.h"
+
+#include "tnlRandom.h"
+
+#include <cmath>
+
+namespace Zap
+{
+
+// Declare our statics
+const S32 SBotController::PathTimerMax;
+const S32 SBotController::AverageShieldMaxTicks;
+
+const SBotController::Profile SBotController::Profiles[] = {
+   //  Name        Difficulty  Aggression  Defense  Speed  Accuracy  Dodging
+   { "S_Bot",      0.5f,       0.5f,       0,       1.0f,  0.90f,    0.25f },
+   { "Meany",      1.0f,       1.0f,       0,       1.0f,  1.0f,     1.0f  },
+   { "Barnside",   0.5f,       1.0f,       0,       0.5f,  0.1f,     0.1f  }
+};
+
+// Worst possible angle is multiplied by the accuracy
+static const F32 WorstAccuracy = 0.25f * FloatTau;  // Quarter-circle...  really bad!
+
+
+static F32 angleDifference(F32 angleA, F32 angleB)
+{
+   return fmod(fmod(angleA - angleB, FloatTau) + FloatPi * 3, FloatTau) - FloatPi;
+}
+
+
+static F32 getRadius(BfObject *obj)
+{
+   if(obj->getObjectTypeNumber() == BulletTypeNumber)
+      return static_cast<Projectile *>(obj)->getRadius();
+
+   return static_cast<Item *>(obj)->getRadius();      // Seekers, asteroids, mines
+}
+
+
+// Energy plus health, each from 0 to 1
+static F32 getPower(Ship *ship)
+{
+   return (F32)ship->getEnergy() / (F32)Ship::EnergyMax + ship->getHealth();
+}
+
+
+// Constructor
+SBotController::SBotController()
+{
+   // Choose a random profile (for now)
+   mProfile = &Profiles[Random::readI(0, ARRAYSIZE(Profiles) - 1)];
+
+   mPathTimer = PathTimerMax;
+   mDirToGo = 0;
+   mGotoPositionWasNil = true;
+
+   mHasPrevTarget = false;
+
+   for(S32 i = 0; i < AverageShieldMaxTicks; i++)
+      mAverageShieldArray[i] = false;
+
+   mAverageShieldIndex = 0;
+
+   mOrbitalDirection = 1;
+   mObjective = Random::readI(0, 10);
+
+   mView = NULL;
+   mMove = NULL;
+   mBot = NULL;
+   mBotRadius = 0;
+   mGameType = NoGameType;
+   mIsTeamGame = false;
+}
+
+
+// Destructor
+SBotController::~SBotController()
+{
+   // Do nothing
+}
+
+
+BotController *SBotController::create(const Vector<string> &args)
+{
+   return new SBotController();
+}
+
+
+string SBotController::getName()
+{
+   return string(mProfile->name) + " [s_bot]";
+}
+
+
+bool SBotController::shieldSelf()
+{
+   static const U8 types[] = { BulletTypeNumber, SeekerTypeNumber, AsteroidTypeNumber, MineTypeNumber };
+   static const Vector<U8> typeList(types, ARRAYSIZE(types));
+
+   FillVector items;
+   mView->findVisibleObjects(typeList, items);
+
+   F32 distToShieldAt = mBotRadius * 2 + (1 - mProfile->difficulty) * 100;
+
+   for(S32 i = 0; i < items.size(); i++)
+   {
+      BfObject *bullet = static_cast<BfObject *>(items[i]);
+
+      Point bulletPos = bullet->getPos();
+      Point bulletVel = bullet->getVel();
+      F32 angleDiff = fabs(angleDifference(bulletVel.ATAN2(), bulletPos.angleTo(mBotPos)));
+
+      bool bulletFromTeam = mIsTeamGame && bullet->getTeam() == mBot->getTeam();
+
+      if(!bulletFromTeam && bulletPos.distanceTo(mBotPos) < distToShieldAt + getRadius(bullet) + bulletVel.len() * 50 &&
+         angleDiff < FloatPi / 4)
+      {
+         mView->fireModule(*mMove, ModuleShield);
+         return true;
+      }
+   }
+
+   return false;
+}
+
+
+// Each tick we see if we should shield.  We store if we've shielded for AverageShieldMaxTicks ticks and average it.
+void SBotController::shield()
+{
+   mAverageShieldArray[mAverageShieldIndex] = shieldSelf();
+   mAverageShieldIndex = (mAverageShieldIndex + 1) % AverageShieldMaxTicks;
+
+   // Find ratio of ticks shielded.  Like the script, this looks at the same (oldest) tick each time around, so the ratio
+   // is all or nothing; kept that way so both bots dodge alike.
+   S32 shieldTickCount = 0;
+
+   for(S32 i = 0; i < AverageShieldMaxTicks; i++)
+      if(mAverageShieldArray[mAverageShieldIndex])
+         shieldTickCount++;
+
+   F32 shieldTickRatio = (F32)shieldTickCount / AverageShieldMaxTicks;
+
+   // Reverse orbital direction if our shielding ratio is greater than the dodging threshold - this means the bot will
+   // appear to strafe more if dodging is higher
+   if(shieldTickRatio > 1 - mProfile->dodging)
+   {
+      mOrbitalDirection = -mOrbitalDirection;
+
+      // Reset shielding average if we had to change direction
+      for(S32 i = 0; i < AverageShieldMaxTicks; i++)
+         mAverageShieldArray[i] = false;
+   }
+}
+
+
+void SBotController::fireAtObjects()
+{
+   static const U8 types[] = { RobotShipTypeNumber, TurretTypeNumber, PlayerShipTypeNumber, AsteroidTypeNumber,
+                               ForceFieldProjectorTypeNumber, SpyBugTypeNumber, CoreTypeNumber };
+   static const Vector<U8> typeList(types, ARRAYSIZE(types));
+
+   FillVector items;
+   mView->findVisibleObjects(typeList, items);
+
+   // Cycle through list of potential items until we find one that we can attack
+   for(S32 i = 0; i < items.size(); i++)
+      if(fireAtObject(static_cast<BfObject *>(items[i]), WeaponPhaser))
+         break;
+}
+
+
+// Fires at the specified object with the specified weapon if the obj is a good target.  Does not fire if object is on
+// the same team or if there is something in the way.  Returns whether it fired or not.
+bool SBotController::fireAtObject(BfObject *obj, WeaponType weapon)
+{
+   U8 classId = obj->getObjectTypeNumber();
+   S32 team = obj->getTeam();
+
+   if(classId == TurretTypeNumber || classId == ForceFieldProjectorTypeNumber)
+   {
+      // Ignore all same-team engineered objects...  even in single-team games
+      if(team == mBot->getTeam())
+         return false;
+
+      if(obj->getHealth() < .1f)      // If item is essentially dead
+         return false;
+   }
+
+   bool isShip = classId == PlayerShipTypeNumber || classId == RobotShipTypeNumber;
+
+   // No shooting various team related objects; turrets and FFs handled above
+   if(((team == mBot->getTeam() && mIsTeamGame) || team == TEAM_NEUTRAL) &&
+      (isShip || classId == CoreTypeNumber || classId == SpyBugTypeNumber))
+      return false;
+
+   // No shooting non-flag carriers in single player rabbit
+   if(mGameType == RabbitGame && !mIsTeamGame && isShip &&
+      mBot->getFlagCount() == 0 && static_cast<Ship *>(obj)->getFlagCount() == 0)
+      return false;
+
+   // We made it here!  We have a valid target..
+   F32 angle;
+   if(!mView->getFiringSolution(obj, angle) || !mView->fireWeapon(*mMove, weapon))
+      return false;
+
+   F32 offset = ((Random::readF() * 2) - 1) * WorstAccuracy * (1 - mProfile->accuracy);
+   mMove->angle = angle + offset;
+
+   return true;
+}
+
+
+void SBotController::orbitPoint(const Point &pt, S32 direction, F32 distAway, F32 strictness)
+{
+   F32 dist = pt.distanceTo(mBotPos);
+   F32 deltaDistance = (dist - distAway) * strictness / distAway;
+   F32 sign = deltaDistance < 0 ? -1.f : 1.f;
+
+   F32 changeInAngle = (fabs(deltaDistance) / (deltaDistance + sign)) * FloatHalfPi;
+   F32 angleToPoint = pt.angleTo(mBotPos);
+
+   mDirToGo = angleToPoint + (FloatHalfPi + changeInAngle) * direction;
+}
+
+
+void SBotController::gotoPosition(const Point &pt)
+{
+   mGotoPositionWasNil = false;
+
+   if(mPathTimer < .01)
+   {
+      Point goalPt;
+      if(mView->getWaypoint(pt, goalPt))
+         mDirToGo = mBotPos.angleTo(goalPt);
+   }
+}
+
+
+void SBotController::gotoAndOrbitPosition(const Point &pt)
+{
+   mGotoPositionWasNil = false;
+
+   if(!mView->canSeePoint(pt))
+      gotoPosition(pt);
+   else
+      orbitPoint(pt, mOrbitalDirection, mBotRadius * 5, 2);
+}
+
+
+// TODO Use aggression in a different manner since I have no idea what this is doing
+void SBotController::setAggressiveAttackTarget(Ship *target)
+{
+   if(!target)
+      return;
+
+   static const U8 types[] = { PlayerShipTypeNumber, RobotShipTypeNumber };
+   static const Vector<U8> typeList(types, ARRAYSIZE(types));
+
+   F32 myPow = getPower(mBot);
+
+   FillVector items;
+   mView->findVisibleObjects(typeList, items);
+
+   F32 otherPow = (F32)target->getEnergy() / (F32)Ship::EnergyMax + target->getHealth() * items.size();
+
+   // Advantage is between -1 and 1, -1 meaning an extreme disadvantage and 1 meaning an extreme advantage
+   F32 advantage = (myPow - otherPow) / max(myPow, otherPow);
+
+   if((advantage * 0.5f) + .5f > 1 - mProfile->aggression)
+   {
+      mPrevTarget = target->getPos();
+      mHasPrevTarget = true;
+   }
+}
+
+
+// Returns the objective for the bot, in the form of an object the bot can navigate towards.  This makes bots choose
+// different defending locations.  With OnTeam, will only return items on the specified team; with NotOnTeam, will only
+// return items *not* on the specified team.  With AnyTeam, team is ignored.
+BfObject *SBotController::getObjective(U8 objType, S32 team, TeamFilter filter)
+{
+   FillVector items;
+   mView->findAllObjects(objType, items);     // All items of type objType in the game
+
+   Vector<BfObject *> itemsOnMyTeam;
+
+   for(S32 i = 0; i < items.size(); i++)
+   {
+      BfObject *item = static_cast<BfObject *>(items[i]);
+      S32 itemTeamIndex = item->getTeam();
+
+      if(objType == FlagTypeNumber && mGameType == NexusGame)
+      {
+         if(!static_cast<FlagItem *>(item)->isMounted())
+            itemsOnMyTeam.push_back(item);
+      }
+      else if(objType == FlagTypeNumber && (mGameType == HTFGame || mGameType == RetrieveGame) &&
+              static_cast<FlagItem *>(item)->getZone())
+      {
+         if(static_cast<FlagItem *>(item)->getZone()->getTeam() != mBot->getTeam())
+            itemsOnMyTeam.push_back(item);
+      }
+      else if(objType == GoalZoneTypeNumber && (mGameType == HTFGame || mGameType == RetrieveGame))
+      {
+         if((filter == AnyTeam || (itemTeamIndex == team) == (filter == OnTeam)) && !static_cast<GoalZone *>(item)->hasFlag())
+            itemsOnMyTeam.push_back(item);
+      }
+      else
+      {
+         // Anything neutral is on our team (except zone control neutral goal zone)
+         if(itemTeamIndex == TEAM_NEUTRAL && (objType != GoalZoneTypeNumber || mGameType != ZoneControlGame))
+            itemTeamIndex = team;
+
+         if(filter == AnyTeam || (itemTeamIndex == team) == (filter == OnTeam))
+            itemsOnMyTeam.push_back(item);
+      }
+   }
+
+   if(itemsOnMyTeam.size() == 0)
+      return NULL;
+
+   return itemsOnMyTeam[mObjective % itemsOnMyTeam.size()];
+}
+
+
+void SBotController::doObjective(Ship *closestEnemy)
+{
+   mGotoPositionWasNil = true;
+
+   S32 myTeam = mBot->getTeam();
+
+   if(mGameType == BitmatchGame)
+   {
+      // Nothing to do here
+   }
+   else if(mGameType == NexusGame)
+   {
+      // Grab any flags that are found, and go to nexus when it opens
+      BfObject *otherFlag = getObjective(FlagTypeNumber);      // Find any flags
+      if(otherFlag)
+         gotoPosition(otherFlag->getPos());
+
+      // If bot has more than 4 flags and the nexus is open or we're within 10 seconds of opening
+      NexusGameType *nexusGame = static_cast<NexusGameType *>(mView->getGameType());
+
+      if(mBot->getFlagCount() > 4 && (nexusGame->isNexusOpen() || nexusGame->getNexusTimeLeftMs() < 10000))
+      {
+         BfObject *nexus = getObjective(NexusTypeNumber);
+         if(nexus)
+            gotoPosition(nexus->getPos());
+      }
+   }
+   else if(mGameType == RabbitGame)
+   {
+      // Grab a flag, or go after the flag
+      if(mBot->getFlagCount() == 0)
+      {
+         BfObject *otherFlag = getObjective(FlagTypeNumber, myTeam, OnTeam);      // Find flags on our team
+         if(otherFlag)
+            gotoPosition(otherFlag->getPos());
+      }
+   }
+   else if(mGameType == HTFGame || mGameType == RetrieveGame)
+   {
+      // Grab the flag and put it into goal zones
+      if(mBot->getFlagCount() > 0)
+      {
+         BfObject *goal = getObjective(GoalZoneTypeNumber, myTeam, OnTeam);       // Find an available GoalZone on our team
+         if(goal)
+            gotoPosition(goal->getPos());
+      }
+      else
+      {
+         BfObject *otherFlag = getObjective(FlagTypeNumber, myTeam, OnTeam);      // Find flags on our team
+         if(otherFlag)
+            gotoPosition(otherFlag->getPos());
+      }
+   }
+   else if(mGameType == CTFGame)
+   {
+      // Defend the flag
+      FlagItem *myFlag    = static_cast<FlagItem *>(getObjective(FlagTypeNumber, myTeam, OnTeam));      // Our flag
+      FlagItem *otherFlag = static_cast<FlagItem *>(getObjective(FlagTypeNumber, myTeam, NotOnTeam));   // Theirs
+
+      if(!myFlag)
+      {
+         // The script would come to grief here; we'll just fall back on chasing enemies
+      }
+      else if(mProfile->defense < .5f)                     // If bot doesn't defend a lot (default is 0)
+      {
+         if(mBot->getFlagCount() > 0)
+         {
+            if(!myFlag->isMounted())
+               gotoPosition(myFlag->getPos());                  // Go to position of my flag
+            else
+               gotoAndOrbitPosition(myFlag->getPos());          // Otherwise, go and orbit the flag on enemy
+         }
+         else
+         {
+            bool retrievingFlag = false;
+
+            // If my flag is not home and not on a ship, and we're within some sane range of it, go return it
+            if(!myFlag->isAtHome() && !myFlag->isMounted() && myFlag->getPos().distSquared(mBotPos) <= 2000 * 2000)
+            {
+               gotoPosition(myFlag->getPos());
+               retrievingFlag = true;
+            }
+
+            if(otherFlag && !retrievingFlag)
+            {
+               if(myFlag->isMounted())                          // If my flag is on a ship
+                  gotoPosition(myFlag->getPos());               // Go to position of my flag
+               else if(!otherFlag->isMounted())                 // If enemy flag is not on a ship
+                  gotoPosition(otherFlag->getPos());            // Go to that flag
+               else
+                  gotoAndOrbitPosition(otherFlag->getPos());    // Go and orbit our team flag's carrier
+            }
+         }
+      }
+      else
+      {
+         if(mBot->getFlagCount() > 0)
+            gotoPosition(myFlag->getPos());                     // Go to team flag
+         else if(myFlag->isAtHome() || myFlag->isMounted())
+            gotoAndOrbitPosition(myFlag->getPos());             // Go and orbit team flag
+         else
+            gotoPosition(myFlag->getPos());                     // If team flag is loose, go to it
+      }
+   }
+   else if(mGameType == SoccerGame)
+   {
+      // Grab soccer and put into enemy goal
+      if(mBot->isCarryingItem(SoccerBallItemTypeNumber))
+      {
+         BfObject *goal = getObjective(GoalZoneTypeNumber, myTeam, NotOnTeam);    // Find GoalZones not on our team
+         if(goal)
+            gotoPosition(goal->getPos());
+      }
+      else
+      {
+         BfObject *ball = getObjective(SoccerBallItemTypeNumber);
+         if(ball)
+            gotoPosition(ball->getPos());
+      }
+   }
+   else if(mGameType == ZoneControlGame)
+   {
+      // Grab flag, then go after zones that are not ours
+      if(mBot->getFlagCount() == 0)
+      {
+         FlagItem *otherFlag = static_cast<FlagItem *>(getObjective(FlagTypeNumber, myTeam, OnTeam));   // Flags on our team
+         if(otherFlag)
+         {
+            if(otherFlag->isMounted())
+               gotoAndOrbitPosition(otherFlag->getPos());
+            else
+               gotoPosition(otherFlag->getPos());
+         }
+      }
+      else
+      {
+         BfObject *zone = getObjective(GoalZoneTypeNumber, myTeam, NotOnTeam);    // GoalZones not ours
+         if(zone)
+            gotoPosition(zone->getPos());
+      }
+   }
+   else if(mGameType == CoreGame)
+   {
+      BfObject *core = getObjective(CoreTypeNumber, myTeam, NotOnTeam);           // Find enemy Core
+      if(core)
+         gotoAndOrbitPosition(core->getPos());
+   }
+
+   // If we have no where to go, go to nearest enemy
+   if(mGotoPositionWasNil)
+   {
+      if(closestEnemy)
+      {
+         mPrevTarget = closestEnemy->getPos();
+         mHasPrevTarget = true;
+      }
+
+      if(mHasPrevTarget)
+         gotoAndOrbitPosition(mPrevTarget);
+   }
+}
+
+
+void SBotController::onTick(const WorldView &view, Move &move)
+{
+   mView = &view;
+   mMove = &move;
+   mBot = view.getBot();
+   mBotPos = mBot->getActualPos();
+   mBotRadius = mBot->getRadius();
+   mGameType = view.getGameType()->getGameTypeId();
+   mIsTeamGame = view.getGameType()->isTeamGame();
+
+   mPathTimer -= view.getDeltaT();
+
+   Ship *closestEnemy = view.findClosestEnemy();
+
+   setAggressiveAttackTarget(closestEnemy);
+   doObjective(closestEnemy);                               // Set bot's objective
+
+   view.setThrust(move, mProfile->speed, mDirToGo);         // Move the ship
+   fireAtObjects();                                         // Fire weapons
+   shield();                                                // Apply shield
+
+   if(mPathTimer < 0)
+      mPathTimer = PathTimerMax + Random::readI(0, PathTimerMax);
+
+   mView = NULL;
+   mMove = NULL;
+}
+
+
+} /* namespace Zap */
@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _SBOT_CONTROLLER_H_
+#define _SBOT_CONTROLLER_H_
+
+#include "BotController.h"
+
+#include "GameTypesEnum.h"
+
+namespace Zap
+{
+
+// S_Bot, our beloved Standard Bot, in C++.  A line by line port of resource/robots/s_bot.bot that plays the same way,
+// for filling servers with bots that cost next to nothing.  Get one with "native:s_bot".
+class SBotController : public BotController
+{
+private:
+   struct Profile {
+      const char *name;
+      F32 difficulty;
+      F32 aggression;
+      F32 defense;
+      F32 speed;
+      F32 accuracy;
+      F32 dodging;
+   };
+
+   static const Profile Profiles[];
+   static const S32 PathTimerMax = 250;
+   static const S32 AverageShieldMaxTicks = 20;
+
+   // Which items getObjective() wants, by team
+   enum TeamFilter {
+      AnyTeam,
+      OnTeam,
+      NotOnTeam
+   };
+
+   const Profile *mProfile;
+
+   S32 mPathTimer;
+   F32 mDirToGo;
+   bool mGotoPositionWasNil;
+
+   Point mPrevTarget;
+   bool mHasPrevTarget;
+
+   bool mAverageShieldArray[AverageShieldMaxTicks];
+   S32 mAverageShieldIndex;
+
+   S32 mOrbitalDirection;
+   S32 mObjective;
+
+   // Set at the start of each tick
+   const WorldView *mView;
+   Move *mMove;
+   Robot *mBot;
+   Point mBotPos;
+   F32 mBotRadius;
+   GameTypeId mGameType;
+   bool mIsTeamGame;
+
+   bool shieldSelf();
+   void shield();
+   void fireAtObjects();
+   bool fireAtObject(BfObject *obj, WeaponType weapon);
+
+   void orbitPoint(const Point &pt, S32 direction, F32 distAway, F32 strictness);
+   void gotoPosition(const Point &pt);
+   void gotoAndOrbitPosition(const Point &pt);
+
+   void setAggressiveAttackTarget(Ship *target);
+   BfObject *getObjective(U8 objType, S32 team = 0, TeamFilter filter = AnyTeam);
+   void doObjective(Ship *closestEnemy);
+
+public:
+   SBotController();                      // Constructor
+   virtual ~SBotController();             // Destructor
+
+   static BotController *create(const Vector<string> &args);
+
+   string getName();
+   void onTick(const WorldView &view, Move &move);
+};
+
+
+} /* namespace Zap */
+#endif
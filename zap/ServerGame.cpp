@@ -7,6 +7,8 @@
 
 #include "BanList.h"             // For banList kick duration
 #include "BotNavMeshZone.h"      // For zone clearing code
+#include "BotNavRouteTable.h"
+#include "BotZoneCache.h"
 #include "gameConnection.h"      // Need Color definitions for RPCs
 #include "GameManager.h"
 #include "gameNetInterface.h"
@@ -14,6 +16,7 @@
 #include "gameType.h"
 #include "IniFile.h"
 #include "Level.h"
+#include "LevelPreparer.h"
 #include "LevelSource.h"
 #include "LevelSpecifierEnum.h" 
 #include "luaGameInfo.h"
@@ -33,7 +36,7 @@ using namespace TNL;
 namespace Zap
 {
 
-static bool instantiated;           // Just a little something to keep us from creating multiple ServerGames...
+static S32 instanceCount;           // Just a little something to keep us from creating multiple ServerGames...
 
 
 // Constructor -- be sure to see Game constructor too!  Lots going on there!
@@ -41,10 +44,11 @@ ServerGame::ServerGame(const Address &address, GameSettingsPtr settings, LevelSo
       Game(address, settings),
       mRobotManager(this, settings)
 {
-   TNLAssert(!instantiated, "Only one ServerGame at a time, please!  If this trips while testing, "
+   // ...except on a dedicated server, which may host several arenas side by side
+   TNLAssert(instanceCount == 0 || dedicated, "Only one ServerGame at a time, please!  If this trips while testing, "
       "it is probably because a test failed before another instance could be deleted.  Try disabling "
       "this assert, see what test fails, and fix it.  Then re-enable it, please!");
-   instantiated = true;
+   instanceCount++;
 
    mLevelSource = levelSource;
 
@@ -118,9 +122,17 @@ ServerGame::ServerGame(const Address &address, GameSettingsPtr settings, LevelSo
    botControlTickTimer.reset(BotControlTickInterval);
 
    mLevelSwitchTimer.setPeriod(LevelSwitchTime);
-   GameManager::setHostingModePhase(GameManager::NotHosting);
+   mHostingModePhase = GameManager::NotHosting;
 
    mGameRecorderServer = NULL;
+
+   mLevelLoadPhaseStart = 0;
+   mBotZonesFromCache = false;
+
+   mLevelPreparer = NULL;
+   mNextLevelPrepStarted = false;
+   mBotZonesPrepared = false;
+   mPreparedBotZonesFailed = false;
 }
 
 
@@ -132,11 +144,10 @@ ServerGame::~ServerGame()
 
    cleanUp();
 
-   instantiated = false;
+   instanceCount--;
 
    delete mGameInfo;
-
-   GameManager::setHostingModePhase(GameManager::NotHosting);
+   delete mLevelPreparer;
 
    if(mGameRecorderServer)
       delete mGameRecorderServer;
@@ -146,7 +157,7 @@ ServerGame::~ServerGame()
 // Called before we load a new level, or when we shut the server down
 void ServerGame::cleanUp()
 {
-   fillVector.clear();
+   FillVector fillVector;
    mDatabaseForBotZones.findObjects(fillVector);
 
    mLevelGens.deleteAndClear();
@@ -303,6 +314,18 @@ void ServerGame::resetLevelLoadIndex()
 }
 
 
+GameManager::HostingModePhase ServerGame::getHostingModePhase() const
+{
+   return mHostingModePhase;
+}
+
+
+void ServerGame::setHostingModePhase(GameManager::HostingModePhase phase)
+{
+   mHostingModePhase = phase;
+}
+
+
 // Return true if the only client connected is the one we passed; don't consider bots
 bool ServerGame::onlyClientIs(GameConnection *client)
 {
@@ -364,7 +387,7 @@ string ServerGame::loadNextLevelInfo()
    if(mLevelLoadIndex == mLevelSource->getLevelCount())
    {
       TNLAssert(mHostOnServer, "Shouldn't be empty if not using -hostonserver");
-      GameManager::setHostingModePhase(GameManager::DoneLoadingLevels);
+      setHostingModePhase(GameManager::DoneLoadingLevels);
       return string("No levels loaded");
    }
 
@@ -380,7 +403,7 @@ string ServerGame::loadNextLevelInfo()
 
    // Last level to process?
    if(mLevelLoadIndex == mLevelSource->getLevelCount())
-      GameManager::setHostingModePhase(GameManager::DoneLoadingLevels);
+      setHostingModePhase(GameManager::DoneLoadingLevels);
 
    return levelName;
 }
@@ -525,6 +548,10 @@ void ServerGame::cycleLevel(S32 nextLevel, bool isReset)
       }
    }
 
+   startLevelLoadTiming();
+
+   mNextLevelPrepStarted = false;
+
    delete mGameRecorderServer;
    mGameRecorderServer = NULL;
 
@@ -537,7 +564,10 @@ void ServerGame::cycleLevel(S32 nextLevel, bool isReset)
 
    // If mLevel is NULL, it's our first time here, and there won't be anything to clean up
    if(mLevel)
+   {
+      LuaScriptRunner::logCpuUsage();
       cleanUp();
+   }
 
    // We moved the clearing code into cleanup()... I think it will always be run.  But better check!
    TNLAssert(mLevelSwitchTimer.getCurrent() == 0, "Expected this to be clear!");
@@ -559,6 +589,8 @@ void ServerGame::cycleLevel(S32 nextLevel, bool isReset)
 
    mRobotManager.onLevelChanged();
 
+   endLevelLoadPhase("cleanup");
+
    if(!loadNextLevel(nextLevel))
       return;
 
@@ -571,9 +603,8 @@ void ServerGame::cycleLevel(S32 nextLevel, bool isReset)
    // dynamic geometry, or if it is a test server, because the user might be editing levels, making caching non-sensical.
    bool hasLevelgens = getSettings()->getGlobalScriptCount() > 0 || getGameType()->getScriptName() != "";
 
-   bool writeZonesToDb = !hasLevelgens && !isTestServer() && mSettings->usingDatabaseZoneCache;
-
-   buildBotMeshZones(writeZonesToDb);
+   buildBotMeshZones(!hasLevelgens && !isTestServer());
+   endLevelLoadPhase(mBotZonesPrepared ? "zones (prepared)" : mBotZonesFromCache ? "zones (cached)" : "zones");
 
    // Clear team info for all clients
    resetAllClientTeams();
@@ -639,14 +670,100 @@ void ServerGame::cycleLevel(S32 nextLevel, bool isReset)
    sendLevelStatsToMaster();     // Give the master some information about this level for its database
 
    suspendIfNoActivePlayers();   // Does nothing if we're already suspended
+
+   endLevelLoadPhase("players");
+   logLevelLoadTimes();
+}
+
+
+void ServerGame::startLevelLoadTiming()
+{
+   mLevelLoadTimes.clear();
+   mLevelLoadPhaseStart = Platform::getHighPrecisionTimerValue();
+}
+
+
+void ServerGame::endLevelLoadPhase(const char *phase)
+{
+   S64 now = Platform::getHighPrecisionTimerValue();
+
+   mLevelLoadTimes.push_back(pair<const char *, F64>(phase, Platform::getHighPrecisionMilliseconds(now - mLevelLoadPhaseStart)));
+   mLevelLoadPhaseStart = now;
+}
+
+
+void ServerGame::logLevelLoadTimes() const
+{
+   F64 total = 0;
+   string phases;
+
+   for(S32 i = 0; i < mLevelLoadTimes.size(); i++)
+   {
+      char phase[64];
+      snprintf(phase, sizeof(phase), "%s%s %.1f", i > 0 ? ", " : "", mLevelLoadTimes[i].first, mLevelLoadTimes[i].second);
+
+      phases += phase;
+      total += mLevelLoadTimes[i].second;
+   }
+
+   logprintf(LogConsumer::ServerFilter, "Level change took %.1f ms (%s)", total, phases.c_str());
+}
+
+
+const Vector<pair<const char *, F64> > &ServerGame::getLevelLoadTimes() const
+{
+   return mLevelLoadTimes;
+}
+
+
+bool ServerGame::getBotZonesFromCache() const
+{
+   return mBotZonesFromCache;
+}
+
+
+// We only need to triangulate the zones if we might display them on the front end (with /showzones).  This will never
+// occur on a dedicated server, so don't waste the cycles computing it there.
+bool ServerGame::getTriangulateZones() const
+{
+#ifdef ZAP_DEDICATED
+   return false;
+#else
+   return !isDedicated();
+#endif
+}
+
+
+// If cacheZones is set, zones are loaded from the zone cache if they're there, and put there if they're not.  Only do that
+// for levels whose geometry is all in the level file, or the cache could be out of date without our knowing it.
+void ServerGame::buildBotMeshZones(bool cacheZones)
+{
+   // Built in the background, along with the rest of the level
+   if(mBotZonesPrepared)
+   {
+      getGameType()->mBotZoneCreationFailed = mPreparedBotZonesFailed;
+      return;
+   }
+
+   Vector<DatabaseObject *> barrierList;
+   getLevel()->findObjects((TestFunc)isWallType, barrierList);
+
+   // Try and load Bot Zones for this level, set flag if failed.
+   // We need to run buildBotMeshZones in order to set mAllZones properly, which is why I (sort of) disabled the use of 
+   // hand-built zones in level files.
+   getGameType()->mBotZoneCreationFailed = !buildBotMeshZones(mLevel.get(), getWorldExtents(), barrierList, getTriangulateZones(),
+                                                              cacheZones, mSettings->usingDatabaseZoneCache, mBotZonesFromCache);
 }
 
 
-void ServerGame::buildBotMeshZones(bool writeZonesToDb)
+// Builds level's zones and route table from its objects and the barriers we pass in, or loads the zones from the cache.
+// Doesn't touch the game, so a LevelPreparer can run it on a worker thread for a level that isn't in play yet.  Static method.
+bool ServerGame::buildBotMeshZones(Level *level, const Rect *worldExtents, const Vector<DatabaseObject *> &barrierList,
+                                   bool triangulateZones, bool cacheZones, bool usingDatabaseZoneCache, bool &loadedFromCache)
 {
    ////// This block could easily be moved off somewhere else   
-   fillVector.clear();
-   mLevel->findObjects(TeleporterTypeNumber, fillVector);
+   FillVector fillVector;
+   level->findObjects(TeleporterTypeNumber, fillVector);
 
    Vector<pair<Point, const Vector<Point> *> > teleporterData(fillVector.size());
    pair<Point, const Vector<Point> *> teldat;
@@ -662,32 +779,109 @@ void ServerGame::buildBotMeshZones(bool writeZonesToDb)
    }
 
    // Get our parameters together
-   Vector<DatabaseObject *> barrierList;
-   getLevel()->findObjects((TestFunc)isWallType, barrierList);
-
    Vector<DatabaseObject *> turretList;
-   getLevel()->findObjects(TurretTypeNumber, turretList);
+   level->findObjects(TurretTypeNumber, turretList);
 
    Vector<DatabaseObject *> forceFieldProjectorList;
-   getLevel()->findObjects(ForceFieldProjectorTypeNumber, forceFieldProjectorList);
+   level->findObjects(ForceFieldProjectorTypeNumber, forceFieldProjectorList);
 
 
-   // Try and load Bot Zones for this level, set flag if failed.
-   // We need to run buildBotMeshZones in order to set mAllZones properly, which is why I (sort of) disabled the use of 
-   // hand-built zones in level files.
-   // We only need to triangulate the zones if we might display them on the front end (with /showzones).  This will never
-   // occur on a dedicated server, so don't waste the cycles computing it there.
-#ifdef ZAP_DEDICATED
-   bool triangulateZones = false;
-#else
-   bool triangulateZones = !isDedicated();
-#endif
+   string cacheFile = BotZoneCache::getCacheFileName(BotZoneCache::CacheDir, level->getHash());
+
+   loadedFromCache = cacheZones && BotZoneCache::load(cacheFile, level->getHash(), level->getBotZoneDatabase(),
+                                                      level->getBotZoneList(), triangulateZones);
+   bool built = loadedFromCache;
+
+   if(!loadedFromCache)
+   {
+      // Zones used to be cached in the level database.  We still look there, so they don't all have to be built again,
+      // but they only get written to the new cache now.
+      built = BotNavMeshZone::buildBotMeshZones(level->getBotZoneDatabase(), level->getBotZoneList(),
+         worldExtents, barrierList, turretList,
+         forceFieldProjectorList, teleporterData, triangulateZones,
+         level->getSqliteLevelId(), false, cacheZones && usingDatabaseZoneCache);
+
+      if(cacheZones && built && makeSureFolderExists(BotZoneCache::CacheDir))
+         BotZoneCache::save(cacheFile, level->getHash(), level->getBotZoneList());
+   }
+
+   // Work out the bots' routes in the background, so nobody has to wait on them mid-game
+   if(!built)
+      level->setBotRouteTable(NULL);
+   else
+   {
+      level->setBotRouteTable(new BotNavRouteTable(level->getBotZoneList()));
+      level->getBotRouteTable()->startBuilding();
+   }
+
+   return built;
+}
+
+
+// Once the game is nearly over, start getting whichever level comes next ready, so the switch doesn't stall everyone
+void ServerGame::prepareNextLevel()
+{
+   if(mLevelPreparer)
+      mLevelPreparer->idle();
+
+   if(mNextLevelPrepStarted || mHostOnServer || mShuttingDown || mLevelSource->getLevelCount() == 0)
+      return;
+
+   GameType *gameType = getGameType();
+
+   if(!gameType->isGameOver() && (gameType->isTimeUnlimited() || gameType->getRemainingGameTimeInMs() > (S32)NextLevelPrepTime))
+      return;
+
+   mNextLevelPrepStarted = true;
+
+   // Settle on a random level now, so it's the one we prepare
+   if(mNextLevel == RANDOM_LEVEL)
+      mNextLevel = getAbsoluteLevelIndex(RANDOM_LEVEL);
 
+   S32 levelIndex = getAbsoluteLevelIndex(mNextLevel);
+   string filename = mLevelSource->findLevelFile(levelIndex);
 
-   getGameType()->mBotZoneCreationFailed = !BotNavMeshZone::buildBotMeshZones(mLevel->getBotZoneDatabase(), mLevel->getBotZoneList(),
-      getWorldExtents(), barrierList, turretList,
-      forceFieldProjectorList, teleporterData, triangulateZones,
-      mLevel->getSqliteLevelId(), writeZonesToDb, mSettings->usingDatabaseZoneCache);
+   if(filename == "")
+      return;
+
+   delete mLevelPreparer;
+   mLevelPreparer = new LevelPreparer(levelIndex, filename, mLevelSource->getLevelInfo(levelIndex).getSqliteLevelId(),
+                                      getSettings()->getGlobalScriptCount() > 0, getTriangulateZones(), !isTestServer(),
+                                      mSettings->usingDatabaseZoneCache);
+   mLevelPreparer->start();
+}
+
+
+// Returns the prepared level, if it's the one we're after, otherwise NULL.  Either way, we're done with the preparer.
+Level *ServerGame::takePreparedLevel(S32 levelIndex)
+{
+   mBotZonesPrepared = false;
+
+   if(!mLevelPreparer)
+      return NULL;
+
+   Level *level = NULL;
+
+   // Check the file too, in case the level list has changed underneath us
+   if(mLevelPreparer->getLevelIndex() == levelIndex && mLevelSource->findLevelFile(levelIndex) == mLevelPreparer->getFilename())
+   {
+      level = mLevelPreparer->takeLevel();
+
+      mBotZonesPrepared = level && mLevelPreparer->hasBotZones();
+      mPreparedBotZonesFailed = mLevelPreparer->getZoneCreationFailed();
+      mBotZonesFromCache = mLevelPreparer->getZonesFromCache();
+   }
+
+   delete mLevelPreparer;
+   mLevelPreparer = NULL;
+
+   return level;
+}
+
+
+const LevelPreparer *ServerGame::getLevelPreparer() const
+{
+   return mLevelPreparer;
 }
 
 
@@ -746,7 +940,9 @@ bool ServerGame::loadNextLevel(S32 nextLevel)
 // Returns true if the level is successfully loaded, false if it wasn't
 bool ServerGame::loadLevel()
 {
-   mLevel = shared_ptr<Level>(mLevelSource->getLevel(mCurrentLevelIndex));
+   Level *level = takePreparedLevel(mCurrentLevelIndex);
+
+   mLevel = shared_ptr<Level>(level ? level : mLevelSource->getLevel(mCurrentLevelIndex));
 
    TNLAssert(!mLevel->getAddedToGame(), "Can't reuse Levels!");
 
@@ -758,12 +954,16 @@ bool ServerGame::loadLevel()
       return false;
    }
 
+   endLevelLoadPhase("read");
+
    mLevel->onAddedToGame(this);     // Gets the TeamManager up and running and populated, adds bots
 
    addObjectsToGame();
 
    mLevel->addBots(this);
 
+   endLevelLoadPhase("objects");
+
    // Levelgens:
    // Run level's levelgen script (if any)
    if(!runLevelGenScript(getGameType()->getScriptName()))
@@ -790,6 +990,8 @@ bool ServerGame::loadLevel()
 
    getGameType()->onLevelLoaded();
 
+   endLevelLoadPhase("levelgens");
+
    return true;
 }
 
@@ -866,7 +1068,7 @@ void ServerGame::sendLevelStatsToMaster()
       return;
 
    // Also don't bother if we are not yet in full-on hosting mode
-   if(GameManager::getHostingModePhase() != GameManager::Hosting)
+   if(mHostingModePhase != GameManager::Hosting)
       return;
 
    MasterServerConnection *masterConn = getConnectionToMaster();
@@ -1506,7 +1708,7 @@ bool ServerGame::isServer() const
 void ServerGame::idle(U32 timeDelta)
 {
    // No idle during pre-game level loading or when there is an error state
-   if(GameManager::getHostingModePhase() == GameManager::LoadingLevels)
+   if(mHostingModePhase == GameManager::LoadingLevels)
       return;
 
    Parent::idle(timeDelta);
@@ -1578,6 +1780,9 @@ void ServerGame::idle(U32 timeDelta)
       }
    }
 
+   // Events the simulation fires below can be held back and handed out together, see EventManager::setDeferred()
+   EventManager::get()->setDeferred(mSettings->getSetting<YesNo>(IniKey::DeferScriptEvents));
+
    // Tick levelgen timers
    for(S32 i = 0; i < mLevelGens.size(); i++)
       mLevelGens[i]->tickTimer<LuaLevelGenerator>(timeDelta);
@@ -1596,17 +1801,27 @@ void ServerGame::idle(U32 timeDelta)
    computeWorldObjectExtents();
 
    U32 botControlTickElapsed = botControlTickTimer.getElapsed();
+   U32 botTickDeltaT = 0;        // Time to pass to onTick for bots thinking in parallel, if they get one this time
 
    if(botControlTickTimer.update(timeDelta))
    {
       // Clear all old bot moves, so that if the bot does nothing, it doesn't just continue with what it was doing before
       mRobotManager.clearMoves();
 
+      if(!EventManager::get()->suppressEvents(EventManager::TickEvent))
+         botTickDeltaT = botControlTickElapsed + timeDelta;
+
       // Fire TickEvent, in case anyone is listening
       EventManager::get()->fireEvent(EventManager::TickEvent, botControlTickElapsed + timeDelta);
 
+      // Native bots don't subscribe; they all get their tick
+      mRobotManager.tickNativeBots(botControlTickElapsed + timeDelta);
+
       botControlTickTimer.reset();
    }
+
+   // Bots with Lua states of their own think now, all together; the rest will think as they idle below
+   mRobotManager.think(timeDelta, botTickDeltaT);
    
    const Vector<DatabaseObject *> *gameObjects = mLevel->findObjects_fast();
 
@@ -1630,8 +1845,15 @@ void ServerGame::idle(U32 timeDelta)
    TNLAssert(getGameType(), "Expect a GameType here!");
    getGameType()->idle(BfObject::ServerIdleMainLoop, timeDelta);
 
+   // Deliver any events held back this tick, before anything they mention is deleted; anything fired between ticks
+   // goes out as it happens
+   EventManager::get()->setDeferred(false);
+
    processDeleteList(timeDelta);
 
+   // Get the next level ready in the background as this one winds down
+   prepareNextLevel();
+
    // Load a new level if the time is out on the current one
    if(mLevelSwitchTimer.update(timeDelta))
    {
@@ -1954,7 +2176,7 @@ bool ServerGame::startHosting()
 
    if(mHostOnServer)
    {
-      GameManager::setHostingModePhase(GameManager::NotHosting);
+      setHostingModePhase(GameManager::NotHosting);
       cycleLevel(FIRST_LEVEL);   // Start with the first level
       return true;
    }
@@ -1968,7 +2190,7 @@ bool ServerGame::startHosting()
    if(levelCount == 0)        // No levels loaded... we'll crash if we try to start a game       
       return false;
 
-   GameManager::setHostingModePhase(GameManager::NotHosting);
+   setHostingModePhase(GameManager::NotHosting);
    cycleLevel(FIRST_LEVEL);   // Start with the first level
 
    return true;
@@ -2126,6 +2348,13 @@ const Vector<BotNavMeshZone *> &ServerGame::getBotZoneList() const
 }
 
 
+// Will be NULL if zones could not be built
+BotNavRouteTable *ServerGame::getBotRouteTable() const
+{
+   return mLevel->getBotRouteTable();
+}
+
+
 GridDatabase &ServerGame::getBotZoneDatabase() const
 {
    return mLevel->getBotZoneDatabase();
@@ -2135,7 +2364,7 @@ GridDatabase &ServerGame::getBotZoneDatabase() const
 // Returns ID of zone containing specified point
 U16 ServerGame::findZoneContaining(const Point &p) const
 {
-   fillVector.clear();
+   FillVector fillVector;
    mLevel->getBotZoneDatabase().findObjects(BotNavMeshZoneTypeNumber, fillVector,
                                 Rect(p - Point(0.1f, 0.1f), p + Point(0.1f, 0.1f)));  // Slightly extend Rect, it can be on the edge of zone
 
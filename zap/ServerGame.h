@@ -7,6 +7,7 @@
 #define _SERVER_GAME_H_
 
 #include "game.h"                // Parent class
+#include "GameManager.h"         // For HostingModePhase def
 
 #include "BotNavMeshZone.h"
 #include "dataConnection.h"
@@ -22,6 +23,8 @@ using namespace std;
 namespace Zap
 {
 
+class BotNavRouteTable;
+class LevelPreparer;
 class LuaLevelGenerator;
 class LuaGameInfo;
 class Robot;
@@ -65,6 +68,7 @@ private:
 
    bool mDedicated;
    S32 mLevelLoadIndex;                   // For keeping track of where we are in the level loading process.  NOT CURRENT LEVEL IN PLAY!
+   GameManager::HostingModePhase mHostingModePhase;   // Each ServerGame loads its levels and starts hosting on its own
 
    SafePtr<GameConnection> mSuspendor;    // Player requesting suspension if game suspended by request
    Timer mTimeToSuspend;
@@ -102,6 +106,25 @@ private:
 
    Vector<string> mSentHashes;            // Hashes of levels already sent to master
 
+   // How long each part of the last level change took, so we can see where the time goes
+   Vector<pair<const char *, F64> > mLevelLoadTimes;     // Phase name, ms
+   S64 mLevelLoadPhaseStart;
+   bool mBotZonesFromCache;
+
+   // The next level, being got ready in the background
+   LevelPreparer *mLevelPreparer;
+   bool mNextLevelPrepStarted;            // So we only try once per game
+   bool mBotZonesPrepared;                // True if the level in play came with its zones already built
+   bool mPreparedBotZonesFailed;
+
+   void prepareNextLevel();
+   Level *takePreparedLevel(S32 levelIndex);
+   bool getTriangulateZones() const;
+
+   void startLevelLoadTiming();
+   void endLevelLoadPhase(const char *phase);
+   void logLevelLoadTimes() const;
+
    void updateStatusOnMaster();           // Give master a status report for this server
    void processVoting(U32 timeDelta);     // Manage any ongoing votes
    void processSimulatedStutter(U32 timeDelta);
@@ -147,6 +170,7 @@ public:
    // These are public so they can be accessed by tests
    static const U32 MaxTimeDelta = TWO_SECONDS;     
    static const U32 LevelSwitchTime = FIVE_SECONDS;
+   static const U32 NextLevelPrepTime = TWENTY_SECONDS;     // How long before the game ends we start getting the next level ready
 
    U32 mVoteTimer;
    VoteType mVoteType;
@@ -178,6 +202,8 @@ public:
 
    void resetLevelLoadIndex();
    string loadNextLevelInfo();
+   GameManager::HostingModePhase getHostingModePhase() const;
+   void setHostingModePhase(GameManager::HostingModePhase phase);
    void addDownloadedLevel(const string &fullFilename, LevelInfo &levelInfo);
 
    void deleteLevelGen(LuaLevelGenerator *levelgen);     // Add misbehaved levelgen to the kill list
@@ -192,7 +218,12 @@ public:
 
    bool runLevelGenScript(const string &scriptName);  // Run any levelgens specified by the level or in the INI
 
-   void buildBotMeshZones(bool writeZonesToDb);       // Only public for test access... not sure why friend isn't working
+   void buildBotMeshZones(bool cacheZones);           // Only public for test access... not sure why friend isn't working
+   static bool buildBotMeshZones(Level *level, const Rect *worldExtents, const Vector<DatabaseObject *> &barrierList,
+                                 bool triangulateZones, bool cacheZones, bool usingDatabaseZoneCache, bool &loadedFromCache);
+   const LevelPreparer *getLevelPreparer() const;
+   bool getBotZonesFromCache() const;
+   const Vector<pair<const char *, F64> > &getLevelLoadTimes() const;
 
    /////
    // Bot related
@@ -275,6 +306,7 @@ public:
    /////
    // BotNavMeshZone management
    const Vector<BotNavMeshZone *> &getBotZoneList() const;
+   BotNavRouteTable *getBotRouteTable() const;
    GridDatabase &getBotZoneDatabase() const;
 
    U16 findZoneContaining(const Point &p) const;
@@ -354,9 +354,9 @@ void ItemSpawn::doneEditingAttrs(EditorAttributeMenuUI *attributeMenu)
  */
 //               Fn name    Param profiles         Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getSpawnTime, ARRAYDEF({{          END }}), 1 ) \
-   METHOD(CLASS, setSpawnTime, ARRAYDEF({{ NUM_GE0, END }}), 1 ) \
-   METHOD(CLASS, spawnNow,     ARRAYDEF({{          END }}), 1 ) \
+   METHOD(CLASS, getSpawnTime, ARRAYDEF({{          END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setSpawnTime, ARRAYDEF({{ NUM_GE0, END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, spawnNow,     ARRAYDEF({{          END }}), 1, ChangesWorld ) \
 
 GENERATE_LUA_METHODS_TABLE(ItemSpawn, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(ItemSpawn, LUA_METHODS);
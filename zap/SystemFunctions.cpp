@@ -6,6 +6,7 @@
 #include "SystemFunctions.h"
 
 #include "GameManager.h"
+#include "gameNetInterface.h"
 #include "GameSettings.h"
 #include "ServerGame.h"
 #include "LevelSource.h"
@@ -37,6 +38,17 @@ namespace Zap
 {
 
 
+static void logHostingStarted(GameSettingsPtr settings, LevelSourcePtr levelSource)
+{
+   logprintf(LogConsumer::ServerFilter, "----------\n"
+                                        "Bitfighter server started [%s]", getTimeStamp().c_str());
+   logprintf(LogConsumer::ServerFilter, "hostname=[%s], hostdescr=[%s]", settings->getHostName().c_str(), 
+                                                                         settings->getHostDescr().c_str());
+
+   logprintf(LogConsumer::ServerFilter, "Loaded %d levels:", levelSource->getLevelCount());
+}
+
+
 // Host a game (and maybe even play a bit, too!)
 void initHosting(GameSettingsPtr settings, LevelSourcePtr levelSource, bool testMode, bool dedicatedServer, bool hostOnServer)
 {
@@ -52,14 +64,7 @@ void initHosting(GameSettingsPtr settings, LevelSourcePtr levelSource, bool test
 
    // Don't need to build our level list when in test mode because we're only running that one level stored in editor.tmp
    if(!testMode)
-   {
-      logprintf(LogConsumer::ServerFilter, "----------\n"
-                                           "Bitfighter server started [%s]", getTimeStamp().c_str());
-      logprintf(LogConsumer::ServerFilter, "hostname=[%s], hostdescr=[%s]", settings->getHostName().c_str(), 
-                                                                            settings->getHostDescr().c_str());
-
-      logprintf(LogConsumer::ServerFilter, "Loaded %d levels:", levelSource->getLevelCount());
-   }
+      logHostingStarted(settings, levelSource);
 
    if(levelSource->getLevelCount() == 0 && !hostOnServer)     // No levels!
    {
@@ -84,6 +89,43 @@ void initHosting(GameSettingsPtr settings, LevelSourcePtr levelSource, bool test
 }
 
 
+// Host an additional arena on a dedicated server that's already running its main game via initHosting().  The arena
+// gets its own port, levels and settings, but shares this process' Lua state, level database, and everything else.
+void initArenaHosting(GameSettingsPtr settings, const string &arenaName)
+{
+   TNLAssert(GameManager::getServerGame() && GameManager::getServerGame()->isDedicated(), "Arenas need a dedicated server!");
+
+   Address address(IPProtocol, Address::Any, GameSettings::DEFAULT_GAME_PORT);
+   address.set(settings->getHostAddress());
+
+   LevelSourcePtr levelSource = LevelSourcePtr(settings->chooseLevelSource(NULL));
+   ServerGame *serverGame = new ServerGame(address, settings, levelSource, false, true);
+
+   if(!serverGame->getNetInterface()->getSocket().isValid())
+   {
+      logprintf(LogConsumer::LogError, "Arena %s could not listen on %s; is another arena using it?  Skipping it.", 
+                                       arenaName.c_str(), address.toString());
+      delete serverGame;
+      return;
+   }
+
+   GameManager::addServerGame(serverGame);       // Also makes it the current game
+   serverGame->setReadyToConnectToMaster(true);
+
+   logprintf(LogConsumer::ServerFilter, "Arena %s listening on %s", arenaName.c_str(), address.toString());
+   logHostingStarted(settings, levelSource);
+
+   if(levelSource->getLevelCount() == 0)
+   {
+      GameManager::abortHosting_noLevels();     // Deletes this arena, but leaves the others running
+      return;
+   }
+
+   serverGame->resetLevelLoadIndex();
+   serverGame->setHostingModePhase(GameManager::LoadingLevels);
+}
+
+
 void shutdownBitfighter();    // Forward declaration
 
 
@@ -28,6 +28,7 @@ typedef shared_ptr<GameSettings> GameSettingsPtr;
 
 
 extern void initHosting(GameSettingsPtr settings, LevelSourcePtr levelSource, bool testMode, bool dedicatedServer, bool hostOnServer = false);
+extern void initArenaHosting(GameSettingsPtr settings, const string &arenaName);
 extern bool writeToConsole();
 extern string getInstalledDataDir();
 
@@ -144,8 +144,6 @@ const Vector<Point> *DestManager::getDestList() const
 
 TNL_IMPLEMENT_NETOBJECT(Teleporter);
 
-static Vector<DatabaseObject *> foundObjects;      // Reusable container
-
 const F32 Teleporter::DamageReductionFactor = 0.5f;
 
 // Combined default C++/Lua constructor
@@ -261,7 +259,7 @@ bool Teleporter::processArguments(S32 argc2, const char **argv2, Level *level)
    // See if we already have any teleports with this pos... if so, this is a "multi-dest" teleporter.
    // Note that editor handles multi-dest teleporters as separate single dest items, so multi-dest teleporters will be
    // broken into a series of single-dest teleporters when the level is added to the editor.
-   foundObjects.clear();
+   FillVector foundObjects;
    level->findObjects(TeleporterTypeNumber, foundObjects, Rect(pos, 1));
 
    for(S32 i = 0; i < foundObjects.size(); i++)
@@ -331,7 +329,7 @@ bool Teleporter::checkDeploymentPosition(const Point &position, const GridDataba
    Point outPoint;  // only used as a return value in polygonCircleIntersect
 
    // Finds: Barriers, PolyWalls, Turrets, ForceFields, Cores, and ForceFieldProjectors
-   foundObjects.clear();
+   FillVector foundObjects;
    gb->findObjects((TestFunc) isCollideableType, foundObjects, queryRect);
 
    Point foundObjectCenter;
@@ -555,7 +553,7 @@ void Teleporter::doTeleport()
 
    Rect queryRect(getOrigin(), TRIGGER_RADIUS);     
 
-   foundObjects.clear();
+   FillVector foundObjects;
    findObjects((TestFunc)isShipType, foundObjects, queryRect);
 
    S32 dest = mDestManager.getRandomDest();
@@ -1003,16 +1001,16 @@ bool Teleporter::canBeNeutral() { return false; }
  */
 //               Fn name                       Param profiles         Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, addDest,       ARRAYDEF({ { PT,   END }                }), 1 ) \
-   METHOD(CLASS, delDest,       ARRAYDEF({ { INT,  END }                }), 1 ) \
-   METHOD(CLASS, clearDests,    ARRAYDEF({ {       END }                }), 1 ) \
-   METHOD(CLASS, getDest,       ARRAYDEF({ { INT,  END }                }), 1 ) \
-   METHOD(CLASS, getDestCount,  ARRAYDEF({ {       END }                }), 1 ) \
-   METHOD(CLASS, setGeom,       ARRAYDEF({ { PT,   END }, { LINE, END } }), 2 ) \
-   METHOD(CLASS, getEngineered, ARRAYDEF({ {       END }                }), 1 ) \
-   METHOD(CLASS, setEngineered, ARRAYDEF({ { BOOL, END }                }), 1 ) \
-   METHOD(CLASS, getDelay,      ARRAYDEF({ {       END }                }), 1 ) \
-   METHOD(CLASS, setDelay,      ARRAYDEF({ { NUM,  END }                }), 1 ) \
+   METHOD(CLASS, addDest,       ARRAYDEF({ { PT,   END }                }), 1, ChangesWorld ) \
+   METHOD(CLASS, delDest,       ARRAYDEF({ { INT,  END }                }), 1, ChangesWorld ) \
+   METHOD(CLASS, clearDests,    ARRAYDEF({ {       END }                }), 1, ChangesWorld ) \
+   METHOD(CLASS, getDest,       ARRAYDEF({ { INT,  END }                }), 1, ReadsWorld   ) \
+   METHOD(CLASS, getDestCount,  ARRAYDEF({ {       END }                }), 1, ReadsWorld   ) \
+   METHOD(CLASS, setGeom,       ARRAYDEF({ { PT,   END }, { LINE, END } }), 2, ChangesWorld ) \
+   METHOD(CLASS, getEngineered, ARRAYDEF({ {       END }                }), 1, ReadsWorld   ) \
+   METHOD(CLASS, setEngineered, ARRAYDEF({ { BOOL, END }                }), 1, ChangesWorld ) \
+   METHOD(CLASS, getDelay,      ARRAYDEF({ {       END }                }), 1, ReadsWorld   ) \
+   METHOD(CLASS, setDelay,      ARRAYDEF({ { NUM,  END }                }), 1, ChangesWorld ) \
 
 GENERATE_LUA_METHODS_TABLE(Teleporter, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(Teleporter, LUA_METHODS);
@@ -462,8 +462,8 @@ void TextItem::textEditedCallback(TextEntryMenuItem *item, const string &text, B
  */
 //               Fn name     Param profiles       Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, setText,      ARRAYDEF({{ STR, END }}), 1 ) \
-   METHOD(CLASS, getText,      ARRAYDEF({{      END }}), 1 ) \
+   METHOD(CLASS, setText,      ARRAYDEF({{ STR, END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, getText,      ARRAYDEF({{      END }}), 1, ReadsWorld   ) \
 
 GENERATE_LUA_METHODS_TABLE(TextItem, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(TextItem, LUA_METHODS);
@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "TickStats.h"
+
+#include "tnlPlatform.h"
+
+#include <stdio.h>
+
+
+namespace Zap
+{
+
+
+TickStats::TickStats()
+{
+   reset();
+}
+
+
+TickStats::~TickStats()
+{
+   // Do nothing
+}
+
+
+void TickStats::recordTick(U32 interval, F64 workTime, U32 targetInterval)
+{
+   mTicks++;
+
+   // A tick that shows up a whole interval late means we missed one entirely
+   if(targetInterval > 0 && interval >= 2 * targetInterval)
+      mLateTicks++;
+
+   mTotalInterval += interval;
+
+   if(interval < mMinInterval)
+      mMinInterval = interval;
+
+   if(interval > mMaxInterval)
+      mMaxInterval = interval;
+
+   mTotalWorkTime += workTime;
+
+   if(workTime > mMaxWorkTime)
+      mMaxWorkTime = workTime;
+}
+
+
+void TickStats::recordWakeup()
+{
+   mWakeups++;
+}
+
+
+void TickStats::reset()
+{
+   mTicks = 0;
+   mLateTicks = 0;
+   mWakeups = 0;
+
+   mTotalInterval = 0;
+   mMinInterval = U32_MAX;
+   mMaxInterval = 0;
+
+   mTotalWorkTime = 0;
+   mMaxWorkTime = 0;
+}
+
+
+U32 TickStats::getTicks() const
+{
+   return mTicks;
+}
+
+
+U32 TickStats::getLateTicks() const
+{
+   return mLateTicks;
+}
+
+
+U32 TickStats::getWakeups() const
+{
+   return mWakeups;
+}
+
+
+F32 TickStats::getAverageInterval() const
+{
+   return mTicks == 0 ? 0 : F32(mTotalInterval) / mTicks;
+}
+
+
+U32 TickStats::getMinInterval() const
+{
+   return mTicks == 0 ? 0 : mMinInterval;
+}
+
+
+U32 TickStats::getMaxInterval() const
+{
+   return mMaxInterval;
+}
+
+
+F64 TickStats::getAverageWorkTime() const
+{
+   return mTicks == 0 ? 0 : mTotalWorkTime / mTicks;
+}
+
+
+F64 TickStats::getMaxWorkTime() const
+{
+   return mMaxWorkTime;
+}
+
+
+string TickStats::toString() const
+{
+   char buffer[256];
+   dSprintf(buffer, sizeof(buffer), "%d ticks (%d late), interval avg/min/max %.1f/%d/%d ms, work avg/max %.2f/%.2f ms, %d wakeups",
+            mTicks, mLateTicks, getAverageInterval(), getMinInterval(), mMaxInterval, getAverageWorkTime(), mMaxWorkTime, mWakeups);
+
+   return buffer;
+}
+
+
+} /* namespace Zap */
@@ -0,0 +1,61 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _TICK_STATS_H_
+#define _TICK_STATS_H_
+
+#include "tnlTypes.h"
+
+#include <string>
+
+using namespace TNL;
+using namespace std;
+
+namespace Zap
+{
+
+// Keeps track of how regularly the server main loop is ticking, and how much of each tick is spent working.
+// Stats accumulate until reset(), so callers can report over whatever window they like.
+class TickStats
+{
+private:
+   U32 mTicks;
+   U32 mLateTicks;         // Ticks that started more than a full interval after they were due
+   U32 mWakeups;           // Times the loop woke between ticks to read packets
+
+   U32 mTotalInterval;
+   U32 mMinInterval;
+   U32 mMaxInterval;
+
+   F64 mTotalWorkTime;     // In ms
+   F64 mMaxWorkTime;
+
+public:
+   TickStats();            // Constructor
+   virtual ~TickStats();   // Destructor
+
+   // interval is the time since the previous tick, workTime how long this tick took to run, and
+   // targetInterval how long we wanted between ticks
+   void recordTick(U32 interval, F64 workTime, U32 targetInterval);
+   void recordWakeup();
+
+   void reset();
+
+   U32 getTicks() const;
+   U32 getLateTicks() const;
+   U32 getWakeups() const;
+
+   F32 getAverageInterval() const;
+   U32 getMinInterval() const;
+   U32 getMaxInterval() const;
+
+   F64 getAverageWorkTime() const;
+   F64 getMaxWorkTime() const;
+
+   string toString() const;
+};
+
+} /* namespace Zap */
+#endif
@@ -590,7 +590,7 @@ void EditorUserInterface::runScript(Level *level, const FolderManager *folderMan
 
    // Process new items that need it (walls need processing so that they can render properly).
    // Items that need no extra processing will be kept as-is.
-   fillVector.clear();
+   FillVector fillVector;
    level->findObjects((TestFunc)isWallType, fillVector);
 
    for(S32 i = 0; i < fillVector.size(); i++)
@@ -847,7 +847,7 @@ static void setTeam(BfObject *obj, S32 team)
 
 static bool hasTeamSpawns(GridDatabase *database)
 {
-   fillVector.clear();
+   FillVector fillVector;
    database->findObjects(FlagSpawnTypeNumber, fillVector);
 
    for(S32 i = 0; i < fillVector.size(); i++)
@@ -878,7 +878,7 @@ void EditorUserInterface::validateLevel()
 
    Level *level = getLevel();
 
-   fillVector.clear();
+   FillVector fillVector;
    level->findObjects(ShipSpawnTypeNumber, fillVector);
 
    for(S32 i = 0; i < fillVector.size(); i++)
@@ -1618,9 +1618,8 @@ static S32 QSORT_CALLBACK sortByTeam(DatabaseObject **a, DatabaseObject **b)
 
 void EditorUserInterface::renderTurretAndSpyBugRanges(GridDatabase *editorDb) const
 {
-   // Make a copy of our vector of pointers to fillVector so we
-   // can sort by team.  This is faster then using findObjects.
-   fillVector = *editorDb->findObjects_fast(SpyBugTypeNumber);  
+   // Make a copy of our vector of pointers so we can sort by team.  This is faster then using findObjects.
+   Vector<DatabaseObject *> fillVector = *editorDb->findObjects_fast(SpyBugTypeNumber);
    if(fillVector.size() != 0)
    {
       // Use Z Buffer to make use of not drawing overlap visible area of same team SpyBug, but does overlap different team
@@ -1997,7 +1996,7 @@ void EditorUserInterface::render() const
    // get the width for display at bottom of dock
    else
    {
-      fillVector.clear();
+      FillVector fillVector;
       editorDb->findObjects((TestFunc)isLineItemType, fillVector);
 
       for(S32 i = 0; i < fillVector.size(); i++)
@@ -2765,7 +2764,7 @@ void EditorUserInterface::findHitItemAndEdge()
    // Note that this is only used for requesting a candidate list from the database, actual hit detection is more precise.
    const Rect cursorRect((mMousePos - mCurrentOffset) / mCurrentScale, 50);
 
-   fillVector.clear();
+   FillVector fillVector;
    GridDatabase *editorDb = getLevel();
    editorDb->findObjects((TestFunc)isAnyObjectType, fillVector, cursorRect);
 
@@ -2788,8 +2787,7 @@ void EditorUserInterface::findHitItemAndEdge()
       }
 
    // We've already checked for wall vertices; now we'll check for hits in the interior of walls
-   fillVector2.clear();
-
+   FillVector fillVector2;
    mLevel->findObjects(isWallType, fillVector2, cursorRect);
 
    for(S32 i = 0; i < fillVector2.size(); i++)
@@ -3528,14 +3526,14 @@ void EditorUserInterface::deleteAllItems()
 // Increase selected wall thickness by amt
 void EditorUserInterface::changeBarrierWidth(S32 amt)
 {
-   fillVector2.clear();    // fillVector gets modified in some child function, so use our secondary reusable container
-   getLevel()->findObjects((TestFunc)isWallItemType, fillVector2);
+   FillVector fillVector;
+   getLevel()->findObjects((TestFunc)isWallItemType, fillVector);
 
    mUndoManager.startTransaction();
 
-   for(S32 i = 0; i < fillVector2.size(); i++)
+   for(S32 i = 0; i < fillVector.size(); i++)
    {
-      WallItem *obj = static_cast<WallItem *>(fillVector2[i]);
+      WallItem *obj = static_cast<WallItem *>(fillVector[i]);
 
       if(obj->isSelected())
       {
@@ -4843,7 +4841,7 @@ void EditorUserInterface::onMouseUp()
    {
       Rect r(convertCanvasToLevelCoord(mMousePos), mMouseDownPos);
 
-      fillVector.clear();
+      FillVector fillVector;
 
       getLevel()->findObjects(fillVector);
 
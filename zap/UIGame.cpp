@@ -2507,7 +2507,7 @@ void GameUserInterface::renderInlineHelpItemOutlines(S32 playerTeam, F32 alpha)
 #undef HELP_TABLE_ITEM
       }
 
-      fillVector.clear();
+      FillVector fillVector;
       getGame()->getLevel()->findObjects(itemTypes, fillVector, *getGame()->getWorldExtents());
       polygons.clear();
       for(S32 i = 0; i < fillVector.size(); i++)
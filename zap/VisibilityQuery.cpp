@@ -0,0 +1,173 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "VisibilityQuery.h"
+
+#include "GeomUtils.h"
+
+#include "tnlAssert.h"
+
+
+namespace Zap
+{
+
+// Declare our statics
+const S32 VisibilityQuery::MaxTargets;
+
+
+// Lay out the edges of every object's collision poly, in the same order polygonsIntersect() would visit them
+void VisibilityQuery::gatherEdges(const Vector<DatabaseObject *> &objects)
+{
+   mExtents.clear();
+   mPolys.clear();
+   mFirstEdge.clear();
+   mStartX.clear();
+   mStartY.clear();
+   mEndX.clear();
+   mEndY.clear();
+
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      const Vector<Point> *poly = objects[i]->getCollisionPoly();
+
+      if(!poly || poly->size() == 0)
+         continue;
+
+      mExtents.push_back(objects[i]->getExtent());
+      mPolys.push_back(poly);
+      mFirstEdge.push_back(mStartX.size());
+
+      const Point *start = &poly->get(poly->size() - 1);
+
+      for(S32 j = 0; j < poly->size(); j++)
+      {
+         const Point *end = &poly->get(j);
+
+         mStartX.push_back(start->x);
+         mStartY.push_back(start->y);
+         mEndX.push_back(end->x);
+         mEndY.push_back(end->y);
+
+         start = end;
+      }
+   }
+
+   mFirstEdge.push_back(mStartX.size());
+}
+
+
+// Same answer as polygonsIntersect(band, poly), with band a 4 point polygon.  The edge test is segmentsIntersect(), done
+// with the same arithmetic, but without branches, so the inner loop can work on several edges at once.
+bool VisibilityQuery::bandHitsObject(const Point *band, S32 objectIndex) const
+{
+   const S32 first = mFirstEdge[objectIndex];
+   const S32 last  = mFirstEdge[objectIndex + 1];
+
+   const F32 *startX = mStartX.address();
+   const F32 *startY = mStartY.address();
+   const F32 *endX   = mEndX.address();
+   const F32 *endY   = mEndY.address();
+
+   const Point *bandStart = &band[3];
+
+   for(S32 i = 0; i < 4; i++)
+   {
+      const Point *bandEnd = &band[i];
+
+      const F32 bandDx = bandEnd->x - bandStart->x;
+      const F32 bandDy = bandEnd->y - bandStart->y;
+
+      bool hit = false;
+
+      for(S32 j = first; j < last; j++)
+      {
+         F32 edgeDx = endX[j] - startX[j];
+         F32 edgeDy = endY[j] - startY[j];
+         F32 offsetX = bandStart->x - startX[j];
+         F32 offsetY = bandStart->y - startY[j];
+
+         F32 denom = (edgeDy * bandDx) - (edgeDx * bandDy);
+         F32 bandTime = ((edgeDx * offsetY) - (edgeDy * offsetX)) / denom;
+         F32 edgeTime = ((bandDx * offsetY) - (bandDy * offsetX)) / denom;
+
+         // When denom is 0, the times are infinite or NaN, and fail these anyway; the denom test is to be explicit
+         hit |= (denom != 0) & (bandTime >= 0) & (bandTime <= 1) & (edgeTime >= 0) & (edgeTime <= 1);
+      }
+
+      if(hit)
+         return true;
+
+      bandStart = bandEnd;
+   }
+
+   // Entirely inside one another?
+   const Vector<Point> &poly = *mPolys[objectIndex];
+
+   return polygonContainsPoint(band, 4, poly[0]) || polygonContainsPoint(poly.address(), poly.size(), band[0]);
+}
+
+
+U64 VisibilityQuery::canSeePoints(const GridDatabase *database, TestFunc testFunc, const Point &origin, F32 radius,
+                                  const Point *targets, S32 targetCount)
+{
+   TNLAssert(targetCount <= MaxTargets, "Too many targets!");
+
+   if(targetCount <= 0)
+      return 0;
+
+   // Each target's band, as a polygon (see Robot::canSeePoint()), with its bounding box
+   mBands.resize(targetCount * 4);
+   mBandRects.resize(targetCount);
+
+   Rect searchRect;
+
+   for(S32 i = 0; i < targetCount; i++)
+   {
+      Point difference = targets[i] - origin;
+
+      Point crossVector(difference.y, -difference.x);  // Perpendicular to the line of sight...
+      crossVector.normalize(radius);                   // ...and as long as the ship's radius
+
+      Point *band = &mBands[i * 4];
+      band[0] = origin + crossVector;
+      band[1] = origin - crossVector;
+      band[2] = targets[i] - crossVector;
+      band[3] = targets[i] + crossVector;
+
+      mBandRects[i].set(band[0], band[1]);
+      mBandRects[i].unionPoint(band[2]);
+      mBandRects[i].unionPoint(band[3]);
+
+      if(i == 0)
+         searchRect = mBandRects[0];
+      else
+         searchRect.unionRect(mBandRects[i]);
+   }
+
+   // One search, covering every band
+   FillVector fillVector;
+   database->findObjects(testFunc, fillVector, searchRect);
+
+   gatherEdges(fillVector);
+
+   U64 visible = 0;
+
+   for(S32 i = 0; i < targetCount; i++)
+   {
+      bool blocked = false;
+
+      for(S32 j = 0; j < mPolys.size() && !blocked; j++)
+         if(mExtents[j].intersects(mBandRects[i]))      // Just what a search of this band alone would have found
+            blocked = bandHitsObject(&mBands[i * 4], j);
+
+      if(!blocked)
+         visible |= U64(1) << i;
+   }
+
+   return visible;
+}
+
+
+} /* namespace Zap */
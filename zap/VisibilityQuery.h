@@ -0,0 +1,59 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _VISIBILITY_QUERY_H_
+#define _VISIBILITY_QUERY_H_
+
+#include "gridDB.h"      // For TestFunc
+#include "Point.h"
+#include "Rect.h"
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+using namespace TNL;
+
+namespace Zap
+{
+
+// Works out which of a set of points a ship can see, all in one go.  Each point is tested just as Robot::canSeePoint()
+// would: a ship-wide band from the ship to the point is checked against the collision polygons of everything nearby.
+// Rather than search the database once per point, we search it once for the whole lot, and lay the edges of everything
+// we find out flat, as arrays of coordinates, so each band can be checked against them in a tight, branch-free loop that
+// the compiler can vectorize.
+//
+// Keeps its buffers between calls, so something asking every tick doesn't have to allocate.  Not thread safe; each bot
+// has its own.
+class VisibilityQuery
+{
+public:
+   static const S32 MaxTargets = 64;     // One bit of the result for each
+
+private:
+   // The band from the ship to each target, 4 points apiece, and its bounding box
+   Vector<Point> mBands;
+   Vector<Rect> mBandRects;
+
+   // Everything we found, one entry per object...
+   Vector<Rect> mExtents;
+   Vector<const Vector<Point> *> mPolys;
+   Vector<S32> mFirstEdge;                // Edges of object i are mFirstEdge[i] up to mFirstEdge[i + 1]
+
+   // ...and the edges of all of them, coordinates in separate arrays
+   Vector<F32> mStartX, mStartY, mEndX, mEndY;
+
+   void gatherEdges(const Vector<DatabaseObject *> &objects);
+   bool bandHitsObject(const Point *band, S32 objectIndex) const;
+
+public:
+   // Returns a mask with bit i set if targets[i] can be seen by a ship of the given radius at origin.  Only objects that
+   // pass testFunc count as getting in the way.  targetCount can be no more than MaxTargets.
+   U64 canSeePoints(const GridDatabase *database, TestFunc testFunc, const Point &origin, F32 radius,
+                    const Point *targets, S32 targetCount);
+};
+
+
+} /* namespace Zap */
+#endif
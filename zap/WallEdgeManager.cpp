@@ -56,6 +56,12 @@ const GridDatabase *WallEdgeManager::getWallEdgeDatabase() const
 }
 
 
+void WallEdgeManager::sizeBucketsToExtents(const Rect &extents)
+{
+   mWallEdgeDatabase.sizeBucketsToExtents(extents);
+}
+
+
 // Delete all segments, then find all walls and build a new set of segments
 void WallEdgeManager::rebuildEdges(const Vector<WallSegment const *> &wallSegments, Vector<Point> &wallEdgePoints)
 {
@@ -233,7 +239,7 @@ void WallEdgeManager::updateAllMountedItems(const GridDatabase *gameObjectDataba
 {
    // First, find any items directly mounted on our wall, and update their location.  Because we don't know where the wall _was_, we 
    // will need to search through all the engineered items, and query each to find which ones where attached to the wall that moved.
-   fillVector.clear();
+   FillVector fillVector;
    gameObjectDatabase->findObjects((TestFunc)isEngineeredType, fillVector);
 
    for(S32 i = 0; i < fillVector.size(); i++)
@@ -37,6 +37,7 @@ public:
    virtual ~WallEdgeManager();   // Destructor
 
    const GridDatabase *getWallEdgeDatabase() const;
+   void sizeBucketsToExtents(const Rect &extents);
 
    // Suspend certain geometry operations for greater efficiency
    void beginBatchGeomUpdate();                                     
@@ -313,8 +313,8 @@ void WallItem::addToGame(Game *game, GridDatabase *database)
  */
 //               Fn name       Param profiles  Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getWidth,     ARRAYDEF({{      END }}), 1 ) \
-   METHOD(CLASS, setWidth,     ARRAYDEF({{ INT, END }}), 1 ) \
+   METHOD(CLASS, getWidth,     ARRAYDEF({{      END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setWidth,     ARRAYDEF({{ INT, END }}), 1, ChangesWorld ) \
 
 GENERATE_LUA_METHODS_TABLE(WallItem, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(WallItem, LUA_METHODS);
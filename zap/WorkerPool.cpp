@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "WorkerPool.h"
+
+#include "tnlLog.h"
+
+
+namespace Zap
+{
+
+
+WorkerPool::Job::~Job()
+{
+   // Do nothing
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+WorkerPool::WorkerThread::WorkerThread(WorkerPool *pool)
+{
+   mPool = pool;
+}
+
+
+U32 WorkerPool::WorkerThread::run()
+{
+   while(true)
+   {
+      mPool->mStartSemaphore.wait();
+
+      if(mPool->mExitNow)
+      {
+         mPool->mDoneSemaphore.increment();
+         return 0;
+      }
+
+      mPool->doItems();
+      mPool->mDoneSemaphore.increment();
+   }
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+WorkerPool::WorkerPool(S32 threadCount)
+{
+   mJob = NULL;
+   mItemCount = 0;
+   mNextItem = 0;
+   mExitNow = false;
+
+   for(S32 i = 0; i < threadCount; i++)
+   {
+      WorkerThread *thread = new WorkerThread(this);
+
+      if(!thread->start())
+      {
+         logprintf(LogConsumer::LogWarning, "Could only start %d of %d worker threads", i, threadCount);
+         delete thread;
+         break;
+      }
+
+      mThreads.push_back(thread);
+   }
+}
+
+
+// Destructor
+WorkerPool::~WorkerPool()
+{
+   mExitNow = true;
+   mStartSemaphore.increment(mThreads.size());
+
+   // Make sure every thread is out of run() before they go away
+   for(S32 i = 0; i < mThreads.size(); i++)
+      mDoneSemaphore.wait();
+
+   mThreads.deleteAndClear();
+}
+
+
+S32 WorkerPool::getThreadCount() const
+{
+   return mThreads.size();
+}
+
+
+// Keep taking the next item until there are none left
+void WorkerPool::doItems()
+{
+   for(S32 index = mNextItem++; index < mItemCount; index = mNextItem++)
+      mJob->run(index);
+}
+
+
+void WorkerPool::run(Job *job, S32 itemCount)
+{
+   if(itemCount <= 0)
+      return;
+
+   mJob = job;
+   mItemCount = itemCount;
+   mNextItem = 0;
+
+   // No point waking threads that would find nothing left to do
+   S32 helpers = itemCount - 1 < mThreads.size() ? itemCount - 1 : mThreads.size();
+
+   // The semaphores see to it that the threads see the job, and that we see what they did with it
+   mStartSemaphore.increment(helpers);
+   doItems();
+
+   for(S32 i = 0; i < helpers; i++)
+      mDoneSemaphore.wait();
+
+   mJob = NULL;
+}
+
+
+} /* namespace Zap */
@@ -0,0 +1,66 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _WORKER_POOL_H_
+#define _WORKER_POOL_H_
+
+#include "tnlThread.h"
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <atomic>
+
+using namespace TNL;
+
+namespace Zap
+{
+
+// A handful of threads that sit waiting until there is a batch of work to share out.  The thread handing over the work
+// pitches in too, and gets it back when every item is done, so the work might as well have been done in a plain loop,
+// only sooner.
+class WorkerPool
+{
+public:
+   class Job
+   {
+   public:
+      virtual ~Job();
+      virtual void run(S32 index) = 0;    // Do item index; may be called on any thread, in any order
+   };
+
+private:
+   class WorkerThread : public Thread
+   {
+   private:
+      WorkerPool *mPool;
+
+   public:
+      explicit WorkerThread(WorkerPool *pool);
+      U32 run();
+   };
+
+   Vector<WorkerThread *> mThreads;
+   Semaphore mStartSemaphore;          // Incremented once per thread when there's work, or when it's time to go
+   Semaphore mDoneSemaphore;           // Incremented by each thread when it's done
+
+   Job *mJob;
+   S32 mItemCount;
+   std::atomic<S32> mNextItem;
+   std::atomic<bool> mExitNow;
+
+   void doItems();
+
+public:
+   explicit WorkerPool(S32 threadCount);  // Constructor
+   virtual ~WorkerPool();                 // Destructor
+
+   S32 getThreadCount() const;            // Not counting the caller of run()
+
+   void run(Job *job, S32 itemCount);     // Returns once job->run() has been called for every item
+};
+
+
+} /* namespace Zap */
+#endif
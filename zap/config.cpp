@@ -1036,6 +1036,31 @@ void loadSettingsFromINI(CIniFile *ini, GameSettings *settings)
 }
 
 
+// Settings for an extra arena on a dedicated server: the usual sections from the already loaded INI, with any
+// [Host] keys found in arenaSection taking precedence.  Leaves key bindings and other client stuff at their defaults.
+void loadArenaSettingsFromINI(CIniFile *ini, GameSettings *settings, const string &arenaSection)
+{
+   IniSettings *iniSettings = settings->getIniSettings();
+
+   for(U32 i = 0; i < ARRAYSIZE(sections); i++)
+      loadSettings(ini, iniSettings, sections[i]);
+
+   SettingsList hostSettings = iniSettings->mSettings.getSettingsInSection("Host");
+
+   for(S32 i = 0; i < hostSettings.size(); i++)
+   {
+      string value = ini->getValue(arenaSection, hostSettings[i]->getKey(), "");
+      if(value != "")
+         hostSettings[i]->setValFromString(value);
+   }
+
+   loadLevelSkipList(ini, settings);
+   loadServerBanList(ini, settings->getBanList());
+
+   settings->onFinishedLoading();
+}
+
+
 void IniSettings::loadUserSettingsFromINI(CIniFile *ini, GameSettings *settings)
 {
    UserSettings userSettings;
@@ -259,6 +259,7 @@ public:
 
 void saveSettingsToINI  (CIniFile *ini, GameSettings *settings);
 void loadSettingsFromINI(CIniFile *ini, GameSettings *settings);    // Load standard game settings
+void loadArenaSettingsFromINI(CIniFile *ini, GameSettings *settings, const string &arenaSection);
 
 void writeSkipList(CIniFile *ini, const Vector<string> *levelSkipList);
 
@@ -399,8 +399,8 @@ bool FlagItem::isAtHome()
  */
 //               Fn name       Param profiles  Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, isInInitLoc,  ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getFlagCount, ARRAYDEF({{ END }}), 1 ) \
+   METHOD(CLASS, isInInitLoc,  ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getFlagCount, ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
 
 GENERATE_LUA_METHODS_TABLE(FlagItem, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(FlagItem, LUA_METHODS);
@@ -51,11 +51,6 @@ U32 NameToAddressThread::run()
 }
 
 
-////////////////////////////////////////
-////////////////////////////////////////
-
-static Vector<DatabaseObject *> fillVector2;
-
 ////////////////////////////////////
 ////////////////////////////////////
 
@@ -934,7 +929,7 @@ void Game::processDeleteList(U32 timeDelta)
 // Delete all objects of specified type  --> currently only used to remove all walls from the game
 void Game::deleteObjects(U8 typeNumber)
 {
-   fillVector.clear();
+   FillVector fillVector;
    mLevel->findObjects(typeNumber, fillVector);
    for(S32 i = 0; i < fillVector.size(); i++)
    {
@@ -947,7 +942,7 @@ void Game::deleteObjects(U8 typeNumber)
 // Not currently used
 void Game::deleteObjects(TestFunc testFunc)
 {
-   fillVector.clear();
+   FillVector fillVector;
    mLevel->findObjects(testFunc, fillVector);
    for(S32 i = 0; i < fillVector.size(); i++)
    {
@@ -967,7 +962,7 @@ Rect Game::computeBarrierExtents()
 {
    Rect extents;
 
-   fillVector.clear();
+   FillVector fillVector;
    mLevel->findObjects((TestFunc)isWallType, fillVector);
 
    for(S32 i = 0; i < fillVector.size(); i++)
@@ -2083,12 +2083,14 @@ bool GameConnection::TransferRecordedGameplay(const char *filename)
          return false;
       }
 
+      // The file goes out byte for byte, so compressed recordings stay compressed on the way.  The last part has
+      // to arrive too: a compressed recording that's missing its end loses its last frame, not just a few bytes.
       s2cSetFilename(filename);
       s2rTransferFileSize(totalTransferSize);
       for(U32 i=0; i < U32(mPendingTransferData.size()) - 1; i++)
          s2rSendDataParts(TransmissionRecordedGame, ByteBufferPtr(mPendingTransferData[i]));
 
-      s2rSendDataParts(TransmissionRecordedGame | TransmissionDone, ByteBufferPtr(new ByteBuffer(0)));
+      s2rSendDataParts(TransmissionRecordedGame | TransmissionDone, ByteBufferPtr(mPendingTransferData.last()));
       return true;
    }
    else
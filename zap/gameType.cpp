@@ -116,6 +116,8 @@ void GameType::initialize(Level *level, S32 winningScore)
    mLevelHasPredeployedFlags = false;
    mLevelHasFlagSpawns = false;
    mShowAllBots = false;
+   mScopeCacheSize = 0;
+   mScopeCacheChangeCount = 0;
    mBotZoneCreationFailed = false;
    mOvertime = false;
    mSuddenDeath = false;
@@ -1575,10 +1577,7 @@ void GameType::performScopeQuery(GhostConnection *connection)
    }
 
    // What does the spy bug see?
-   bool sameQuery = false;  // helps speed up by not repeatedly finding same objects
-
    const Vector<DatabaseObject *> *spyBugs = mLevel->findObjects_fast(SpyBugTypeNumber);
-   const Point scopeRange(SpyBug::SPY_BUG_RADIUS, SpyBug::SPY_BUG_RADIUS * FloatSqrt3Half);  // Bounding box of hexagon
    
    for(S32 i = spyBugs->size()-1; i >= 0; i--)
    {
@@ -1586,31 +1585,127 @@ void GameType::performScopeQuery(GhostConnection *connection)
 
       if(sb->isVisibleToPlayer(clientInfo, isTeamGame()))
       {
-         Point pos = sb->getActualPos();
-         Rect queryRect(pos, pos);
+         const Vector<DatabaseObject *> &seen = getSpyBugScope(sb);
 
-         queryRect.expand(scopeRange);
+         for(S32 j = 0; j < seen.size(); j++)
+         {
+            connection->objectInScope(static_cast<BfObject *>(seen[j]));
+            if(isShipType(seen[j]->getObjectTypeNumber()))
+               markAllMountedItemsAsBeingInScope(static_cast<Ship *>(seen[j]), conn);
+         }
+      }
+   }
+}
 
-         fillVector.clear();
-         mLevel->findObjects((TestFunc)isAnyObjectType, fillVector, queryRect, sameQuery);
 
-         sameQuery = true;
+// Scope queries for different connections often look through the same ship or spy bug, so we remember the results
+// until something in the level changes.  Connections are all processed together, between game ticks, so every
+// connection after the first gets the answer for free.  Sets found if the entry is already filled in.
+GameType::ScopeCacheEntry *GameType::getScopeCacheEntry(const BfObject *vantage, bool hasSensor, bool &found)
+{
+   if(mLevel->getChangeCount() != mScopeCacheChangeCount)
+   {
+      mScopeCacheSize = 0;
+      mScopeCacheChangeCount = mLevel->getChangeCount();
+   }
 
-         for(S32 j = 0; j < fillVector.size(); j++)
-         {
-            // Some objects don't have geometry (ForceFields).  Is this a bug?
-            if(!fillVector[j]->hasGeometry())
-               continue;
+   for(S32 i = 0; i < mScopeCacheSize; i++)
+      if(mScopeCache[i].vantage == vantage && mScopeCache[i].hasSensor == hasSensor)
+      {
+         found = true;
+         return &mScopeCache[i];
+      }
 
-            if(!pointInHexagon(fillVector[j]->getPos(), pos, (F32)SpyBug::SPY_BUG_RADIUS))
-               continue;
+   if(mScopeCacheSize == mScopeCache.size())
+      mScopeCache.push_back(ScopeCacheEntry());
 
-            connection->objectInScope(static_cast<BfObject *>(fillVector[j]));
-            if(isShipType(fillVector[j]->getObjectTypeNumber()))
-               markAllMountedItemsAsBeingInScope(static_cast<Ship *>(fillVector[j]), conn);
-         }
+   ScopeCacheEntry *entry = &mScopeCache[mScopeCacheSize];
+   mScopeCacheSize++;
+
+   entry->vantage = vantage;
+   entry->hasSensor = hasSensor;
+   entry->objects.clear();
+
+   found = false;
+   return entry;
+}
+
+
+// Everything within scope range of the ship.  Until the level changes, the reference stays good, but the
+// contents might not; copy them before looking up another ship.
+const Vector<DatabaseObject *> &GameType::getShipScope(Ship *ship)
+{
+   bool hasSensor = ship->hasModule(ModuleSensor);
+   bool found;
+
+   ScopeCacheEntry *entry = getScopeCacheEntry(ship, hasSensor, found);
+
+   if(!found)
+   {
+      Rect queryRect(ship->getActualPos(), ship->getActualPos());
+      queryRect.expand(Game::getScopeRange(hasSensor));
+
+      mLevel->findObjects((TestFunc)isAnyObjectType, entry->objects, queryRect);
+   }
+
+   return entry->objects;
+}
+
+
+// Everything inside the spy bug's hexagon.  Same caveats as getShipScope().
+const Vector<DatabaseObject *> &GameType::getSpyBugScope(SpyBug *spyBug)
+{
+   bool found;
+   ScopeCacheEntry *entry = getScopeCacheEntry(spyBug, false, found);
+
+   if(!found)
+   {
+      static const Point scopeRange(SpyBug::SPY_BUG_RADIUS, SpyBug::SPY_BUG_RADIUS * FloatSqrt3Half);  // Bounding box of hexagon
+
+      Point pos = spyBug->getActualPos();
+      Rect queryRect(pos, pos);
+
+      queryRect.expand(scopeRange);
+
+      FillVector fillVector;
+      mLevel->findObjects((TestFunc)isAnyObjectType, fillVector, queryRect);
+
+      for(S32 i = 0; i < fillVector.size(); i++)
+      {
+         // Some objects don't have geometry (ForceFields).  Is this a bug?
+         if(!fillVector[i]->hasGeometry())
+            continue;
+
+         if(pointInHexagon(fillVector[i]->getPos(), pos, (F32)SpyBug::SPY_BUG_RADIUS))
+            entry->objects.push_back(fillVector[i]);
       }
    }
+
+   return entry->objects;
+}
+
+
+static bool sortByAddress(DatabaseObject * const &a, DatabaseObject * const &b)
+{
+   return a < b;
+}
+
+
+// Leaves one of each object in objects, in no particular order
+static void removeDuplicates(Vector<DatabaseObject *> &objects)
+{
+   if(objects.size() < 2)
+      return;
+
+   objects.sort(sortByAddress);
+
+   S32 count = 1;
+
+   for(S32 i = 1; i < objects.size(); i++)
+      if(objects[i] != objects[count - 1])
+         objects[count++] = objects[i];
+
+   objects.resize(count);
 }
 
 
@@ -1642,11 +1737,11 @@ void GameType::performProxyScopeQuery(BfObject *scopeObject, ClientInfo *clientI
    GameConnection *connection = clientInfo->getConnection();
    TNLAssert(connection, "NULL gameConnection!");
 
+   FillVector fillVector;
+
    if(isTeamGame() && connection->isInCommanderMap())
    {
       S32 teamId = clientInfo->getTeamIndex();
-      fillVector.clear();
-      bool sameQuery = false;  // Helps speed up by not repeatedly finding same objects
 
       for(S32 i = 0; i < mGame->getClientCount(); i++)
       {
@@ -1659,34 +1754,36 @@ void GameType::performProxyScopeQuery(BfObject *scopeObject, ClientInfo *clientI
          if(!ship)            // Can happen!
             continue;
 
-         Rect queryRect(ship->getActualPos(), ship->getActualPos());
-         queryRect.expand(Game::getScopeRange(ship->hasModule(ModuleSensor)));
+         // Every teammate in commander's map looks through the same ships, so these come from the scope cache
+         const Vector<DatabaseObject *> &seen = getShipScope(ship);
 
          TestFunc testFunc;
          if(scopeObject == ship)    
             testFunc = &isAnyObjectType;
          else
-            if(ship && ship->hasModule(ModuleSensor))
+            if(ship->hasModule(ModuleSensor))
                testFunc = &isVisibleOnCmdrsMapWithSensorType;
             else     // No sensor
                testFunc = &isVisibleOnCmdrsMapType;
 
-         mLevel->findObjects(testFunc, fillVector, queryRect, sameQuery);
-         sameQuery = true;
+         for(S32 j = 0; j < seen.size(); j++)
+            if(testFunc(seen[j]->getObjectTypeNumber()))
+               fillVector.push_back(seen[j]);
       }
+
+      // Teammates' views overlap, so the same object may have been added more than once
+      removeDuplicates(fillVector);
    }
    else     // Not a team game OR not in commander's map -- Do a simple query of the objects within scope range of the ship
    {
       // Note that if we make mine visibility controlled by server, here's where we'd put the code
-      Point pos = scopeObject->getPos();
       TNLAssert(dynamic_cast<Ship *>(scopeObject), "Control object is not a ship!");
       Ship *ship = static_cast<Ship *>(scopeObject);
 
-      Rect queryRect(pos, pos);
-      queryRect.expand(Game::getScopeRange(ship->hasModule(ModuleSensor)));
+      const Vector<DatabaseObject *> &seen = getShipScope(ship);
 
-      fillVector.clear();
-      mLevel->findObjects((TestFunc)isAnyObjectType, fillVector, queryRect);
+      for(S32 i = 0; i < seen.size(); i++)
+         fillVector.push_back(seen[i]);
    }
 
    // Set object-in-scope for all objects found above
@@ -2359,7 +2456,7 @@ void GameType::changeClientTeam(ClientInfo *client, S32 team)
    if(ship)
    {
       // Find all spybugs and mines that this player owned, and reset ownership
-      fillVector.clear();
+      FillVector fillVector;
       mLevel->findObjects((TestFunc)isGrenadeType, fillVector);
 
       for(S32 i = 0; i < fillVector.size(); i++)
@@ -2623,7 +2720,7 @@ GAMETYPE_RPC_S2C(GameType, s2cClientJoinedTeam,
    // save the overhead of sending a separate message which, while theoretically cleaner, will never be needed practically.
    if(localClientInfo->getName() == name)
    {
-      fillVector.clear();
+      FillVector fillVector;
       mLevel->findObjects((TestFunc)isGrenadeType, fillVector);
 
       for(S32 i = 0; i < fillVector.size(); i++)
@@ -2841,6 +2938,88 @@ void GameType::processServerCommand(ClientInfo *clientInfo, const char *cmd, Vec
       else
          clientInfo->getConnection()->s2cDisplayErrorMessage("!!! Need admin");
    }
+   else if(stricmp(cmd, "scriptstats") == 0)
+   {
+      if(clientInfo->isAdmin())
+      {
+         static const S32 MaxLines = 8;
+
+         Vector<string> lines;
+         LuaScriptRunner::getCpuUsageReport(lines);
+
+         GameConnection *conn = clientInfo->getConnection();
+
+         if(lines.size() == 0)
+            conn->s2cDisplayMessage(0, 0, "No scripts have run on this level");
+
+         for(S32 i = 0; i < lines.size() && i < MaxLines; i++)
+            conn->s2cDisplayMessage(0, 0, lines[i].c_str());
+
+         if(lines.size() > MaxLines)
+            conn->s2cDisplayMessage(0, 0, ("... and " + itos(lines.size() - MaxLines) + " more").c_str());
+      }
+      else
+         clientInfo->getConnection()->s2cDisplayErrorMessage("!!! Need admin");
+   }
+   // /eventstats [reset]
+   else if(stricmp(cmd, "eventstats") == 0)
+   {
+      GameConnection *conn = clientInfo->getConnection();
+
+      if(!clientInfo->isAdmin())
+         conn->s2cDisplayErrorMessage("!!! Need admin");
+
+      else if(args.size() >= 1 && stricmp(args[0].getString(), "reset") == 0)
+      {
+         EventManager::get()->resetEventCounts();
+         conn->s2cDisplayMessage(0, 0, "Event counts reset");
+      }
+
+      else
+      {
+         Vector<string> lines;
+         EventManager::get()->getEventReport(lines);
+
+         if(lines.size() == 0)
+            conn->s2cDisplayMessage(0, 0, "No events have been fired");
+
+         for(S32 i = 0; i < lines.size(); i++)
+            conn->s2cDisplayMessage(0, 0, lines[i].c_str());
+      }
+   }
+   // /luaprofile start [part of bot name or script filename] ... /luaprofile stop
+   else if(stricmp(cmd, "luaprofile") == 0)
+   {
+      GameConnection *conn = clientInfo->getConnection();
+
+      if(!clientInfo->isAdmin())
+         conn->s2cDisplayErrorMessage("!!! Need admin");
+
+      else if(args.size() >= 1 && stricmp(args[0].getString(), "start") == 0)
+      {
+         S32 count = LuaScriptRunner::startProfiling(args.size() >= 2 ? args[1].getString() : "");
+
+         if(count == 0)
+            conn->s2cDisplayErrorMessage("!!! No scripts to profile");
+         else
+            conn->s2cDisplayMessage(0, 0, ("Profiling " + itos(count) + " script(s); /luaprofile stop to see the results").c_str());
+      }
+
+      else if(args.size() >= 1 && stricmp(args[0].getString(), "stop") == 0)
+      {
+         Vector<string> summary;
+         string dir = serverGame->getSettings()->getFolderManager()->getLogDir();
+
+         if(LuaScriptRunner::stopProfiling(dir, summary) == 0)
+            conn->s2cDisplayErrorMessage("!!! No scripts are being profiled");
+
+         for(S32 i = 0; i < summary.size(); i++)
+            conn->s2cDisplayMessage(0, 0, summary[i].c_str());
+      }
+
+      else
+         conn->s2cDisplayErrorMessage("!!! Usage: /luaprofile start [name], or /luaprofile stop");
+   }
    else
       clientInfo->getConnection()->s2cDisplayErrorMessage("!!! Invalid Command");
 }
@@ -3676,7 +3855,7 @@ TNL_IMPLEMENT_NETOBJECT_RPC(GameType, c2sResendItemStatus, (U16 itemId), (itemId
       }
    }
 
-   fillVector.clear();
+   FillVector fillVector;
    mLevel->findObjects(fillVector);
 
    for(S32 i = 0; i < fillVector.size(); i++)
@@ -96,6 +96,23 @@ private:
 
    Vector<SafePtr<MoveItem> > mCacheResendItem;  // Speed up c2sResendItemStatus
 
+   // What each ship or spy bug can see, shared by every connection looking through it (e.g. teammates in
+   // commander's map mode).  Only good while nothing in the level changes; see getScopeCacheEntry().
+   struct ScopeCacheEntry
+   {
+      const BfObject *vantage;
+      bool hasSensor;
+      Vector<DatabaseObject *> objects;
+   };
+
+   Vector<ScopeCacheEntry> mScopeCache;    // Entries beyond mScopeCacheSize are unused, but keep their storage
+   S32 mScopeCacheSize;
+   U32 mScopeCacheChangeCount;
+
+   ScopeCacheEntry *getScopeCacheEntry(const BfObject *vantage, bool hasSensor, bool &found);
+   const Vector<DatabaseObject *> &getShipScope(Ship *ship);
+   const Vector<DatabaseObject *> &getSpyBugScope(SpyBug *spyBug);
+
    void initialize(Level *level, S32 winningScore);
 
    void idle_client(U32 deltaT);
@@ -501,9 +518,6 @@ public:
 
    void announceTeamsLocked(bool locked);
    void displayAnnouncement(const string &message) const;
-
-
-   map <pair<U16,U16>, Vector<Point> > cachedBotFlightPlans;  // cache of zone-to-zone flight plans, shared for all bots
 };
 
 #define GAMETYPE_RPC_S2C(className, methodName, args, argNames) \
@@ -232,6 +232,12 @@ S32 GoalZone::getScore()
 }
 
 
+bool GoalZone::hasFlag() const
+{
+   return mHasFlag;
+}
+
+
 void GoalZone::setHasFlag(bool hasFlag)
 {
    mHasFlag = hasFlag;
@@ -289,7 +295,7 @@ void GoalZone::idle(BfObject::IdleCallPath path)
  */
 //               Fn name       Param profiles  Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, hasFlag,     ARRAYDEF({{ END }}), 1 ) \
+   METHOD(CLASS, hasFlag,     ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
 
 GENERATE_LUA_METHODS_TABLE(GoalZone, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(GoalZone, LUA_METHODS);
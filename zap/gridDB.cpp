@@ -13,34 +13,30 @@
 #include "tnlLog.h"
 #include "tnlNetBase.h"
 
+#include <atomic>
+
 namespace Zap
 {
 
 // Statics
-U32 GridDatabase::mQueryId = 0;
-ClassChunker<DatabaseBucketEntry> *GridDatabase::mChunker = NULL;
-U32 GridDatabase::mCountGridDatabase = 0;
+bool GridDatabase::mAdaptiveBucketSizing = true;
 
 
 static U32 getNextId() 
 {
-   static U32 nextId = 0;
+   static std::atomic<U32> nextId(0);
    return nextId++;
 }
 
-// Constructor
-GridDatabase::GridDatabase()
+// Constructor -- there are a lot of small databases around, so we'll give out bucket entries in smaller blocks than usual
+GridDatabase::GridDatabase() : mChunker(ChunkerBlockSize)
 {
-   if(mChunker == NULL)
-      mChunker = new ClassChunker<DatabaseBucketEntry>();        // Static shared by all databases, reference counted and deleted in destructor
-
-   mCountGridDatabase++;
-
-   for(U32 i = 0; i < BucketRowCount; i++)
-      for(U32 j = 0; j < BucketRowCount; j++)
-         mBuckets[i][j].nextInBucket = NULL;
+   mBucketRowCount = 0;
+   mBucketWidthBitShift = 0;
+   setBucketLayout(DefaultBucketRowCount, DefaultBucketWidthBitShift);
 
    mDatabaseId = getNextId();
+   mChangeCount = 0;
 }
 
 
@@ -48,15 +44,148 @@ GridDatabase::GridDatabase()
 GridDatabase::~GridDatabase()       
 {
    removeEverythingFromDatabase();
+}
+
 
-   TNLAssert(mChunker != NULL || mCountGridDatabase != 0, "Running GridDatabase destructor without initalizing?");
+// Changes the size and shape of our spatial grid; any objects already in the database will be moved into the new buckets
+void GridDatabase::setBucketLayout(U32 rowCount, S32 bucketWidthBitShift)
+{
+   TNLAssert(rowCount > 0 && (rowCount & (rowCount - 1)) == 0, "Row count must be a power of 2!");
+
+   if(rowCount == mBucketRowCount && bucketWidthBitShift == mBucketWidthBitShift)
+      return;
+
+   for(S32 i = 0; i < mAllObjects.size(); i++)
+      unlinkFromBuckets(mAllObjects[i]);
 
-   mCountGridDatabase--;
+   mBucketRowCount = rowCount;
+   mBucketMask = rowCount - 1;
+   mBucketWidthBitShift = bucketWidthBitShift;
 
-   if(mCountGridDatabase == 0)
+   mBuckets.resize(rowCount * rowCount);
+
+   for(S32 i = 0; i < mBuckets.size(); i++)
+      mBuckets[i].nextInBucket = NULL;
+
+   IntRect bins;
+
+   for(S32 i = 0; i < mAllObjects.size(); i++)
    {
-      delete mChunker;
-      mChunker = NULL;
+      fillBins(mAllObjects[i]->getExtent(), bins);
+      linkToBuckets(mAllObjects[i], bins);
+   }
+}
+
+
+// Pick a grid layout that covers extents without wrapping, so that objects at opposite ends of a big level don't
+// land in the same bucket.  We start with the default layout, and add rows until extents fit; if we hit
+// MaxBucketRowCount first, we make the buckets wider instead.  We never go smaller than the default.
+void GridDatabase::sizeBucketsToExtents(const Rect &extents)
+{
+   // +1 because extents are unlikely to line up with bucket boundaries
+   S32 span = S32(min(max(extents.getWidth(), extents.getHeight()), F32(S32_MAX >> 1))) + 1;
+
+   S32 shift = DefaultBucketWidthBitShift;
+   while((span >> shift) + 1 > MaxBucketRowCount && shift < MaxBucketWidthBitShift)
+      shift++;
+
+   U32 rowCount = DefaultBucketRowCount;
+   while(rowCount < U32(span >> shift) + 1 && rowCount < MaxBucketRowCount)
+      rowCount <<= 1;
+
+   setBucketLayout(rowCount, shift);
+}
+
+
+U32 GridDatabase::getBucketRowCount() const
+{
+   return mBucketRowCount;
+}
+
+
+S32 GridDatabase::getBucketWidthBitShift() const
+{
+   return mBucketWidthBitShift;
+}
+
+
+// Diagnostic -- returns the number of bucket entries that a search of extents will walk, including duplicates and
+// objects that turn out not to overlap extents.  Compare with the number of objects actually found to judge how
+// well the bucket layout suits the level.
+S32 GridDatabase::countBucketEntries(const Rect &extents) const
+{
+   IntRect bins;
+   fillBins(extents, bins);
+
+   S32 count = 0;
+
+   for(S32 x = bins.minx; bins.maxx - x >= 0; x++)
+      for(S32 y = bins.miny; bins.maxy - y >= 0; y++)
+         for(DatabaseBucketEntry *walk = getBucket(x, y)->nextInBucket; walk; walk = walk->nextInBucket)
+            count++;
+
+   return count;
+}
+
+
+void GridDatabase::setAdaptiveBucketSizing(bool adaptive)
+{
+   mAdaptiveBucketSizing = adaptive;
+}
+
+
+bool GridDatabase::getAdaptiveBucketSizing()
+{
+   return mAdaptiveBucketSizing;
+}
+
+
+// Coordinates are wrapped, so every (x,y) maps to some bucket
+DatabaseBucketEntryBase *GridDatabase::getBucket(S32 x, S32 y)
+{
+   return &mBuckets[(U32(x) & mBucketMask) * mBucketRowCount + (U32(y) & mBucketMask)];
+}
+
+
+const DatabaseBucketEntryBase *GridDatabase::getBucket(S32 x, S32 y) const
+{
+   return &mBuckets[(U32(x) & mBucketMask) * mBucketRowCount + (U32(y) & mBucketMask)];
+}
+
+
+// Don't use x <= maxx, it will endless loop if maxx = S32_MAX and x overflows
+// Instead, use maxx - x >= 0, it will better handle overflows and avoid endless loop (MIN_S32 - MAX_S32 = +1)
+void GridDatabase::linkToBuckets(DatabaseObject *object, const IntRect &bins)
+{
+   for(S32 x = bins.minx; bins.maxx - x >= 0; x++)
+      for(S32 y = bins.miny; bins.maxy - y >= 0; y++)
+      {
+         DatabaseBucketEntry *be = mChunker.alloc();
+         DatabaseBucketEntryBase *base = getBucket(x, y);
+         be->theObject = object;
+         if(base->nextInBucket)
+            base->nextInBucket->prevInBucket = be;
+         be->nextInBucket = base->nextInBucket;
+         be->prevInBucket = base;
+         base->nextInBucket = be;
+         be->nextInBucketForThisObject = object->mBucketList;
+         object->mBucketList = be;
+      }
+}
+
+
+void GridDatabase::unlinkFromBuckets(DatabaseObject *object)
+{
+   while(object->mBucketList)
+   {
+      DatabaseBucketEntry *b = object->mBucketList;
+      TNLAssert(b->theObject == object, "Object mismatch");
+      TNLAssert(b->prevInBucket->nextInBucket == b, "Broken linked list");
+      if(b->nextInBucket)
+         b->nextInBucket->prevInBucket = b->prevInBucket;
+      b->prevInBucket->nextInBucket = b->nextInBucket;
+      object->mBucketList = b->nextInBucketForThisObject;
+      mChunker.free(b);
    }
 }
 
@@ -96,6 +225,8 @@ void GridDatabase::copyObjects(const GridDatabase *source)
    mWallitems   .reserve(source->mWallitems.size());
    mLoadoutZones.reserve(source->mLoadoutZones.size());
 
+   setBucketLayout(source->mBucketRowCount, source->mBucketWidthBitShift);
+
    for(S32 i = 0; i < source->mAllObjects.size(); i++)
       addToDatabase(source->mAllObjects[i]->clone());
 
@@ -119,24 +250,12 @@ void GridDatabase::addToDatabase(DatabaseObject *object)
       return;
 
    object->mDatabase = this;
+   mChangeCount++;
 
-   static IntRect bins;
+   IntRect bins;
    fillBins(object->getExtent(), bins);
 
-   for(S32 x = bins.minx; bins.maxx - x >= 0; x++)
-      for(S32 y = bins.miny; bins.maxy - y >= 0; y++)
-      {
-         DatabaseBucketEntry *be = mChunker->alloc();
-         DatabaseBucketEntryBase *base = &mBuckets[x & BucketMask][y & BucketMask];
-         be->theObject = object;
-         if(base->nextInBucket)
-            base->nextInBucket->prevInBucket = be;
-         be->nextInBucket = base->nextInBucket;
-         be->prevInBucket = base;
-         base->nextInBucket = be;
-         be->nextInBucketForThisObject = object->mBucketList;
-         object->mBucketList = be;
-      }
+   linkToBuckets(object, bins);
 
    // Add the object to our non-spatial "database" as well
    mAllObjects.push_back(object);
@@ -186,20 +305,19 @@ void GridDatabase::addToDatabase(const Vector<BfObject *> &objects)
 // Removes and deletes all objects in database
 void GridDatabase::removeEverythingFromDatabase()
 {
-   for(S32 x = 0; x < BucketRowCount; x++)
+   mChangeCount++;
+
+   for(S32 i = 0; i < mBuckets.size(); i++)
    {
-      for(S32 y = 0; y < BucketRowCount; y++)
+      for(DatabaseBucketEntry *walk = mBuckets[i].nextInBucket; walk; )
       {
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; )
-         {
-            DatabaseBucketEntry *rem = walk;
-            walk->theObject->mDatabase = NULL;  // make sure object don't point to this database anymore
-            walk->theObject->mBucketList = NULL;
-            walk = rem->nextInBucket;
-            mChunker->free(rem);
-         }
-         mBuckets[x & BucketMask][y & BucketMask].nextInBucket = NULL;
+         DatabaseBucketEntry *rem = walk;
+         walk->theObject->mDatabase = NULL;  // make sure object don't point to this database anymore
+         walk->theObject->mBucketList = NULL;
+         walk = rem->nextInBucket;
+         mChunker.free(rem);
       }
+      mBuckets[i].nextInBucket = NULL;
    }
 
    // Clear out our specialty lists -- since objects are also in mAllObjects, they'll be deleted below
@@ -245,23 +363,10 @@ void GridDatabase::removeFromDatabase(DatabaseObject *object, bool deleteObject)
    if(object->mDatabase != this)
       return;
 
-   const Rect &extents = object->mExtent;
    object->mDatabase = NULL;
+   mChangeCount++;
 
-   static IntRect bins;
-   fillBins(extents, bins);
-
-   while(object->mBucketList)
-   {
-      DatabaseBucketEntry *b = object->mBucketList;
-      TNLAssert(b->theObject == object, "Object mismatch");
-      TNLAssert(b->prevInBucket->nextInBucket == b, "Broken linked list");
-      if(b->nextInBucket)
-         b->nextInBucket->prevInBucket = b->prevInBucket;
-      b->prevInBucket->nextInBucket = b->nextInBucket;
-      object->mBucketList = b->nextInBucketForThisObject;
-      mChunker->free(b);
-   }
+   unlinkFromBuckets(object);
 
    // Find and delete object from our non-spatial databases
    for(S32 i = 0; i < mAllObjects.size(); i++)
@@ -337,34 +442,50 @@ const Vector<DatabaseObject *> *GridDatabase::findObjects_fast(U8 typeNumber) co
 }
 
 
-void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const
+// An object that spans several buckets will be seen in each of them during a search.  So that we only report it once,
+// and without marking the object itself (which would make searches unsafe to run concurrently), we only accept it
+// from the bucket holding the first cell that both the object and the search area cover.  Buckets wrap around, so
+// we compare bucket coordinates rather than cells.
+bool GridDatabase::isFirstBucketForObject(const DatabaseObject *object, const IntRect &bins, S32 x, S32 y) const
 {
-   static Vector<U8> types;
-   types.resize(1);
+   IntRect objectBins;
+   fillBins(object->mExtent, objectBins);
 
-   types[0] = typeNumber;
+   S32 firstx = max(bins.minx, objectBins.minx);
+   S32 firsty = max(bins.miny, objectBins.miny);
 
-   findObjects(types, fillVector, extents, bins);
+   return ((U32(x ^ firstx) | U32(y ^ firsty)) & mBucketMask) == 0;
 }
 
 
-void GridDatabase::findObjects(Vector<U8> typeNumbers, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const
+void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents, const IntRect &bins) const
 {
-   mQueryId++;    // Used to prevent the same item from being found in multiple buckets
+   for(S32 x = bins.minx; bins.maxx - x >= 0; x++)
+      for(S32 y = bins.miny; bins.maxy - y >= 0; y++)
+         for(DatabaseBucketEntry *walk = getBucket(x, y)->nextInBucket; walk; walk = walk->nextInBucket)
+         {
+            DatabaseObject *theObject = walk->theObject;
+
+            if(theObject->getObjectTypeNumber() == typeNumber &&             // Object is of the right type; and
+               theObject->mExtent.intersects(extents) &&                     // overlaps our extents; and
+               isFirstBucketForObject(theObject, bins, x, y))                // hasn't been found in another bucket
+               fillVector.push_back(theObject);
+         }
+}
+
 
-   for(S32 x = bins->minx; bins->maxx - x >= 0; x++)
-      for(S32 y = bins->miny; bins->maxy - y >= 0; y++)
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; walk = walk->nextInBucket)
+void GridDatabase::findObjects(const Vector<U8> &typeNumbers, Vector<DatabaseObject *> &fillVector, const Rect &extents, const IntRect &bins) const
+{
+   for(S32 x = bins.minx; bins.maxx - x >= 0; x++)
+      for(S32 y = bins.miny; bins.maxy - y >= 0; y++)
+         for(DatabaseBucketEntry *walk = getBucket(x, y)->nextInBucket; walk; walk = walk->nextInBucket)
          {
             DatabaseObject *theObject = walk->theObject;
 
-            if(theObject->mLastQueryId != mQueryId &&                         // Object hasn't been queried; and
-               testTypes(typeNumbers, theObject->getObjectTypeNumber()) &&    // is of the right type; and
-               (!extents || theObject->mExtent.intersects(*extents)) )        // overlaps our extents (if passed)
-            {
-               walk->theObject->mLastQueryId = mQueryId;    // Flag the object so we know we've already visited it
-               fillVector.push_back(walk->theObject);       // And save it as a found item
-            }
+            if(testTypes(typeNumbers, theObject->getObjectTypeNumber()) &&   // Object is of the right type; and
+               theObject->mExtent.intersects(extents) &&                     // overlaps our extents; and
+               isFirstBucketForObject(theObject, bins, x, y))                // hasn't been found in another bucket
+               fillVector.push_back(theObject);
          }
 }
 
@@ -386,48 +507,43 @@ void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVect
 // Translates extents into bins to search
 void GridDatabase::fillBins(const Rect &extents, IntRect &bins) const
 {
-   bins.minx = S32(extents.min.x) >> BucketWidthBitShift;
-   bins.miny = S32(extents.min.y) >> BucketWidthBitShift;
-   bins.maxx = S32(extents.max.x) >> BucketWidthBitShift;
-   bins.maxy = S32(extents.max.y) >> BucketWidthBitShift;
+   bins.minx = S32(extents.min.x) >> mBucketWidthBitShift;
+   bins.miny = S32(extents.min.y) >> mBucketWidthBitShift;
+   bins.maxx = S32(extents.max.x) >> mBucketWidthBitShift;
+   bins.maxy = S32(extents.max.y) >> mBucketWidthBitShift;
 
-   if(U32(bins.maxx - bins.minx) >= BucketRowCount)
-      bins.maxx = bins.minx + BucketRowCount - 1;
+   if(U32(bins.maxx - bins.minx) >= mBucketRowCount)
+      bins.maxx = bins.minx + mBucketRowCount - 1;
 
-   if(U32(bins.maxy - bins.miny) >= BucketRowCount)
-      bins.maxy = bins.miny + BucketRowCount - 1;
+   if(U32(bins.maxy - bins.miny) >= mBucketRowCount)
+      bins.maxy = bins.miny + mBucketRowCount - 1;
 }
 
 
 // Find all objects in &extents that are of type typeNumber
 void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
 {
-   static IntRect bins;
+   IntRect bins;
    fillBins(extents, bins);
 
-   findObjects(typeNumber, fillVector, &extents, &bins);
+   findObjects(typeNumber, fillVector, extents, bins);
 }
 
 
-void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins, bool sameQuery) const
+void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents, const IntRect &bins) const
 {
    TNLAssert(this, "findObjects 'this' is NULL");
-   if(!sameQuery)
-      mQueryId++;    // Used to prevent the same item from being found in multiple buckets
 
-   for(S32 x = bins->minx; bins->maxx - x >= 0; x++)
-      for(S32 y = bins->miny; bins->maxy - y >= 0; y++)
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; walk = walk->nextInBucket)
+   for(S32 x = bins.minx; bins.maxx - x >= 0; x++)
+      for(S32 y = bins.miny; bins.maxy - y >= 0; y++)
+         for(DatabaseBucketEntry *walk = getBucket(x, y)->nextInBucket; walk; walk = walk->nextInBucket)
          {
             DatabaseObject *theObject = walk->theObject;
 
-            if(theObject->mLastQueryId != mQueryId &&                      // Object hasn't been queried; and
-               (testFunc(theObject->getObjectTypeNumber())) &&             // is of the right type; and
-               (!extents || theObject->mExtent.intersects(*extents)) )     // overlaps our extents (if passed)
-            {
-               walk->theObject->mLastQueryId = mQueryId;    // Flag the object so we know we've already visited it
-               fillVector.push_back(walk->theObject);       // And save it as a found item
-            }
+            if(testFunc(theObject->getObjectTypeNumber()) &&                 // Object is of the right type; and
+               theObject->mExtent.intersects(extents) &&                     // overlaps our extents; and
+               isFirstBucketForObject(theObject, bins, x, y))                // hasn't been found in another bucket
+               fillVector.push_back(theObject);
          }
 }
 
@@ -444,10 +560,10 @@ void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fill
 // Find all objects in database using derived type test function
 void GridDatabase::findObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
 {
-   static IntRect bins;
+   IntRect bins;
    fillBins(extents, bins);
 
-   findObjects(types, fillVector, &extents, &bins);
+   findObjects(types, fillVector, extents, bins);
 }
 
 
@@ -471,20 +587,20 @@ bool GridDatabase::testTypes(const Vector<U8> &types, U8 objectType) const
 
 
 // Find all objects in &extents derived type test function
-void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents, bool sameQuery) const
+void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
 {
-   static IntRect bins;
+   IntRect bins;
    fillBins(extents, bins);
 
-   findObjects(testFunc, fillVector, &extents, &bins, sameQuery);
+   findObjects(testFunc, fillVector, extents, bins);
 }
 
 
 void GridDatabase::dumpObjects()
 {
-   for(S32 x = 0; x < BucketRowCount; x++)
-      for(S32 y = 0; y < BucketRowCount; y++)
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; walk = walk->nextInBucket)
+   for(S32 x = 0; x < (S32)mBucketRowCount; x++)
+      for(S32 y = 0; y < (S32)mBucketRowCount; y++)
+         for(DatabaseBucketEntry *walk = getBucket(x, y)->nextInBucket; walk; walk = walk->nextInBucket)
          {
             DatabaseObject *object = walk->theObject;
             logprintf("Found object in (%d,%d) with extents %s", x, y, object->getExtent().toString().c_str());
@@ -575,7 +691,6 @@ DatabaseObject::~DatabaseObject()
 // Code that needs to run for both constructor and copy constructor
 void DatabaseObject::initialize() 
 {
-   mLastQueryId = 0; 
    mExtent = Rect(); 
    mExtentSet = false;
    mDatabase = NULL;
@@ -601,10 +716,7 @@ DatabaseObject *GridDatabase::findObjectLOS(U8 typeNumber, U32 stateIndex, bool
 {
    Rect queryRect(rayStart, rayEnd);
 
-   // Use a local copy here, most callers expect our global fillVector to remain unchanged
-   static Vector<DatabaseObject *> fillVector;  
-   fillVector.clear();
-
+   FillVector fillVector;
    findObjects(typeNumber, fillVector, queryRect);
 
    return findObjectLOS(fillVector, stateIndex, format, rayStart, rayEnd, collisionTime, surfaceNormal);
@@ -617,10 +729,7 @@ DatabaseObject *GridDatabase::findObjectLOS(TestFunc testFunc, U32 stateIndex, b
 {
    Rect queryRect(rayStart, rayEnd);
 
-   // Use a local copy here, most callers expect our global fillVector to remain unchanged
-   static Vector<DatabaseObject *> fillVector;  
-   fillVector.clear();
-
+   FillVector fillVector;
    findObjects(testFunc, fillVector, queryRect);
 
    return findObjectLOS(fillVector, stateIndex, format, rayStart, rayEnd, collisionTime, surfaceNormal);
@@ -718,6 +827,12 @@ S32 GridDatabase::getObjectCount() const
 }
 
 
+U32 GridDatabase::getChangeCount() const
+{
+   return mChangeCount;
+}
+
+
 // Return count of objects of specified type.  Only supports certain types at the moment.
 S32 GridDatabase::getObjectCount(U8 typeNumber) const
 {
@@ -805,62 +920,19 @@ void GridDatabase::updateExtents(DatabaseObject *object, const Rect &newExtents)
    // removeFromDatabase();    
    // addToDatabase();
 
-   S32 minxold, minyold, maxxold, maxyold;
-   S32 minx, miny, maxx, maxy;
-
-   Rect oldExtents = object->getExtent();
+   IntRect oldBins, bins;
 
-   minxold = S32(oldExtents.min.x) >> BucketWidthBitShift;
-   minyold = S32(oldExtents.min.y) >> BucketWidthBitShift;
-   maxxold = S32(oldExtents.max.x) >> BucketWidthBitShift;
-   maxyold = S32(oldExtents.max.y) >> BucketWidthBitShift;
+   mChangeCount++;      // Even if the buckets stay the same, the object has moved
 
-   minx    = S32(newExtents.min.x) >> BucketWidthBitShift;
-   miny    = S32(newExtents.min.y) >> BucketWidthBitShift;
-   maxx    = S32(newExtents.max.x) >> BucketWidthBitShift;
-   maxy    = S32(newExtents.max.y) >> BucketWidthBitShift;
+   fillBins(object->getExtent(), oldBins);
+   fillBins(newExtents, bins);
 
    // Don't do anything if the buckets haven't changed...
-   if((minxold - minx) | (minyold - miny) | (maxxold - maxx) | (maxyold - maxy))
+   if((oldBins.minx - bins.minx) | (oldBins.miny - bins.miny) | (oldBins.maxx - bins.maxx) | (oldBins.maxy - bins.maxy))
    {
       // They are different... remove and readd to database, but don't touch mAllObjects
-      if(U32(maxx - minx) >= BucketRowCount)        maxx    = minx    + BucketRowCount - 1;
-      if(U32(maxy - miny) >= BucketRowCount)        maxy    = miny    + BucketRowCount - 1;
-      if(U32(maxxold >= minxold) + BucketRowCount)  maxxold = minxold + BucketRowCount - 1;
-      if(U32(maxyold >= minyold) + BucketRowCount)  maxyold = minyold + BucketRowCount - 1;
-
-
-      // Don't use x <= maxx, it will endless loop if maxx = S32_MAX and x overflows
-      // Instead, use maxx - x >= 0, it will better handle overflows and avoid endless loop (MIN_S32 - MAX_S32 = +1)
-
-      // Remove from the extents database for current extents...
-      while(object->mBucketList)
-      {
-         DatabaseBucketEntry *b = object->mBucketList;
-         TNLAssert(b->theObject == object, "Object mismatch");
-         TNLAssert(b->prevInBucket->nextInBucket == b, "Broken linked list");
-         if(b->nextInBucket)
-            b->nextInBucket->prevInBucket = b->prevInBucket;
-         b->prevInBucket->nextInBucket = b->nextInBucket;
-         object->mBucketList = b->nextInBucketForThisObject;
-         mChunker->free(b);
-      }
-
-      // ...and re-add for the new extent
-      for(S32 x = minx; maxx - x >= 0; x++)
-         for(S32 y = miny; maxy - y >= 0; y++)
-         {
-            DatabaseBucketEntry *be = mChunker->alloc();
-            DatabaseBucketEntryBase *base = &mBuckets[x & BucketMask][y & BucketMask];
-            be->theObject = object;
-            if(base->nextInBucket)
-               base->nextInBucket->prevInBucket = be;
-            be->nextInBucket = base->nextInBucket;
-            be->prevInBucket = base;
-            base->nextInBucket = be;
-            be->nextInBucketForThisObject = object->mBucketList;
-            object->mBucketList = be;
-         }
+      unlinkFromBuckets(object);
+      linkToBuckets(object, bins);
    }
 }
 
@@ -1017,11 +1089,36 @@ DatabaseObject *DatabaseObject::clone() const
 }
 
 
-};
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Spare buffers for FillVector, one stack per thread.  Buffers keep their capacity between uses, so once things
+// warm up, searches don't need to allocate anything.
+static thread_local std::vector<std::vector<DatabaseObject *> > fillVectorPool;
+
+
+// Constructor -- borrow a buffer from this thread's pool, if there is one
+FillVector::FillVector()
+{
+   if(!fillVectorPool.empty())
+   {
+      getStlVector().swap(fillVectorPool.back());
+      fillVectorPool.pop_back();
+   }
+}
+
+
+// Destructor -- return our buffer to the pool for the next search
+FillVector::~FillVector()
+{
+   if(fillVectorPool.size() >= MaxPooledBuffers)
+      return;
 
-// Reusable container for searching gridDatabases
-// Has to be outside of Zap namespace seems to help with debugging showing what's inside fillVector  (debugger forgets to add Zap::)
-Vector<Zap::DatabaseObject *> fillVector;
-Vector<Zap::DatabaseObject *> fillVector2;
+   clear();
+   fillVectorPool.push_back(std::vector<DatabaseObject *>());
+   fillVectorPool.back().swap(getStlVector());
+}
 
 
+};
+
@@ -53,7 +53,6 @@ class DatabaseObject : public GeomObject
    friend class EditorObjectDatabase;
 
 private:
-   U32 mLastQueryId;
    Rect mExtent;
    bool mExtentSet;     // A flag to mark whether extent has been set on this object
    GridDatabase *mDatabase;
@@ -111,8 +110,16 @@ class GridDatabase
 {
 private:
    U32 mDatabaseId;
-   static U32 mQueryId;
-   static U32 mCountGridDatabase;      // Reference counter for destruction of mChunker
+   U32 mChangeCount;                   // Bumped whenever an object is added, removed or moved
+   static bool mAdaptiveBucketSizing;  // Should levels resize their buckets to fit their extents when loaded?
+
+   // Spatial buckets -- a square grid of mBucketRowCount x mBucketRowCount cells, each 2 ^ mBucketWidthBitShift 
+   // pixels wide.  Coordinates outside the grid wrap around, so the grid covers the whole plane, but objects far
+   // apart can end up sharing a bucket.  Stored row-major in a flat list; see getBucket().
+   Vector<DatabaseBucketEntryBase> mBuckets;
+   U32 mBucketRowCount;                // Should be power of 2
+   U32 mBucketMask;
+   S32 mBucketWidthBitShift;
 
    // For tracking objects by type
    Vector<DatabaseObject *> mAllObjects;
@@ -125,27 +132,46 @@ private:
    // For tracking objects by type and team
    Vector<Vector<DatabaseObject *> > mLoadoutZones;
 
-   void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const;
-   void findObjects(Vector<U8> typeNumbers, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const;
-   void findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins, bool sameQuery = false) const;
+   void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents, const IntRect &bins) const;
+   void findObjects(const Vector<U8> &typeNumbers, Vector<DatabaseObject *> &fillVector, const Rect &extents, const IntRect &bins) const;
+   void findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents, const IntRect &bins) const;
 
    void fillBins(const Rect &extents, IntRect &bins) const;    // Helper function -- translates extents into bins to search
+   bool isFirstBucketForObject(const DatabaseObject *object, const IntRect &bins, S32 x, S32 y) const;
+
+   DatabaseBucketEntryBase *getBucket(S32 x, S32 y);
+   const DatabaseBucketEntryBase *getBucket(S32 x, S32 y) const;
+
+   void linkToBuckets(DatabaseObject *object, const IntRect &bins);
+   void unlinkFromBuckets(DatabaseObject *object);
 
 public:
    enum {
-      BucketRowCount = 16,    // Number of buckets per grid row, and number of rows; should be power of 2
-      BucketMask = BucketRowCount - 1,
+      DefaultBucketRowCount = 16,      // Number of buckets per grid row, and number of rows, unless resized to fit a level
+      MaxBucketRowCount = 128,         // Upper limit when resizing; larger levels get wider buckets instead
+      ChunkerBlockSize = 4096,         // Bytes of bucket entries we allocate at a time
    };
 
-   static ClassChunker<DatabaseBucketEntry> *mChunker;
+   static const S32 DefaultBucketWidthBitShift = 8;   // Width/height of each bucket in pixels, in a form of 2 ^ n, 8 is 256 pixels
+   static const S32 MaxBucketWidthBitShift = 14;      // Widest we'll make a bucket when resizing, 16384 pixels
 
-   DatabaseBucketEntryBase mBuckets[BucketRowCount][BucketRowCount];
+   // Each database has its own, so databases belonging to different threads (a level being prepared in the background,
+   // say) don't trip over each other
+   ClassChunker<DatabaseBucketEntry> mChunker;
 
    explicit GridDatabase();   // Constructor
    virtual ~GridDatabase();   // Destructor
 
 
-   static const S32 BucketWidthBitShift = 8;    // Width/height of each bucket in pixels, in a form of 2 ^ n, 8 is 256 pixels
+   // Bucket layout -- changing it will re-bucket every object currently in the database
+   void setBucketLayout(U32 rowCount, S32 bucketWidthBitShift);
+   void sizeBucketsToExtents(const Rect &extents);
+   U32 getBucketRowCount() const;
+   S32 getBucketWidthBitShift() const;
+   S32 countBucketEntries(const Rect &extents) const;    // How many bucket entries a search of extents will visit
+
+   static void setAdaptiveBucketSizing(bool adaptive);
+   static bool getAdaptiveBucketSizing();
 
    DatabaseObject *findObjectLOS(U8 typeNumber, U32 stateIndex, bool format, const Point &rayStart, const Point &rayEnd,
                                  F32 &collisionTime, Point &surfaceNormal) const;
@@ -171,7 +197,7 @@ public:
    void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
 
    void findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector) const;
-   void findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents, bool sameQuery = false) const;
+   void findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
 
    void findObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector) const;
    void findObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
@@ -198,6 +224,7 @@ public:
    void removeEverythingFromDatabase();
 
    S32 getObjectCount() const;                          // Return the number of objects currently in the database
+   U32 getChangeCount() const;                          // Changes whenever search results might; for caching them
    S32 getObjectCount(U8 typeNumber) const;             // Return the number of objects currently in the database of specified type
    bool hasObjectOfType(U8 typeNumber) const;
    bool hasObjectOfType(U8 typeNumber, S32 teamIndex) const;
@@ -205,12 +232,25 @@ public:
 };
 
 
-}
+////////////////////////////////////////
+////////////////////////////////////////
 
+// Holds the results of a database search.  Declare one wherever you need to run a search, and pass it to
+// findObjects() as you would any Vector.  Storage is recycled through a per-thread pool, so this is cheap to
+// create, and because each search gets its own list, it is safe to run another search (or call code that does)
+// while working through the results of the first.
+class FillVector : public Vector<DatabaseObject *>
+{
+private:
+   static const U32 MaxPooledBuffers = 16;
+
+public:
+   FillVector();     // Constructor
+   ~FillVector();    // Destructor
+};
+
+
+}
 
-// Reusable container for searching gridDatabases
-// putting it outside of Zap namespace seems to help with visual C++ debugging showing whats inside fillVector  (debugger forgets to add Zap::)
-extern Vector<Zap::DatabaseObject *> fillVector;
-extern Vector<Zap::DatabaseObject *> fillVector2;
 
 #endif
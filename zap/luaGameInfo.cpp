@@ -31,22 +31,22 @@ LuaGameInfo::~LuaGameInfo()
 
 //                Fn name                  Param profiles            Profile count
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getGameType,          ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getGameTypeName,      ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getFlagCount,         ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getWinningScore,      ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getGameTimeTotal,     ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getGameTimeRemaining, ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getLeadingScore,      ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getLeadingTeam,       ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getTeamCount,         ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getLevelName,         ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, isTeamGame,           ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getEventScore,        ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getPlayers,           ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, isNexusOpen,          ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getNexusTimeLeft,     ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getTeam,              ARRAYDEF({{ TEAM_INDX, END }}), 1 ) \
+   METHOD(CLASS, getGameType,          ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getGameTypeName,      ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getFlagCount,         ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getWinningScore,      ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getGameTimeTotal,     ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getGameTimeRemaining, ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getLeadingScore,      ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getLeadingTeam,       ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getTeamCount,         ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getLevelName,         ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, isTeamGame,           ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getEventScore,        ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getPlayers,           ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, isNexusOpen,          ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getNexusTimeLeft,     ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getTeam,              ARRAYDEF({{ TEAM_INDX, END }}), 1, ReadsWorld   ) \
 
 GENERATE_LUA_FUNARGS_TABLE(LuaGameInfo, LUA_METHODS);
 GENERATE_LUA_METHODS_TABLE(LuaGameInfo, LUA_METHODS);
@@ -92,6 +92,7 @@ using namespace TNL;
 #endif
 
 #include "ServerGame.h"
+#include "GameRecorder.h"
 #include "version.h"       // For BUILD_VERSION def
 #include "DisplayManager.h"
 #include "stringUtils.h"
@@ -248,17 +249,30 @@ void display()
 
 
 // If the server game exists, and is shutting down, close any ClientGame connections we might have to it, then delete it.
-// If there are no client games, delete it and return to the OS.
+// If there are no client games, delete it and return to the OS.  A dedicated server hosting several arenas only quits
+// when the last one shuts down.
 void checkIfServerGameIsShuttingDown(U32 timeDelta)
 {
 #ifndef ZAP_DEDICATED
    const Vector<ClientGame *> *clientGames = GameManager::getClientGames();
 #endif
-   ServerGame *serverGame = GameManager::getServerGame();
+   Vector<ServerGame *> serverGames = *GameManager::getServerGames();   // Copy, as we might delete some
 
-   string shutdownReason;
-   if(serverGame && serverGame->isReadyToShutdown(timeDelta, shutdownReason))
+   for(S32 i = 0; i < serverGames.size(); i++)
    {
+      ServerGame *serverGame = serverGames[i];
+
+      string shutdownReason;
+      if(!serverGame->isReadyToShutdown(timeDelta, shutdownReason))
+         continue;
+
+      if(GameManager::getServerGames()->size() > 1)
+      {
+         logprintf(LogConsumer::ServerFilter, "Arena %s shut down; other arenas continue.", serverGame->getSettings()->getHostName().c_str());
+         GameManager::deleteServerGame(serverGame);
+         continue;
+      }
+
 #ifndef ZAP_DEDICATED
       // Disconnect any local clients, passing whatever reason string we have
       for(S32 i = 0; i < clientGames->size(); i++)
@@ -276,17 +290,16 @@ void checkIfServerGameIsShuttingDown(U32 timeDelta)
 
 // Need to do this here because this is really the only place where we can pass information from
 // a ServerGame directly to a ClientGame without any overly gross stuff.  But man, is this ugly!
-void loadAnotherLevelOrStartHosting()
+static void loadAnotherLevelOrStartHosting(ServerGame *serverGame)
 {
-   if(!GameManager::getServerGame())
-      return;
+   GameManager::setCurrentServerGame(serverGame);
 
    if(GameManager::getHostingModePhase() == GameManager::Hosting || GameManager::getHostingModePhase() == GameManager::NotHosting)
       return;
 
    if(GameManager::getHostingModePhase() == GameManager::LoadingLevels)
    {
-      string levelName = GameManager::getServerGame()->loadNextLevelInfo();
+      string levelName = serverGame->loadNextLevelInfo();
 
 #ifndef ZAP_DEDICATED
       const Vector<ClientGame *> *clientGames = GameManager::getClientGames();
@@ -307,6 +320,16 @@ void loadAnotherLevelOrStartHosting()
 }
 
 
+// Every arena loads its levels one per tick until it is ready to host
+void loadAnotherLevelOrStartHosting()
+{
+   Vector<ServerGame *> serverGames = *GameManager::getServerGames();   // Copy, as hosting can fail and delete an arena
+
+   for(S32 i = 0; i < serverGames.size(); i++)
+      loadAnotherLevelOrStartHosting(serverGames[i]);
+}
+
+
 // This is the master idle loop that is called on every game tick.
 // This in turn calls the idle functions for all other objects in the game.
 void idle()
@@ -384,7 +407,7 @@ void idle()
 
    // If there are no players, set sleepTime to 40 to further reduce impact on the server.
    // We'll only go into this longer sleep on dedicated servers when there are no players.
-   if(dedicated && GameManager::getServerGame()->isSuspended())
+   if(dedicated && GameManager::allServerGamesSuspended())
       sleepTime = 40;     // The higher this number, the less accurate the ping is on server lobby when empty, but the less power consumed.
 
    Platform::sleep(sleepTime);
@@ -392,8 +415,85 @@ void idle()
 }  // end idle()
 
 
+// Alternative to calling idle() over and over: rather than polling every ms, sleep on the game sockets until a
+// packet arrives or the next tick is due.  Packets are read as soon as they show up, so pings and commands get
+// handled promptly, and ticks run on a fixed schedule that doesn't drift with however long each one took.
+static void eventDrivenServerLoop()
+{
+   static const U32 SuspendedTickInterval = 40;    // Same as the regular loop's sleep when nobody is playing
+
+   TickStats *tickStats = GameManager::getTickStats();
+
+   U32 lastTick = Platform::getRealMilliseconds();
+   U32 nextTick = lastTick;
+   U32 lastStatsReport = lastTick;
+
+   for(;;)        // Loop forever!
+   {
+      loadAnotherLevelOrStartHosting();
+
+      // Read everything we need from the settings now; the tick below can shut down the game that owns them
+      GameSettings *settings = GameManager::getServerGame()->getSettings();
+      U32 maxFPS = settings->getSetting<U32>(IniKey::MaxFpsServer);
+      U32 statsInterval = settings->getSetting<U32>(IniKey::TickStatsInterval) * 1000;
+
+      U32 tickInterval = maxFPS == 0 ? 1 : 1000 / maxFPS;
+      if(GameManager::allServerGamesSuspended())
+         tickInterval = max(tickInterval, SuspendedTickInterval);
+
+      U32 currentTime = Platform::getRealMilliseconds();
+
+      if(S32(nextTick - currentTime) > 0)
+      {
+         if(GameManager::waitForIncomingPackets(nextTick - currentTime))
+         {
+            tickStats->recordWakeup();
+            GameManager::readIncomingPackets();
+         }
+         continue;
+      }
+
+      U32 deltaT = currentTime - lastTick;
+      lastTick = currentTime;
+
+      S64 workStart = Platform::getHighPrecisionTimerValue();
+
+      checkIfServerGameIsShuttingDown(deltaT);
+      GameManager::idle(deltaT);
+
+      tickStats->recordTick(deltaT, Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - workStart), tickInterval);
+
+      // Keep to the schedule, unless we've fallen so far behind that catching up would mean a burst of ticks
+      nextTick += tickInterval;
+      if(S32(currentTime - nextTick) >= S32(tickInterval))
+         nextTick = currentTime + tickInterval;
+
+      if(statsInterval > 0 && currentTime - lastStatsReport >= statsInterval)
+      {
+         logprintf(LogConsumer::ServerFilter, "Server loop: %s", tickStats->toString().c_str());
+         tickStats->reset();
+
+         const Vector<ServerGame *> *serverGames = GameManager::getServerGames();
+         for(S32 i = 0; i < serverGames->size(); i++)
+         {
+            GameRecorderServer *recorder = serverGames->get(i)->getGameRecorder();
+            if(recorder)
+               logprintf(LogConsumer::ServerFilter, "Recorder %s: %s", recorder->mFileName.c_str(), recorder->getWriterStats().c_str());
+         }
+         lastStatsReport = currentTime;
+      }
+   }
+}
+
+
 void dedicatedServerLoop()
 {
+   ServerGame *serverGame = GameManager::getServerGame();
+
+   // Clients need to keep polling SDL, so only dedicated servers can wait on their sockets
+   if(serverGame && serverGame->isDedicated() && serverGame->getSettings()->getSetting<YesNo>(IniKey::EventDrivenLoop))
+      eventDrivenServerLoop();
+
    for(;;)        // Loop forever!
       idle();     // Idly!
 }
@@ -1192,6 +1292,8 @@ int main(int argc, char **argv)
 
    Ship::computeMaxFireDelay();                 // Look over weapon info and get some ranges, which we'll need before we start sending data
 
+   GridDatabase::setAdaptiveBucketSizing(settings->getSetting<YesNo>(IniKey::AdaptiveSpatialIndex));
+
    settings->runCmdLineDirectives();            // If we specified a directive on the cmd line, like -help, attend to that now
 
 
@@ -1217,6 +1319,11 @@ int main(int argc, char **argv)
 
       // Figure out what levels we'll be playing with, and start hosting  
       initHosting(settings, levelSource, false, true, settings->isCmdLineParamSpecified(HOST_ON_DEDICATED));
+
+      // Any extra arenas run right alongside, each on its own port
+      Vector<string> arenaNames = settings->getArenaNames();
+      for(S32 i = 0; i < arenaNames.size() && GameManager::getServerGame(); i++)
+         initArenaHosting(settings->createArenaSettings(arenaNames[i]), arenaNames[i]);
    }
    else
    {
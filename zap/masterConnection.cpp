@@ -463,6 +463,46 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, m2cPlayerLeftGlobalChat, (Str
 }
 
 
+// A tick's worth of the messages above, bundled together by the master
+// Runs on client only (but initiated by master)
+TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, m2cLobbyChatEvents, (Vector<U8> eventTypes, Vector<StringTableEntry> playerNicks, 
+                                                                         Vector<string> messages))
+{
+   if(mGame->isServer())
+      return;
+
+   ClientGame *clientGame = static_cast<ClientGame *>(mGame);
+   S32 messageIndex = 0;
+
+   for(S32 i = 0; i < eventTypes.size() && i < playerNicks.size(); i++)
+   {
+      switch(eventTypes[i])
+      {
+         case LobbyChatClientConnected:
+            clientGame->onClientConnectedToMaster(playerNicks[i]);
+            break;
+
+         case LobbyChatClientDisconnected:
+         case LobbyChatPlayerLeft:
+            clientGame->playerLeftLobbyChat(playerNicks[i]);
+            break;
+
+         case LobbyChatPlayerJoined:
+            clientGame->playerJoinedLobbyChat(playerNicks[i]);
+            break;
+
+         case LobbyChatMessage:
+            if(messageIndex < messages.size())
+               clientGame->gotLobbyChatMessage(playerNicks[i].getString(), messages[messageIndex++].c_str(), false);
+            break;
+
+         default:
+            break;      // From a newer master; nothing we can do with it
+      }
+   }
+}
+
+
 TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, m2cSendHighScores, (Vector<StringTableEntry> groupNames, 
                            Vector<string> names, Vector<string> scores))
 {
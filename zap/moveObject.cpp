@@ -463,7 +463,7 @@ BfObject *MoveObject::findFirstCollision(U32 stateIndex, F32 &collisionTime, Poi
    Rect queryRect(getPos(stateIndex), getPos(stateIndex) + delta);
    queryRect.expand(Point(mRadius, mRadius));
 
-   fillVector.clear();
+   FillVector fillVector;
 
    findObjects(collideTypes(), fillVector, queryRect);   // Free CPU for finding only the ones we care about
 
@@ -613,7 +613,7 @@ void MoveObject::getZonesObjectIsIn(Vector<SafePtr<Zone> > &zoneList)
 
    Rect rect(getActualPos(), getActualPos());            // Center of object
 
-   fillVector.clear();
+   FillVector fillVector;
    findObjects((TestFunc)isZoneType, fillVector, rect);  // Find all zones the object might be in
 
    // Extents overlap...  now check for actual overlap
@@ -885,10 +885,10 @@ void MoveObject::computeImpulseDirection(DamageInfo *damageInfo)
  */
 //               Fn name Param profiles  Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getVel, ARRAYDEF({{     END }}), 1 ) \
-   METHOD(CLASS, setVel, ARRAYDEF({{ PT, END }}), 1 ) \
-   METHOD(CLASS, getAngle, ARRAYDEF({{      END }}), 1 ) \
-   METHOD(CLASS, setAngle, ARRAYDEF({{ NUM, END }}), 1 ) \
+   METHOD(CLASS, getVel, ARRAYDEF({{     END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setVel, ARRAYDEF({{ PT, END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, getAngle, ARRAYDEF({{      END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setAngle, ARRAYDEF({{ NUM, END }}), 1, ChangesWorld ) \
 
 GENERATE_LUA_METHODS_TABLE(MoveObject, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(MoveObject, LUA_METHODS);
@@ -1385,8 +1385,8 @@ bool MountableItem::isItemThatMakesYouVisibleWhileCloaked() { return true; }
  */
 //               Fn name       Param profiles  Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getShip,  ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, isOnShip, ARRAYDEF({{ END }}), 1 ) \
+   METHOD(CLASS, getShip,  ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, isOnShip, ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
 
 GENERATE_LUA_METHODS_TABLE(MountableItem, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(MountableItem, LUA_METHODS);
@@ -1798,9 +1798,9 @@ void Asteroid::fillAttributesVectors(Vector<string> &keys, Vector<string> &value
  */
 //               Fn name       Param profiles  Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getSizeIndex, ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getSizeCount, ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, setSize,      ARRAYDEF({{ INT, END }}), 1 ) \
+   METHOD(CLASS, getSizeIndex, ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getSizeCount, ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setSize,      ARRAYDEF({{ INT, END }}), 1, ChangesWorld ) \
 
 GENERATE_LUA_METHODS_TABLE(Asteroid, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(Asteroid, LUA_METHODS);
@@ -33,13 +33,13 @@ LuaPlayerInfo::~LuaPlayerInfo()
  */
 //                Fn name                  Param profiles            Profile count
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getName,             ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getShip,             ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getTeamIndex,        ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getRating,               ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getScore,                ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, isRobot,                 ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getScriptName,           ARRAYDEF({{ END }}), 1 ) \
+   METHOD(CLASS, getName,             ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getShip,             ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getTeamIndex,        ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getRating,               ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getScore,                ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, isRobot,                 ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getScriptName,           ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
 
 GENERATE_LUA_FUNARGS_TABLE(LuaPlayerInfo, LUA_METHODS);
 GENERATE_LUA_METHODS_TABLE(LuaPlayerInfo, LUA_METHODS);
@@ -242,12 +242,10 @@ void Projectile::idle(BfObject::IdleCallPath path)
          Point endPos = startPos + (mVelocity * .001f) * timeLeft;    // mVelocity in units/sec, timeLeft in ms
 
          // Check for collision along projected route of movement
-         static Vector<BfObject *> disabledList;
+         Vector<BfObject *> disabledList;     // Usually stays empty, so costs nothing
 
          Rect queryRect(startPos, endPos);     // Bounding box of our travels
 
-         disabledList.clear();
-
 
          // Don't collide with shooter during first 500ms of life
          if(mShooter.isValid() && objAge < 500 && !mBounced)
@@ -461,10 +459,10 @@ bool Projectile::shouldRender() const
  */
 //               Fn name    Param profiles  Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getRad,    ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getWeapon, ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getVel,    ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, setVel,    ARRAYDEF({{ PT,  END }}), 1 ) \
+   METHOD(CLASS, getRad,    ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getWeapon, ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getVel,    ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setVel,    ARRAYDEF({{ PT,  END }}), 1, ChangesWorld ) \
 
 GENERATE_LUA_METHODS_TABLE(Projectile, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(Projectile, LUA_METHODS);
@@ -788,7 +786,7 @@ bool Burst::shouldRender() const
  */
 //               Fn name    Param profiles  Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getWeapon, ARRAYDEF({{ END }}), 1 ) \
+   METHOD(CLASS, getWeapon, ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
 
 GENERATE_LUA_METHODS_TABLE(Burst, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(Burst, LUA_METHODS);
@@ -896,7 +894,7 @@ void Mine::idle(IdleCallPath path)
    Rect queryRect(pos, pos);
    queryRect.expand(Point(SensorRadius, SensorRadius));
 
-   fillVector.clear();
+   FillVector fillVector;
    findObjects((TestFunc)isMotionTriggerType, fillVector, queryRect);
 
    // Found something!
@@ -1576,11 +1574,8 @@ void Seeker::acquireTarget()
 {
    F32 ourAngle = getActualAngle();
 
-   // Used for wall detection
-   static Vector<DatabaseObject *> localFillVector;
-
    Rect queryRect(getPos(), TargetAcquisitionRadius);
-   fillVector.clear();
+   FillVector fillVector;
    findObjects(isSeekerTarget, fillVector, queryRect);
 
    F32 closest = F32_MAX;
@@ -1616,7 +1611,8 @@ void Seeker::acquireTarget()
          continue;
 
       // Finally make sure there are no collideable objects in the way (like walls, forcefields)
-      localFillVector.clear();
+      // Used for wall detection
+      FillVector localFillVector;
       findObjects((TestFunc)isCollideableType, localFillVector, Rect(getPos(), foundObject->getPos()));
 
       F32 dummy;
@@ -1870,7 +1866,7 @@ bool Seeker::canAddToEditor() { return false; }    // No seekers in the editor!
  */
 //               Fn name    Param profiles  Profile count
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getWeapon, ARRAYDEF({{ END }}), 1 ) \
+   METHOD(CLASS, getWeapon, ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
 
 GENERATE_LUA_METHODS_TABLE(Seeker, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(Seeker, LUA_METHODS);
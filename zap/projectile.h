@@ -45,8 +45,6 @@ protected:
 
    Point mVelocity;
 
-   virtual F32 getRadius() const;
-
 public:
    U32 mTimeRemaining;
    ProjectileType mType;
@@ -74,6 +72,7 @@ public:
 
    virtual Point getRenderVel() const;
    virtual Point getActualVel() const;
+   virtual F32 getRadius() const;
 
    virtual bool canAddToEditor();
 
@@ -5,9 +5,11 @@
 
 #include "robot.h"
 
+#include "BotController.h"
 #include "Level.h"
 #include "playerInfo.h"          // For RobotPlayerInfo constructor
 #include "BotNavMeshZone.h"      // For BotNavMeshZone class definition
+#include "BotNavRouteTable.h"
 #include "GameObjectRender.h"
 #include "GameSettings.h"
 
@@ -44,6 +46,8 @@ TNL_IMPLEMENT_NETOBJECT(Robot);
 Robot::Robot(lua_State *L) : Ship(NULL, TEAM_NEUTRAL, Point(0,0)),   
                              LuaScriptRunner() 
 {
+   mController = NULL;
+
    if(L)
    {
       static LuaFunctionArgList constructorArgList = { {{ END }, { PT, TEAM_INDX, END }, { PT, TEAM_INDX, STRS, END }}, 3 };
@@ -57,12 +61,14 @@ Robot::Robot(lua_State *L) : Ship(NULL, TEAM_NEUTRAL, Point(0,0)),
 
       if(profile == 2)
       {
-         mScriptName = getGame()->getSettings()->getFolderManager()->findBotFile(getString(L, i++));
+         string scriptName = getString(L, i++);
 
          while(i <= lua_gettop(L))
          {
             mScriptArgs.push_back(getString(L, i++));
          }
+
+         setScript(scriptName, getGame()->getSettings()->getFolderManager());
       }
 
       lua_pop(L, i - 1);
@@ -72,6 +78,8 @@ Robot::Robot(lua_State *L) : Ship(NULL, TEAM_NEUTRAL, Point(0,0)),
    }
 
    mHasSpawned = false;
+   mThinkTickDeltaT = 0;
+   mHasThought = false;
    mObjectTypeNumber = RobotShipTypeNumber;
 
    mCurrentZone = U16_MAX;
@@ -107,6 +115,9 @@ Robot::~Robot()
 
    Game *game = getGame();
 
+   if(mController)
+      EventManager::get()->removeNativeListener(this);
+
    if(game)       // Can be NULL if this robot was never added to game (bad / missing robot file)
    {
       EventManager::get()->fireEvent(this, EventManager::PlayerLeftEvent, getPlayerInfo());
@@ -125,6 +136,8 @@ Robot::~Robot()
 	   delete mClientInfo.getPointer();
    }
 
+   delete mController;
+
    // Even though a similar line gets called when parent classes are destructed, we need this here to set our very own personal copy
    // of luaProxy as defunct.  Each "level" of an object has their own private lauProxy object that needs to be individually marked.
    LUAW_DESTRUCTOR_CLEANUP;
@@ -165,18 +178,61 @@ void Robot::doClassSpecificInitialization(const Point &pos)
 const char *Robot::getErrorMessagePrefix() { return "***ROBOT ERROR***"; }
 
 
+string Robot::getScriptDescription()
+{
+   if(!mClientInfo.isValid())
+      return LuaScriptRunner::getScriptDescription();
+
+   return "Robot " + string(mClientInfo->getName().getString()) + " (" + extractFilename(mScriptName) + ")";
+}
+
+
+static string getNextName()
+{
+   static const string botNames[] = {
+      "Addison", "Alexis", "Amelia", "Audrey", "Chloe", "Claire", "Elizabeth", "Ella",
+      "Emily", "Emma", "Evelyn", "Gabriella", "Hailey", "Hannah", "Isabella", "Layla",
+      "Lillian", "Lucy", "Madison", "Natalie", "Olivia", "Riley", "Samantha", "Zoe"
+   };
+
+   static U8 nameIndex = 0;
+   return botNames[(nameIndex++) % ARRAYSIZE(botNames)];
+}
+
+
 // Server only
 bool Robot::start()
 {
-   if(!getGame() || !runScript(!getGame()->isTestServer()))   // Load the script, execute the chunk to get it in memory, then run its main() function
+   if(!getGame())
       return false;
 
-   // Pass true so that if this bot doesn't have a TickEvent handler, we don't print a message
-   EventManager::get()->subscribe(this, EventManager::TickEvent, RobotContext, true);
+   string name;
+
+   if(mController)      // Native bots have no script; they hear every event, and get ticked by RobotManager
+   {
+      EventManager::get()->addNativeListener(this);
+
+      name = mController->getName();
+      if(name == "")
+         name = getNextName();
+   }
+   else
+   {
+      // Bots that think in parallel need Lua states of their own
+      if(getGame()->getSettings()->getSetting<U32>(IniKey::BotThinkThreads) > 0 && !hasOwnLuaState() && !createLuaState())
+         return false;
+
+      if(!runScript(!getGame()->isTestServer()))   // Load the script, execute the chunk to get it in memory, then run its main() function
+         return false;
+
+      // Pass true so that if this bot doesn't have a TickEvent handler, we don't print a message
+      EventManager::get()->subscribe(this, EventManager::TickEvent, RobotContext, true);
+
+      mSubscriptions[EventManager::TickEvent] = true;
 
-   mSubscriptions[EventManager::TickEvent] = true;
+      name = runGetName();                                                 // Run bot's getName function
+   }
 
-   string name = runGetName();                                          // Run bot's getName function
    mClientInfo->setName(getGame()->makeUnique(name.c_str()).c_str());   // Make sure name is unique
 
    mHasSpawned = true;
@@ -192,6 +248,8 @@ bool Robot::prepareEnvironment()
    if(!LuaScriptRunner::prepareEnvironment())
       return false;
 
+   lua_State *L = getLuaState();
+
    // Set this first so we have this object available in the helper functions in case we need overrides
    setSelf(L, this, "bot");
 
@@ -199,22 +257,11 @@ bool Robot::prepareEnvironment()
 }
 
 
-static string getNextName()
-{
-   static const string botNames[] = {
-      "Addison", "Alexis", "Amelia", "Audrey", "Chloe", "Claire", "Elizabeth", "Ella",
-      "Emily", "Emma", "Evelyn", "Gabriella", "Hailey", "Hannah", "Isabella", "Layla",
-      "Lillian", "Lucy", "Madison", "Natalie", "Olivia", "Riley", "Samantha", "Zoe"
-   };
-
-   static U8 nameIndex = 0;
-   return botNames[(nameIndex++) % ARRAYSIZE(botNames)];
-}
-
-
 // Run bot's getName function, return default name if fn isn't defined
 string Robot::runGetName()
 {
+   lua_State *L = getLuaState();
+
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
    // error will only be true if: 1) getName doesn't exist, which should never happen -- getName is stubbed out in robot_helper_functions.lua
@@ -285,8 +332,7 @@ void Robot::onAddedToGame(Game *game)
    {
       GameSettings *settings = game->getSettings();
 
-      string scriptName = settings->getSetting<string>(IniKey::DefaultRobotScript);
-      mScriptName = settings->getFolderManager()->findBotFile(scriptName);
+      setScript(settings->getSetting<string>(IniKey::DefaultRobotScript), settings->getFolderManager());
    }
 
    mLuaGame = game;
@@ -417,10 +463,16 @@ bool Robot::processArguments(const Vector<string> &args, Game *game, string &err
    else
       scriptName = game->getSettings()->getSetting<string>(IniKey::DefaultRobotScript);
 
+   // Collect our arguments to be passed into the args table in the robot (starting with the robot name)
+   // Need to make a copy or containerize argv[i] somehow, because otherwise new data will get written
+   // to the string location subsequently, and our vals will change from under us.  That's bad!
+   for(S32 i = 2; i < args.size(); i++)        // Does nothing if we have no args
+      mScriptArgs.push_back(args[i]);
+
    FolderManager *folderManager = game->getSettings()->getFolderManager();
 
    if(scriptName != "")
-      mScriptName = folderManager->findBotFile(scriptName);
+      setScript(scriptName, folderManager);
 
    if(mScriptName == "")     // Bot script could not be located
    {
@@ -428,12 +480,6 @@ bool Robot::processArguments(const Vector<string> &args, Game *game, string &err
       return false;
    }
 
-   // Collect our arguments to be passed into the args table in the robot (starting with the robot name)
-   // Need to make a copy or containerize argv[i] somehow, because otherwise new data will get written
-   // to the string location subsequently, and our vals will change from under us.  That's bad!
-   for(S32 i = 2; i < args.size(); i++)        // Does nothing if we have no args
-      mScriptArgs.push_back(args[i]);
-
    // I'm not sure this goes here, but it needs to be set early in setting up the Robot, but after
    // the constructor
    //
@@ -445,6 +491,25 @@ bool Robot::processArguments(const Vector<string> &args, Game *game, string &err
 }
 
 
+// Finds the bot file called for by scriptName, or, for names starting with "native:", makes the native bot; mScriptArgs
+// should already be set.  Leaves mScriptName empty, and returns false, if there's no such thing.
+bool Robot::setScript(const string &scriptName, FolderManager *folderManager)
+{
+   delete mController;
+   mController = NULL;
+
+   if(!BotController::isNativeName(scriptName))
+      mScriptName = folderManager->findBotFile(scriptName);
+   else
+   {
+      mController = BotController::create(scriptName, mScriptArgs);
+      mScriptName = mController ? scriptName : "";
+   }
+
+   return mScriptName != "";
+}
+
+
 // Returns zone ID of current zone
 S32 Robot::getCurrentZone()
 {
@@ -493,7 +558,7 @@ bool Robot::canSeePoint(Point point, bool wallOnly)
 
    Rect queryRect(thisPoints);
 
-   fillVector.clear();
+   FillVector fillVector;
    mGame->getLevel()->findObjects(wallOnly ? (TestFunc)isWallType : (TestFunc)isCollideableType, fillVector, queryRect);
 
    for(S32 i = 0; i < fillVector.size(); i++)
@@ -507,6 +572,14 @@ bool Robot::canSeePoint(Point point, bool wallOnly)
 }
 
 
+// Answers canSeePoint() for a batch of points, searching the database just once for all of them
+U64 Robot::canSeePoints(const Point *points, S32 count, bool wallOnly)
+{
+   return mVisibilityQuery.canSeePoints(mGame->getLevel(), wallOnly ? (TestFunc)isWallType : (TestFunc)isCollideableType,
+                                        getActualPos(), mRadius, points, count);
+}
+
+
 void Robot::renderLayer(S32 layerIndex)
 {
 #ifndef ZAP_DEDICATED
@@ -540,7 +613,10 @@ void Robot::idle(BfObject::IdleCallPath path)
 
       TNLAssert(deltaT != 0, "Time should never be zero!");    
 
-      tickTimer<Robot>(deltaT);
+      if(mHasThought)
+         mHasThought = false;
+      else if(!mController)            // Native bots have no timers
+         tickTimer<Robot>(deltaT);
 
       Parent::idle(BfObject::ServerProcessingUpdatesFromClient);   // Let's say the script is the client  ==> really not sure this is right
    }
@@ -562,6 +638,76 @@ void Robot::clearMove()
 }
 
 
+BotController *Robot::getController() const
+{
+   return mController;
+}
+
+
+// Gives our native bot its turn to think; the equivalent of onTick.  Dead bots have nothing to think about.
+void Robot::tickController(U32 deltaT)
+{
+   if(!mController || mHasExploded)
+      return;
+
+   WorldView view(this, deltaT);
+   Move move = getCurrentMove();
+
+   mController->onTick(view, move);
+
+   setCurrentMove(move);
+}
+
+
+// Called on the main thread, before think()
+void Robot::prepareToThink(U32 tickDeltaT)
+{
+   mThinkTickDeltaT = tickDeltaT;
+}
+
+
+// Does what the main loop would otherwise do for this bot this tick: delivers onTick, if it's time, and runs the timers.
+// The bot's Lua state is its own, so this can run on any thread; see RobotManager::think().
+void Robot::think()
+{
+   try
+   {
+      if(mThinkTickDeltaT > 0 && !isThrottled())
+         EventManager::get()->fireTickEvent(this, mThinkTickDeltaT);
+
+      mHasThought = !mHasExploded;
+
+      if(mHasThought)
+         tickTimer<Robot>(mCurrentMove.time);
+   }
+   catch(LuaException &e)
+   {
+      logError("Error thinking: %s", e.msg.c_str());
+   }
+}
+
+
+void Robot::sendChat(const string &message, bool global)
+{
+   GameType *gt = getGame()->getGameType();
+   if(!gt)
+      return;
+
+   gt->sendChat(mClientInfo->getName(), mClientInfo, message.c_str(), global, mClientInfo->getTeamIndex());
+
+   // Fire our event handler
+   EventManager::get()->fireEvent(this, EventManager::MsgReceivedEvent, message.c_str(), getPlayerInfo(), global);
+}
+
+
+void Robot::dropAllItems()
+{
+   S32 count = mMountedItems.size();
+   for(S32 i = count - 1; i >= 0; i--)
+      mMountedItems[i]->dismount(DISMOUNT_NORMAL);
+}
+
+
 // Overrides Ship method
 void Robot::onPositionChanged(GhostConnection *connection)
 {
@@ -590,7 +736,10 @@ const char *Robot::getScriptName()
 
 Robot *Robot::clone() const
 {
-   return new Robot(*this);
+   Robot *robot = new Robot(*this);
+   robot->mController = NULL;       // Editor copies never run, and the controller is the original's
+
+   return robot;
 }
 
 
@@ -641,156 +790,19 @@ U16 Robot::findClosestZone(const Point &point)
    return closestZone;
 }
 
-//// Lua methods
-
-//                Fn name               Param profiles                  Profile count                           
-#define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS,  setAngle,             ARRAYDEF({{ PT, END }, { NUM, END }}), 2 )           \
-   METHOD(CLASS,  getAnglePt,           ARRAYDEF({{ PT, END }              }), 1 )           \
-   METHOD(CLASS,  canSeePoint,          ARRAYDEF({{ PT, END }              }), 1 )           \
-                                                                                             \
-   METHOD(CLASS,  getWaypoint,          ARRAYDEF({{ PT, END }}), 1 )                         \
-                                                                                             \
-   METHOD(CLASS,  setThrust,            ARRAYDEF({{ NUM, NUM, END }, { NUM, PT, END}}), 2 )  \
-   METHOD(CLASS,  setThrustToPt,        ARRAYDEF({{ PT,       END }                 }), 1 )  \
-                                                                                             \
-   METHOD(CLASS,  fireWeapon,           ARRAYDEF({{ WEAP_ENUM, END }}), 1 )                  \
-   METHOD(CLASS,  hasWeapon,            ARRAYDEF({{ WEAP_ENUM, END }}), 1 )                  \
-                                                                                             \
-   METHOD(CLASS,  fireModule,           ARRAYDEF({{ MOD_ENUM, END }}), 1 )                   \
-   METHOD(CLASS,  hasModule,            ARRAYDEF({{ MOD_ENUM, END }}), 1 )                   \
-                                                                                             \
-   METHOD(CLASS,  setLoadoutWeapon,     ARRAYDEF({{ WEAP_SLOT, WEAP_ENUM, END }}), 1 )       \
-   METHOD(CLASS,  setLoadoutModule,     ARRAYDEF({{ MOD_SLOT,  MOD_ENUM,  END }}), 1 )       \
-                                                                                             \
-   METHOD(CLASS,  globalMsg,            ARRAYDEF({{ STR, END }}), 1 )                        \
-   METHOD(CLASS,  teamMsg,              ARRAYDEF({{ STR, END }}), 1 )                        \
-   METHOD(CLASS,  privateMsg,           ARRAYDEF({{ STR, STR, END }}), 1 )                   \
-                                                                                             \
-   METHOD(CLASS,  findVisibleObjects,   ARRAYDEF({{ TABLE, INTS, END }, { INTS, END }}), 2 ) \
-   METHOD(CLASS,  findClosestEnemy,     ARRAYDEF({{              END }, { NUM,  END }}), 2 ) \
-                                                                                             \
-   METHOD(CLASS,  getFiringSolution,    ARRAYDEF({{ BFOBJ, END }}), 1 )                      \
-   METHOD(CLASS,  getInterceptCourse,   ARRAYDEF({{ BFOBJ, END }}), 1 )                      \
-                                                                                             \
-   METHOD(CLASS,  engineerDeployObject, ARRAYDEF({{ INT,    END }}), 1 )                     \
-   METHOD(CLASS,  dropItem,             ARRAYDEF({{         END }}), 1 )                     \
-   METHOD(CLASS,  copyMoveFromObject,   ARRAYDEF({{ MOVOBJ, END }}), 1 )                     \
-
-
-GENERATE_LUA_METHODS_TABLE(Robot, LUA_METHODS);
-GENERATE_LUA_FUNARGS_TABLE(Robot, LUA_METHODS);
-
-#undef LUA_METHODS
-
-
-const char *Robot::luaClassName = "Robot";
-REGISTER_LUA_SUBCLASS(Robot, Ship);
-
-
-/**
- * @luafunc Robot::setAngle(num angle)
- *
- * @brief Sets the Robot's angle to `angle`
- *
- * @param angle The desired angle in radians
- */
-
-/**
- * @luafunc Robot::setAngle(point p)
- *
- * @brief Sets the Robot's angle to point towards `p`
- *
- * @param p The point to point at
- */
-S32 Robot::lua_setAngle(lua_State *L)
-{
-   S32 profile = checkArgList(L, functionArgs, "Robot", "setAngle");
-
-   Move move = getCurrentMove();
-
-   if(profile == 0)        // Args: PT    ==> Aim towards point
-   {
-      Point point = getPointOrXY(L, 1);
-      move.angle = getAnglePt(point);
-   }
-
-   else if(profile == 1)   // Args: NUM   ==> Aim at this angle (radians)
-      move.angle = getFloat(L, 1);
-
-   setCurrentMove(move);
-   return 0;
-}
-
-
-/**
- * @luafunc num Robot::getAnglePt(point p)
- *
- * @brief Gets the angle from the Robot to point `p`
- *
- * @return The angle in radians
- */
-S32 Robot::lua_getAnglePt(lua_State *L)
-{
-   checkArgList(L, functionArgs, "Robot", "getAnglePt");
-
-   Point point = getPointOrXY(L, 1);
-
-   return returnFloat(L, getAnglePt(point));
-}
-
-
-/**
- * @luafunc bool Robot::canSeePoint(point pt)
- * 
- * @brief Does this robot have line-of-sight to the given point.
- * 
- * @descr Line-of-sight a straight path from the robot to the object without any
- * stationary, collideable objects in the way
- * 
- * @param pt point to test
- * 
- * @return `true` if this bot can see the given point, `false` otherwise
- */
-S32 Robot::lua_canSeePoint(lua_State *L)
-{
-   checkArgList(L, functionArgs, "Robot", "canSeePoint");
-
-   Point point = getPointOrXY(L, 1);
-
-   return returnBool(L, canSeePoint(point));
-}
-
-
-/**
- * @luafunc point Robot::getWaypoint(point p)
- * 
- * @brief Get next waypoint to head toward in order to move to `p`
- * 
- * @descr Finds a path from the current position to `p` using the built-in
- * pathing utility. The algorithm will consider teleporters and tries to take
- * the shortest route to `p`.
- *
- * @param p The destination point
- * 
- * @return The next point to head towards, or `nil` if no path can be found
- */
 
-// Note that this function will be called frequently by various robots, so any
-// optimizations will be helpful.
-S32 Robot::lua_getWaypoint(lua_State *L)
+// Finds the next point to head for on the way to target; returns false if there's no way there.  Note that this function
+// will be called frequently by various robots, so any optimizations will be helpful.
+bool Robot::getWaypoint(const Point &target, Point &waypoint)
 {
    TNLAssert(getGame()->isServer(), "Not a ServerGame");
 
-   checkArgList(L, functionArgs, "Robot", "getWaypoint");
-
-   Point target = getPointOrXY(L, 1);
-
    // If we can see the target, go there directly
    if(canSeePoint(target, true))
    {
       flightPlan.clear();
-      return returnPoint(L, target);
+      waypoint = target;
+      return true;
    }
 
    // TODO: cache destination point; if it hasn't moved, then skip ahead.
@@ -802,7 +814,7 @@ S32 Robot::lua_getWaypoint(lua_State *L)
       targetZone = findClosestZone(target);
 
       if(targetZone == U16_MAX)
-         return returnNil(L);
+         return false;
    }
 
    // Make sure target is still in the same zone it was in when we created our flightplan.
@@ -817,27 +829,36 @@ S32 Robot::lua_getWaypoint(lua_State *L)
       // arranged so the closest points are at the end of the list, and the target is at index 0.
       Point dest;
       bool found = false;
-//      bool first = true;
 
+      // We'll assume that if we could see the point on the previous turn, we can
+      // still see it, even though in some cases, the turning of the ship around a
+      // protruding corner may make it technically not visible.  This will prevent
+      // rapidfire recalcuation of the path when it's not really necessary.
+
+      // Check the waypoints a batch at a time, from the end of the list.  We discard each one we can see, stopping at the
+      // first one we can't, just as if we'd checked them one by one.
       while(flightPlan.size() > 0)
       {
-         Point last = flightPlan.last();
+         S32 count = min(flightPlan.size(), VisibilityQuery::MaxTargets);
 
-         // We'll assume that if we could see the point on the previous turn, we can
-         // still see it, even though in some cases, the turning of the ship around a
-         // protruding corner may make it technically not visible.  This will prevent
-         // rapidfire recalcuation of the path when it's not really necessary.
+         Point batch[VisibilityQuery::MaxTargets];
+         for(S32 i = 0; i < count; i++)
+            batch[i] = flightPlan[flightPlan.size() - 1 - i];
 
-         // removed if(first) ... Problems with Robot get stuck after pushed from burst or mines.
-         // To save calculations, might want to avoid (canSeePoint(last))
-         if(canSeePoint(last, true))
-         {
-            dest = last;
-            found = true;
-//            first = false;
-            flightPlan.pop_back();   // Discard now possibly superfluous waypoint
-         }
-         else
+         U64 visible = canSeePoints(batch, count, true);
+
+         S32 seen = 0;
+         while(seen < count && ((visible >> seen) & 1))
+            seen++;
+
+         if(seen == 0)
+            break;
+
+         dest = batch[seen - 1];
+         found = true;
+         flightPlan.resize(flightPlan.size() - seen);    // Discard now possibly superfluous waypoints
+
+         if(seen < count)
             break;
       }
 
@@ -845,7 +866,8 @@ S32 Robot::lua_getWaypoint(lua_State *L)
       if(found)
       {
          flightPlan.push_back(dest);    // Put dest back at the end of the flightplan
-         return returnPoint(L, dest);
+         waypoint = dest;
+         return true;
       }
    }
 
@@ -858,97 +880,78 @@ S32 Robot::lua_getWaypoint(lua_State *L)
       currentZone = findClosestZone(getActualPos());
 
    if(currentZone == U16_MAX)      // That didn't go so well...
-      return returnNil(L);
+      return false;
 
    // We're in, or on the cusp of, the zone containing our target.  We're close!!
    if(currentZone == targetZone)
    {
-      Point p;
       flightPlan.push_back(target);
 
       if(!canSeePoint(target, true))           // Possible, if we're just on a boundary, and a protrusion's blocking a ship edge
       {
          BotNavMeshZone *zone = static_cast<BotNavMeshZone *>(getGame()->getBotZoneDatabase().getObjectByIndex(targetZone));
 
-         p = zone->getCenter();
-         flightPlan.push_back(p);
+         waypoint = zone->getCenter();
+         flightPlan.push_back(waypoint);
       }
       else
-         p = target;
+         waypoint = target;
 
-      return returnPoint(L, p);
+      return true;
    }
 
    // If we're still here, then we need to find a new path.  Either our original path was invalid for some reason,
    // or the path we had no longer applied to our current location
    flightPlanTo = targetZone;
 
-   // check cache for path first
-   pair<S32,S32> pathIndex = pair<S32,S32>(currentZone, targetZone);
+   // Routes are worked out ahead of time, so this is just a matter of following them
+   BotNavRouteTable *routeTable = static_cast<ServerGame *>(getGame())->getBotRouteTable();
 
-   const Vector<BotNavMeshZone *> &zones = static_cast<ServerGame *>(getGame())->getBotZoneList();  // Our pre-cached list of nav zones
+   if(routeTable)
+      flightPlan = routeTable->findPath(currentZone, targetZone, target);
 
-   if(getGame()->getGameType()->cachedBotFlightPlans.find(pathIndex) == getGame()->getGameType()->cachedBotFlightPlans.end())
-   {
-      // Not found so calculate flight plan
-      flightPlan = AStar::findPath(&zones, currentZone, targetZone, target);
+   if(flightPlan.size() == 0)
+      return false;     // Out of options, end of the road
 
-      // Add to cache
-      getGame()->getGameType()->cachedBotFlightPlans[pathIndex] = flightPlan;
-   }
-   else
-      flightPlan = getGame()->getGameType()->cachedBotFlightPlans[pathIndex];
+   waypoint = flightPlan.last();
+   return true;
+}
 
-   if(flightPlan.size() > 0)
-      return returnPoint(L, flightPlan.last());
-   else
-      return returnNil(L);    // Out of options, end of the road
+// Closest enemy ship or robot within scanner range, taking into account whether we have the Sensor module
+Ship *Robot::findClosestEnemy()
+{
+   Point pos = getActualPos();
+   Rect queryRect(pos, pos);
+   queryRect.expand(getGame()->computePlayerVisArea(this));
+
+   return findClosestEnemyIn(&queryRect);
 }
 
 
-/**
- * @luafunc Ship Robot::findClosestEnemy(num range)
- * 
- * @brief Finds the closest enemy ship or robot that is within the specified
- * distance.
- * 
- * @descr Finds closest enemy within specified distance of the bot. If dist is
- * omitted, this will use standard scanner range, taking into account whether
- * the bot has the Sensor module. To search the entire map, specify -1 for the
- * range.
- * 
- * @param range (Optional) Radius in which to search. Use -1 to search entire
- * map. If omitted, will use normal scanner range.
- * 
- * @return Ship object representing closest enemy, or nil if none were found.
- */
-S32 Robot::lua_findClosestEnemy(lua_State *L)
+// Closest enemy within range; a range of -1 searches the whole map
+Ship *Robot::findClosestEnemy(F32 range)
 {
-   S32 profile = checkArgList(L, functionArgs, "Robot", "findClosestEnemy");
+   if(range == -1)
+      return findClosestEnemyIn(NULL);
 
    Point pos = getActualPos();
    Rect queryRect(pos, pos);
-   bool useRange = true;
+   queryRect.expand(Point(range, range));
 
-   if(profile == 0)           // Args: None
-      queryRect.expand(getGame()->computePlayerVisArea(this));  
-   else                       // Args: Range
-   {
-      F32 range = getFloat(L, 1);
-      if(range == -1)
-         useRange = false;
-        else
-         queryRect.expand(Point(range, range));
-   }
+   return findClosestEnemyIn(&queryRect);
+}
 
 
+// Closest visible, living enemy in queryRect, or anywhere if queryRect is NULL
+Ship *Robot::findClosestEnemyIn(const Rect *queryRect)
+{
    F32 minDist = F32_MAX;
    Ship *closest = NULL;
 
-   fillVector.clear();
+   FillVector fillVector;
 
-   if(useRange)
-      getGame()->getLevel()->findObjects((TestFunc)isShipType, fillVector, queryRect);   
+   if(queryRect)
+      getGame()->getLevel()->findObjects((TestFunc)isShipType, fillVector, *queryRect);   
    else
       getGame()->getLevel()->findObjects((TestFunc)isShipType, fillVector);   
 
@@ -975,7 +978,284 @@ S32 Robot::lua_findClosestEnemy(lua_State *L)
       }
    }
 
-   return returnShip(L, closest);    // Handles closest == NULL
+   return closest;
+}
+
+
+// Finds objects of the given types within the bot's area of vision.  Leaves out the bot itself, and any ships that are
+// dead, or cloaked (unless we have the Sensor module).  BotNavMeshZones can be asked for along with everything else.
+void Robot::findVisibleObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector)
+{
+   Point pos = getActualPos();
+   Rect queryRect(pos, pos);
+   queryRect.expand(getGame()->computePlayerVisArea(this));
+
+   // Zones live in a database of their own
+   if(types.contains(BotNavMeshZoneTypeNumber))
+      getGame()->getBotZoneDatabase().findObjects(BotNavMeshZoneTypeNumber, fillVector, queryRect);
+
+   // Get other objects on screen-visible area only
+   getGame()->getLevel()->findObjects(types, fillVector, queryRect);
+
+   bool hasSensor = hasModule(ModuleSensor);
+   S32 kept = 0;
+
+   for(S32 i = 0; i < fillVector.size(); i++)
+   {
+      if(isShipType(fillVector[i]->getObjectTypeNumber()))
+      {
+         if(fillVector[i] == this)  // Don't add this bot to the list of found objects!
+            continue;
+
+         // Ignore ship/robot if it's dead or cloaked (unless bot has sensor)
+         Ship *ship = static_cast<Ship *>(fillVector[i]);
+         if(!ship->isVisible(hasSensor) || ship->mHasExploded)
+            continue;
+      }
+
+      fillVector[kept] = fillVector[i];
+      kept++;
+   }
+
+   fillVector.resize(kept);
+}
+
+
+// Selects weapon, if we have it on board; returns false if we don't
+bool Robot::readyWeapon(WeaponType weapon)
+{
+   for(S32 i = 0; i < ShipWeaponCount; i++)
+      if(mLoadout.getWeapon(i) == weapon)
+      {
+         selectWeapon(i);
+         return true;
+      }
+
+   return false;
+}
+
+
+// Returns the slot module is in, or NONE if it isn't equipped
+S32 Robot::findModuleSlot(ShipModule module) const
+{
+   for(S32 i = 0; i < ShipModuleCount; i++)
+      if(getModule(i) == module)
+         return i;
+
+   return NONE;
+}
+
+
+//// Lua methods
+
+//                Fn name               Param profiles                  Profile count                           
+#define LUA_METHODS(CLASS, METHOD) \
+   METHOD(CLASS,  setAngle,             ARRAYDEF({{ PT, END }, { NUM, END }}), 2, ReadsWorld   )           \
+   METHOD(CLASS,  getAnglePt,           ARRAYDEF({{ PT, END }              }), 1, ReadsWorld   )           \
+   METHOD(CLASS,  canSeePoint,          ARRAYDEF({{ PT, END }              }), 1, ReadsWorld   )           \
+   METHOD(CLASS,  canSeePoints,         ARRAYDEF({{ TABLE, END }           }), 1, ReadsWorld   )           \
+                                                                                                           \
+   METHOD(CLASS,  getWaypoint,          ARRAYDEF({{ PT, END }}), 1, ReadsWorld   )                         \
+                                                                                                           \
+   METHOD(CLASS,  setThrust,            ARRAYDEF({{ NUM, NUM, END }, { NUM, PT, END}}), 2, ReadsWorld   )  \
+   METHOD(CLASS,  setThrustToPt,        ARRAYDEF({{ PT,       END }                 }), 1, ReadsWorld   )  \
+                                                                                                           \
+   METHOD(CLASS,  fireWeapon,           ARRAYDEF({{ WEAP_ENUM, END }}), 1, ChangesWorld )                  \
+   METHOD(CLASS,  hasWeapon,            ARRAYDEF({{ WEAP_ENUM, END }}), 1, ReadsWorld   )                  \
+                                                                                                           \
+   METHOD(CLASS,  fireModule,           ARRAYDEF({{ MOD_ENUM, END }}), 1, ReadsWorld   )                   \
+   METHOD(CLASS,  hasModule,            ARRAYDEF({{ MOD_ENUM, END }}), 1, ReadsWorld   )                   \
+                                                                                                           \
+   METHOD(CLASS,  setLoadoutWeapon,     ARRAYDEF({{ WEAP_SLOT, WEAP_ENUM, END }}), 1, ChangesWorld )       \
+   METHOD(CLASS,  setLoadoutModule,     ARRAYDEF({{ MOD_SLOT,  MOD_ENUM,  END }}), 1, ChangesWorld )       \
+                                                                                                           \
+   METHOD(CLASS,  globalMsg,            ARRAYDEF({{ STR, END }}), 1, ChangesWorld )                        \
+   METHOD(CLASS,  teamMsg,              ARRAYDEF({{ STR, END }}), 1, ChangesWorld )                        \
+   METHOD(CLASS,  privateMsg,           ARRAYDEF({{ STR, STR, END }}), 1, ChangesWorld )                   \
+                                                                                                           \
+   METHOD(CLASS,  findVisibleObjects,   ARRAYDEF({{ TABLE, INTS, END }, { INTS, END }}), 2, ReadsWorld   ) \
+   METHOD(CLASS,  findClosestEnemy,     ARRAYDEF({{              END }, { NUM,  END }}), 2, ReadsWorld   ) \
+                                                                                                           \
+   METHOD(CLASS,  getFiringSolution,    ARRAYDEF({{ BFOBJ, END }}), 1, ReadsWorld   )                      \
+   METHOD(CLASS,  getInterceptCourse,   ARRAYDEF({{ BFOBJ, END }}), 1, ReadsWorld   )                      \
+                                                                                                           \
+   METHOD(CLASS,  engineerDeployObject, ARRAYDEF({{ INT,    END }}), 1, ChangesWorld )                     \
+   METHOD(CLASS,  dropItem,             ARRAYDEF({{         END }}), 1, ChangesWorld )                     \
+   METHOD(CLASS,  copyMoveFromObject,   ARRAYDEF({{ MOVOBJ, END }}), 1, ReadsWorld   )                     \
+
+
+GENERATE_LUA_METHODS_TABLE(Robot, LUA_METHODS);
+GENERATE_LUA_FUNARGS_TABLE(Robot, LUA_METHODS);
+
+#undef LUA_METHODS
+
+
+const char *Robot::luaClassName = "Robot";
+REGISTER_LUA_SUBCLASS(Robot, Ship);
+
+
+/**
+ * @luafunc Robot::setAngle(num angle)
+ *
+ * @brief Sets the Robot's angle to `angle`
+ *
+ * @param angle The desired angle in radians
+ */
+
+/**
+ * @luafunc Robot::setAngle(point p)
+ *
+ * @brief Sets the Robot's angle to point towards `p`
+ *
+ * @param p The point to point at
+ */
+S32 Robot::lua_setAngle(lua_State *L)
+{
+   S32 profile = checkArgList(L, functionArgs, "Robot", "setAngle");
+
+   Move move = getCurrentMove();
+
+   if(profile == 0)        // Args: PT    ==> Aim towards point
+   {
+      Point point = getPointOrXY(L, 1);
+      move.angle = getAnglePt(point);
+   }
+
+   else if(profile == 1)   // Args: NUM   ==> Aim at this angle (radians)
+      move.angle = getFloat(L, 1);
+
+   setCurrentMove(move);
+   return 0;
+}
+
+
+/**
+ * @luafunc num Robot::getAnglePt(point p)
+ *
+ * @brief Gets the angle from the Robot to point `p`
+ *
+ * @return The angle in radians
+ */
+S32 Robot::lua_getAnglePt(lua_State *L)
+{
+   checkArgList(L, functionArgs, "Robot", "getAnglePt");
+
+   Point point = getPointOrXY(L, 1);
+
+   return returnFloat(L, getAnglePt(point));
+}
+
+
+/**
+ * @luafunc bool Robot::canSeePoint(point pt)
+ * 
+ * @brief Does this robot have line-of-sight to the given point.
+ * 
+ * @descr Line-of-sight a straight path from the robot to the object without any
+ * stationary, collideable objects in the way
+ * 
+ * @param pt point to test
+ * 
+ * @return `true` if this bot can see the given point, `false` otherwise
+ */
+S32 Robot::lua_canSeePoint(lua_State *L)
+{
+   checkArgList(L, functionArgs, "Robot", "canSeePoint");
+
+   Point point = getPointOrXY(L, 1);
+
+   return returnBool(L, canSeePoint(point));
+}
+
+
+/**
+ * @luafunc table Robot::canSeePoints(table points)
+ * 
+ * @brief Does this robot have line-of-sight to each of the given points.
+ * 
+ * @descr Gives the same answers as calling canSeePoint() on each point, but
+ * is much quicker when there are several points to check.
+ * 
+ * @param points table of points to test
+ * 
+ * @return A table with a boolean for each point, in the same order; `true` if
+ * this bot can see the point, `false` otherwise
+ */
+S32 Robot::lua_canSeePoints(lua_State *L)
+{
+   checkArgList(L, functionArgs, "Robot", "canSeePoints");
+
+   Vector<Point> points = getPointsOrXYs(L, 1);
+   clearStack(L);
+
+   lua_createtable(L, points.size(), 0);                             // -- table
+
+   for(S32 i = 0; i < points.size(); i += VisibilityQuery::MaxTargets)
+   {
+      S32 count = min(points.size() - i, VisibilityQuery::MaxTargets);
+      U64 visible = canSeePoints(points.address() + i, count);
+
+      for(S32 j = 0; j < count; j++)
+      {
+         lua_pushboolean(L, (visible >> j) & 1);                      // -- table, bool
+         lua_rawseti(L, 1, i + j + 1);                                // -- table
+      }
+   }
+
+   return 1;
+}
+
+
+/**
+ * @luafunc point Robot::getWaypoint(point p)
+ * 
+ * @brief Get next waypoint to head toward in order to move to `p`
+ * 
+ * @descr Finds a path from the current position to `p` using the built-in
+ * pathing utility. The algorithm will consider teleporters and tries to take
+ * the shortest route to `p`.
+ *
+ * @param p The destination point
+ * 
+ * @return The next point to head towards, or `nil` if no path can be found
+ */
+S32 Robot::lua_getWaypoint(lua_State *L)
+{
+   checkArgList(L, functionArgs, "Robot", "getWaypoint");
+
+   Point waypoint;
+
+   if(getWaypoint(getPointOrXY(L, 1), waypoint))
+      return returnPoint(L, waypoint);
+
+   return returnNil(L);
+}
+
+
+/**
+ * @luafunc Ship Robot::findClosestEnemy(num range)
+ * 
+ * @brief Finds the closest enemy ship or robot that is within the specified
+ * distance.
+ * 
+ * @descr Finds closest enemy within specified distance of the bot. If dist is
+ * omitted, this will use standard scanner range, taking into account whether
+ * the bot has the Sensor module. To search the entire map, specify -1 for the
+ * range.
+ * 
+ * @param range (Optional) Radius in which to search. Use -1 to search entire
+ * map. If omitted, will use normal scanner range.
+ * 
+ * @return Ship object representing closest enemy, or nil if none were found.
+ */
+S32 Robot::lua_findClosestEnemy(lua_State *L)
+{
+   S32 profile = checkArgList(L, functionArgs, "Robot", "findClosestEnemy");
+
+   if(profile == 0)           // Args: None
+      return returnShip(L, findClosestEnemy());    // Handles closest == NULL
+   else                       // Args: Range
+      return returnShip(L, findClosestEnemy(getFloat(L, 1)));
 }
 
 
@@ -1069,19 +1349,9 @@ S32 Robot::lua_fireWeapon(lua_State *L)
    checkArgList(L, functionArgs, luaClassName, "fireWeapon");
 
    WeaponType weapon = getWeaponType(L, 1);
-   bool hasWeapon = false;
-
-   // Check the weapons we have on board -- if any match the requested weapon, select it
-   for(S32 i = 0; i < ShipWeaponCount; i++)
-      if(mLoadout.getWeapon(i) == weapon)
-      {
-         hasWeapon = true;
-         selectWeapon(i);
-         break;
-      }
 
    // If weapon was equipped, fire!
-   if(hasWeapon)
+   if(readyWeapon(weapon))
    {
       Move move = getCurrentMove();
       move.fire = true;
@@ -1127,20 +1397,12 @@ S32 Robot::lua_fireModule(lua_State *L)
 {
    checkArgList(L, functionArgs, "Robot", "fireModule");
 
-   ShipModule module = getShipModule(L, 1);
-
-   bool hasModule = false;
+   S32 slot = findModuleSlot(getShipModule(L, 1));
 
    // Check if module is equipped and fire it
-   for(S32 i = 0; i < ShipModuleCount; i++)
-      if(getModule(i) == module)
-      {
-         hasModule = true;
-         mCurrentMove.modulePrimary[i] = true;
-         break;
-      }
-
-   if(!hasModule)
+   if(slot != NONE)
+      mCurrentMove.modulePrimary[slot] = true;
+   else
       THROW_LUA_EXCEPTION(L, "The module given to bot:fireModule(module) is not equipped!");
 
    return 0;
@@ -1238,19 +1500,12 @@ S32 Robot::lua_globalMsg(lua_State *L)
 {
    checkArgList(L, functionArgs, luaClassName, "globalMsg");
 
-   const char *message = getString(L, 1);
+   string message = getString(L, 1);
 
-   GameType *gt = getGame()->getGameType();
-   if(gt)
-   {
-      gt->sendChat(mClientInfo->getName(), mClientInfo, message, true, mClientInfo->getTeamIndex());
+   // Clean up before firing event
+   lua_pop(L, 1);
 
-      // Clean up before firing event
-      lua_pop(L, 1);
-
-      // Fire our event handler
-      EventManager::get()->fireEvent(this, EventManager::MsgReceivedEvent, message, getPlayerInfo(), true);
-   }
+   sendChat(message, true);
 
    return 0;
 }
@@ -1268,19 +1523,12 @@ S32 Robot::lua_teamMsg(lua_State *L)
 {
    checkArgList(L, functionArgs, luaClassName, "teamMsg");
 
-   const char *message = getString(L, 1);
-
-   GameType *gt = getGame()->getGameType();
-   if(gt)
-   {
-      gt->sendChat(mClientInfo->getName(), mClientInfo, message, false, mClientInfo->getTeamIndex());
+   string message = getString(L, 1);
 
-      // Clean up before firing event
-      lua_pop(L, 1);
+   // Clean up before firing event
+   lua_pop(L, 1);
 
-      // Fire our event handler
-      EventManager::get()->fireEvent(this, EventManager::MsgReceivedEvent, message, getPlayerInfo(), false);
-   }
+   sendChat(message, false);
 
    return 0;
 }
@@ -1321,6 +1569,10 @@ S32 Robot::lua_privateMsg(lua_State *L)
  * 
  * Can specify multiple types.
  * 
+ * To save making a new table on every call, a table can be passed in as the
+ * first argument; it will be filled with the results and returned.  Anything
+ * already in the table is replaced.
+ * 
  * @param types One or more \ref ObjTypeEnum specifying what types of objects to
  * find.
  * 
@@ -1338,78 +1590,34 @@ S32 Robot::lua_findVisibleObjects(lua_State *L)
 {
    checkArgList(L, functionArgs, "Robot", "findVisibleObjects");
 
-   Point pos = getActualPos();
-   Rect queryRect(pos, pos);
-   queryRect.expand(getGame()->computePlayerVisArea(this));
-
-   fillVector.clear();
-   static Vector<U8> types;
+   FillVector fillVector;
+   static thread_local Vector<U8> types;      // Bots may be thinking on several threads at once
 
    types.clear();
 
    // We expect the stack to look like this: -- objType1, objType2, ...
-   // or this, if using the deprecated fill table option -- [fillTable], objType1, objType2, ...
+   // or this, if using the fill table option -- [fillTable], objType1, objType2, ...
    // We'll work our way down from the top of the stack (element -1) until we find something that is not a number.
    // We expect that when we find something that is not a number, the stack will only contain our fillTable.  If the stack
    // is empty at that point, we'll add a table.
    while(lua_gettop(L) > 0 && lua_isnumber(L, -1))
    {
-      U8 typenum = (U8)lua_tointeger(L, -1);
-
-      // Requests for botzones have to be handled separately; not a problem, we'll just do the search here, and add them to
-      // fillVector, where they'll be merged with the rest of our search results.
-      if(typenum != BotNavMeshZoneTypeNumber)
-         types.push_back(typenum);
-      else
-         getGame()->getBotZoneDatabase().findObjects(BotNavMeshZoneTypeNumber, fillVector, queryRect);
-
+      types.push_back((U8)lua_tointeger(L, -1));
       lua_pop(L, 1);
    }
 
-   // Get other objects on screen-visible area only
-   getGame()->getLevel()->findObjects(types, fillVector, queryRect);
-
-
-   // We are expecting a table to be on top of the stack when we get here.  If not, we can add one.
-   if(!lua_istable(L, -1))
-   {
-      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack not cleared!");
-
-      // Create a table, cannot pre-allocate because of filtering objects from
-      // the database
-      lua_newtable(L);
-   }
-   else
-      logprintf(LogConsumer::LuaBotMessage, "Usage of a fill table with findVisibleObjects() "
-            "is deprecated and will be removed in the future.  Instead, don't use one");
-
-   TNLAssert((lua_gettop(L) == 1 && lua_istable(L, -1)) || dumpStack(L), "Should only have table!");
+   findVisibleObjects(types, fillVector);
 
-
-   S32 pushed = 0;      // Count of items we put into our table
+   // If there's no table for the results on the stack, this will add one
+   prepareResultTable(L, fillVector.size());
 
    for(S32 i = 0; i < fillVector.size(); i++)
    {
-      if(isShipType(fillVector[i]->getObjectTypeNumber()))
-      {
-         if(fillVector[i] == this)  // Don't add this bot to the list of found objects!
-            continue;
-
-         // Ignore ship/robot if it's dead or cloaked (unless bot has sensor)
-         Ship *ship = static_cast<Ship *>(fillVector[i]);
-         bool callerHasSensor = this->hasModule(ModuleSensor);
-         if(!ship->isVisible(callerHasSensor) || ship->mHasExploded)
-            continue;
-      }
-
       static_cast<BfObject *>(fillVector[i])->push(L);
-      pushed++;      // Increment pushed before using it because Lua uses 1-based arrays
-      lua_rawseti(L, 1, pushed);
+      lua_rawseti(L, 1, i + 1);
    }
 
-   TNLAssert(lua_gettop(L) == 1 || dumpStack(L), "Stack has unexpected items on it!");
-
-   return 1;
+   return returnResultTable(L, fillVector.size());
 }
 
 
@@ -1477,6 +1685,17 @@ static bool calcInterceptCourse(BfObject *target, Point aimPos, F32 aimRadius, S
 }
 
 
+// Angle to fire at to hit target with our current weapon; returns false if there's no way to hit it.  Will happily
+// fire at teammates.
+bool Robot::getFiringSolution(BfObject *target, F32 &angle)
+{
+   WeaponInfo weap = WeaponInfo::getWeaponInfo(mLoadout.getActiveWeapon());    // Robot's active weapon
+
+   return calcInterceptCourse(target, getActualPos(), getRadius(), getTeam(), (F32)weap.projVelocity, 
+                              (F32)weap.projLiveTime, false, hasModule(ModuleSensor), angle);
+}
+
+
 /**
  * @luafunc num Robot::getFiringSolution(BfObject obj)
  *
@@ -1495,12 +1714,9 @@ S32 Robot::lua_getFiringSolution(lua_State *L)
 
    BfObject *target = luaW_check<BfObject>(L, 1);
 
-   WeaponInfo weap = WeaponInfo::getWeaponInfo(mLoadout.getActiveWeapon());    // Robot's active weapon
-
    F32 interceptAngle;
 
-   if(calcInterceptCourse(target, getActualPos(), getRadius(), getTeam(), (F32)weap.projVelocity, 
-                          (F32)weap.projLiveTime, false, hasModule(ModuleSensor), interceptAngle))
+   if(getFiringSolution(target, interceptAngle))
       return returnFloat(L, interceptAngle);
 
    return returnNil(L);
@@ -1559,9 +1775,7 @@ S32 Robot::lua_dropItem(lua_State *L)
 {
    checkArgList(L, functionArgs, "Robot", "dropItem");
 
-   S32 count = mMountedItems.size();
-   for(S32 i = count - 1; i >= 0; i--)
-      mMountedItems[i]->dismount(DISMOUNT_NORMAL);
+   dropAllItems();
 
    return 0;
 }
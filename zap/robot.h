@@ -7,10 +7,13 @@
 #define _ROBOT_H_
 
 #include "ship.h"             // Parent class
+#include "VisibilityQuery.h"
 
 namespace Zap
 {
 
+class BotController;
+class FolderManager;
 class MoveItem;
 class ServerGame;
 
@@ -33,6 +36,19 @@ private:
 
    bool mHasSpawned;
 
+   U32 mThinkTickDeltaT;            // Time to pass to onTick during the next think(), or 0 to skip it
+   bool mHasThought;                // think() already ran our timers this tick, so idle() shouldn't
+
+   VisibilityQuery mVisibilityQuery;
+
+   BotController *mController;      // Native bot driving this one instead of a script, or NULL; we own it
+
+   bool setScript(const string &scriptName, FolderManager *folderManager);   // Script file or native bot
+   Ship *findClosestEnemyIn(const Rect *queryRect);
+
+   void sendChat(const string &message, bool global);
+   void dropAllItems();
+
    Point getNextWaypoint();                          // Helper function for getWaypoint()
    U16 findClosestZone(const Point &point);          // Finds zone closest to point, used when robots get off the map
 
@@ -60,6 +76,7 @@ public:
    S32 getCurrentZone();
    void setCurrentZone(S32 zone);
    bool canSeePoint(Point point, bool wallOnly = false);         // Is point within robot's LOS?
+   U64 canSeePoints(const Point *points, S32 count, bool wallOnly = false);   // Same, for up to 64 points; bit i is points[i]
 
    Vector<Point> flightPlan;           // List of points to get from one point to another
    U16 flightPlanTo;                   // Zone our flightplan was calculated to
@@ -67,10 +84,20 @@ public:
    // Some informational functions
    F32 getAnglePt(Point point);
 
+   // The C++ side of the bot API, shared by scripts and native bots
+   bool getWaypoint(const Point &target, Point &waypoint);
+   Ship *findClosestEnemy();                 // Within scanner range
+   Ship *findClosestEnemy(F32 range);        // -1 means anywhere
+   void findVisibleObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector);
+   bool getFiringSolution(BfObject *target, F32 &angle);
+   bool readyWeapon(WeaponType weapon);      // Select weapon; false if we don't have it
+   S32 findModuleSlot(ShipModule module) const;
+
    void onPositionChanged(GhostConnection *connection);
    void onChangedClientTeam();
 
    const char *getErrorMessagePrefix();
+   string getScriptDescription();
 
    LuaPlayerInfo *getPlayerInfo();
    bool start();
@@ -80,6 +107,12 @@ public:
 
    void clearMove();                   // Reset bot's move to do nothing
 
+   BotController *getController() const;
+   void tickController(U32 deltaT);    // onTick for native bots; main thread only
+
+   void prepareToThink(U32 tickDeltaT);
+   void think();                       // Run the bot's Lua for this tick; may be called on any thread
+
 
    const char *getScriptName();
 
@@ -98,6 +131,7 @@ public:
    S32 lua_setAngle(lua_State *L);
    S32 lua_getAnglePt(lua_State *L);
    S32 lua_canSeePoint(lua_State *L);
+   S32 lua_canSeePoints(lua_State *L);
 
    // Navigation
    S32 lua_getWaypoint(lua_State *L);
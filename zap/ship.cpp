@@ -354,7 +354,8 @@ F32 Ship::processMove(U32 stateIndex)
 // If ship is in multiple zones, an aribtrary one will be returned, and the level designer will be flogged.
 BfObject *Ship::isInAnyZone() const
 {
-   findObjectsUnderShip((TestFunc)isZoneType);  // Clears and fills fillVector
+   FillVector fillVector;
+   findObjectsUnderShip((TestFunc)isZoneType, fillVector);
    return doIsInZone(fillVector);
 }
 
@@ -363,7 +364,8 @@ BfObject *Ship::isInAnyZone() const
 // If ship is in multiple zones of type zoneTypeNumber, an aribtrary one will be returned, and the level designer will be flogged.
 BfObject *Ship::isInZone(U8 zoneTypeNumber) const
 {
-   findObjectsUnderShip(zoneTypeNumber);        // Clears and fills fillVector
+   FillVector fillVector;
+   findObjectsUnderShip(zoneTypeNumber, fillVector);
    return doIsInZone(fillVector);
 }
 
@@ -372,12 +374,13 @@ BfObject *Ship::isInZone(U8 zoneTypeNumber) const
 // If ship is in multiple zones of type zoneTypeNumber, an aribtrary one will be returned, and the level designer will be flogged.
 BfObject *Ship::isInZone(U8 zoneTypeNumber, S32 teamIndex) const
 {
-   findObjectsUnderShip(zoneTypeNumber);        // Clears and fills fillVector
+   FillVector fillVector;
+   findObjectsUnderShip(zoneTypeNumber, fillVector);
    return doIsInZone(fillVector, teamIndex);
 }
 
 
-// Private helper for isInZone() and isInAnyZone() -- these fill fillVector, and we operate on it below
+// Private helper for isInZone() and isInAnyZone() -- these find candidate zones, and we operate on them below
 // Note: teamIndex defaults to NO_TEAM
 BfObject *Ship::doIsInZone(const Vector<DatabaseObject *> &objects, S32 teamIndex) const
 {
@@ -408,7 +411,8 @@ BfObject *Ship::doIsInZone(const Vector<DatabaseObject *> &objects, S32 teamInde
 // Returns the object in question if this ship is on an object of type objectType
 DatabaseObject *Ship::isOnObject(U8 objectType, U32 stateIndex)
 {
-   findObjectsUnderShip(objectType);
+   FillVector fillVector;
+   findObjectsUnderShip(objectType, fillVector);
 
    if(fillVector.size() == 0)  // Ship isn't in extent of any objectType objects, can bail here
       return NULL;
@@ -712,8 +716,6 @@ bool Ship::checkForSpeedzones(U32 stateIndex)
 }
 
 
-static Vector<DatabaseObject *> foundObjects;      // Reusable container
-
 void Ship::findRepairTargets()
 {
    // We use the render position in findRepairTargets so that
@@ -724,7 +726,7 @@ void Ship::findRepairTargets()
    Point pos = getRenderPos();
    Rect r(pos, (RepairRadius + CollisionRadius));
    
-   foundObjects.clear();
+   FillVector foundObjects;
    findObjects((TestFunc)isWithHealthType, foundObjects, r);   // All isWithHealthType objects are items
 
    for(S32 i = 0; i < foundObjects.size(); i++)
@@ -2369,23 +2371,23 @@ void Ship::removeMountedItem(MountableItem *item)
 
 //               Fn name           Param profiles  Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, isAlive,         ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getPlayerInfo,   ARRAYDEF({{ END }}), 1 ) \
+   METHOD(CLASS, isAlive,         ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getPlayerInfo,   ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
                                                            \
-   METHOD(CLASS, isModActive,     ARRAYDEF({{ MOD_ENUM, END }}), 1 ) \
-   METHOD(CLASS, getEnergy,       ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, setEnergy,       ARRAYDEF({{ NUM, END }}), 1 ) \
-   METHOD(CLASS, getHealth,       ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, setHealth,       ARRAYDEF({{ NUM, END }}), 1 ) \
-   METHOD(CLASS, hasFlag,         ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getFlagCount,    ARRAYDEF({{ END }}), 1 ) \
+   METHOD(CLASS, isModActive,     ARRAYDEF({{ MOD_ENUM, END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getEnergy,       ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setEnergy,       ARRAYDEF({{ NUM, END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, getHealth,       ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setHealth,       ARRAYDEF({{ NUM, END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, hasFlag,         ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getFlagCount,    ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
                                                            \
-   METHOD(CLASS, getAngle,        ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getActiveWeapon, ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getMountedItems, ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, getLoadout,      ARRAYDEF({{ END }}), 1 ) \
-   METHOD(CLASS, setLoadout,      ARRAYDEF({{ TABLE, END }, { INT, INT, INT, INT, INT, END }}), 2 ) \
-   METHOD(CLASS, setLoadoutNow,   ARRAYDEF({{ TABLE, END }, { INT, INT, INT, INT, INT, END }}), 2 ) \
+   METHOD(CLASS, getAngle,        ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getActiveWeapon, ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getMountedItems, ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, getLoadout,      ARRAYDEF({{ END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setLoadout,      ARRAYDEF({{ TABLE, END }, { INT, INT, INT, INT, INT, END }}), 2, ChangesWorld ) \
+   METHOD(CLASS, setLoadoutNow,   ARRAYDEF({{ TABLE, END }, { INT, INT, INT, INT, INT, END }}), 2, ChangesWorld ) \
 
 
 GENERATE_LUA_METHODS_TABLE(Ship, LUA_METHODS);
@@ -573,12 +573,12 @@ bool SpeedZone::canBeNeutral() { return false; }
  */
 //               Fn name     Param profiles       Profile count                           
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, setDir,      ARRAYDEF({{ PT,      END }}), 1 ) \
-   METHOD(CLASS, getDir,      ARRAYDEF({{          END }}), 1 ) \
-   METHOD(CLASS, setSpeed,    ARRAYDEF({{ INT_GE0, END }}), 1 ) \
-   METHOD(CLASS, getSpeed,    ARRAYDEF({{          END }}), 1 ) \
-   METHOD(CLASS, setSnapping, ARRAYDEF({{ BOOL,    END }}), 1 ) \
-   METHOD(CLASS, getSnapping, ARRAYDEF({{          END }}), 1 ) \
+   METHOD(CLASS, setDir,      ARRAYDEF({{ PT,      END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, getDir,      ARRAYDEF({{          END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setSpeed,    ARRAYDEF({{ INT_GE0, END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, getSpeed,    ARRAYDEF({{          END }}), 1, ReadsWorld   ) \
+   METHOD(CLASS, setSnapping, ARRAYDEF({{ BOOL,    END }}), 1, ChangesWorld ) \
+   METHOD(CLASS, getSnapping, ARRAYDEF({{          END }}), 1, ReadsWorld   ) \
 
 GENERATE_LUA_METHODS_TABLE(SpeedZone, LUA_METHODS);
 GENERATE_LUA_FUNARGS_TABLE(SpeedZone, LUA_METHODS);
@@ -380,13 +380,13 @@ void Team::incrementBotCount()
 
 //                Fn name                  Param profiles            Profile count
 #define LUA_METHODS(CLASS, METHOD) \
-   METHOD(CLASS, getIndex,          ARRAYDEF({{ END }}), 1 )      \
-   METHOD(CLASS, getName,           ARRAYDEF({{ END }}), 1 )      \
-   METHOD(CLASS, getScore,          ARRAYDEF({{ END }}), 1 )      \
-   METHOD(CLASS, getPlayerCount,    ARRAYDEF({{ END }}), 1 )      \
-   METHOD(CLASS, getPlayers,        ARRAYDEF({{ END }}), 1 )      \
-   METHOD(CLASS, getColor,          ARRAYDEF({{ END }}), 1 )      \
-   METHOD(CLASS, setScore,          ARRAYDEF({{ INT, END }}), 1 ) \
+   METHOD(CLASS, getIndex,          ARRAYDEF({{ END }}), 1, ReadsWorld   )      \
+   METHOD(CLASS, getName,           ARRAYDEF({{ END }}), 1, ReadsWorld   )      \
+   METHOD(CLASS, getScore,          ARRAYDEF({{ END }}), 1, ReadsWorld   )      \
+   METHOD(CLASS, getPlayerCount,    ARRAYDEF({{ END }}), 1, ReadsWorld   )      \
+   METHOD(CLASS, getPlayers,        ARRAYDEF({{ END }}), 1, ReadsWorld   )      \
+   METHOD(CLASS, getColor,          ARRAYDEF({{ END }}), 1, ReadsWorld   )      \
+   METHOD(CLASS, setScore,          ARRAYDEF({{ INT, END }}), 1, ChangesWorld ) \
 
 GENERATE_LUA_FUNARGS_TABLE(Team, LUA_METHODS);
 GENERATE_LUA_METHODS_TABLE(Team, LUA_METHODS);
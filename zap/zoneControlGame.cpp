@@ -333,7 +333,6 @@ void ZoneControlGameType::onFlagMounted(S32 teamIndex)
 void ZoneControlGameType::majorScoringEventOcurred(S32 team)
 {
    // Find all zones...
-   fillVector.clear();
    const Vector<DatabaseObject *> *goalZones = getGame()->getLevel()->findObjects_fast(GoalZoneTypeNumber);
 
    // ...and make sure they're not flashing...